@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2026 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/async_log_appender.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sstream>
+#include <log4cplus/helpers/loglog.h>
+#include <log4cplus/layout.h>
+#include <log4cplus/spi/loggingevent.h>
+
+#include "base/time_util.h"
+
+AsyncLogAppender::AsyncLogAppender(const std::string &filename,
+                                   long max_file_size, int max_backup_index,
+                                   size_t queue_capacity,
+                                   int sync_interval_msecs)
+    : filename_(filename),
+      max_file_size_(max_file_size),
+      max_backup_index_(max_backup_index),
+      sync_interval_usecs_(sync_interval_msecs * 1000ULL),
+      writer_running_(false),
+      fd_(-1),
+      file_size_(0),
+      sync_pending_(false),
+      last_sync_usecs_(ClockMonotonicUsec()),
+      dropped_reported_(0) {
+    records_queued_ = 0;
+    records_dropped_ = 0;
+    records_written_ = 0;
+    write_errors_ = 0;
+    syncs_ = 0;
+    stop_ = false;
+    queue_.set_capacity(queue_capacity);
+    Open(false);
+}
+
+AsyncLogAppender::~AsyncLogAppender() {
+    destructorImpl();
+    std::string *record;
+    while (queue_.try_pop(record)) {
+        delete record;
+    }
+}
+
+bool AsyncLogAppender::Start() {
+    if (writer_running_ || closed) {
+        return writer_running_;
+    }
+    if (pthread_create(&writer_, NULL, &AsyncLogAppender::WriterRun,
+                       this) != 0) {
+        log4cplus::helpers::getLogLog().error(
+            "AsyncLogAppender: writer thread create FAILED");
+        return false;
+    }
+    writer_running_ = true;
+    return true;
+}
+
+void AsyncLogAppender::close() {
+    if (closed) {
+        return;
+    }
+    closed = true;
+    if (writer_running_) {
+        stop_ = true;
+        // Wakes the writer up if it waits for records. If the queue is full,
+        // the writer is not waiting and sees stop_ after its current batch.
+        queue_.try_push(NULL);
+        pthread_join(writer_, NULL);
+        writer_running_ = false;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void AsyncLogAppender::Flush() {
+    uint64_t queued = records_queued_;
+    while (writer_running_ && records_written_ + write_errors_ < queued) {
+        usleep(1000);
+    }
+}
+
+void AsyncLogAppender::append(
+    const log4cplus::spi::InternalLoggingEvent &event) {
+    log4cplus::tostringstream buf;
+    layout->formatAndAppend(buf, event);
+    std::string *record = new std::string(buf.str());
+    // Drop rather than wait for the writer if the queue is full
+    if (!queue_.try_push(record)) {
+        delete record;
+        records_dropped_++;
+        return;
+    }
+    records_queued_++;
+}
+
+bool AsyncLogAppender::Write(const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t ret = ::write(fd_, data, size);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+void *AsyncLogAppender::WriterRun(void *arg) {
+    static_cast<AsyncLogAppender *>(arg)->Run();
+    return NULL;
+}
+
+void AsyncLogAppender::Run() {
+    std::string batch;
+    batch.reserve(kMaxBatchSize);
+    while (true) {
+        std::string *record;
+        if (stop_) {
+            // Write what is left in the queue, without waiting for more
+            if (!queue_.try_pop(record)) {
+                break;
+            }
+        } else {
+            queue_.pop(record);
+        }
+        batch.clear();
+        size_t count = 0;
+        do {
+            if (record == NULL) {
+                continue;
+            }
+            batch.append(*record);
+            delete record;
+            count++;
+        } while (batch.size() < kMaxBatchSize && queue_.try_pop(record));
+
+        uint64_t dropped = records_dropped_;
+        if (dropped != dropped_reported_) {
+            std::ostringstream msg;
+            msg << "Log queue full, " << dropped - dropped_reported_ <<
+                " log records dropped" << std::endl;
+            batch.append(msg.str());
+            dropped_reported_ = dropped;
+        }
+        if (!batch.empty()) {
+            WriteBatch(batch, count);
+        }
+    }
+    if (sync_pending_) {
+        Sync();
+    }
+}
+
+void AsyncLogAppender::WriteBatch(const std::string &batch, size_t count) {
+    if (fd_ < 0 || !Write(batch.data(), batch.size())) {
+        write_errors_ += count;
+        return;
+    }
+    file_size_ += batch.size();
+    sync_pending_ = true;
+    if (max_file_size_ > 0 && file_size_ >= max_file_size_) {
+        Rollover();
+    } else if (ClockMonotonicUsec() - last_sync_usecs_ >=
+               sync_interval_usecs_) {
+        Sync();
+    }
+    records_written_ += count;
+}
+
+void AsyncLogAppender::Open(bool truncate) {
+    int flags = O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0);
+    fd_ = ::open(filename_.c_str(), flags, 0644);
+    if (fd_ < 0) {
+        std::ostringstream msg;
+        msg << "AsyncLogAppender: log file " << filename_ <<
+            " open FAILED: " << strerror(errno);
+        log4cplus::helpers::getLogLog().error(msg.str());
+        return;
+    }
+    file_size_ = lseek(fd_, 0, SEEK_END);
+}
+
+void AsyncLogAppender::Sync() {
+    if (fd_ >= 0) {
+        fdatasync(fd_);
+        syncs_++;
+    }
+    sync_pending_ = false;
+    last_sync_usecs_ = ClockMonotonicUsec();
+}
+
+// Same naming as the log4cplus RollingFileAppender: <file>.1 is the most
+// recent backup and <file>.<max_backup_index> the oldest.
+void AsyncLogAppender::Rollover() {
+    Sync();
+    ::close(fd_);
+    fd_ = -1;
+    if (max_backup_index_ > 0) {
+        for (int i = max_backup_index_ - 1; i >= 1; i--) {
+            std::ostringstream from, to;
+            from << filename_ << "." << i;
+            to << filename_ << "." << i + 1;
+            rename(from.str().c_str(), to.str().c_str());
+        }
+        std::string backup(filename_ + ".1");
+        rename(filename_.c_str(), backup.c_str());
+    }
+    Open(true);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __ASYNC_LOG_APPENDER_H__
+#define __ASYNC_LOG_APPENDER_H__
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+#include <tbb/atomic.h>
+#include <tbb/concurrent_queue.h>
+#include <log4cplus/appender.h>
+#include "base/util.h"
+
+//
+// Rolling file appender that does not write on the thread of the caller.
+// Log records are formatted by the caller and queued into a bounded queue,
+// a dedicated thread writes them to the file in batches and syncs the file
+// at most once per sync interval. If the queue is full, e.g. because the
+// disk stalls, the record is dropped and counted, rather than blocking the
+// caller; the number of records dropped is then written to the file.
+// The writer thread is started by Start(), once the appender, including
+// any derived class, is constructed.
+//
+class AsyncLogAppender : public log4cplus::Appender {
+public:
+    static const size_t kDefaultQueueCapacity = 64 * 1024;
+    static const int kDefaultSyncIntervalMsecs = 1000;
+    static const size_t kMaxBatchSize = 64 * 1024;
+
+    AsyncLogAppender(const std::string &filename, long max_file_size,
+                     int max_backup_index,
+                     size_t queue_capacity = kDefaultQueueCapacity,
+                     int sync_interval_msecs = kDefaultSyncIntervalMsecs);
+    virtual ~AsyncLogAppender();
+
+    // Starts the writer thread. Records appended before are queued.
+    bool Start();
+
+    // Writes the queued records and stops the writer thread, without
+    // waiting for room in the queue
+    virtual void close();
+
+    // Waits until the records queued so far are written. For testing.
+    void Flush();
+
+    uint64_t records_queued() const { return records_queued_; }
+    uint64_t records_dropped() const { return records_dropped_; }
+    uint64_t records_written() const { return records_written_; }
+    uint64_t write_errors() const { return write_errors_; }
+    uint64_t syncs() const { return syncs_; }
+
+protected:
+    virtual void append(const log4cplus::spi::InternalLoggingEvent &event);
+    // Writes a batch of records, runs on the writer thread
+    virtual bool Write(const char *data, size_t size);
+
+private:
+    static void *WriterRun(void *arg);
+    void Run();
+    void WriteBatch(const std::string &batch, size_t count);
+    void Open(bool truncate);
+    void Sync();
+    void Rollover();
+
+    const std::string filename_;
+    const long max_file_size_;
+    const int max_backup_index_;
+    const uint64_t sync_interval_usecs_;
+    // NULL is queued to wake the writer thread up when stop_ is set
+    tbb::concurrent_bounded_queue<std::string *> queue_;
+    pthread_t writer_;
+    bool writer_running_;
+    tbb::atomic<bool> stop_;
+
+    // Writer thread state
+    int fd_;
+    long file_size_;
+    bool sync_pending_;
+    uint64_t last_sync_usecs_;
+    uint64_t dropped_reported_;
+
+    tbb::atomic<uint64_t> records_queued_;
+    tbb::atomic<uint64_t> records_dropped_;
+    tbb::atomic<uint64_t> records_written_;
+    tbb::atomic<uint64_t> write_errors_;
+    tbb::atomic<uint64_t> syncs_;
+
+    DISALLOW_COPY_AND_ASSIGN(AsyncLogAppender);
+};
+
+#endif // __ASYNC_LOG_APPENDER_H__
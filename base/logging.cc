@@ -14,6 +14,8 @@
 #include <boost/format.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 
+#include "base/async_log_appender.h"
+
 using namespace log4cplus;
 
 static bool disabled_;
@@ -59,7 +61,8 @@ void LoggingInit() {
 
 void LoggingInit(const std::string &filename, long maxFileSize, int maxBackupIndex,
                  bool useSyslog, const std::string &syslogFacility,
-                 const std::string &ident, LogLevel logLevel) {
+                 const std::string &ident, LogLevel logLevel,
+                 bool asyncWrite) {
     Logger logger = Logger::getRoot();
     logger.setLogLevel(logLevel);
 
@@ -82,6 +85,13 @@ void LoggingInit(const std::string &filename, long maxFileSize, int maxBackupInd
         if (filename == "<stdout>" || filename.length() == 0) {
             BasicConfigurator config;
             config.configure();
+        } else if (asyncWrite) {
+            // Do not let disk stalls block the callers
+            AsyncLogAppender *appender = new AsyncLogAppender(filename,
+                                           maxFileSize, maxBackupIndex);
+            appender->Start();
+            SharedAppenderPtr fileappender(appender);
+            logger.addAppender(fileappender);
         } else {
             SharedAppenderPtr fileappender(new RollingFileAppender(filename,
                                            maxFileSize, maxBackupIndex));
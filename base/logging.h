@@ -38,13 +38,16 @@
     } while (0)
 
 void LoggingInit();
+// With asyncWrite, e.g. set by the DEFAULT.log_async_write option of the
+// sandesh options, the log file is written by an AsyncLogAppender
 void LoggingInit(const std::string &filename,
                  long maxFileSize,
                  int maxBackupIndex,
                  bool useSyslog,
                  const std::string &syslogFacility,
                  const std::string &ident,
-                 log4cplus::LogLevel logLevel);
+                 log4cplus::LogLevel logLevel,
+                 bool asyncWrite = false);
 
 void LoggingInit(const std::string &propertyFile);
 void SetLoggingLevel(log4cplus::LogLevel logLevel);
@@ -220,6 +220,50 @@ double TDigest_percentile(TDigest *digest, double q)
     return RB_MAX(CentroidTree, &(digest->C))->mean;
 }
 
+// Fraction of the samples that are less than or equal to x, interpolating
+// linearly between the means of the neighbouring centroids.
+double TDigest_cdf(TDigest *digest, double x)
+{
+    Centroid *c, *prev = NULL;
+    double t = 0;
+
+    if (digest->count == 0) {
+        return 0;
+    }
+    RB_FOREACH(c, CentroidTree, &(digest->C)) {
+        if (x < c->mean) {
+            if (prev == NULL) {
+                return 0;
+            }
+            double f = (x - prev->mean) / (c->mean - prev->mean);
+            t += f * (prev->count + c->count) / 2.0 - prev->count / 2.0;
+            return t / digest->count;
+        }
+        t += c->count;
+        prev = c;
+    }
+    return 1;
+}
+
+// Adds the centroids of other to digest. Like TDigest_add, returns the
+// compressed digest that replaces digest if digest had to be compressed.
+TDigest * TDigest_merge(TDigest *digest, TDigest *other)
+{
+    TDigest *rd = NULL, *nd;
+    Centroid *c;
+
+    RB_FOREACH(c, CentroidTree, &(other->C)) {
+        nd = TDigest_add(rd != NULL ? rd : digest, c->mean, c->count);
+        if (nd != NULL) {
+            if (rd != NULL) {
+                TDigest_destroy(rd);
+            }
+            rd = nd;
+        }
+    }
+    return rd;
+}
+
 size_t TDigest_get_ncentroids(TDigest *digest)
 {
     return digest->ncentroids;
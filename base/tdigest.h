@@ -32,6 +32,12 @@ THE SOFTWARE.
 #ifndef TDIGEST_H
 #define TDIGEST_H
 
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define DEFAULT_DELTA 0.01
 #define DEFAULT_K 100
 
@@ -44,6 +50,8 @@ TDigest * TDigest_add(TDigest *pdigest, double x, size_t w);
 Centroid *TDigest_find_closest_centroid(TDigest *digest, double x, size_t w);
 TDigest * TDigest_compress(TDigest *digest);
 double TDigest_percentile(TDigest *digest, double q);
+double TDigest_cdf(TDigest *digest, double x);
+TDigest * TDigest_merge(TDigest *digest, TDigest *other);
 size_t TDigest_get_ncentroids(TDigest *digest);
 Centroid *TDigest_get_centroid(TDigest *digest, size_t i);
 size_t TDigest_get_ncompressions(TDigest *digest);
@@ -54,4 +62,8 @@ void Centroid_add(Centroid *c, double x, size_t w);
 double Centroid_get_mean(Centroid *c);
 size_t Centroid_get_count(Centroid *c);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
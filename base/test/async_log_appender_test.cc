@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2026 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <log4cplus/layout.h>
+#include <log4cplus/logger.h>
+#include <log4cplus/loggingmacros.h>
+#include "testing/gunit.h"
+#include "base/async_log_appender.h"
+#include "base/time_util.h"
+
+namespace {
+
+// Time taken by each write to the simulated slow disk
+static const int kSlowDiskUsecs = 200;
+
+// Writes to a slow disk, or to a stalled one while blocked
+class SlowAsyncLogAppender : public AsyncLogAppender {
+public:
+    SlowAsyncLogAppender(const std::string &filename, size_t queue_capacity,
+                         int delay_usecs)
+        : AsyncLogAppender(filename, 0, 0, queue_capacity),
+          delay_usecs_(delay_usecs) {
+        blocked_ = false;
+    }
+    virtual ~SlowAsyncLogAppender() {
+        // Stop the writer thread while Write() can still be called
+        close();
+    }
+    void set_blocked(bool blocked) { blocked_ = blocked; }
+
+protected:
+    virtual bool Write(const char *data, size_t size) {
+        while (blocked_) {
+            usleep(1000);
+        }
+        usleep(delay_usecs_);
+        return AsyncLogAppender::Write(data, size);
+    }
+
+private:
+    tbb::atomic<bool> blocked_;
+    int delay_usecs_;
+};
+
+// Writes to a slow disk on the thread of the caller, as the log4cplus file
+// appenders do
+class SlowSyncAppender : public log4cplus::Appender {
+public:
+    SlowSyncAppender(const std::string &filename, int delay_usecs)
+        : delay_usecs_(delay_usecs) {
+        fd_ = open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    }
+    virtual ~SlowSyncAppender() {
+        destructorImpl();
+    }
+    virtual void close() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        closed = true;
+    }
+
+protected:
+    virtual void append(const log4cplus::spi::InternalLoggingEvent &event) {
+        log4cplus::tostringstream buf;
+        layout->formatAndAppend(buf, event);
+        std::string record(buf.str());
+        usleep(delay_usecs_);
+        EXPECT_EQ((ssize_t)record.size(),
+                  write(fd_, record.data(), record.size()));
+    }
+
+private:
+    int fd_;
+    int delay_usecs_;
+};
+
+class AsyncLogAppenderTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        std::ostringstream filename;
+        filename << "/tmp/async_log_appender_test." << getpid() << ".log";
+        filename_ = filename.str();
+        RemoveFiles();
+        logger_ = log4cplus::Logger::getInstance("AsyncLogAppenderTest");
+        logger_.setAdditivity(false);
+        logger_.setLogLevel(log4cplus::INFO_LOG_LEVEL);
+    }
+
+    virtual void TearDown() {
+        logger_.removeAllAppenders();
+        RemoveFiles();
+    }
+
+    void RemoveFiles() {
+        remove(filename_.c_str());
+        remove((filename_ + ".1").c_str());
+        remove((filename_ + ".2").c_str());
+    }
+
+    void AddAppender(log4cplus::Appender *appender) {
+        log4cplus::SharedAppenderPtr appender_ptr(appender);
+        std::auto_ptr<log4cplus::Layout> layout(
+            new log4cplus::PatternLayout("%m%n"));
+        appender_ptr->setLayout(layout);
+        logger_.addAppender(appender_ptr);
+    }
+
+    std::vector<std::string> ReadLines(const std::string &filename) {
+        std::vector<std::string> lines;
+        std::ifstream file(filename.c_str());
+        std::string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    void Benchmark(const std::string &name, int count) {
+        std::vector<uint64_t> latency;
+        latency.reserve(count);
+        uint64_t start = ClockMonotonicUsec();
+        for (int i = 0; i < count; i++) {
+            uint64_t call_start = ClockMonotonicUsec();
+            LOG4CPLUS_INFO(logger_, "Benchmark log record " << i);
+            latency.push_back(ClockMonotonicUsec() - call_start);
+        }
+        uint64_t elapsed = ClockMonotonicUsec() - start;
+        std::sort(latency.begin(), latency.end());
+        std::cout << name << ": " <<
+            count * 1000000ULL / (elapsed ? elapsed : 1) <<
+            " calls/sec, p99 latency " << latency[count * 99 / 100] <<
+            " usecs" << std::endl;
+    }
+
+    std::string filename_;
+    log4cplus::Logger logger_;
+};
+
+TEST_F(AsyncLogAppenderTest, Basic) {
+    AsyncLogAppender *appender = new AsyncLogAppender(filename_, 0, 0);
+    ASSERT_TRUE(appender->Start());
+    AddAppender(appender);
+    for (int i = 0; i < 1000; i++) {
+        LOG4CPLUS_INFO(logger_, "Log record " << i);
+    }
+    appender->Flush();
+    EXPECT_EQ(1000U, appender->records_queued());
+    EXPECT_EQ(1000U, appender->records_written());
+    EXPECT_EQ(0U, appender->records_dropped());
+    EXPECT_EQ(0U, appender->write_errors());
+
+    std::vector<std::string> lines(ReadLines(filename_));
+    ASSERT_EQ(1000U, lines.size());
+    EXPECT_EQ("Log record 0", lines.front());
+    EXPECT_EQ("Log record 999", lines.back());
+}
+
+// Records appended before the writer thread is started are written once it
+// is started
+TEST_F(AsyncLogAppenderTest, StartAfterAppend) {
+    AsyncLogAppender *appender = new AsyncLogAppender(filename_, 0, 0);
+    AddAppender(appender);
+    for (int i = 0; i < 100; i++) {
+        LOG4CPLUS_INFO(logger_, "Log record " << i);
+    }
+    EXPECT_EQ(100U, appender->records_queued());
+    EXPECT_EQ(0U, appender->records_written());
+    ASSERT_TRUE(appender->Start());
+    appender->Flush();
+    EXPECT_EQ(100U, appender->records_written());
+    std::vector<std::string> lines(ReadLines(filename_));
+    ASSERT_EQ(100U, lines.size());
+    EXPECT_EQ("Log record 0", lines.front());
+}
+
+TEST_F(AsyncLogAppenderTest, Overflow) {
+    SlowAsyncLogAppender *appender =
+        new SlowAsyncLogAppender(filename_, 10, 0);
+    ASSERT_TRUE(appender->Start());
+    AddAppender(appender);
+    // The disk stalls, callers must not
+    appender->set_blocked(true);
+    for (int i = 0; i < 100; i++) {
+        LOG4CPLUS_INFO(logger_, "Log record " << i);
+    }
+    // At most one record taken by the writer in addition to the queue
+    EXPECT_GE(11U, appender->records_queued());
+    EXPECT_EQ(100U, appender->records_queued() + appender->records_dropped());
+
+    appender->set_blocked(false);
+    appender->Flush();
+    EXPECT_EQ(appender->records_queued(), appender->records_written());
+    // Records written, and the number of records dropped
+    std::vector<std::string> lines(ReadLines(filename_));
+    uint64_t records = 0, dropped = 0;
+    for (size_t i = 0; i < lines.size(); i++) {
+        unsigned long count;
+        if (sscanf(lines[i].c_str(), "Log queue full, %lu", &count) == 1) {
+            dropped += count;
+        } else {
+            records++;
+        }
+    }
+    EXPECT_EQ(appender->records_written(), records);
+    EXPECT_EQ(appender->records_dropped(), dropped);
+}
+
+static void *CloseAppender(void *arg) {
+    static_cast<AsyncLogAppender *>(arg)->close();
+    return NULL;
+}
+
+// Closing with a full queue writes all the queued records
+TEST_F(AsyncLogAppenderTest, CloseFullQueue) {
+    SlowAsyncLogAppender *appender =
+        new SlowAsyncLogAppender(filename_, 10, 0);
+    ASSERT_TRUE(appender->Start());
+    AddAppender(appender);
+    appender->set_blocked(true);
+    for (int i = 0; i < 100; i++) {
+        LOG4CPLUS_INFO(logger_, "Log record " << i);
+    }
+    pthread_t closer;
+    ASSERT_EQ(0, pthread_create(&closer, NULL, &CloseAppender, appender));
+    usleep(10000);
+    appender->set_blocked(false);
+    pthread_join(closer, NULL);
+    EXPECT_EQ(appender->records_queued(), appender->records_written());
+    std::vector<std::string> lines(ReadLines(filename_));
+    ASSERT_FALSE(lines.empty());
+    EXPECT_EQ("Log record 0", lines.front());
+}
+
+TEST_F(AsyncLogAppenderTest, Rollover) {
+    AsyncLogAppender *appender = new AsyncLogAppender(filename_, 1024, 2);
+    ASSERT_TRUE(appender->Start());
+    AddAppender(appender);
+    // The file size is checked after each batch
+    for (int i = 0; i < 1000; i++) {
+        LOG4CPLUS_INFO(logger_, "Log record " << i);
+        if (i % 100 == 99) {
+            appender->Flush();
+        }
+    }
+    EXPECT_EQ(1000U, appender->records_written());
+    EXPECT_FALSE(ReadLines(filename_ + ".1").empty());
+    EXPECT_FALSE(ReadLines(filename_ + ".2").empty());
+    EXPECT_TRUE(ReadLines(filename_ + ".3").empty());
+
+    // The most recent records, oldest backup first
+    std::vector<std::string> lines(ReadLines(filename_ + ".2"));
+    std::vector<std::string> lines1(ReadLines(filename_ + ".1"));
+    std::vector<std::string> lines0(ReadLines(filename_));
+    lines.insert(lines.end(), lines1.begin(), lines1.end());
+    lines.insert(lines.end(), lines0.begin(), lines0.end());
+    ASSERT_LT(0U, lines.size());
+    int first = 1000 - lines.size();
+    for (size_t i = 0; i < lines.size(); i++) {
+        std::ostringstream record;
+        record << "Log record " << first + i;
+        EXPECT_EQ(record.str(), lines[i]);
+    }
+}
+
+// Log calls/sec and p99 latency of the caller with a slow disk
+TEST_F(AsyncLogAppenderTest, DISABLED_SyncSlowDisk) {
+    AddAppender(new SlowSyncAppender(filename_, kSlowDiskUsecs));
+    Benchmark("Sync", 10000);
+}
+
+TEST_F(AsyncLogAppenderTest, DISABLED_AsyncSlowDisk) {
+    SlowAsyncLogAppender *appender = new SlowAsyncLogAppender(filename_,
+        AsyncLogAppender::kDefaultQueueCapacity, kSlowDiskUsecs);
+    ASSERT_TRUE(appender->Start());
+    AddAppender(appender);
+    Benchmark("Async", 10000);
+    appender->Flush();
+    EXPECT_EQ(0U, appender->records_dropped());
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -2,7 +2,16 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 #include "testing/gunit.h"
+#include "base/time_util.h"
 #include "base/trace.h"
 
 namespace {
@@ -14,6 +23,15 @@ class TraceStruct {
     char data[4096];
 };
 
+class TraceSeqStruct {
+public:
+    explicit TraceSeqStruct(int value) : value_(value) {
+    }
+    int value() const { return value_; }
+private:
+    int value_;
+};
+
 TEST_F(TraceTest, DISABLED_1MillionTraceWrite) {
     // Enable trace
     Trace<TraceStruct>::GetInstance()->TraceOn();
@@ -27,10 +45,436 @@ TEST_F(TraceTest, DISABLED_1MillionTraceWrite) {
         trace_buf->TraceWrite(ni);
     }
 }
+
+class TraceReader {
+public:
+    void Read(TraceSeqStruct *entry, bool more) {
+        values_.push_back(entry->value());
+        more_.push_back(more);
+    }
+    std::vector<int> values_;
+    std::vector<bool> more_;
+};
+
+TEST_F(TraceTest, PerThreadRead) {
+    boost::shared_ptr<TraceBuffer<TraceSeqStruct> > trace_buf(
+        Trace<TraceSeqStruct>::GetInstance()->TraceBufAdd("PerThreadReadBuf",
+            5, true, true));
+    EXPECT_TRUE(trace_buf->IsPerThread());
+    TraceReader empty;
+    trace_buf->TraceRead("ctx", 0,
+        boost::bind(&TraceReader::Read, &empty, _1, _2));
+    EXPECT_TRUE(empty.values_.empty());
+
+    for (int i = 0; i < 8; i++) {
+        trace_buf->TraceWrite(new TraceSeqStruct(i));
+    }
+    // Only the last 5 entries are retained, oldest first
+    TraceReader all;
+    trace_buf->TraceRead("all", 0,
+        boost::bind(&TraceReader::Read, &all, _1, _2));
+    ASSERT_EQ(5U, all.values_.size());
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(i + 3, all.values_[i]);
+        EXPECT_EQ(i != 4, all.more_[i]);
+    }
+
+    // Read in batches using a read context
+    TraceReader batch;
+    trace_buf->TraceRead("ctx", 2,
+        boost::bind(&TraceReader::Read, &batch, _1, _2));
+    ASSERT_EQ(2U, batch.values_.size());
+    EXPECT_EQ(3, batch.values_[0]);
+    EXPECT_EQ(4, batch.values_[1]);
+    trace_buf->TraceWrite(new TraceSeqStruct(8));
+    trace_buf->TraceRead("ctx", 0,
+        boost::bind(&TraceReader::Read, &batch, _1, _2));
+    ASSERT_EQ(6U, batch.values_.size());
+    for (int i = 0; i < 6; i++) {
+        EXPECT_EQ(i + 3, batch.values_[i]);
+    }
+    // Nothing new since the last read
+    trace_buf->TraceRead("ctx", 0,
+        boost::bind(&TraceReader::Read, &batch, _1, _2));
+    EXPECT_EQ(6U, batch.values_.size());
+    trace_buf->TraceReadDone("ctx");
+
+    // Shrinking the capacity limits what is returned
+    trace_buf->TraceBufCapacityReset(2);
+    EXPECT_EQ(2U, trace_buf->TraceBufCapacityGet());
+    TraceReader shrunk;
+    trace_buf->TraceRead("ctx", 0,
+        boost::bind(&TraceReader::Read, &shrunk, _1, _2));
+    ASSERT_EQ(2U, shrunk.values_.size());
+    EXPECT_EQ(7, shrunk.values_[0]);
+    EXPECT_EQ(8, shrunk.values_[1]);
+}
+
+// Encodes values below 1000 only, larger values are kept as objects
+class TraceSeqCodec : public TraceEntryCodec<TraceSeqStruct> {
+public:
+    virtual size_t Encode(TraceSeqStruct *entry, uint8_t *buf,
+                          size_t buf_len) {
+        int value = entry->value();
+        if (value >= 1000 || buf_len < sizeof(value)) {
+            return 0;
+        }
+        memcpy(buf, &value, sizeof(value));
+        return sizeof(value);
+    }
+    virtual TraceSeqStruct *Decode(const uint8_t *buf, size_t buf_len) {
+        int value;
+        if (buf_len != sizeof(value)) {
+            return NULL;
+        }
+        memcpy(&value, buf, sizeof(value));
+        return new TraceSeqStruct(value);
+    }
+    virtual void SetArena(TraceArena *arena) {
+        arena->SetTypeName(0, "TraceSeqStruct");
+    }
+};
+
+TEST_F(TraceTest, BinaryRead) {
+    boost::shared_ptr<TraceEntryCodec<TraceSeqStruct> > codec(
+        new TraceSeqCodec);
+    boost::shared_ptr<TraceBuffer<TraceSeqStruct> > trace_buf(
+        Trace<TraceSeqStruct>::GetInstance()->TraceBufAddBinary(
+            "BinaryReadBuf", 4, true, codec, 16));
+    EXPECT_TRUE(trace_buf->IsBinary());
+    EXPECT_FALSE(trace_buf->IsPersistent());
+    EXPECT_EQ(4 * (sizeof(TraceSlotHeader) + 16 + sizeof(TraceSeqStruct *)),
+              trace_buf->TraceBufMemoryGet());
+
+    trace_buf->TraceWrite(new TraceSeqStruct(1));
+    trace_buf->TraceWrite(new TraceSeqStruct(1002));
+    trace_buf->TraceWrite(new TraceSeqStruct(3));
+    TraceReader first;
+    trace_buf->TraceRead("ctx", 2,
+        boost::bind(&TraceReader::Read, &first, _1, _2));
+    ASSERT_EQ(2U, first.values_.size());
+    EXPECT_EQ(1, first.values_[0]);
+    EXPECT_EQ(1002, first.values_[1]);
+    EXPECT_TRUE(first.more_[1]);
+
+    // Wrap the buffer, the oldest entries are overwritten
+    for (int i = 4; i < 7; i++) {
+        trace_buf->TraceWrite(new TraceSeqStruct(i));
+    }
+    TraceReader next;
+    trace_buf->TraceRead("ctx", 0,
+        boost::bind(&TraceReader::Read, &next, _1, _2));
+    ASSERT_EQ(4U, next.values_.size());
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(i + 3, next.values_[i]);
+        EXPECT_EQ(i != 3, next.more_[i]);
+    }
+    TraceReader none;
+    trace_buf->TraceRead("ctx", 0,
+        boost::bind(&TraceReader::Read, &none, _1, _2));
+    EXPECT_TRUE(none.values_.empty());
+    trace_buf->TraceReadDone("ctx");
+
+    // Capacity reset keeps the most recent entries
+    trace_buf->TraceBufCapacityReset(2);
+    EXPECT_EQ(2U, trace_buf->TraceBufCapacityGet());
+    trace_buf->TraceWrite(new TraceSeqStruct(7));
+    TraceReader reset;
+    trace_buf->TraceRead("ctx", 0,
+        boost::bind(&TraceReader::Read, &reset, _1, _2));
+    ASSERT_EQ(2U, reset.values_.size());
+    EXPECT_EQ(6, reset.values_[0]);
+    EXPECT_EQ(7, reset.values_[1]);
+
+    // Growing the buffer keeps all the entries, including the objects
+    trace_buf->TraceWrite(new TraceSeqStruct(1008));
+    trace_buf->TraceBufCapacityReset(3);
+    trace_buf->TraceWrite(new TraceSeqStruct(9));
+    TraceReader grow;
+    trace_buf->TraceRead("ctx", 0,
+        boost::bind(&TraceReader::Read, &grow, _1, _2));
+    ASSERT_EQ(3U, grow.values_.size());
+    EXPECT_EQ(7, grow.values_[0]);
+    EXPECT_EQ(1008, grow.values_[1]);
+    EXPECT_EQ(9, grow.values_[2]);
+}
+
+static std::string ReadTraceFile(const std::string &path) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+TEST_F(TraceTest, PersistentRead) {
+    char tmpl[] = "/tmp/trace_test_XXXXXX";
+    ASSERT_TRUE(mkdtemp(tmpl) != NULL);
+    std::string path(std::string(tmpl) + "/PersistentBuf.trace");
+    boost::shared_ptr<TraceEntryCodec<TraceSeqStruct> > codec(
+        new TraceSeqCodec);
+    boost::shared_ptr<TraceBuffer<TraceSeqStruct> > trace_buf(
+        Trace<TraceSeqStruct>::GetInstance()->TraceBufAddBinary(
+            "PersistentBuf", 3, true, codec, 16, path));
+    EXPECT_TRUE(trace_buf->IsPersistent());
+    for (int i = 1; i <= 4; i++) {
+        trace_buf->TraceWrite(new TraceSeqStruct(i == 2 ? 1002 : i));
+    }
+    TraceReader reader;
+    trace_buf->TraceRead("ctx", 0,
+        boost::bind(&TraceReader::Read, &reader, _1, _2));
+    ASSERT_EQ(3U, reader.values_.size());
+    EXPECT_EQ(1002, reader.values_[0]);
+    EXPECT_EQ(4, reader.values_[2]);
+
+    // The file holds the entries without any help from the process
+    std::string contents(ReadTraceFile(path));
+    ASSERT_LE(sizeof(TraceFileHeader), contents.size());
+    TraceFileHeader header;
+    memcpy(&header, contents.data(), sizeof(header));
+    EXPECT_EQ(0, memcmp(header.magic, TraceArena::kFileMagic,
+                        sizeof(header.magic)));
+    EXPECT_EQ(TraceArena::kFileVersion, header.version);
+    EXPECT_EQ(3U, header.slot_count);
+    EXPECT_STREQ("PersistentBuf", header.name);
+    ASSERT_EQ(TraceArena::kTypeCount, header.type_count);
+    EXPECT_STREQ("TraceSeqStruct",
+                 contents.data() + header.type_table_offset);
+    ASSERT_EQ(header.header_size + header.slot_count * header.slot_size,
+              contents.size());
+    // Slot 0 was overwritten by the 4th entry, the 2nd entry did not fit
+    uint64_t seqno[] = { 4, 2, 3 };
+    int value[] = { 4, 0, 3 };
+    for (uint32_t i = 0; i < header.slot_count; i++) {
+        const char *slot = contents.data() + header.header_size +
+            i * header.slot_size;
+        const TraceSlotHeader *slot_header =
+            reinterpret_cast<const TraceSlotHeader *>(slot);
+        EXPECT_EQ(seqno[i], slot_header->seqno);
+        uint32_t len = slot_header->len;
+        if (value[i] == 0) {
+            EXPECT_EQ(0U, len);
+            continue;
+        }
+        ASSERT_EQ(sizeof(int), len);
+        int slot_value;
+        memcpy(&slot_value, slot + sizeof(*slot_header), sizeof(slot_value));
+        EXPECT_EQ(value[i], slot_value);
+    }
+
+    // Re-creating the buffer keeps the previous file
+    trace_buf.reset();
+    trace_buf = Trace<TraceSeqStruct>::GetInstance()->TraceBufAddBinary(
+        "PersistentBuf", 3, true, codec, 16, path);
+    EXPECT_TRUE(trace_buf->IsPersistent());
+    EXPECT_EQ(contents, ReadTraceFile(path + ".prev"));
+
+    // Resizing keeps the most recent entries in the file
+    trace_buf->TraceWrite(new TraceSeqStruct(5));
+    trace_buf->TraceWrite(new TraceSeqStruct(6));
+    trace_buf->TraceBufCapacityReset(2);
+    EXPECT_TRUE(trace_buf->IsPersistent());
+    contents = ReadTraceFile(path);
+    memcpy(&header, contents.data(), sizeof(header));
+    EXPECT_EQ(2U, header.slot_count);
+    ASSERT_EQ(header.header_size + header.slot_count * header.slot_size,
+              contents.size());
+    EXPECT_STREQ("TraceSeqStruct",
+                 contents.data() + header.type_table_offset);
+    for (uint32_t i = 0; i < header.slot_count; i++) {
+        const char *slot = contents.data() + header.header_size +
+            i * header.slot_size;
+        int slot_value;
+        memcpy(&slot_value, slot + sizeof(TraceSlotHeader),
+               sizeof(slot_value));
+        EXPECT_EQ(static_cast<int>(i + 5), slot_value);
+    }
+    trace_buf.reset();
+    unlink((path + ".prev").c_str());
+    unlink(path.c_str());
+    rmdir(tmpl);
+}
+
+TEST_F(TraceTest, PersistentFallback) {
+    std::string path("/nonexistent/trace_test/FallbackBuf.trace");
+    boost::shared_ptr<TraceEntryCodec<TraceSeqStruct> > codec(
+        new TraceSeqCodec);
+    boost::shared_ptr<TraceBuffer<TraceSeqStruct> > trace_buf(
+        Trace<TraceSeqStruct>::GetInstance()->TraceBufAddBinary(
+            "FallbackBuf", 2, true, codec, 16, path));
+    EXPECT_TRUE(trace_buf->IsBinary());
+    EXPECT_FALSE(trace_buf->IsPersistent());
+    trace_buf->TraceWrite(new TraceSeqStruct(1));
+    trace_buf->TraceBufCapacityReset(3);
+    EXPECT_FALSE(trace_buf->IsPersistent());
+    trace_buf->TraceWrite(new TraceSeqStruct(2));
+    TraceReader reader;
+    trace_buf->TraceRead("ctx", 0,
+        boost::bind(&TraceReader::Read, &reader, _1, _2));
+    ASSERT_EQ(2U, reader.values_.size());
+    EXPECT_EQ(1, reader.values_[0]);
+    EXPECT_EQ(2, reader.values_[1]);
+    trace_buf.reset();
+}
+
+struct TraceWriterArgs {
+    TraceBuffer<TraceSeqStruct> *trace_buf;
+    int id;
+    int count;
+    pthread_barrier_t *barrier;
+};
+
+static void *TraceWriterRun(void *arg) {
+    TraceWriterArgs *args = static_cast<TraceWriterArgs *>(arg);
+    for (int i = 0; i < args->count; i++) {
+        args->trace_buf->TraceWrite(
+            new TraceSeqStruct(args->id * args->count + i));
+    }
+    return NULL;
+}
+
+static uint64_t RunTraceWriters(TraceBuffer<TraceSeqStruct> *trace_buf,
+                                int thread_count, int count) {
+    std::vector<pthread_t> thread_ids;
+    std::vector<TraceWriterArgs> args(thread_count);
+    uint64_t start = ClockMonotonicUsec();
+    for (int i = 0; i < thread_count; i++) {
+        args[i].trace_buf = trace_buf;
+        args[i].id = i;
+        args[i].count = count;
+        pthread_t tid;
+        pthread_create(&tid, NULL, &TraceWriterRun, &args[i]);
+        thread_ids.push_back(tid);
+    }
+    pthread_t tid;
+    BOOST_FOREACH(tid, thread_ids) { pthread_join(tid, NULL); }
+    return ClockMonotonicUsec() - start;
+}
+
+TEST_F(TraceTest, PerThreadConcurrentWrite) {
+    const int kThreads = 4;
+    const int kCount = 10000;
+    boost::shared_ptr<TraceBuffer<TraceSeqStruct> > trace_buf(
+        Trace<TraceSeqStruct>::GetInstance()->TraceBufAdd(
+            "PerThreadConcurrentBuf", kCount, true, true));
+    RunTraceWriters(trace_buf.get(), kThreads, kCount);
+    TraceReader reader;
+    trace_buf->TraceRead("ctx", 0,
+        boost::bind(&TraceReader::Read, &reader, _1, _2));
+    // The newest kCount entries across all the threads, and entries from
+    // the same thread stay in write order
+    ASSERT_EQ(static_cast<size_t>(kCount), reader.values_.size());
+    std::vector<int> last(kThreads, -1);
+    BOOST_FOREACH(int value, reader.values_) {
+        int id = value / kCount;
+        EXPECT_LT(last[id], value);
+        last[id] = value;
+    }
+}
+
+TEST_F(TraceTest, PerThreadRingRecycle) {
+    const int kCount = 100;
+    boost::shared_ptr<TraceBuffer<TraceSeqStruct> > trace_buf(
+        Trace<TraceSeqStruct>::GetInstance()->TraceBufAdd(
+            "PerThreadRecycleBuf", kCount, true, true));
+    RunTraceWriters(trace_buf.get(), 1, kCount);
+    size_t memory = trace_buf->TraceBufMemoryGet();
+    // Each writer thread exits before the next one starts, and reuses its
+    // ring instead of adding one
+    for (int i = 0; i < 5; i++) {
+        RunTraceWriters(trace_buf.get(), 1, kCount);
+        EXPECT_EQ(memory, trace_buf->TraceBufMemoryGet());
+    }
+    RunTraceWriters(trace_buf.get(), 1, kCount / 2);
+    EXPECT_EQ(memory, trace_buf->TraceBufMemoryGet());
+    // Make more entries than a ring holds visible, there is only one ring
+    trace_buf->TraceBufCapacityReset(10 * kCount);
+    TraceReader reader;
+    trace_buf->TraceRead("ctx", 0,
+        boost::bind(&TraceReader::Read, &reader, _1, _2));
+    ASSERT_EQ(static_cast<size_t>(kCount), reader.values_.size());
+    // The newer half of the entries of the previous thread are still read
+    for (int i = 0; i < kCount / 2; i++) {
+        EXPECT_EQ(kCount / 2 + i, reader.values_[i]);
+        EXPECT_EQ(i, reader.values_[kCount / 2 + i]);
+    }
+}
+
+// More per-thread buffers than the process has thread keys
+TEST_F(TraceTest, PerThreadManyBuffers) {
+    const int kBuffers = PTHREAD_KEYS_MAX + 10;
+    std::vector<boost::shared_ptr<TraceBuffer<TraceSeqStruct> > > trace_bufs;
+    for (int i = 0; i < kBuffers; i++) {
+        std::ostringstream name;
+        name << "PerThreadManyBuf" << i;
+        trace_bufs.push_back(Trace<TraceSeqStruct>::GetInstance()->
+            TraceBufAdd(name.str(), 2, true, true));
+        EXPECT_TRUE(trace_bufs.back()->IsPerThread());
+        RunTraceWriters(trace_bufs.back().get(), 1, 1);
+        trace_bufs.back()->TraceWrite(new TraceSeqStruct(i));
+    }
+    BOOST_FOREACH(boost::shared_ptr<TraceBuffer<TraceSeqStruct> > &trace_buf,
+                  trace_bufs) {
+        TraceReader reader;
+        trace_buf->TraceRead("ctx", 0,
+            boost::bind(&TraceReader::Read, &reader, _1, _2));
+        EXPECT_EQ(2U, reader.values_.size());
+    }
+}
+
+// A writer thread that exits after the buffer is destroyed does not
+// release its ring to it
+static void *TraceWriterWait(void *arg) {
+    TraceWriterArgs *args = static_cast<TraceWriterArgs *>(arg);
+    args->trace_buf->TraceWrite(new TraceSeqStruct(args->id));
+    pthread_barrier_wait(args->barrier);
+    pthread_barrier_wait(args->barrier);
+    return NULL;
+}
+
+TEST_F(TraceTest, PerThreadBufferDestroyed) {
+    boost::shared_ptr<TraceBuffer<TraceSeqStruct> > trace_buf(
+        Trace<TraceSeqStruct>::GetInstance()->TraceBufAdd(
+            "PerThreadDestroyedBuf", 10, true, true));
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, 2);
+    TraceWriterArgs args;
+    args.trace_buf = trace_buf.get();
+    args.id = 1;
+    args.count = 1;
+    args.barrier = &barrier;
+    pthread_t tid;
+    pthread_create(&tid, NULL, &TraceWriterWait, &args);
+    pthread_barrier_wait(&barrier);
+    trace_buf.reset();
+    pthread_barrier_wait(&barrier);
+    pthread_join(tid, NULL);
+    pthread_barrier_destroy(&barrier);
+}
+
+TEST_F(TraceTest, DISABLED_TraceWriteScaling) {
+    const int kCount = 1000000;
+    for (int per_thread = 0; per_thread < 2; per_thread++) {
+        for (int threads = 1; threads <= 8; threads *= 2) {
+            std::ostringstream name;
+            name << "ScalingBuf" << per_thread << "-" << threads;
+            boost::shared_ptr<TraceBuffer<TraceSeqStruct> > trace_buf(
+                Trace<TraceSeqStruct>::GetInstance()->TraceBufAdd(
+                    name.str(), 10000, true, per_thread));
+            uint64_t usecs = RunTraceWriters(trace_buf.get(), threads,
+                                             kCount);
+            std::cout << (per_thread ? "per-thread" : "shared") <<
+                " threads: " << threads << " traces/sec: " <<
+                (threads * static_cast<uint64_t>(kCount) * 1000000) /
+                    (usecs ? usecs : 1) << std::endl;
+        }
+    }
+}
 } // namespace
 
 template<> Trace<TraceStruct>
         *Trace<TraceStruct>::trace_ = NULL;
+template<> Trace<TraceSeqStruct>
+        *Trace<TraceSeqStruct>::trace_ = NULL;
 
 int main(int argc, char *argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2026 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/trace.h"
+
+namespace {
+
+struct RingBuffer {
+    void *buffer;
+    TraceThreadRings::ReleaseFn release;
+};
+
+// Rings of a thread, by buffer id
+typedef std::map<uint64_t, void *> ThreadRingMap;
+typedef std::map<uint64_t, RingBuffer> RingBufferMap;
+
+// Created by the first buffer registered, trace buffers are created by
+// static initializers
+struct ThreadRingsState {
+    tbb::mutex mutex;
+    RingBufferMap buffers;
+    uint64_t next_id;
+    pthread_key_t key;
+    bool key_created;
+};
+
+ThreadRingsState *thread_rings_state;
+pthread_once_t thread_rings_once = PTHREAD_ONCE_INIT;
+
+}  // namespace
+
+void TraceThreadRings::Init() {
+    thread_rings_state = new ThreadRingsState;
+    thread_rings_state->next_id = 1;
+    thread_rings_state->key_created = pthread_key_create(
+        &thread_rings_state->key, &TraceThreadRings::ReleaseThread) == 0;
+}
+
+uint64_t TraceThreadRings::Register(void *buffer, ReleaseFn release) {
+    pthread_once(&thread_rings_once, &TraceThreadRings::Init);
+    ThreadRingsState *state = thread_rings_state;
+    if (!state->key_created) {
+        return 0;
+    }
+    tbb::mutex::scoped_lock lock(state->mutex);
+    uint64_t id = state->next_id++;
+    RingBuffer ring_buffer = { buffer, release };
+    state->buffers.insert(std::make_pair(id, ring_buffer));
+    return id;
+}
+
+void TraceThreadRings::Unregister(uint64_t id) {
+    ThreadRingsState *state = thread_rings_state;
+    tbb::mutex::scoped_lock lock(state->mutex);
+    state->buffers.erase(id);
+}
+
+void *TraceThreadRings::Lookup(uint64_t id) {
+    ThreadRingMap *rings = static_cast<ThreadRingMap *>(
+        pthread_getspecific(thread_rings_state->key));
+    if (rings == NULL) {
+        return NULL;
+    }
+    ThreadRingMap::const_iterator it = rings->find(id);
+    return it == rings->end() ? NULL : it->second;
+}
+
+bool TraceThreadRings::Insert(uint64_t id, void *ring) {
+    ThreadRingsState *state = thread_rings_state;
+    ThreadRingMap *rings = static_cast<ThreadRingMap *>(
+        pthread_getspecific(state->key));
+    if (rings == NULL) {
+        rings = new ThreadRingMap;
+        if (pthread_setspecific(state->key, rings) != 0) {
+            delete rings;
+            return false;
+        }
+    }
+    // Rings of the buffers destroyed since are freed with them
+    tbb::mutex::scoped_lock lock(state->mutex);
+    for (ThreadRingMap::iterator it = rings->begin(); it != rings->end();) {
+        if (state->buffers.find(it->first) == state->buffers.end()) {
+            rings->erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    rings->insert(std::make_pair(id, ring));
+    return true;
+}
+
+// Thread exit hook of the key, the buffers are kept registered while their
+// rings are released
+void TraceThreadRings::ReleaseThread(void *arg) {
+    ThreadRingMap *rings = static_cast<ThreadRingMap *>(arg);
+    ThreadRingsState *state = thread_rings_state;
+    {
+        tbb::mutex::scoped_lock lock(state->mutex);
+        for (ThreadRingMap::const_iterator it = rings->begin();
+             it != rings->end(); ++it) {
+            RingBufferMap::const_iterator buffer =
+                state->buffers.find(it->first);
+            if (buffer != state->buffers.end()) {
+                buffer->second.release(buffer->second.buffer, it->second);
+            }
+        }
+    }
+    delete rings;
+}
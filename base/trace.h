@@ -5,33 +5,157 @@
 #ifndef __TRACE_H__
 #define __TRACE_H__
 
+#include <pthread.h>
+#include <tbb/atomic.h>
 #include <tbb/mutex.h>
+#include <algorithm>
 #include <map>
+#include <memory>
 #include <vector>
 #include <stdexcept>
 #include <boost/function.hpp>
 #include <boost/ptr_container/ptr_circular_buffer.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/scoped_array.hpp>
 #include <boost/weak_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include "base/trace_arena.h"
 #include "base/util.h"
 
+// Approximate memory held by a trace entry. Overloaded for entry types
+// that can report their own size.
+template<typename TraceEntryT>
+inline size_t TraceEntryMemory(const TraceEntryT *entry) {
+    return sizeof(TraceEntryT);
+}
+
+// Serializes trace entries into the fixed size slots of a binary trace
+// buffer and decodes them back when the buffer is read. The codec is only
+// invoked with the owning buffer's lock held.
+template<typename TraceEntryT>
+class TraceEntryCodec {
+public:
+    virtual ~TraceEntryCodec() {
+    }
+    // Returns the encoded length, or 0 if the entry cannot be encoded
+    // within buf_len bytes
+    virtual size_t Encode(TraceEntryT *entry, uint8_t *buf,
+                          size_t buf_len) = 0;
+    // Returns a newly allocated entry, or NULL on failure
+    virtual TraceEntryT *Decode(const uint8_t *buf, size_t buf_len) = 0;
+    // Called whenever the arena of the buffer is (re)allocated, so that
+    // the codec can record its entry types in a persistent arena
+    virtual void SetArena(TraceArena *arena) {
+    }
+};
+
+//
+// Rings of the per-thread trace buffers. A single process wide thread key
+// maps each writer thread to its ring in every buffer it writes to, so the
+// number of buffers is not bounded by PTHREAD_KEYS_MAX. When a writer
+// thread exits, its rings are handed back to the buffers that are still
+// registered.
+//
+class TraceThreadRings {
+public:
+    typedef void (*ReleaseFn)(void *buffer, void *ring);
+
+    // Returns the id of the buffer, or 0 if the thread key could not be
+    // created
+    static uint64_t Register(void *buffer, ReleaseFn release);
+    // Threads exiting after this no longer release their ring to the buffer
+    static void Unregister(uint64_t id);
+    // Ring of the calling thread in the buffer, NULL if it has none
+    static void *Lookup(uint64_t id);
+    // Returns false if the ring could not be recorded for the thread
+    static bool Insert(uint64_t id, void *ring);
+
+private:
+    static void Init();
+    static void ReleaseThread(void *arg);
+};
+
+//
+// TraceBuffer supports three storage modes:
+//
+// Shared (default): a single circular buffer protected by mutex_.
+//
+// Binary: same as shared, but instead of keeping one heap object per entry,
+// TraceWrite serializes the entry through a TraceEntryCodec into a
+// pre-allocated arena of fixed size slots, and entries are only decoded
+// when the buffer is read. Entries that do not fit in a slot are kept as
+// objects. If a file path is given, the arena is a shared mapping of that
+// file so the encoded traces survive a crash of the process.
+//
+// Per-thread: every writer thread appends to its own fixed size ring of
+// trace_buf_size_ slots without taking any lock. Each entry is tagged with
+// a buffer wide write sequence number and TraceRead merges the rings in
+// sequence order. The reader temporarily borrows the records out of the
+// slots, so a writer that wraps around onto a borrowed slot leaves the old
+// record for the reader to free instead of deleting it underneath it.
+// When a writer thread exits, its ring keeps its entries and is handed to
+// the next new writer thread, so the number of rings is bounded by the
+// number of concurrent writers rather than by the threads ever created.
+// If the rings can not be tracked per thread, the buffer is shared.
+//
 template<typename TraceEntryT>
 class TraceBuffer {
 public:
-    TraceBuffer(const std::string& buf_name, size_t size, bool trace_enable)
+    TraceBuffer(const std::string& buf_name, size_t size, bool trace_enable,
+                bool per_thread = false)
+        : trace_buf_name_(buf_name),
+          trace_buf_size_(size),
+          trace_buf_(per_thread ? 0 : trace_buf_size_),
+          write_index_(0),
+          read_index_(0),
+          wrap_(false),
+          per_thread_(per_thread),
+          ring_size_(size),
+          ring_id_(0),
+          slot_size_(0) {
+        seqno_ = 0;
+        write_seqno_ = 0;
+        trace_enable_ = trace_enable;
+        if (per_thread_) {
+            ring_id_ = TraceThreadRings::Register(this,
+                                                  &TraceBuffer::ReleaseRing);
+            if (ring_id_ == 0) {
+                per_thread_ = false;
+                trace_buf_.rset_capacity(trace_buf_size_);
+            }
+        }
+    }
+
+    TraceBuffer(const std::string& buf_name, size_t size, bool trace_enable,
+                boost::shared_ptr<TraceEntryCodec<TraceEntryT> > codec,
+                size_t slot_size, const std::string &file_path = "")
         : trace_buf_name_(buf_name),
           trace_buf_size_(size),
-          trace_buf_(trace_buf_size_),
+          trace_buf_(0),
           write_index_(0),
           read_index_(0),
-          wrap_(false) {
+          wrap_(false),
+          per_thread_(false),
+          ring_size_(0),
+          ring_id_(0),
+          codec_(codec),
+          slot_size_(slot_size),
+          file_path_(file_path) {
         seqno_ = 0;
+        write_seqno_ = 0;
         trace_enable_ = trace_enable;
+        AllocArena(true);
     }
 
+    // Once the buffer is unregistered, the threads that are still alive no
+    // longer release their rings, which are freed with the buffer.
     ~TraceBuffer() {
+        if (per_thread_) {
+            TraceThreadRings::Unregister(ring_id_);
+        }
         read_context_map_.clear();
         trace_buf_.clear();
+        FreeArena();
     }
 
     std::string Name() {
@@ -55,20 +179,89 @@ public:
     }
 
     size_t TraceBufCapacityGet() {
+        if (per_thread_ || codec_) {
+            return trace_buf_size_;
+        }
         return trace_buf_.capacity();
     }
 
+    bool IsPerThread() const {
+        return per_thread_;
+    }
+
+    bool IsBinary() const {
+        return codec_.get() != NULL;
+    }
+
+    bool IsPersistent() const {
+        return arena_.mapped();
+    }
+
+    // Approximate memory held by the buffer and its entries
+    size_t TraceBufMemoryGet() {
+        tbb::mutex::scoped_lock lock(mutex_);
+        size_t memory = 0;
+        if (codec_) {
+            memory = trace_buf_size_ * (SlotStride() + sizeof(TraceEntryT *));
+            for (size_t i = 0; i < trace_buf_size_; i++) {
+                if (slot_entry_[i]) {
+                    memory += TraceEntryMemory(slot_entry_[i]);
+                }
+            }
+        } else if (per_thread_) {
+            std::vector<BorrowedRecord> records;
+            size_t rings = BorrowRecords(&records);
+            memory = rings * ring_size_ * sizeof(TraceSlot);
+            for (typename std::vector<BorrowedRecord>::iterator it =
+                 records.begin(); it != records.end(); ++it) {
+                memory += sizeof(TraceRecord) +
+                    TraceEntryMemory(it->record->entry);
+            }
+            ReturnRecords(records);
+        } else {
+            memory = trace_buf_.capacity() * sizeof(void *);
+            for (typename ContainerType::iterator it = trace_buf_.begin();
+                 it != trace_buf_.end(); ++it) {
+                memory += TraceEntryMemory(&(*it));
+            }
+        }
+        return memory;
+    }
 
+    // In per-thread mode the rings cannot be resized underneath the
+    // writers, so the new size only bounds the number of (most recent)
+    // entries returned by TraceRead.
+    // In binary mode the arena is reallocated and the most recent entries
+    // that fit in the new size are kept.
     void TraceBufCapacityReset(size_t size) {
+        if (per_thread_) {
+            tbb::mutex::scoped_lock lock(mutex_);
+            trace_buf_size_ = size;
+            return;
+        }
+        if (codec_) {
+            tbb::mutex::scoped_lock lock(mutex_);
+            ResizeArena(size);
+            return;
+        }
         trace_buf_.rset_capacity(size);
         trace_buf_size_ = size;
     }
 
     void TraceWrite(TraceEntryT *trace_entry) {
+        if (per_thread_) {
+            TraceWritePerThread(trace_entry);
+            return;
+        }
+
         tbb::mutex::scoped_lock lock(mutex_);
 
         // Add the trace
-        trace_buf_.push_back(trace_entry);
+        if (codec_) {
+            TraceStoreBinary(trace_entry);
+        } else {
+            trace_buf_.push_back(trace_entry);
+        }
 
         // Once the trace buffer is wrapped, increment the read index
         if (wrap_) {
@@ -114,6 +307,14 @@ public:
     void TraceRead(const std::string& context, const int count,
             boost::function<void (TraceEntryT *, bool)> cb) {
         tbb::mutex::scoped_lock lock(mutex_);
+        if (per_thread_) {
+            TraceReadPerThread(context, count, cb);
+            return;
+        }
+        if (codec_) {
+            TraceReadBinary(context, count, cb);
+            return;
+        }
         if (trace_buf_.empty()) {
             // No message in the trace buffer
             return;
@@ -168,6 +369,310 @@ private:
     typedef std::map<const std::string, boost::shared_ptr<size_t> >
         ReadContextMap;
 
+    struct TraceRecord {
+        TraceRecord() : seqno(0), entry(NULL) {
+        }
+        ~TraceRecord() {
+            delete entry;
+        }
+        uint64_t seqno;
+        TraceEntryT *entry;
+    };
+    typedef tbb::atomic<TraceRecord *> TraceSlot;
+
+    // write_index and spare are only touched by the owning writer thread
+    struct ThreadRing {
+        explicit ThreadRing(size_t ring_size)
+            : slots(new TraceSlot[ring_size]),
+              size(ring_size),
+              write_index(0),
+              spare(NULL) {
+            for (size_t i = 0; i < size; i++) {
+                slots[i] = NULL;
+            }
+        }
+        ~ThreadRing() {
+            for (size_t i = 0; i < size; i++) {
+                delete slots[i].fetch_and_store(NULL);
+            }
+            delete spare;
+        }
+        boost::scoped_array<TraceSlot> slots;
+        size_t size;
+        size_t write_index;
+        TraceRecord *spare;
+    };
+
+    struct BorrowedRecord {
+        BorrowedRecord(TraceSlot *s, TraceRecord *r) : slot(s), record(r) {
+        }
+        static bool SeqnoLess(const BorrowedRecord &lhs,
+                              const BorrowedRecord &rhs) {
+            return lhs.record->seqno < rhs.record->seqno;
+        }
+        TraceSlot *slot;
+        TraceRecord *record;
+    };
+
+    // Returns NULL if the ring could not be recorded for the thread
+    ThreadRing *LocalRing() {
+        ThreadRing *ring =
+            static_cast<ThreadRing *>(TraceThreadRings::Lookup(ring_id_));
+        if (ring == NULL) {
+            {
+                tbb::mutex::scoped_lock lock(ring_list_mutex_);
+                if (free_rings_.empty()) {
+                    ring = new ThreadRing(ring_size_);
+                    ring_list_.push_back(ring);
+                } else {
+                    ring = free_rings_.back();
+                    free_rings_.pop_back();
+                }
+            }
+            // Not under ring_list_mutex_, which is taken by the thread exit
+            // hooks while the rings are tracked
+            if (!TraceThreadRings::Insert(ring_id_, ring)) {
+                tbb::mutex::scoped_lock lock(ring_list_mutex_);
+                free_rings_.push_back(ring);
+                return NULL;
+            }
+        }
+        return ring;
+    }
+
+    // Thread exit hook of the buffer. The ring stays readable and is
+    // recycled by the next thread that writes to the buffer.
+    static void ReleaseRing(void *arg, void *ring_arg) {
+        TraceBuffer *buffer = static_cast<TraceBuffer *>(arg);
+        ThreadRing *ring = static_cast<ThreadRing *>(ring_arg);
+        tbb::mutex::scoped_lock lock(buffer->ring_list_mutex_);
+        buffer->free_rings_.push_back(ring);
+    }
+
+    void TraceWritePerThread(TraceEntryT *trace_entry) {
+        ThreadRing *ring = LocalRing();
+        if (ring == NULL) {
+            delete trace_entry;
+            return;
+        }
+        TraceRecord *record = ring->spare;
+        ring->spare = NULL;
+        if (record == NULL) {
+            record = new TraceRecord;
+        }
+        record->seqno = write_seqno_.fetch_and_increment();
+        record->entry = trace_entry;
+        TraceRecord *old =
+            ring->slots[ring->write_index].fetch_and_store(record);
+        if (++ring->write_index == ring->size) {
+            ring->write_index = 0;
+        }
+        // A NULL slot is either unused or currently borrowed by a reader,
+        // in which case the reader frees the record it holds.
+        if (old) {
+            delete old->entry;
+            old->entry = NULL;
+            ring->spare = old;
+        }
+    }
+
+    // Called with mutex_ held, which serializes the readers.
+    // Returns the number of rings.
+    size_t BorrowRecords(std::vector<BorrowedRecord> *records) {
+        tbb::mutex::scoped_lock lock(ring_list_mutex_);
+        for (typename RingList::iterator it = ring_list_.begin();
+             it != ring_list_.end(); ++it) {
+            for (size_t i = 0; i < it->size; i++) {
+                TraceRecord *record = it->slots[i].fetch_and_store(NULL);
+                if (record) {
+                    records->push_back(BorrowedRecord(&it->slots[i], record));
+                }
+            }
+        }
+        return ring_list_.size();
+    }
+
+    // Return the records, unless the writer has already reused the slot
+    void ReturnRecords(const std::vector<BorrowedRecord> &records) {
+        for (typename std::vector<BorrowedRecord>::const_iterator it =
+             records.begin(); it != records.end(); ++it) {
+            if (it->slot->compare_and_swap(it->record, NULL) != NULL) {
+                delete it->record;
+            }
+        }
+    }
+
+    // Called with mutex_ held, which serializes the readers.
+    // The read context stores the sequence number of the next entry to read.
+    void TraceReadPerThread(const std::string& context, const int count,
+            boost::function<void (TraceEntryT *, bool)> cb) {
+        std::vector<BorrowedRecord> records;
+        BorrowRecords(&records);
+        if (records.empty()) {
+            // No message in the trace buffer
+            return;
+        }
+        std::sort(records.begin(), records.end(), BorrowedRecord::SeqnoLess);
+
+        // Only the most recent trace_buf_size_ entries are visible
+        size_t first = records.size() > trace_buf_size_ ?
+            records.size() - trace_buf_size_ : 0;
+        size_t *next_seqno_ptr;
+        ReadContextMap::iterator context_it =
+            read_context_map_.find(context);
+        if (context_it != read_context_map_.end()) {
+            next_seqno_ptr = context_it->second.get();
+            while (first < records.size() &&
+                   records[first].record->seqno < *next_seqno_ptr) {
+                first++;
+            }
+        } else {
+            boost::shared_ptr<size_t> read_context(new size_t(0));
+            next_seqno_ptr = read_context.get();
+            read_context_map_.insert(std::make_pair(context, read_context));
+        }
+
+        size_t cnt = count ? count : records.size();
+        for (size_t i = first, n = 0; i < records.size() && n < cnt;
+             i++, n++) {
+            cb(records[i].record->entry, i + 1 != records.size());
+            *next_seqno_ptr = records[i].record->seqno + 1;
+        }
+        ReturnRecords(records);
+    }
+
+    // Slot header plus slot_size_ bytes of data, 8 byte aligned
+    size_t SlotStride() const {
+        return (sizeof(TraceSlotHeader) + slot_size_ + 7) & ~7UL;
+    }
+
+    // If the file cannot be mapped (the arena logs why), the arena falls
+    // back to heap memory and the buffer is no longer persistent, also
+    // across later resizes.
+    void AllocArena(bool keep_previous) {
+        if (!arena_.Alloc(trace_buf_name_, SlotStride(), trace_buf_size_,
+                          file_path_, keep_previous)) {
+            file_path_.clear();
+        }
+        slot_entry_.reset(new TraceEntryT *[trace_buf_size_]());
+        codec_->SetArena(&arena_);
+    }
+
+    // Called with mutex_ held. Moves the most recent entries, oldest first,
+    // to the start of a new arena of the given size.
+    void ResizeArena(size_t size) {
+        size_t entries = wrap_ ? trace_buf_size_ : write_index_;
+        size_t keep = std::min(entries, size);
+        size_t first = (wrap_ ? write_index_ : 0) + entries - keep;
+        size_t stride = SlotStride();
+        std::vector<uint8_t> slots(keep * stride);
+        std::vector<TraceEntryT *> slot_entries(keep);
+        for (size_t i = 0; i < keep; i++) {
+            size_t slot = (first + i) % trace_buf_size_;
+            const uint8_t *data = arena_.Slot(slot);
+            std::copy(data, data + stride, slots.begin() + i * stride);
+            slot_entries[i] = slot_entry_[slot];
+            slot_entry_[slot] = NULL;
+        }
+
+        FreeArena();
+        trace_buf_size_ = size;
+        AllocArena(false);
+        for (size_t i = 0; i < keep; i++) {
+            std::copy(slots.begin() + i * stride,
+                      slots.begin() + (i + 1) * stride, arena_.Slot(i));
+            slot_entry_[i] = slot_entries[i];
+        }
+        wrap_ = keep == size;
+        write_index_ = wrap_ ? 0 : keep;
+        read_index_ = 0;
+        read_context_map_.clear();
+    }
+
+    void FreeArena() {
+        if (!slot_entry_) {
+            return;
+        }
+        for (size_t i = 0; i < trace_buf_size_; i++) {
+            delete slot_entry_[i];
+            slot_entry_[i] = NULL;
+        }
+        arena_.Free();
+    }
+
+    // Called with mutex_ held, stores the entry at write_index_.
+    // The slot length is cleared while the slot is rewritten so that a
+    // persistent buffer never shows a partially written entry after a crash.
+    void TraceStoreBinary(TraceEntryT *trace_entry) {
+        size_t slot = write_index_;
+        delete slot_entry_[slot];
+        slot_entry_[slot] = NULL;
+        TraceSlotHeader *header = arena_.SlotHeader(slot);
+        header->len.fetch_and_store(0);
+        size_t len = codec_->Encode(trace_entry, arena_.SlotData(slot),
+                                    slot_size_);
+        header->seqno = write_seqno_.fetch_and_increment() + 1;
+        header->len.store<tbb::release>(len);
+        if (len) {
+            delete trace_entry;
+        } else {
+            slot_entry_[slot] = trace_entry;
+        }
+    }
+
+    // Called with mutex_ held. Uses the same read context semantics as the
+    // shared mode, with the read index pointing to an arena slot.
+    void TraceReadBinary(const std::string& context, const int count,
+            boost::function<void (TraceEntryT *, bool)> cb) {
+        size_t entries = wrap_ ? trace_buf_size_ : write_index_;
+        if (entries == 0) {
+            // No message in the trace buffer
+            return;
+        }
+
+        size_t cnt = count ? count : entries;
+        size_t offset = 0;
+        size_t *read_index_ptr;
+        ReadContextMap::iterator context_it =
+            read_context_map_.find(context);
+        if (context_it != read_context_map_.end()) {
+            read_index_ptr = context_it->second.get();
+            offset = (*read_index_ptr + trace_buf_size_ - read_index_) %
+                trace_buf_size_;
+            // The read context is at the oldest entry only after the
+            // whole buffer has been read
+            if (offset == 0) {
+                offset = entries;
+            }
+        } else {
+            boost::shared_ptr<size_t> read_context(new size_t(read_index_));
+            read_index_ptr = read_context.get();
+            read_context_map_.insert(std::make_pair(context, read_context));
+        }
+
+        size_t i;
+        for (i = 0; (offset + i < entries) && (i < cnt); i++) {
+            size_t slot = (read_index_ + offset + i) % trace_buf_size_;
+            bool more = offset + i + 1 < entries;
+            if (slot_entry_[slot]) {
+                cb(slot_entry_[slot], more);
+                continue;
+            }
+            std::auto_ptr<TraceEntryT> entry(codec_->Decode(
+                arena_.SlotData(slot), arena_.SlotHeader(slot)->len));
+            if (entry.get()) {
+                cb(entry.get(), more);
+            }
+        }
+
+        // Update the read index in the read context
+        size_t index = *read_index_ptr + i;
+        *read_index_ptr = index >= trace_buf_size_ ?
+            index - trace_buf_size_ : index;
+    }
+
+    typedef boost::ptr_vector<ThreadRing> RingList;
+
     std::string trace_buf_name_;
     size_t trace_buf_size_;
     ContainerType trace_buf_;
@@ -180,6 +685,19 @@ private:
     ReadContextMap read_context_map_; // stores the read context
     tbb::atomic<uint32_t> seqno_;
     tbb::mutex mutex_;
+    bool per_thread_;
+    size_t ring_size_;
+    uint64_t ring_id_;
+    RingList ring_list_;
+    std::vector<ThreadRing *> free_rings_; // rings of exited threads
+    tbb::mutex ring_list_mutex_;
+    tbb::atomic<uint64_t> write_seqno_;
+    boost::shared_ptr<TraceEntryCodec<TraceEntryT> > codec_;
+    size_t slot_size_;
+    std::string file_path_;
+    TraceArena arena_;
+    boost::scoped_array<TraceEntryT *> slot_entry_; // entries too large
+                                                    // for a slot
 
     // Reserve 0 and max(uint32_t)
     static const uint32_t kMaxSeqno = ((2 ^ 32) - 1) - 1;
@@ -251,7 +769,7 @@ public:
     }
 
     boost::shared_ptr<TraceBuffer<TraceEntryT> > TraceBufAdd(const std::string& buf_name, size_t size,
-                     bool trace_enable) {
+                     bool trace_enable, bool per_thread = false) {
         // should we have a default size for the buffer?
         if (!size) {
             return boost::shared_ptr<TraceBuffer<TraceEntryT> >();
@@ -260,7 +778,28 @@ public:
         typename TraceBufMap::iterator it = trace_buf_map_.find(buf_name);
         if (it == trace_buf_map_.end()) {
             boost::shared_ptr<TraceBuffer<TraceEntryT> > trace_buf(
-                new TraceBuffer<TraceEntryT>(buf_name, size, trace_enable),
+                new TraceBuffer<TraceEntryT>(buf_name, size, trace_enable,
+                                             per_thread),
+                TraceBufferDeleter<TraceEntryT>(trace_buf_map_, mutex_));
+            trace_buf_map_.insert(std::make_pair(buf_name, trace_buf));
+            return trace_buf;
+        }
+        return it->second.lock();
+    }
+
+    boost::shared_ptr<TraceBuffer<TraceEntryT> > TraceBufAddBinary(
+            const std::string& buf_name, size_t size, bool trace_enable,
+            boost::shared_ptr<TraceEntryCodec<TraceEntryT> > codec,
+            size_t slot_size, const std::string &file_path = "") {
+        if (!size || !slot_size) {
+            return boost::shared_ptr<TraceBuffer<TraceEntryT> >();
+        }
+        tbb::mutex::scoped_lock lock(mutex_);
+        typename TraceBufMap::iterator it = trace_buf_map_.find(buf_name);
+        if (it == trace_buf_map_.end()) {
+            boost::shared_ptr<TraceBuffer<TraceEntryT> > trace_buf(
+                new TraceBuffer<TraceEntryT>(buf_name, size, trace_enable,
+                                             codec, slot_size, file_path),
                 TraceBufferDeleter<TraceEntryT>(trace_buf_map_, mutex_));
             trace_buf_map_.insert(std::make_pair(buf_name, trace_buf));
             return trace_buf;
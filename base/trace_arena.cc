@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2026 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/trace_arena.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "base/logging.h"
+
+const char TraceArena::kFileMagic[8] = {
+    'C', 'T', 'R', 'A', 'C', 'E', '0', '1'
+};
+const uint32_t TraceArena::kFileVersion;
+const uint32_t TraceArena::kTypeCount;
+const uint32_t TraceArena::kTypeNameSize;
+
+TraceArena::TraceArena()
+    : base_(NULL), size_(0), slots_(NULL), slot_size_(0), mapped_(false) {
+}
+
+TraceArena::~TraceArena() {
+    Free();
+}
+
+bool TraceArena::Alloc(const std::string &name, size_t slot_size,
+                       size_t slot_count, const std::string &path,
+                       bool keep_previous) {
+    Free();
+    slot_size_ = slot_size;
+    if (!path.empty() && Map(name, slot_count, path, keep_previous)) {
+        return true;
+    }
+    size_ = slot_size_ * slot_count;
+    base_ = new uint8_t[size_]();
+    slots_ = base_;
+    return path.empty();
+}
+
+void TraceArena::Free() {
+    if (base_ == NULL) {
+        return;
+    }
+    if (mapped_) {
+        munmap(base_, size_);
+    } else {
+        delete [] base_;
+    }
+    base_ = NULL;
+    slots_ = NULL;
+    size_ = 0;
+    mapped_ = false;
+}
+
+bool TraceArena::SetTypeName(size_t index, const std::string &type_name) {
+    if (!mapped_ || index >= kTypeCount) {
+        return false;
+    }
+    const TraceFileHeader *header =
+        reinterpret_cast<const TraceFileHeader *>(base_);
+    char *name = reinterpret_cast<char *>(base_ + header->type_table_offset +
+                                          index * kTypeNameSize);
+    memset(name, 0, kTypeNameSize);
+    strncpy(name, type_name.c_str(), kTypeNameSize - 1);
+    return true;
+}
+
+bool TraceArena::Map(const std::string &name, size_t slot_count,
+                     const std::string &path, bool keep_previous) {
+    // Keep the traces of the previous incarnation of the process
+    if (keep_previous) {
+        std::string prev_path(path + ".prev");
+        if (rename(path.c_str(), prev_path.c_str()) != 0 &&
+            errno != ENOENT) {
+            LOG(ERROR, "Trace buffer " << name << ": rename " << path <<
+                " FAILED: " << strerror(errno));
+        }
+    }
+
+    size_t header_size = sizeof(TraceFileHeader) + kTypeCount * kTypeNameSize;
+    size_t size = header_size + slot_size_ * slot_count;
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG(ERROR, "Trace buffer " << name << ": open " << path <<
+            " FAILED: " << strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, size) != 0) {
+        LOG(ERROR, "Trace buffer " << name << ": truncate " << path <<
+            " FAILED: " << strerror(errno));
+        close(fd);
+        return false;
+    }
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        LOG(ERROR, "Trace buffer " << name << ": mmap " << path <<
+            " FAILED: " << strerror(errno));
+        return false;
+    }
+
+    // The file is zero filled by ftruncate
+    base_ = static_cast<uint8_t *>(base);
+    size_ = size;
+    slots_ = base_ + header_size;
+    mapped_ = true;
+
+    TraceFileHeader *header = reinterpret_cast<TraceFileHeader *>(base_);
+    memcpy(header->magic, kFileMagic, sizeof(header->magic));
+    header->version = kFileVersion;
+    header->header_size = header_size;
+    header->slot_size = slot_size_;
+    header->slot_count = slot_count;
+    strncpy(header->name, name.c_str(), sizeof(header->name) - 1);
+    header->type_table_offset = sizeof(TraceFileHeader);
+    header->type_count = kTypeCount;
+    header->type_name_size = kTypeNameSize;
+    return true;
+}
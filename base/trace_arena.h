@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __TRACE_ARENA_H__
+#define __TRACE_ARENA_H__
+
+#include <stdint.h>
+#include <string>
+#include <tbb/atomic.h>
+#include "base/util.h"
+
+//
+// Layout of a persistent trace buffer file: a TraceFileHeader, a table of
+// type_count entry type names of type_name_size bytes, then slot_count
+// slots of slot_size bytes, each starting with a TraceSlotHeader and
+// followed by the encoded entry. All fields are in host byte order.
+// The type names are recorded by the codec of the buffer, so that an
+// offline tool can map the type index of an encoded entry to its type.
+//
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;   // offset of the first slot
+    uint32_t slot_size;     // bytes per slot, including the TraceSlotHeader
+    uint32_t slot_count;
+    char name[64];          // trace buffer name, NUL terminated
+    uint32_t type_table_offset;
+    uint32_t type_count;
+    uint32_t type_name_size;    // bytes per type name, NUL terminated
+    uint32_t reserved;
+};
+
+// seqno is 0 if the slot was never written. len is 0 while the slot is
+// being written, or if the entry did not fit in the slot. len is stored
+// last with release semantics, so the seqno and the encoded entry are in
+// the file before a non zero len.
+struct TraceSlotHeader {
+    uint64_t seqno;
+    tbb::atomic<uint32_t> len;
+    uint32_t reserved;
+};
+
+//
+// Backing memory for the slots of a binary trace buffer: either heap
+// memory or a shared mapping of a file, so that the traces survive the
+// death of the process and can be read by an offline tool. Once allocated,
+// writing to the slots is plain memory access.
+//
+class TraceArena {
+public:
+    static const char kFileMagic[8];
+    static const uint32_t kFileVersion = 2;
+    static const uint32_t kTypeCount = 256;
+    static const uint32_t kTypeNameSize = 64;
+
+    TraceArena();
+    ~TraceArena();
+
+    // Allocates zeroed slots, returns false if the file could not be
+    // mapped in which case heap memory is used. If keep_previous is set,
+    // an existing file is first renamed to <path>.prev.
+    bool Alloc(const std::string &name, size_t slot_size, size_t slot_count,
+               const std::string &path, bool keep_previous);
+    void Free();
+    // Records the name of the entry type with the given index in the file.
+    // Returns false if the arena is not a file or the index is out of the
+    // type table.
+    bool SetTypeName(size_t index, const std::string &type_name);
+
+    uint8_t *Slot(size_t index) { return slots_ + index * slot_size_; }
+    TraceSlotHeader *SlotHeader(size_t index) {
+        return reinterpret_cast<TraceSlotHeader *>(Slot(index));
+    }
+    uint8_t *SlotData(size_t index) {
+        return Slot(index) + sizeof(TraceSlotHeader);
+    }
+    bool mapped() const { return mapped_; }
+    size_t size() const { return size_; }
+
+private:
+    bool Map(const std::string &name, size_t slot_count,
+             const std::string &path, bool keep_previous);
+
+    uint8_t *base_;
+    size_t size_;
+    uint8_t *slots_;
+    size_t slot_size_;
+    bool mapped_;
+
+    DISALLOW_COPY_AND_ASSIGN(TraceArena);
+};
+
+#endif // __TRACE_ARENA_H__
@@ -3,9 +3,12 @@
 //
 
 #include <assert.h>
+#include <algorithm>
 #include <fstream>
+#include <limits>
 
 #include <tbb/atomic.h>
+#include <tbb/compat/condition_variable>
 #include <boost/foreach.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/join.hpp>
@@ -18,6 +21,7 @@
 #include <base/misc_utils.h>
 #include <base/task.h>
 #include <base/timer.h>
+#include <base/time_util.h>
 #include <base/string_util.h>
 #include <base/address_util.h>
 #include <io/event_manager.h>
@@ -277,53 +281,60 @@ class CassQueryPrinter : public boost::static_visitor<> {
 //
 // CassStatement bind
 //
-class CassStatementIndexBinder : public boost::static_visitor<> {
+
+// Returns false if the value can not be bound, the statement must not be
+// executed then
+class CassStatementIndexBinder : public boost::static_visitor<bool> {
  public:
     CassStatementIndexBinder(interface::CassLibrary *cci,
         CassStatement *statement) :
         cci_(cci),
         statement_(statement) {
     }
-    void operator()(const boost::blank &tblank, size_t index) const {
-        assert(false && "CassStatement bind to boost::blank not supported");
+    bool operator()(const boost::blank &tblank, size_t index) const {
+        return false;
     }
-    void operator()(const std::string &tstring, size_t index) const {
+    bool operator()(const std::string &tstring, size_t index) const {
         CassError rc(cci_->CassStatementBindStringN(statement_, index,
             tstring.c_str(), tstring.length()));
-        assert(rc == CASS_OK);
+        return rc == CASS_OK;
     }
-    void operator()(const boost::uuids::uuid &tuuid, size_t index) const {
+    bool operator()(const boost::uuids::uuid &tuuid, size_t index) const {
         CassUuid cuuid;
         decode_uuid((char *)&tuuid, &cuuid);
         CassError rc(cci_->CassStatementBindUuid(statement_, index, cuuid));
-        assert(rc == CASS_OK);
+        return rc == CASS_OK;
     }
-    void operator()(const uint8_t &tu8, size_t index) const {
+    bool operator()(const uint8_t &tu8, size_t index) const {
         CassError rc(cci_->CassStatementBindInt32(statement_, index, tu8));
-        assert(rc == CASS_OK);
+        return rc == CASS_OK;
     }
-    void operator()(const uint16_t &tu16, size_t index) const {
+    bool operator()(const uint16_t &tu16, size_t index) const {
         CassError rc(cci_->CassStatementBindInt32(statement_, index, tu16));
-        assert(rc == CASS_OK);
+        return rc == CASS_OK;
     }
-    void operator()(const uint32_t &tu32, size_t index) const {
-        assert(tu32 <= (uint32_t)std::numeric_limits<int32_t>::max());
+    bool operator()(const uint32_t &tu32, size_t index) const {
+        if (tu32 > (uint32_t)std::numeric_limits<int32_t>::max()) {
+            return false;
+        }
         CassError rc(cci_->CassStatementBindInt32(statement_, index,
             (cass_int32_t)tu32));
-        assert(rc == CASS_OK);
+        return rc == CASS_OK;
     }
-    void operator()(const uint64_t &tu64, size_t index) const {
-        assert(tu64 <= (uint64_t)std::numeric_limits<int64_t>::max());
+    bool operator()(const uint64_t &tu64, size_t index) const {
+        if (tu64 > (uint64_t)std::numeric_limits<int64_t>::max()) {
+            return false;
+        }
         CassError rc(cci_->CassStatementBindInt64(statement_, index,
             (cass_int64_t)tu64));
-        assert(rc == CASS_OK);
+        return rc == CASS_OK;
     }
-    void operator()(const double &tdouble, size_t index) const {
+    bool operator()(const double &tdouble, size_t index) const {
         CassError rc(cci_->CassStatementBindDouble(statement_, index,
             (cass_double_t)tdouble));
-        assert(rc == CASS_OK);
+        return rc == CASS_OK;
     }
-    void operator()(const IpAddress &tipaddr, size_t index) const {
+    bool operator()(const IpAddress &tipaddr, size_t index) const {
         CassInet cinet;
         if (tipaddr.is_v4()) {
             boost::asio::ip::address_v4 tv4(tipaddr.to_v4());
@@ -334,12 +345,12 @@ class CassStatementIndexBinder : public boost::static_visitor<> {
         }
         CassError rc(cci_->CassStatementBindInet(statement_, index,
             cinet));
-        assert(rc == CASS_OK);
+        return rc == CASS_OK;
     }
-    void operator()(const GenDb::Blob &tblob, size_t index) const {
+    bool operator()(const GenDb::Blob &tblob, size_t index) const {
         CassError rc(cci_->CassStatementBindBytes(statement_, index,
             tblob.data(), tblob.size()));
-        assert(rc == CASS_OK);
+        return rc == CASS_OK;
     }
     interface::CassLibrary *cci_;
     CassStatement *statement_;
@@ -861,7 +872,10 @@ bool DynamicCf2CassPrepareBind(interface::CassLibrary *cci,
     int rk_size(rkeys.size());
     size_t idx(0);
     for (; (int) idx < rk_size; idx++) {
-        boost::apply_visitor(boost::bind(values_binder, _1, idx), rkeys[idx]);
+        if (!boost::apply_visitor(boost::bind(values_binder, _1, idx),
+                rkeys[idx])) {
+            return false;
+        }
     }
     // Columns
     const GenDb::NewColVec &columns(v_columns->columns_);
@@ -872,25 +886,328 @@ bool DynamicCf2CassPrepareBind(interface::CassLibrary *cci,
     const GenDb::DbDataValueVec &cnames(*column.name.get());
     int cn_size(cnames.size());
     for (int i = 0; i < cn_size; i++, idx++) {
-        boost::apply_visitor(boost::bind(values_binder, _1, idx), cnames[i]);
+        if (!boost::apply_visitor(boost::bind(values_binder, _1, idx),
+                cnames[i])) {
+            return false;
+        }
     }
     // Column Values
     const GenDb::DbDataValueVec &cvalues(*column.value.get());
     if (cvalues.size() > 0) {
-        boost::apply_visitor(boost::bind(values_binder, _1, idx++),
-            cvalues[0]);
+        if (!boost::apply_visitor(boost::bind(values_binder, _1, idx++),
+                cvalues[0])) {
+            return false;
+        }
     }
     CassError rc(cci->CassStatementBindInt32(statement, idx++,
         (cass_int32_t)column.ttl));
-    assert(rc == CASS_OK);
+    return rc == CASS_OK;
+}
+
+//
+// CassInsertPlan
+//
+CassInsertPlan::CassInsertPlan(const GenDb::NewCf &cf) :
+    is_static_(cf.cftype_ == GenDb::NewCf::COLUMN_FAMILY_SQL),
+    rk_count_(cf.partition_keys_.size()),
+    rk_types_(cf.partition_keys_),
+    value_index_(0) {
+    prefix_ = "INSERT INTO " + cf.cfname_ + " (";
+    for (size_t i = 0; i < rk_count_; i++) {
+        if (i) {
+            prefix_ += ", key" + integerToString(i + 1);
+        } else {
+            prefix_ += "key";
+        }
+    }
+    if (is_static_) {
+        BOOST_FOREACH(const GenDb::NewCf::ColumnMap::value_type &cfcolumn,
+            cf.cfcolumns_) {
+            column_index_.insert(std::make_pair(cfcolumn.first,
+                names_.size()));
+            names_.push_back(", \"" + cfcolumn.first + "\"");
+            types_.push_back(cfcolumn.second);
+        }
+        return;
+    }
+    types_ = cf.clustering_columns_;
+    types_.insert(types_.end(), cf.columns_.begin(), cf.columns_.end());
+    for (size_t i = 0; i < types_.size(); i++) {
+        names_.push_back(", column" + integerToString(i + 1));
+    }
+    value_index_ = names_.size();
+    if (!cf.value_.empty()) {
+        names_.push_back(", value");
+        types_.push_back(cf.value_[0]);
+    }
+}
+
+bool CassInsertPlan::GetStaticCfColumns(const GenDb::ColList *v_columns,
+    ColumnSet *columns, std::vector<const GenDb::DbDataValue *> *values,
+    int *ttl) const {
+    BOOST_FOREACH(const GenDb::NewCol &column, v_columns->columns_) {
+        const GenDb::DbDataValueVec &cnames(*column.name.get());
+        const GenDb::DbDataValueVec &cvalues(*column.value.get());
+        if (column.cftype_ != GenDb::NewCf::COLUMN_FAMILY_SQL ||
+            cnames.size() != 1 || cvalues.size() != 1 ||
+            cnames[0].which() != GenDb::DB_VALUE_STRING) {
+            return false;
+        }
+        ColumnIndexMap::const_iterator it(column_index_.find(
+            boost::get<std::string>(cnames[0])));
+        if (it == column_index_.end()) {
+            return false;
+        }
+        columns->push_back(it->second);
+        values->push_back(&cvalues[0]);
+        *ttl = column.ttl;
+    }
+    return true;
+}
+
+bool CassInsertPlan::GetDynamicCfColumns(const GenDb::ColList *v_columns,
+    ColumnSet *columns, std::vector<const GenDb::DbDataValue *> *values,
+    int *ttl) const {
+    if (v_columns->columns_.size() != 1) {
+        return false;
+    }
+    const GenDb::NewCol &column(v_columns->columns_[0]);
+    const GenDb::DbDataValueVec &cnames(*column.name.get());
+    const GenDb::DbDataValueVec &cvalues(*column.value.get());
+    if (column.cftype_ != GenDb::NewCf::COLUMN_FAMILY_NOSQL ||
+        cnames.size() > value_index_ ||
+        (!cvalues.empty() && value_index_ == names_.size())) {
+        return false;
+    }
+    // Blank column names are not inserted
+    for (size_t i = 0; i < cnames.size(); i++) {
+        if (cnames[i].which() != GenDb::DB_VALUE_BLANK) {
+            columns->push_back(i);
+            values->push_back(&cnames[i]);
+        }
+    }
+    if (!cvalues.empty()) {
+        columns->push_back(value_index_);
+        values->push_back(&cvalues[0]);
+    }
+    *ttl = column.ttl;
     return true;
 }
 
+const std::string *CassInsertPlan::LocateQuery(const ColumnSet &columns,
+    bool ttl) {
+    QueryKey key(columns, ttl);
+    tbb::mutex::scoped_lock lock(mutex_);
+    QueryMap::const_iterator it(queries_.find(key));
+    if (it != queries_.end()) {
+        return &it->second;
+    }
+    if (queries_.size() >= kMaxQueries) {
+        return NULL;
+    }
+    std::string query(prefix_);
+    BOOST_FOREACH(size_t column, columns) {
+        query += names_[column];
+    }
+    query += ") VALUES (?";
+    for (size_t i = 1; i < rk_count_ + columns.size(); i++) {
+        query += ", ?";
+    }
+    query += ")";
+    if (ttl) {
+        query += " USING TTL ?";
+    }
+    // The queries are not removed, and stay at the same address
+    return &queries_.insert(std::make_pair(key, query)).first->second;
+}
+
+static bool DbDataValueUnsigned(const GenDb::DbDataValue &value,
+    uint64_t *u64) {
+    switch (value.which()) {
+      case GenDb::DB_VALUE_UINT8:
+        *u64 = boost::get<uint8_t>(value);
+        return true;
+      case GenDb::DB_VALUE_UINT16:
+        *u64 = boost::get<uint16_t>(value);
+        return true;
+      case GenDb::DB_VALUE_UINT32:
+        *u64 = boost::get<uint32_t>(value);
+        return true;
+      case GenDb::DB_VALUE_UINT64:
+        *u64 = boost::get<uint64_t>(value);
+        return true;
+      default:
+        return false;
+    }
+}
+
+// Returns the value if it binds as the column type as is, else the value
+// converted into converted, or NULL if it does not convert
+static const GenDb::DbDataValue *DbDataValue2CassType(
+    GenDb::DbDataType::type db_type, const GenDb::DbDataValue &value,
+    GenDb::DbDataValue *converted) {
+    uint64_t u64;
+    switch (db_type) {
+      case GenDb::DbDataType::AsciiType:
+      case GenDb::DbDataType::UTF8Type:
+        return value.which() == GenDb::DB_VALUE_STRING ? &value : NULL;
+      case GenDb::DbDataType::LexicalUUIDType:
+      case GenDb::DbDataType::TimeUUIDType:
+        return value.which() == GenDb::DB_VALUE_UUID ? &value : NULL;
+      case GenDb::DbDataType::InetType:
+        return value.which() == GenDb::DB_VALUE_INET ? &value : NULL;
+      case GenDb::DbDataType::BlobType:
+        return value.which() == GenDb::DB_VALUE_BLOB ? &value : NULL;
+      case GenDb::DbDataType::Unsigned8Type:
+      case GenDb::DbDataType::Unsigned16Type:
+      case GenDb::DbDataType::Unsigned32Type:
+        // Bound as int
+        if (value.which() == GenDb::DB_VALUE_UINT8 ||
+            value.which() == GenDb::DB_VALUE_UINT16 ||
+            value.which() == GenDb::DB_VALUE_UINT32) {
+            return &value;
+        }
+        if (!DbDataValueUnsigned(value, &u64) ||
+            u64 > (uint64_t)std::numeric_limits<int32_t>::max()) {
+            return NULL;
+        }
+        *converted = static_cast<uint32_t>(u64);
+        return converted;
+      case GenDb::DbDataType::Unsigned64Type:
+        // Bound as bigint
+        if (value.which() == GenDb::DB_VALUE_UINT64) {
+            return &value;
+        }
+        if (!DbDataValueUnsigned(value, &u64)) {
+            return NULL;
+        }
+        *converted = u64;
+        return converted;
+      case GenDb::DbDataType::DoubleType:
+        if (value.which() == GenDb::DB_VALUE_DOUBLE) {
+            return &value;
+        }
+        if (!DbDataValueUnsigned(value, &u64)) {
+            return NULL;
+        }
+        *converted = static_cast<double>(u64);
+        return converted;
+      default:
+        // varint is printed
+        return NULL;
+    }
+}
+
+CassStatement *CassInsertPlan::NewStatement(interface::CassLibrary *cci,
+    const GenDb::ColList *v_columns) {
+    const GenDb::DbDataValueVec &rkeys(v_columns->rowkey_);
+    if (rk_count_ == 0 || rkeys.size() != rk_count_) {
+        return NULL;
+    }
+    ColumnSet columns;
+    std::vector<const GenDb::DbDataValue *> values;
+    columns.reserve(names_.size());
+    values.reserve(names_.size());
+    int ttl(-1);
+    bool success(is_static_ ?
+        GetStaticCfColumns(v_columns, &columns, &values, &ttl) :
+        GetDynamicCfColumns(v_columns, &columns, &values, &ttl));
+    if (!success) {
+        return NULL;
+    }
+    // Converted to the column types, the conversions that are needed are
+    // done again when binding
+    GenDb::DbDataValue converted;
+    for (size_t i = 0; i < rk_count_; i++) {
+        if (DbDataValue2CassType(rk_types_[i], rkeys[i], &converted) ==
+            NULL) {
+            return NULL;
+        }
+    }
+    for (size_t i = 0; i < values.size(); i++) {
+        if (DbDataValue2CassType(types_[columns[i]], *values[i],
+            &converted) == NULL) {
+            return NULL;
+        }
+    }
+    // TTL 0 does not expire, as no TTL does
+    bool set_ttl(ttl > 0);
+    const std::string *query(LocateQuery(columns, set_ttl));
+    if (query == NULL) {
+        return NULL;
+    }
+    CassStatement *statement(cci->CassStatementNew(query->c_str(),
+        rk_count_ + values.size() + (set_ttl ? 1 : 0)));
+    CassStatementIndexBinder values_binder(cci, statement);
+    bool bound(true);
+    size_t idx(0);
+    for (; bound && idx < rk_count_; idx++) {
+        bound = boost::apply_visitor(boost::bind(values_binder, _1, idx),
+            *DbDataValue2CassType(rk_types_[idx], rkeys[idx], &converted));
+    }
+    for (size_t i = 0; bound && i < values.size(); i++) {
+        bound = boost::apply_visitor(boost::bind(values_binder, _1, idx++),
+            *DbDataValue2CassType(types_[columns[i]], *values[i],
+                &converted));
+    }
+    if (bound && set_ttl) {
+        bound = cci->CassStatementBindInt32(statement, idx,
+            (cass_int32_t)ttl) == CASS_OK;
+    }
+    // The insert is executed as text
+    if (!bound) {
+        cci->CassStatementFree(statement);
+        return NULL;
+    }
+    return statement;
+}
+
+size_t CassInsertPlan::queries() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return queries_.size();
+}
+
+// Prints the value into the query, or a bind marker if the values are
+// returned for binding
+static void CassSelectValue(std::ostream &query,
+    const GenDb::DbDataValue &value, GenDb::DbDataValueVec *values) {
+    if (values) {
+        query << "?";
+        values->push_back(value);
+        return;
+    }
+    CassQueryPrinter cprinter(query);
+    boost::apply_visitor(cprinter, value);
+}
+
+static void CassSelectClusteringKey(std::ostream &query,
+    const GenDb::DbDataValueVec &ck, GenDb::Op::type op,
+    GenDb::DbDataValueVec *values) {
+    int ck_size(ck.size());
+    query << " AND (";
+    for (int i = 0; i < ck_size; i++) {
+        if (i) {
+            query << ", ";
+        }
+        int cnum(i + 1);
+        query << "column" << cnum;
+    }
+    query << ") " << GenDb::Op::ToString(op) << " (";
+    for (int i = 0; i < ck_size; i++) {
+        if (i) {
+            query << ", ";
+        }
+        CassSelectValue(query, ck[i], values);
+    }
+    query << ")";
+}
+
 static std::string CassSelectFromTableInternal(const std::string &table,
     const std::vector<GenDb::DbDataValueVec> &rkeys,
     const GenDb::ColumnNameRange &ck_range,
     const GenDb::FieldNamesToReadVec &read_vec,
-    const GenDb::WhereIndexInfoVec &where_vec) {
+    const GenDb::WhereIndexInfoVec &where_vec,
+    GenDb::DbDataValueVec *values = NULL) {
     std::ostringstream query;
     // Table
     if (read_vec.empty()) {
@@ -909,9 +1226,8 @@ static std::string CassSelectFromTableInternal(const std::string &table,
         query << " FROM " << table;
     }
     if (rkeys.size() == 1) {
-        GenDb::DbDataValueVec rkey = rkeys[0];
+        const GenDb::DbDataValueVec &rkey(rkeys[0]);
         int rk_size(rkey.size());
-        CassQueryPrinter cprinter(query);
         for (int i = 0; i < rk_size; i++) {
             if (i) {
                 int key_num(i + 1);
@@ -919,16 +1235,15 @@ static std::string CassSelectFromTableInternal(const std::string &table,
             } else {
                 query << " WHERE key=";
             }
-            boost::apply_visitor(cprinter, rkey[i]);
+            CassSelectValue(query, rkey[i], values);
         }
 
     } else if (rkeys.size() > 1) {
         query << " WHERE key IN (";
-        BOOST_FOREACH(GenDb::DbDataValueVec rkey, rkeys) {
+        BOOST_FOREACH(const GenDb::DbDataValueVec &rkey, rkeys) {
             int rk_size(rkey.size());
             assert(rk_size == 1);
-            CassQueryPrinter cprinter(query);
-            boost::apply_visitor(cprinter, rkey[0]);
+            CassSelectValue(query, rkey[0], values);
             query << ",";
         }
         query.seekp(-1, query.cur);
@@ -937,57 +1252,25 @@ static std::string CassSelectFromTableInternal(const std::string &table,
     if (!where_vec.empty()) {
         for (GenDb::WhereIndexInfoVec::const_iterator it = where_vec.begin();
             it != where_vec.end(); ++it) {
-            std::ostringstream value_ss;
-            CassQueryPrinter value_vprinter(value_ss);
-            boost::apply_visitor(value_vprinter, it->get<2>());
             query << " AND";
             query << " " << it->get<0>();
             query << " " << GenDb::Op::ToString(it->get<1>());
-            query << " " << value_ss.str();
+            query << " ";
+            CassSelectValue(query, it->get<2>(), values);
         }
     }
     if (!ck_range.IsEmpty()) {
         if (!ck_range.start_.empty()) {
-            int ck_start_size(ck_range.start_.size());
-            std::ostringstream start_ss;
-            start_ss << " " << GenDb::Op::ToString(ck_range.start_op_) << " (";
-            CassQueryPrinter start_vprinter(start_ss);
-            query << " AND (";
-            for (int i = 0; i < ck_start_size; i++) {
-                if (i) {
-                    query << ", ";
-                    start_ss << ", ";
-                }
-                int cnum(i + 1);
-                query << "column" << cnum;
-                boost::apply_visitor(start_vprinter, ck_range.start_[i]);
-            }
-            query << ")";
-            start_ss << ")";
-            query << start_ss.str();
+            CassSelectClusteringKey(query, ck_range.start_,
+                ck_range.start_op_, values);
         }
         if (!ck_range.finish_.empty()) {
-            int ck_finish_size(ck_range.finish_.size());
-            std::ostringstream finish_ss;
-            finish_ss << " " << GenDb::Op::ToString(ck_range.finish_op_) <<
-                " (";
-            CassQueryPrinter finish_vprinter(finish_ss);
-            query << " AND (";
-            for (int i = 0; i < ck_finish_size; i++) {
-                if (i) {
-                    query << ", ";
-                    finish_ss << ", ";
-                }
-                int cnum(i + 1);
-                query << "column" << cnum;
-                boost::apply_visitor(finish_vprinter, ck_range.finish_[i]);
-            }
-            query << ")";
-            finish_ss << ")";
-            query << finish_ss.str();
+            CassSelectClusteringKey(query, ck_range.finish_,
+                ck_range.finish_op_, values);
         }
         if (ck_range.count_) {
-            query << " LIMIT " << ck_range.count_;
+            query << " LIMIT ";
+            CassSelectValue(query, ck_range.count_, values);
         }
     }
     if (where_vec.size() > 1) {
@@ -1041,6 +1324,16 @@ std::string CassSelectFromTable(const std::string &table) {
         GenDb::WhereIndexInfoVec());
 }
 
+std::string CassPrepareSelectFromTable(const std::string &table,
+    const std::vector<GenDb::DbDataValueVec> &rkeys,
+    const GenDb::ColumnNameRange &ck_range,
+    const GenDb::FieldNamesToReadVec &read_vec,
+    const GenDb::WhereIndexInfoVec &where_vec,
+    GenDb::DbDataValueVec *values) {
+    return CassSelectFromTableInternal(table, rkeys, ck_range, read_vec,
+        where_vec, values);
+}
+
 static GenDb::DbDataValue CassValue2DbDataValue(
     interface::CassLibrary *cci, const CassValue *cvalue) {
     if (cci->CassValueIsNull(cvalue)) {
@@ -1132,6 +1425,132 @@ static GenDb::DbDataValue CassValue2DbDataValue(
     }
 }
 
+static void CassValue2CassValueView(interface::CassLibrary *cci,
+    const CassValue *cvalue, CassValueView *view) {
+    if (cci->CassValueIsNull(cvalue)) {
+        view->type = GenDb::DB_VALUE_BLANK;
+        return;
+    }
+    CassValueType cvtype(cci->GetCassValueType(cvalue));
+    CassError rc(CASS_OK);
+    switch (cvtype) {
+      case CASS_VALUE_TYPE_ASCII:
+      case CASS_VALUE_TYPE_VARCHAR:
+      case CASS_VALUE_TYPE_TEXT: {
+        view->type = GenDb::DB_VALUE_STRING;
+        rc = cci->CassValueGetString(cvalue, &view->bytes.data,
+            &view->bytes.size);
+        break;
+      }
+      case CASS_VALUE_TYPE_UUID: {
+        view->type = GenDb::DB_VALUE_UUID;
+        rc = cci->CassValueGetUuid(cvalue, &view->uuid);
+        break;
+      }
+      case CASS_VALUE_TYPE_DOUBLE: {
+        view->type = GenDb::DB_VALUE_DOUBLE;
+        cass_double_t ctdouble;
+        rc = cci->CassValueGetDouble(cvalue, &ctdouble);
+        view->d = ctdouble;
+        break;
+      }
+      case CASS_VALUE_TYPE_TINY_INT: {
+        view->type = GenDb::DB_VALUE_UINT8;
+        cass_int8_t ct8;
+        rc = cci->CassValueGetInt8(cvalue, &ct8);
+        view->u8 = (uint8_t)ct8;
+        break;
+      }
+      case CASS_VALUE_TYPE_SMALL_INT: {
+        view->type = GenDb::DB_VALUE_UINT16;
+        cass_int16_t ct16;
+        rc = cci->CassValueGetInt16(cvalue, &ct16);
+        view->u16 = (uint16_t)ct16;
+        break;
+      }
+      case CASS_VALUE_TYPE_INT: {
+        view->type = GenDb::DB_VALUE_UINT32;
+        cass_int32_t ct32;
+        rc = cci->CassValueGetInt32(cvalue, &ct32);
+        view->u32 = (uint32_t)ct32;
+        break;
+      }
+      case CASS_VALUE_TYPE_BIGINT: {
+        view->type = GenDb::DB_VALUE_UINT64;
+        cass_int64_t ct64;
+        rc = cci->CassValueGetInt64(cvalue, &ct64);
+        view->u64 = (uint64_t)ct64;
+        break;
+      }
+      case CASS_VALUE_TYPE_INET: {
+        view->type = GenDb::DB_VALUE_INET;
+        rc = cci->CassValueGetInet(cvalue, &view->inet);
+        break;
+      }
+      case CASS_VALUE_TYPE_BLOB: {
+        view->type = GenDb::DB_VALUE_BLOB;
+        const cass_byte_t *bytes(NULL);
+        rc = cci->CassValueGetBytes(cvalue, &bytes, &view->bytes.size);
+        view->bytes.data = reinterpret_cast<const char *>(bytes);
+        break;
+      }
+      case CASS_VALUE_TYPE_UNKNOWN: {
+        // null type
+        view->type = GenDb::DB_VALUE_BLANK;
+        break;
+      }
+      default: {
+        CQLIF_ERR_TRACE("Unhandled CassValueType: " << cvtype);
+        assert(false && "Unhandled value type");
+        view->type = GenDb::DB_VALUE_BLANK;
+        break;
+      }
+    }
+    assert(rc == CASS_OK);
+}
+
+GenDb::DbDataValue CassValueView::ToDbDataValue() const {
+    switch (type) {
+      case GenDb::DB_VALUE_STRING:
+        return std::string(bytes.data, bytes.size);
+      case GenDb::DB_VALUE_UINT64:
+        return u64;
+      case GenDb::DB_VALUE_UINT32:
+        return u32;
+      case GenDb::DB_VALUE_UUID: {
+        boost::uuids::uuid u;
+        encode_uuid((char *)&u, uuid);
+        return u;
+      }
+      case GenDb::DB_VALUE_UINT8:
+        return u8;
+      case GenDb::DB_VALUE_UINT16:
+        return u16;
+      case GenDb::DB_VALUE_DOUBLE:
+        return d;
+      case GenDb::DB_VALUE_INET: {
+        IpAddress ipaddr;
+        if (inet.address_length == CASS_INET_V4_LENGTH) {
+            Ip4Address::bytes_type ipv4;
+            memcpy(GENERIC_RAW_ARRAY(ipv4), inet.address, CASS_INET_V4_LENGTH);
+            ipaddr = Ip4Address(ipv4);
+        } else if (inet.address_length == CASS_INET_V6_LENGTH) {
+            Ip6Address::bytes_type ipv6;
+            memcpy(GENERIC_RAW_ARRAY(ipv6), inet.address, CASS_INET_V6_LENGTH);
+            ipaddr = Ip6Address(ipv6);
+        } else {
+            assert(0);
+        }
+        return ipaddr;
+      }
+      case GenDb::DB_VALUE_BLOB:
+        return GenDb::Blob(reinterpret_cast<const uint8_t *>(bytes.data),
+            bytes.size);
+      default:
+        return GenDb::DbDataValue();
+    }
+}
+
 static bool PrepareSync(interface::CassLibrary *cci,
     CassSession *session, const char* query,
     CassPreparedPtr *prepared) {
@@ -1184,11 +1603,10 @@ static bool ExecuteQuerySync(interface::CassLibrary *cci,
 }
 
 static bool ExecuteQueryResultSync(interface::CassLibrary *cci,
-    CassSession *session, const char *query,
+    CassSession *session, const char *query, CassStatement *statement,
     CassResultPtr *result, CassConsistency consistency) {
     CQLIF_DEBUG_TRACE( "SyncQuery: " << query);
-    CassStatementPtr statement(cci->CassStatementNew(query, 0), cci);
-    return ExecuteQuerySyncInternal(cci, session, statement.get(), result,
+    return ExecuteQuerySyncInternal(cci, session, statement, result,
         consistency);
 }
 
@@ -1524,13 +1942,58 @@ static void ExecuteQueryAsyncInternal(interface::CassLibrary *cci,
         ctx.release());
 }
 
-static void ExecuteQueryAsync(interface::CassLibrary *cci,
-    CassSession *session, const char *query,
-    CassConsistency consistency, CassAsyncQueryCallback cb) {
+struct CassAsyncColumnsContext {
+    CassAsyncColumnsContext(const char *query_id, CassAsyncColumnsCallback cb,
+        interface::CassLibrary *cci, bool is_dynamic_cf, size_t rk_count,
+        size_t ck_count) :
+        query_id_(query_id),
+        cb_(cb),
+        cci_(cci),
+        is_dynamic_cf_(is_dynamic_cf),
+        rk_count_(rk_count),
+        ck_count_(ck_count) {
+    }
+    std::string query_id_;
+    CassAsyncColumnsCallback cb_;
+    interface::CassLibrary *cci_;
+    bool is_dynamic_cf_;
+    size_t rk_count_;
+    size_t ck_count_;
+};
+
+static void OnExecuteColumnsAsync(CassFuture *future, void *data) {
+    assert(data);
+    std::auto_ptr<CassAsyncColumnsContext> ctx(
+        static_cast<CassAsyncColumnsContext *>(data));
+    interface::CassLibrary *cci(ctx->cci_);
+    CassError rc(cci->CassFutureErrorCode(future));
+    GenDb::DbOpResult::type db_rc(CassError2DbOpResult(rc));
+    if (rc != CASS_OK) {
+        CassString err;
+        cci->CassFutureErrorMessage(future, &err.data, &err.length);
+        CQLIF_ERR_TRACE("AsyncQuery: " << ctx->query_id_ << " FAILED: "
+            << std::string(err.data, err.length));
+        ctx->cb_(db_rc, CassResultColumnsPtr());
+        return;
+    }
+    CassResultPtr result(cci->CassFutureGetResult(future), cci);
+    CassResultColumnsPtr columns(new CassResultColumns(cci, result,
+        ctx->is_dynamic_cf_, ctx->rk_count_, ctx->ck_count_));
+    ctx->cb_(db_rc, columns);
+}
+
+static void ExecuteColumnsAsync(interface::CassLibrary *cci,
+    CassSession *session, const char *query, CassStatement *statement,
+    CassConsistency consistency, CassAsyncColumnsCallback cb,
+    bool is_dynamic_cf, size_t rk_count, size_t ck_count) {
     CQLIF_DEBUG_TRACE( "AsyncQuery: " << query);
-    CassStatementPtr statement(cci->CassStatementNew(query, 0), cci);
-    ExecuteQueryAsyncInternal(cci, session, query, statement.get(),
-        consistency, cb);
+    cci->CassStatementSetConsistency(statement, consistency);
+    CassFuturePtr future(cci->CassSessionExecute(session, statement), cci);
+    std::auto_ptr<CassAsyncColumnsContext> ctx(
+        new CassAsyncColumnsContext(query, cb, cci, is_dynamic_cf, rk_count,
+            ck_count));
+    cci->CassFutureSetCallback(future.get(), OnExecuteColumnsAsync,
+        ctx.release());
 }
 
 static void ExecuteQueryStatementAsync(interface::CassLibrary *cci,
@@ -1541,32 +2004,1077 @@ static void ExecuteQueryStatementAsync(interface::CassLibrary *cci,
 }
 
 static void ExecuteQueryResultAsync(interface::CassLibrary *cci,
-    CassSession *session, const char *query, CassConsistency consistency,
-    CassAsyncQueryCallback cb, CassQueryResultContext *rctx) {
-    CassStatementPtr statement(cci->CassStatementNew(query, 0), cci);
-    ExecuteQueryAsyncInternal(cci, session, query, statement.get(),
-        consistency, cb, rctx);
+    CassSession *session, const char *query, CassStatement *statement,
+    CassConsistency consistency, CassAsyncQueryCallback cb,
+    CassQueryResultContext *rctx) {
+    ExecuteQueryAsyncInternal(cci, session, query, statement, consistency,
+        cb, rctx);
 }
 
-static bool DynamicCfGetResultAsync(interface::CassLibrary *cci,
-    CassSession *session, const char *query, CassConsistency consistency,
-    impl::CassAsyncQueryCallback cb, size_t rk_count, size_t ck_count,
-    const std::string &cfname, const GenDb::DbDataValueVec &row_key) {
-    std::auto_ptr<CassQueryResultContext> rctx(
-        new CassQueryResultContext(cfname, true, row_key,
-            rk_count, ck_count));
-    ExecuteQueryResultAsync(cci, session, query, consistency, cb,
-        rctx.release());
-    return true;
+void ExecuteSelectAsync(interface::CassLibrary *cci, CassSessionPtr session,
+    const std::string &query, CassStatementPtr statement,
+    CassConsistency consistency, const CassQueryResultContext &rctx,
+    CassAsyncQueryCallback cb) {
+    ExecuteQueryResultAsync(cci, session.get(), query.c_str(), statement.get(),
+        consistency, cb, new CassQueryResultContext(rctx));
+}
+
+struct CassAsyncBatchContext {
+    CassAsyncBatchContext(const std::string &table,
+        std::vector<CassAsyncQueryCallback> *callbacks,
+        interface::CassLibrary *cci) :
+        table_(table),
+        cci_(cci) {
+        callbacks_.swap(*callbacks);
+    }
+    std::string table_;
+    std::vector<CassAsyncQueryCallback> callbacks_;
+    interface::CassLibrary *cci_;
+};
+
+static void OnExecuteBatchAsync(CassFuture *future, void *data) {
+    assert(data);
+    std::auto_ptr<CassAsyncBatchContext> ctx(
+        static_cast<CassAsyncBatchContext *>(data));
+    interface::CassLibrary *cci(ctx->cci_);
+    CassError rc(cci->CassFutureErrorCode(future));
+    GenDb::DbOpResult::type db_rc(CassError2DbOpResult(rc));
+    if (rc != CASS_OK) {
+        CassString err;
+        cci->CassFutureErrorMessage(future, &err.data, &err.length);
+        CQLIF_ERR_TRACE("AsyncBatch: " << ctx->table_ << ": " <<
+            ctx->callbacks_.size() << " statements FAILED: " <<
+            std::string(err.data, err.length));
+    }
+    BOOST_FOREACH(CassAsyncQueryCallback &cb, ctx->callbacks_) {
+        cb(db_rc, std::auto_ptr<GenDb::ColList>());
+    }
+}
+
+//
+// CassWriteCoalescer
+//
+CassWriteCoalescer::CassWriteCoalescer(interface::CassLibrary *cci,
+    size_t max_statements, size_t max_bytes, int linger_msecs) :
+    cci_(cci),
+    max_statements_(max_statements),
+    max_bytes_(max_bytes),
+    linger_msecs_(linger_msecs),
+    pending_statements_(0) {
+    requests_ = 0;
+    statements_ = 0;
+}
+
+CassWriteCoalescer::~CassWriteCoalescer() {
+    assert(pending_batches_.empty());
+}
+
+void CassWriteCoalescer::AddStatement(CassSession *session,
+    const std::string &table, const GenDb::DbDataValueVec &partition_key,
+    CassConsistency consistency, CassStatementPtr statement, size_t size,
+    CassAsyncQueryCallback cb) {
+    std::ostringstream key;
+    key << table << ":" << consistency << ":" <<
+        GenDb::DbDataValueVecToString(partition_key);
+    // At most the pending batch that the statement does not fit in, and
+    // the batch completed by the statement
+    PendingBatch full, completed;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        PendingBatch &pending(pending_batches_[key.str()]);
+        if (!pending.statements.empty() && pending.size + size > max_bytes_) {
+            pending_statements_ -= pending.statements.size();
+            full.swap(pending);
+        }
+        if (pending.statements.empty()) {
+            pending.table = table;
+            pending.consistency = consistency;
+            pending.start_usecs = ClockMonotonicUsec();
+        }
+        pending.statements.push_back(statement);
+        pending.callbacks.push_back(cb);
+        pending.size += size;
+        pending_statements_++;
+        if (pending.statements.size() >= max_statements_ ||
+            pending.size >= max_bytes_) {
+            pending_statements_ -= pending.statements.size();
+            completed.swap(pending);
+            pending_batches_.erase(key.str());
+        }
+    }
+    if (!full.statements.empty()) {
+        ExecuteBatch(session, &full);
+    }
+    if (!completed.statements.empty()) {
+        ExecuteBatch(session, &completed);
+    }
+}
+
+void CassWriteCoalescer::FlushExpired(CassSession *session,
+    uint64_t now_usecs) {
+    std::vector<PendingBatch> expired;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        PendingBatchMap::iterator it(pending_batches_.begin());
+        while (it != pending_batches_.end()) {
+            PendingBatch &pending(it->second);
+            if (pending.start_usecs + linger_msecs_ * 1000ULL > now_usecs) {
+                ++it;
+                continue;
+            }
+            pending_statements_ -= pending.statements.size();
+            expired.push_back(PendingBatch());
+            expired.back().swap(pending);
+            it = pending_batches_.erase(it);
+        }
+    }
+    BOOST_FOREACH(PendingBatch &batch, expired) {
+        ExecuteBatch(session, &batch);
+    }
+}
+
+void CassWriteCoalescer::Flush(CassSession *session) {
+    FlushExpired(session, std::numeric_limits<uint64_t>::max());
+}
+
+size_t CassWriteCoalescer::pending_statements() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return pending_statements_;
+}
+
+void CassWriteCoalescer::ExecuteBatch(CassSession *session,
+    PendingBatch *pending) {
+    requests_++;
+    statements_ += pending->statements.size();
+    // No need for a batch
+    if (pending->statements.size() == 1) {
+        std::string qid("Coalesce: " + pending->table);
+        ExecuteQueryStatementAsync(cci_, session, qid.c_str(),
+            pending->statements[0].get(), pending->consistency,
+            pending->callbacks[0]);
+        return;
+    }
+    CQLIF_DEBUG_TRACE("AsyncBatch: " << pending->table << ": " <<
+        pending->statements.size() << " statements");
+    CassBatchPtr batch(cci_->CassBatchNew(CASS_BATCH_TYPE_UNLOGGED), cci_);
+    cci_->CassBatchSetConsistency(batch.get(), pending->consistency);
+    BOOST_FOREACH(const CassStatementPtr &statement, pending->statements) {
+        cci_->CassBatchAddStatement(batch.get(), statement.get());
+    }
+    CassFuturePtr future(cci_->CassSessionExecuteBatch(session, batch.get()),
+        cci_);
+    std::auto_ptr<CassAsyncBatchContext> ctx(
+        new CassAsyncBatchContext(pending->table, &pending->callbacks, cci_));
+    cci_->CassFutureSetCallback(future.get(), OnExecuteBatchAsync,
+        ctx.release());
+}
+
+//
+// CassWriteQueue
+//
+CassWriteQueue::CassWriteQueue(size_t max_in_flight,
+    size_t max_table_in_flight, size_t max_queued) :
+    max_in_flight_(Limit(max_in_flight)),
+    max_table_in_flight_(Limit(max_table_in_flight)),
+    max_queued_(max_queued),
+    queued_(0),
+    in_flight_(0),
+    executing_(false) {
+    enqueues_ = 0;
+    drops_ = 0;
+}
+
+CassWriteQueue::~CassWriteQueue() {
+    assert(queued_ == 0);
+}
+
+size_t CassWriteQueue::Limit(size_t limit) {
+    return limit ? limit : std::numeric_limits<size_t>::max();
+}
+
+void CassWriteQueue::SetLimits(size_t max_in_flight,
+    size_t max_table_in_flight, size_t max_queued) {
+    bool execute;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        max_in_flight_ = Limit(max_in_flight);
+        max_table_in_flight_ = Limit(max_table_in_flight);
+        max_queued_ = max_queued;
+        // Tables that were at their limit
+        for (TableQueueMap::iterator it = tables_.begin();
+             it != tables_.end(); ++it) {
+            MakeReady(&it->second);
+        }
+        execute = DequeueReady();
+    }
+    if (execute) {
+        ExecuteWrites();
+    }
+}
+
+void CassWriteQueue::Enqueue(const std::string &table, WriteFn write_fn,
+    CassAsyncQueryCallback cb) {
+    bool execute;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        TableQueue *tqueue(&tables_[table]);
+        bool wait(!tqueue->writes.empty() ||
+            tqueue->in_flight >= max_table_in_flight_ ||
+            in_flight_ >= max_in_flight_);
+        if (wait && queued_ >= max_queued_) {
+            lock.release();
+            drops_++;
+            cb(GenDb::DbOpResult::BACK_PRESSURE,
+                std::auto_ptr<GenDb::ColList>());
+            return;
+        }
+        enqueues_++;
+        tqueue->writes.push_back(Write(write_fn, cb));
+        queued_++;
+        MakeReady(tqueue);
+        execute = DequeueReady();
+    }
+    ProcessWaterMarks(true);
+    if (execute) {
+        ExecuteWrites();
+    }
+}
+
+void CassWriteQueue::Clear() {
+    std::vector<Write> writes;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        for (TableQueueMap::iterator it = tables_.begin();
+             it != tables_.end(); ++it) {
+            TableQueue &tqueue(it->second);
+            writes.insert(writes.end(), tqueue.writes.begin(),
+                tqueue.writes.end());
+            tqueue.writes.clear();
+            tqueue.ready = false;
+        }
+        ready_.clear();
+        queued_ = 0;
+    }
+    ProcessWaterMarks(false);
+    BOOST_FOREACH(Write &write, writes) {
+        write.cb(GenDb::DbOpResult::ERROR, std::auto_ptr<GenDb::ColList>());
+    }
+}
+
+void CassWriteQueue::SetWaterMark(bool high, size_t count,
+    WaterMarkCallback cb) {
+    tbb::mutex::scoped_lock lock(water_mutex_);
+    if (high) {
+        watermarks_.SetHighWaterMark(WaterMarkInfo(count, cb));
+    } else {
+        watermarks_.SetLowWaterMark(WaterMarkInfo(count, cb));
+    }
+}
+
+void CassWriteQueue::ResetWaterMarks() {
+    tbb::mutex::scoped_lock lock(water_mutex_);
+    watermarks_.ResetHighWaterMark();
+    watermarks_.ResetLowWaterMark();
+}
+
+size_t CassWriteQueue::count() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return queued_ + in_flight_;
+}
+
+size_t CassWriteQueue::queued() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return queued_;
+}
+
+size_t CassWriteQueue::in_flight() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return in_flight_;
+}
+
+size_t CassWriteQueue::table_in_flight(const std::string &table) const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    TableQueueMap::const_iterator it(tables_.find(table));
+    if (it == tables_.end()) {
+        return 0;
+    }
+    return it->second.in_flight;
+}
+
+void CassWriteQueue::MakeReady(TableQueue *tqueue) {
+    if (!tqueue->ready && !tqueue->writes.empty() &&
+        tqueue->in_flight < max_table_in_flight_) {
+        ready_.push_back(tqueue);
+        tqueue->ready = true;
+    }
+}
+
+// Takes one write of each ready table in turn while there are outstanding
+// writes available, called with the mutex held. Returns true if the caller
+// is to execute the dequeued writes.
+bool CassWriteQueue::DequeueReady() {
+    while (in_flight_ < max_in_flight_ && !ready_.empty()) {
+        TableQueue *tqueue(ready_.front());
+        ready_.pop_front();
+        tqueue->ready = false;
+        // The limit was lowered
+        if (tqueue->in_flight >= max_table_in_flight_) {
+            continue;
+        }
+        const Write &write(tqueue->writes.front());
+        dequeued_.push_back(Write(write.write_fn,
+            boost::bind(&CassWriteQueue::OnWriteCompletion, this, tqueue,
+                write.cb, _1, _2)));
+        tqueue->writes.pop_front();
+        queued_--;
+        tqueue->in_flight++;
+        in_flight_++;
+        MakeReady(tqueue);
+    }
+    if (executing_ || dequeued_.empty()) {
+        return false;
+    }
+    executing_ = true;
+    return true;
+}
+
+// Executes the dequeued writes until there are none left. The writes
+// dequeued when a write completes synchronously, or on another thread,
+// are left to this loop instead of being executed recursively.
+void CassWriteQueue::ExecuteWrites() {
+    std::vector<Write> writes;
+    while (true) {
+        {
+            tbb::mutex::scoped_lock lock(mutex_);
+            if (dequeued_.empty()) {
+                executing_ = false;
+                return;
+            }
+            writes.swap(dequeued_);
+        }
+        BOOST_FOREACH(Write &write, writes) {
+            write.write_fn(write.cb);
+        }
+        writes.clear();
+    }
+}
+
+// The count is read under the water mark mutex, so that the water marks
+// are processed in the order of the counts
+void CassWriteQueue::ProcessWaterMarks(bool high) {
+    tbb::mutex::scoped_lock lock(water_mutex_);
+    size_t queue_count(count());
+    if (high) {
+        watermarks_.ProcessHighWaterMarks(queue_count);
+    } else {
+        watermarks_.ProcessLowWaterMarks(queue_count);
+    }
+}
+
+void CassWriteQueue::OnWriteCompletion(TableQueue *tqueue,
+    CassAsyncQueryCallback cb, GenDb::DbOpResult::type drc,
+    std::auto_ptr<GenDb::ColList> row) {
+    bool execute;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        tqueue->in_flight--;
+        in_flight_--;
+        MakeReady(tqueue);
+        execute = DequeueReady();
+    }
+    ProcessWaterMarks(false);
+    if (execute) {
+        ExecuteWrites();
+    }
+    cb(drc, row);
+}
+
+//
+// CassAsyncMultiRowSelect
+//
+CassAsyncMultiRowSelect::CassAsyncMultiRowSelect(
+    const std::vector<GenDb::DbDataValueVec> &v_rowkey, size_t window,
+    SelectFn select_fn, CompletionCb cb) :
+    v_rowkey_(v_rowkey),
+    window_(std::max(window, static_cast<size_t>(1))),
+    select_fn_(select_fn),
+    cb_(cb),
+    rows_(v_rowkey.size(), static_cast<GenDb::ColList *>(NULL)),
+    next_(0),
+    outstanding_(0),
+    result_(GenDb::DbOpResult::OK) {
+}
+
+CassAsyncMultiRowSelect::~CassAsyncMultiRowSelect() {
+    BOOST_FOREACH(GenDb::ColList *row, rows_) {
+        delete row;
+    }
+}
+
+void CassAsyncMultiRowSelect::Start() {
+    if (v_rowkey_.empty()) {
+        cb_(GenDb::DbOpResult::OK,
+            std::auto_ptr<GenDb::ColListVec>(new GenDb::ColListVec));
+        return;
+    }
+    IssueSelects();
+}
+
+void CassAsyncMultiRowSelect::IssueSelects() {
+    while (true) {
+        size_t index;
+        {
+            tbb::mutex::scoped_lock lock(mutex_);
+            if (result_ != GenDb::DbOpResult::OK ||
+                next_ == v_rowkey_.size() || outstanding_ >= window_) {
+                return;
+            }
+            index = next_++;
+            outstanding_++;
+        }
+        bool success(select_fn_(v_rowkey_[index],
+            boost::bind(&CassAsyncMultiRowSelect::OnSelectCompletion,
+                shared_from_this(), index, _1, _2)));
+        if (!success) {
+            OnSelectCompletion(index, GenDb::DbOpResult::ERROR,
+                std::auto_ptr<GenDb::ColList>());
+        }
+    }
+}
+
+void CassAsyncMultiRowSelect::OnSelectCompletion(size_t index,
+    GenDb::DbOpResult::type drc, std::auto_ptr<GenDb::ColList> row) {
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        outstanding_--;
+        if (drc != GenDb::DbOpResult::OK) {
+            if (result_ == GenDb::DbOpResult::OK) {
+                result_ = drc;
+            }
+        } else {
+            // No row if the partition is empty
+            if (row.get() == NULL) {
+                row.reset(new GenDb::ColList);
+                row->rowkey_ = v_rowkey_[index];
+            }
+            rows_[index] = row.release();
+        }
+        bool done(outstanding_ == 0 && (result_ != GenDb::DbOpResult::OK ||
+            next_ == v_rowkey_.size()));
+        if (!done) {
+            lock.release();
+            IssueSelects();
+            return;
+        }
+    }
+    // All selects are done, no other thread accesses the rows
+    if (result_ != GenDb::DbOpResult::OK) {
+        cb_(result_, std::auto_ptr<GenDb::ColListVec>());
+        return;
+    }
+    std::auto_ptr<GenDb::ColListVec> rows(new GenDb::ColListVec);
+    for (size_t i = 0; i < rows_.size(); i++) {
+        rows->push_back(rows_[i]);
+        rows_[i] = NULL;
+    }
+    cb_(result_, rows);
+}
+
+//
+// CassPagedSelect
+//
+CassPagedSelect::CassPagedSelect(interface::CassLibrary *cci,
+    CassSessionPtr session, const std::string &query,
+    CassStatementPtr statement, CassConsistency consistency,
+    size_t page_size, bool is_dynamic_cf, size_t rk_count, size_t ck_count,
+    PageCb cb) :
+    cci_(cci),
+    session_(session),
+    query_(query),
+    statement_(statement),
+    is_dynamic_cf_(is_dynamic_cf),
+    rk_count_(rk_count),
+    ck_count_(ck_count),
+    cb_(cb) {
+    pages_ = 0;
+    rows_ = 0;
+    cci_->CassStatementSetConsistency(statement_.get(), consistency);
+    cci_->CassStatementSetPagingSize(statement_.get(),
+        static_cast<int>(std::max(page_size, static_cast<size_t>(1))));
+}
+
+void CassPagedSelect::Start() {
+    FetchNextPage();
+}
+
+void CassPagedSelect::FetchNextPage() {
+    CQLIF_DEBUG_TRACE("AsyncQuery: " << query_ << " Page: " << pages_);
+    CassFuturePtr future(cci_->CassSessionExecute(session_.get(),
+        statement_.get()), cci_);
+    // The select is kept until the page is received
+    cci_->CassFutureSetCallback(future.get(), OnPageAsync,
+        new CassPagedSelectPtr(shared_from_this()));
+}
+
+void CassPagedSelect::OnPageAsync(CassFuture *future, void *data) {
+    assert(data);
+    std::auto_ptr<CassPagedSelectPtr> select(
+        static_cast<CassPagedSelectPtr *>(data));
+    (*select)->OnPage(future);
+}
+
+void CassPagedSelect::OnPage(CassFuture *future) {
+    CassError rc(cci_->CassFutureErrorCode(future));
+    if (rc != CASS_OK) {
+        CassString err;
+        cci_->CassFutureErrorMessage(future, &err.data, &err.length);
+        CQLIF_ERR_TRACE("AsyncQuery: " << query_ << " Page: " << pages_ <<
+            " FAILED: " << std::string(err.data, err.length));
+        cb_(CassError2DbOpResult(rc), std::auto_ptr<GenDb::ColListVec>(),
+            CassPagedSelectPtr());
+        return;
+    }
+    CassResultPtr result(cci_->CassFutureGetResult(future), cci_);
+    std::auto_ptr<GenDb::ColListVec> rows(new GenDb::ColListVec);
+    if (is_dynamic_cf_) {
+        DynamicCfGetResult(cci_, &result, rk_count_, ck_count_, rows.get());
+    } else {
+        StaticCfGetResult(cci_, &result, rk_count_, rows.get());
+    }
+    pages_++;
+    rows_ += cci_->CassResultRowCount(result.get());
+    CassPagedSelectPtr next;
+    if (cci_->CassResultHasMorePages(result.get())) {
+        // The paging state is copied into the statement
+        cci_->CassStatementSetPagingState(statement_.get(), result.get());
+        next = shared_from_this();
+    }
+    // Free the page before it is handed over
+    result.reset();
+    cb_(GenDb::DbOpResult::OK, rows, next);
+}
+
+//
+// CassCompletionQueues
+//
+class WorkerTask : public Task {
+ public:
+    typedef boost::function<void(void)> FunctionPtr;
+    WorkerTask(FunctionPtr func, int task_id, int task_instance) :
+        Task(task_id, task_instance),
+        func_(func) {
+    }
+    bool Run() {
+        func_();
+        return true;
+    }
+    std::string Description() const {
+        return "cass::cql::impl::WorkerTask";
+    }
+ private:
+    FunctionPtr func_;
+};
+
+CassCompletionQueues::CassCompletionQueues() {
+}
+
+CassCompletionQueues::~CassCompletionQueues() {
+    BOOST_FOREACH(QueueMap::value_type &entry, queues_) {
+        entry.second->Shutdown();
+        delete entry.second;
+    }
+    queues_.clear();
+}
+
+CassCompletionQueues::CompletionQueue *CassCompletionQueues::LocateQueue(
+    int task_id, int task_instance) {
+    std::pair<int, int> key(task_id, task_instance);
+    {
+        tbb::spin_rw_mutex::scoped_lock lock(rw_mutex_, false);
+        QueueMap::const_iterator it(queues_.find(key));
+        if (it != queues_.end()) {
+            return it->second;
+        }
+    }
+    tbb::spin_rw_mutex::scoped_lock lock(rw_mutex_, true);
+    std::pair<QueueMap::iterator, bool> ret(queues_.insert(
+        std::make_pair(key, static_cast<CompletionQueue *>(NULL))));
+    if (ret.second) {
+        CompletionQueue *queue(new CompletionQueue(task_id, task_instance,
+            boost::bind(&CassCompletionQueues::RunCompletion, this, _1),
+            CompletionQueue::kMaxSize, kMaxCompletionsPerRun));
+        queue->set_name("cass::cql::impl::CassCompletionQueue");
+        ret.first->second = queue;
+    }
+    return ret.first->second;
+}
+
+void CassCompletionQueues::Enqueue(int task_id, int task_instance,
+    Completion completion) {
+    // Completions for any instance run concurrently, as they were
+    if (task_instance == Task::kTaskInstanceAny) {
+        TaskScheduler *scheduler = TaskScheduler::GetInstance();
+        scheduler->Enqueue(new WorkerTask(completion, task_id,
+            task_instance));
+        return;
+    }
+    // Queues are not deleted until destruction, enqueue without the lock
+    LocateQueue(task_id, task_instance)->Enqueue(completion);
+}
+
+bool CassCompletionQueues::RunCompletion(Completion completion) {
+    completion();
+    return true;
+}
+
+uint64_t CassCompletionQueues::completions() const {
+    tbb::spin_rw_mutex::scoped_lock lock(rw_mutex_, false);
+    uint64_t completions(0);
+    BOOST_FOREACH(const QueueMap::value_type &entry, queues_) {
+        completions += entry.second->NumDequeues();
+    }
+    return completions;
+}
+
+uint64_t CassCompletionQueues::task_runs() const {
+    tbb::spin_rw_mutex::scoped_lock lock(rw_mutex_, false);
+    uint64_t task_runs(0);
+    BOOST_FOREACH(const QueueMap::value_type &entry, queues_) {
+        task_runs += entry.second->task_starts();
+    }
+    return task_runs;
+}
+
+size_t CassCompletionQueues::queue_count() const {
+    tbb::spin_rw_mutex::scoped_lock lock(rw_mutex_, false);
+    return queues_.size();
+}
+
+//
+// CassHedgedReads
+//
+struct CassHedgedReads::HedgedRead {
+    HedgedRead(const std::string &table, ReadFn read_fn,
+        CassAsyncQueryCallback cb) :
+        table_(table),
+        read_fn_(read_fn),
+        cb_(cb),
+        start_usecs_(ClockMonotonicUsec()),
+        outstanding_(1),
+        done_(false),
+        waiting_(false) {
+    }
+    const std::string table_;
+    ReadFn read_fn_;
+    CassAsyncQueryCallback cb_;
+    const uint64_t start_usecs_;
+    // Executions not completed yet
+    int outstanding_;
+    bool done_;
+    // In the hedge map, at hedge_it_
+    bool waiting_;
+    HedgeMap::iterator hedge_it_;
+};
+
+CassHedgedReads::CassHedgedReads() {
+    reads_ = 0;
+    hedges_ = 0;
+    hedges_won_ = 0;
+    hedges_over_budget_ = 0;
+}
+
+CassHedgedReads::~CassHedgedReads() {
+    Clear();
+}
+
+void CassHedgedReads::SetPolicy(const std::string &table,
+    const Policy &policy) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    policies_[table].policy = policy;
+}
+
+void CassHedgedReads::ClearPolicy(const std::string &table) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    policies_.erase(table);
+}
+
+bool CassHedgedReads::IsHedged(const std::string &table) const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return policies_.find(table) != policies_.end();
+}
+
+size_t CassHedgedReads::policies() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return policies_.size();
+}
+
+uint64_t CassHedgedReads::HedgeDelayUsecs(const TablePolicy &tpolicy,
+    const std::string &table) const {
+    const Policy &policy(tpolicy.policy);
+    uint64_t min_usecs(policy.min_delay_msecs * 1000ULL);
+    uint64_t max_usecs(policy.max_delay_msecs * 1000ULL);
+    uint64_t usecs;
+    if (!latencies_.GetPercentile(table,
+            GenDb::DbTableLatencyStatistics::OP_SELECT, policy.percentile,
+            &usecs)) {
+        return max_usecs;
+    }
+    return std::min(std::max(usecs, min_usecs), max_usecs);
+}
+
+uint64_t CassHedgedReads::HedgeDelayUsecs(const std::string &table) const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    TablePolicyMap::const_iterator it(policies_.find(table));
+    if (it == policies_.end()) {
+        return 0;
+    }
+    return HedgeDelayUsecs(it->second, table);
+}
+
+void CassHedgedReads::Read(const std::string &table, ReadFn read_fn,
+    CassAsyncQueryCallback cb) {
+    HedgedReadPtr read(new HedgedRead(table, read_fn, cb));
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        TablePolicyMap::iterator it(policies_.find(table));
+        if (it != policies_.end()) {
+            TablePolicy &tpolicy(it->second);
+            tpolicy.budget = std::min(tpolicy.budget +
+                tpolicy.policy.budget_percent, 100 * kMaxBurst);
+            read->hedge_it_ = hedges_map_.insert(std::make_pair(
+                read->start_usecs_ + HedgeDelayUsecs(tpolicy, table), read));
+            read->waiting_ = true;
+            reads_++;
+        }
+    }
+    read_fn(boost::bind(&CassHedgedReads::OnReadCompletion, this, read, false,
+        _1, _2));
+}
+
+void CassHedgedReads::HedgeExpired(uint64_t now_usecs) {
+    std::vector<HedgedReadPtr> hedges;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        while (!hedges_map_.empty() &&
+               hedges_map_.begin()->first <= now_usecs) {
+            HedgedReadPtr read(hedges_map_.begin()->second);
+            hedges_map_.erase(hedges_map_.begin());
+            read->waiting_ = false;
+            // Policy cleared since the read was issued
+            TablePolicyMap::iterator it(policies_.find(read->table_));
+            if (it == policies_.end()) {
+                continue;
+            }
+            if (it->second.budget < 100) {
+                hedges_over_budget_++;
+                continue;
+            }
+            it->second.budget -= 100;
+            read->outstanding_++;
+            hedges_++;
+            hedges.push_back(read);
+        }
+    }
+    BOOST_FOREACH(HedgedReadPtr &read, hedges) {
+        CQLIF_DEBUG_TRACE("HedgedRead: " << read->table_);
+        read->read_fn_(boost::bind(&CassHedgedReads::OnReadCompletion, this,
+            read, true, _1, _2));
+    }
+}
+
+void CassHedgedReads::OnReadCompletion(HedgedReadPtr read, bool hedge,
+    GenDb::DbOpResult::type drc, std::auto_ptr<GenDb::ColList> row) {
+    // The latencies of the first executions, including the ones that lost,
+    // give the hedge delay
+    if (!hedge) {
+        latencies_.Update(read->table_,
+            GenDb::DbTableLatencyStatistics::OP_SELECT,
+            ClockMonotonicUsec() - read->start_usecs_);
+    }
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        read->outstanding_--;
+        if (read->done_) {
+            return;
+        }
+        // Wait for the other execution rather than fail the read
+        if (drc != GenDb::DbOpResult::OK && read->outstanding_ > 0) {
+            return;
+        }
+        read->done_ = true;
+        if (read->waiting_) {
+            hedges_map_.erase(read->hedge_it_);
+            read->waiting_ = false;
+        }
+        if (hedge && drc == GenDb::DbOpResult::OK) {
+            hedges_won_++;
+        }
+    }
+    read->cb_(drc, row);
+}
+
+void CassHedgedReads::Clear() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    BOOST_FOREACH(HedgeMap::value_type &entry, hedges_map_) {
+        entry.second->waiting_ = false;
+    }
+    hedges_map_.clear();
+}
+
+size_t CassHedgedReads::waiting() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return hedges_map_.size();
+}
+
+//
+// CassResultColumns
+//
+CassResultColumns::CassResultColumns(interface::CassLibrary *cci,
+    CassResultPtr result, bool is_dynamic_cf, size_t rk_count,
+    size_t ck_count) :
+    result_(result),
+    is_dynamic_cf_(is_dynamic_cf),
+    rk_count_(rk_count),
+    ck_count_(ck_count),
+    row_count_(cci->CassResultRowCount(result.get())),
+    column_count_(cci->CassResultColumnCount(result.get())),
+    names_(column_count_),
+    values_(row_count_ * column_count_) {
+    for (size_t i = 0; i < column_count_; i++) {
+        CassValueView &name(names_[i]);
+        CassError rc(cci->CassResultColumnName(result_.get(), i,
+            &name.bytes.data, &name.bytes.size));
+        assert(rc == CASS_OK);
+        name.type = GenDb::DB_VALUE_STRING;
+    }
+    // Row iterator
+    CassIteratorPtr riterator(cci->CassIteratorFromResult(result_.get()),
+        cci);
+    for (size_t r = 0; r < row_count_ &&
+         cci->CassIteratorNext(riterator.get()); r++) {
+        const CassRow *row(cci->CassIteratorGetRow(riterator.get()));
+        for (size_t i = 0; i < column_count_; i++) {
+            const CassValue *cvalue(cci->CassRowGetColumn(row, i));
+            assert(cvalue);
+            CassValue2CassValueView(cci, cvalue,
+                &values_[i * row_count_ + r]);
+        }
+    }
+}
+
+GenDb::NewCol *CassResultColumns::GetDynamicCfColumn(size_t row) const {
+    // Clustering key
+    GenDb::DbDataValueVec *cnames(new GenDb::DbDataValueVec);
+    cnames->reserve(ck_count_);
+    for (size_t i = rk_count_; i < rk_count_ + ck_count_; i++) {
+        cnames->push_back(value(row, i).ToDbDataValue());
+    }
+    // Values
+    GenDb::DbDataValueVec *values(new GenDb::DbDataValueVec);
+    values->reserve(column_count_ - rk_count_ - ck_count_);
+    for (size_t i = rk_count_ + ck_count_; i < column_count_; i++) {
+        values->push_back(value(row, i).ToDbDataValue());
+    }
+    return new GenDb::NewCol(cnames, values, 0);
+}
+
+void CassResultColumns::GetStaticCfColumns(size_t row,
+    GenDb::NewColVec *v_columns) const {
+    for (size_t i = 0; i < column_count_; i++) {
+        const CassValueView &cvalue(value(row, i));
+        if (cvalue.type == GenDb::DB_VALUE_BLANK) {
+            continue;
+        }
+        const CassValueView &cname(names_[i]);
+        GenDb::NewCol *column(new GenDb::NewCol(
+            std::string(cname.bytes.data, cname.bytes.size),
+            cvalue.ToDbDataValue(), 0));
+        v_columns->push_back(column);
+    }
+}
+
+void CassResultColumns::GetColumns(GenDb::NewColVec *v_columns) const {
+    for (size_t r = 0; r < row_count_; r++) {
+        if (is_dynamic_cf_) {
+            v_columns->push_back(GetDynamicCfColumn(r));
+        } else {
+            GetStaticCfColumns(r, v_columns);
+        }
+    }
+}
+
+void CassResultColumns::GetColumns(GenDb::ColListVec *v_col_list) const {
+    std::auto_ptr<GenDb::ColList> col_list;
+    for (size_t r = 0; r < row_count_; r++) {
+        // Partition key
+        GenDb::DbDataValueVec rkey;
+        rkey.reserve(rk_count_);
+        for (size_t i = 0; i < rk_count_; i++) {
+            rkey.push_back(value(r, i).ToDbDataValue());
+        }
+        // Do we need a new ColList?
+        if (col_list.get() && rkey != col_list->rowkey_) {
+            v_col_list->push_back(col_list.release());
+        }
+        if (!col_list.get()) {
+            col_list.reset(new GenDb::ColList);
+            col_list->rowkey_.swap(rkey);
+        }
+        if (is_dynamic_cf_) {
+            col_list->columns_.push_back(GetDynamicCfColumn(r));
+        } else {
+            GetStaticCfColumns(r, &col_list->columns_);
+        }
+    }
+    if (col_list.get()) {
+        v_col_list->push_back(col_list.release());
+    }
+}
+
+//
+// CassPreparedCache
+//
+struct CassPreparedCache::PrepareContext {
+    PrepareContext(CassPreparedCache *cache, const std::string &query,
+        uint64_t generation) :
+        cache_(cache),
+        query_(query),
+        generation_(generation) {
+    }
+    CassPreparedCache *cache_;
+    std::string query_;
+    uint64_t generation_;
+};
+
+CassPreparedCache::CassPreparedCache(interface::CassLibrary *cci,
+    size_t max_size) :
+    cci_(cci),
+    max_size_(max_size),
+    generation_(0) {
+    hits_ = 0;
+    misses_ = 0;
+    prepare_failures_ = 0;
+    bind_failures_ = 0;
+}
+
+bool CassPreparedCache::Lookup(CassSession *session, const std::string &query,
+    CassPreparedPtr *prepared) {
+    uint64_t generation;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        CassPreparedMap::const_iterator it(prepared_map_.find(query));
+        if (it != prepared_map_.end()) {
+            if (it->second.get() == NULL) {
+                misses_++;
+                return false;
+            }
+            hits_++;
+            *prepared = it->second;
+            return true;
+        }
+        misses_++;
+        if (prepared_map_.size() >= max_size_) {
+            return false;
+        }
+        prepared_map_.insert(std::make_pair(query,
+            CassPreparedPtr(NULL, cci_)));
+        generation = generation_;
+    }
+    CQLIF_DEBUG_TRACE("PrepareAsync: " << query);
+    CassFuturePtr future(cci_->CassSessionPrepare(session, query.c_str()),
+        cci_);
+    std::auto_ptr<PrepareContext> ctx(
+        new PrepareContext(this, query, generation));
+    cci_->CassFutureSetCallback(future.get(), OnPrepareAsync, ctx.release());
+    return false;
+}
+
+bool CassPreparedCache::BindFailed(const std::string &query) {
+    bind_failures_++;
+    tbb::mutex::scoped_lock lock(mutex_);
+    CassPreparedMap::iterator it(prepared_map_.find(query));
+    if (it == prepared_map_.end() || it->second.get() == NULL) {
+        return false;
+    }
+    // Not looked up as prepared again
+    it->second = CassPreparedPtr(NULL, cci_);
+    return true;
+}
+
+void CassPreparedCache::Clear() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    prepared_map_.clear();
+    generation_++;
+}
+
+size_t CassPreparedCache::size() const {
+    tbb::mutex::scoped_lock lock(mutex_);
+    return prepared_map_.size();
+}
+
+void CassPreparedCache::OnPrepareAsync(CassFuture *future, void *data) {
+    assert(data);
+    std::auto_ptr<PrepareContext> ctx(static_cast<PrepareContext *>(data));
+    ctx->cache_->PrepareDone(future, ctx->query_, ctx->generation_);
+}
+
+void CassPreparedCache::PrepareDone(CassFuture *future,
+    const std::string &query, uint64_t generation) {
+    CassError rc(cci_->CassFutureErrorCode(future));
+    CassPreparedPtr prepared(NULL, cci_);
+    if (rc != CASS_OK) {
+        prepare_failures_++;
+        CassString err;
+        cci_->CassFutureErrorMessage(future, &err.data, &err.length);
+        CQLIF_ERR_TRACE("PrepareAsync: " << query << " FAILED: " <<
+            std::string(err.data, err.length));
+    } else {
+        prepared = CassPreparedPtr(cci_->CassFutureGetPrepared(future), cci_);
+    }
+    tbb::mutex::scoped_lock lock(mutex_);
+    // Prepared on a previous session
+    if (generation != generation_) {
+        return;
+    }
+    // The query stays in the cache if it failed to prepare, so that it is
+    // not prepared again
+    CassPreparedMap::iterator it(prepared_map_.find(query));
+    assert(it != prepared_map_.end());
+    it->second = prepared;
+}
+
+bool CassStatementBindValues(interface::CassLibrary *cci,
+    CassStatement *statement, const GenDb::DbDataValueVec &values) {
+    CassStatementIndexBinder values_binder(cci, statement);
+    for (size_t i = 0; i < values.size(); i++) {
+        if (!boost::apply_visitor(boost::bind(values_binder, _1, i),
+                values[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool DynamicCfGetResultAsync(interface::CassLibrary *cci,
+    CassSession *session, const char *query, CassStatement *statement,
+    CassConsistency consistency, impl::CassAsyncQueryCallback cb,
+    size_t rk_count, size_t ck_count,
+    const std::string &cfname, const GenDb::DbDataValueVec &row_key) {
+    std::auto_ptr<CassQueryResultContext> rctx(
+        new CassQueryResultContext(cfname, true, row_key,
+            rk_count, ck_count));
+    ExecuteQueryResultAsync(cci, session, query, statement, consistency, cb,
+        rctx.release());
+    return true;
 }
 
 static bool DynamicCfGetResultSync(interface::CassLibrary *cci,
-    CassSession *session, const char *query,
+    CassSession *session, const char *query, CassStatement *statement,
     const GenDb::FieldNamesToReadVec &read_vec,
     CassConsistency consistency, GenDb::NewColVec *v_columns) {
     CassResultPtr result(NULL, cci);
-    bool success(ExecuteQueryResultSync(cci, session, query, &result,
-        consistency));
+    bool success(ExecuteQueryResultSync(cci, session, query, statement,
+        &result, consistency));
     if (!success) {
         return success;
     }
@@ -1575,12 +3083,12 @@ static bool DynamicCfGetResultSync(interface::CassLibrary *cci,
 }
 
 static bool DynamicCfGetResultSync(interface::CassLibrary *cci,
-    CassSession *session, const char *query,
+    CassSession *session, const char *query, CassStatement *statement,
     const GenDb::FieldNamesToReadVec &read_vec,
     CassConsistency consistency, GenDb::ColListVec *v_columns) {
     CassResultPtr result(NULL, cci);
-    bool success(ExecuteQueryResultSync(cci, session, query, &result,
-        consistency));
+    bool success(ExecuteQueryResultSync(cci, session, query, statement,
+        &result, consistency));
     if (!success) {
         return success;
     }
@@ -1589,12 +3097,12 @@ static bool DynamicCfGetResultSync(interface::CassLibrary *cci,
 }
 
 static bool DynamicCfGetResultSync(interface::CassLibrary *cci,
-    CassSession *session, const char *query,
+    CassSession *session, const char *query, CassStatement *statement,
     size_t rk_count, size_t ck_count, CassConsistency consistency,
     GenDb::NewColVec *v_columns) {
     CassResultPtr result(NULL, cci);
-    bool success(ExecuteQueryResultSync(cci, session, query, &result,
-        consistency));
+    bool success(ExecuteQueryResultSync(cci, session, query, statement,
+        &result, consistency));
     if (!success) {
         return success;
     }
@@ -1603,12 +3111,12 @@ static bool DynamicCfGetResultSync(interface::CassLibrary *cci,
 }
 
 static bool DynamicCfGetResultSync(interface::CassLibrary *cci,
-    CassSession *session, const char *query,
+    CassSession *session, const char *query, CassStatement *statement,
     size_t rk_count, size_t ck_count, CassConsistency consistency,
     GenDb::ColListVec *v_col_list) {
     CassResultPtr result(NULL, cci);
-    bool success(ExecuteQueryResultSync(cci, session, query, &result,
-        consistency));
+    bool success(ExecuteQueryResultSync(cci, session, query, statement,
+        &result, consistency));
     if (!success) {
         return success;
     }
@@ -1617,22 +3125,22 @@ static bool DynamicCfGetResultSync(interface::CassLibrary *cci,
 }
 
 static bool StaticCfGetResultAsync(interface::CassLibrary *cci,
-    CassSession *session, const char *query,
+    CassSession *session, const char *query, CassStatement *statement,
     CassConsistency consistency, impl::CassAsyncQueryCallback cb,
     const std::string& cfname, const GenDb::DbDataValueVec &row_key) {
     std::auto_ptr<CassQueryResultContext> rctx(
         new CassQueryResultContext(cfname, false, row_key));
-    ExecuteQueryResultAsync(cci, session, query, consistency, cb,
+    ExecuteQueryResultAsync(cci, session, query, statement, consistency, cb,
         rctx.release());
     return true;
 }
 
 static bool StaticCfGetResultSync(interface::CassLibrary *cci,
-    CassSession *session, const char *query,
+    CassSession *session, const char *query, CassStatement *statement,
     CassConsistency consistency, GenDb::NewColVec *v_columns) {
     CassResultPtr result(NULL, cci);
-    bool success(ExecuteQueryResultSync(cci, session, query, &result,
-        consistency));
+    bool success(ExecuteQueryResultSync(cci, session, query, statement,
+        &result, consistency));
     if (!success) {
         return success;
     }
@@ -1641,11 +3149,12 @@ static bool StaticCfGetResultSync(interface::CassLibrary *cci,
 }
 
 static bool StaticCfGetResultSync(interface::CassLibrary *cci,
-    CassSession *session, const char *query, size_t rk_count,
+    CassSession *session, const char *query,
+    CassStatement *statement, size_t rk_count,
     CassConsistency consistency, GenDb::ColListVec *v_col_list) {
     CassResultPtr result(NULL, cci);
-    bool success(ExecuteQueryResultSync(cci, session, query, &result,
-        consistency));
+    bool success(ExecuteQueryResultSync(cci, session, query, statement,
+        &result, consistency));
     if (!success) {
         return success;
     }
@@ -1820,24 +3329,6 @@ static std::string LoadCertFile(const std::string &ca_certs_path) {
 }
 
 
-class WorkerTask : public Task {
- public:
-    typedef boost::function<void(void)> FunctionPtr;
-    WorkerTask(FunctionPtr func, int task_id, int task_instance) :
-        Task(task_id, task_instance),
-        func_(func) {
-    }
-    bool Run() {
-        func_();
-        return true;
-    }
-    std::string Description() const {
-        return "cass::cql::impl::WorkerTask";
-    }
- private:
-    FunctionPtr func_;
-};
-
 }  // namespace impl
 
 //
@@ -1858,7 +3349,10 @@ CqlIfImpl::CqlIfImpl(EventManager *evm,
     session_(cci_->CassSessionNew(), cci_),
     schema_session_(cci_->CassSessionNew(), cci_),
     keyspace_(),
-    io_thread_count_(2) {
+    io_thread_count_(2),
+    select_prepared_cache_(cci_),
+    write_coalescer_timer_(NULL),
+    hedge_timer_(NULL) {
     // Set session state to INIT
     session_state_ = SessionState::INIT;
     schema_session_state_ = SessionState::INIT;
@@ -1906,6 +3400,12 @@ CqlIfImpl::~CqlIfImpl() {
         session_state_ == SessionState::DISCONNECTED);
     assert(schema_session_state_ == SessionState::INIT ||
         schema_session_state_ == SessionState::DISCONNECTED);
+    if (write_coalescer_timer_) {
+        TimerManager::DeleteTimer(write_coalescer_timer_);
+    }
+    if (hedge_timer_) {
+        TimerManager::DeleteTimer(hedge_timer_);
+    }
 }
 
 bool CqlIfImpl::CreateKeyspaceIfNotExistsSync(const std::string &keyspace,
@@ -2035,6 +3535,26 @@ bool CqlIfImpl::LocatePrepareInsertIntoTable(const GenDb::NewCf &cf) {
     return success;
 }
 
+void CqlIfImpl::LocateInsertPlan(const GenDb::NewCf &cf) {
+    tbb::mutex::scoped_lock lock(map_mutex_);
+    if (insert_plan_map_.find(cf.cfname_) == insert_plan_map_.end()) {
+        insert_plan_map_.insert(std::make_pair(cf.cfname_,
+            impl::CassInsertPlanPtr(new impl::CassInsertPlan(cf))));
+    }
+}
+
+bool CqlIfImpl::GetInsertPlan(const std::string &table_name,
+    impl::CassInsertPlanPtr *plan) const {
+    tbb::mutex::scoped_lock lock(map_mutex_);
+    CassInsertPlanMapType::const_iterator it(
+        insert_plan_map_.find(table_name));
+    if (it == insert_plan_map_.end()) {
+        return false;
+    }
+    *plan = it->second;
+    return true;
+}
+
 bool CqlIfImpl::GetPrepareInsertIntoTable(const std::string &table_name,
     impl::CassPreparedPtr *prepared) const {
     tbb::mutex::scoped_lock lock(map_mutex_);
@@ -2077,25 +3597,83 @@ bool CqlIfImpl::SelectFromTableAsync(const std::string &cfname,
     if (session_state_ != SessionState::CONNECTED) {
         return false;
     }
-    std::string query(impl::PartitionKey2CassSelectFromTable(cfname,rkey));
+    std::string query;
+    impl::CassStatementPtr statement(SelectFromTableStatement(cfname,
+        std::vector<GenDb::DbDataValueVec>(1, rkey), GenDb::ColumnNameRange(),
+        GenDb::FieldNamesToReadVec(), GenDb::WhereIndexInfoVec(), &query));
     if (IsTableStatic(cfname) == 1) {
+        if (hedged_reads_.IsHedged(cfname)) {
+            return HedgedSelectAsync(query, statement, consistency,
+                impl::CassQueryResultContext(cfname, false, rkey), cb);
+        }
         return impl::StaticCfGetResultAsync(cci_, session_.get(),
-            query.c_str(), consistency, cb, cfname.c_str(), rkey);
+            query.c_str(), statement.get(), consistency, cb, cfname.c_str(),
+            rkey);
     } else if (IsTableStatic(cfname) == 0) {
         size_t rk_count;
-        assert(impl::GetCassTablePartitionKeyCount(cci_, session_.get(),
-            keyspace_, cfname, &rk_count));
+        bool rk_found(impl::GetCassTablePartitionKeyCount(cci_,
+            session_.get(), keyspace_, cfname, &rk_count));
+        assert(rk_found);
         size_t ck_count;
-        assert(impl::GetCassTableClusteringKeyCount(cci_, session_.get(),
-            keyspace_, cfname, &ck_count));
+        bool ck_found(impl::GetCassTableClusteringKeyCount(cci_,
+            session_.get(), keyspace_, cfname, &ck_count));
+        assert(ck_found);
+        if (hedged_reads_.IsHedged(cfname)) {
+            return HedgedSelectAsync(query, statement, consistency,
+                impl::CassQueryResultContext(cfname, true, rkey, rk_count,
+                    ck_count), cb);
+        }
         return impl::DynamicCfGetResultAsync(cci_, session_.get(),
-            query.c_str(), consistency, cb, rk_count, ck_count,
-            cfname, rkey);
+            query.c_str(), statement.get(), consistency, cb, rk_count,
+            ck_count, cfname, rkey);
    } else {
         return false;
    }
 }
 
+bool CqlIfImpl::HedgedSelectAsync(const std::string &query,
+    impl::CassStatementPtr statement, CassConsistency consistency,
+    const impl::CassQueryResultContext &rctx,
+    impl::CassAsyncQueryCallback cb) {
+    // The session is kept for the hedge, which may execute after a
+    // reconnect
+    hedged_reads_.Read(rctx.cf_name_, boost::bind(&impl::ExecuteSelectAsync,
+        cci_, session_, query, statement, consistency, rctx, _1), cb);
+    return true;
+}
+
+bool CqlIfImpl::SelectFromTablePagedAsync(const std::string &cfname,
+    const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+    const GenDb::ColumnNameRange &ck_range, size_t page_size,
+    CassConsistency consistency, impl::CassPagedSelect::PageCb cb) {
+    if (session_state_ != SessionState::CONNECTED) {
+        return false;
+    }
+    int is_static(IsTableStatic(cfname));
+    if (is_static == -1) {
+        return false;
+    }
+    std::string query;
+    impl::CassStatementPtr statement(SelectFromTableStatement(cfname,
+        v_rowkey, ck_range, GenDb::FieldNamesToReadVec(),
+        GenDb::WhereIndexInfoVec(), &query));
+    size_t rk_count;
+    bool rk_found(impl::GetCassTablePartitionKeyCount(cci_,
+        session_.get(), keyspace_, cfname, &rk_count));
+    assert(rk_found);
+    size_t ck_count(0);
+    if (!is_static) {
+        bool ck_found(impl::GetCassTableClusteringKeyCount(cci_,
+            session_.get(), keyspace_, cfname, &ck_count));
+        assert(ck_found);
+    }
+    impl::CassPagedSelectPtr select(new impl::CassPagedSelect(cci_,
+        session_, query, statement, consistency, page_size, !is_static,
+        rk_count, ck_count, cb));
+    select->Start();
+    return true;
+}
+
 bool CqlIfImpl::SelectFromTableClusteringKeyRangeAndIndexValueAsync(
     const std::string &cfname, const GenDb::DbDataValueVec &rkey,
     const GenDb::ColumnNameRange &ck_range,
@@ -2105,19 +3683,22 @@ bool CqlIfImpl::SelectFromTableClusteringKeyRangeAndIndexValueAsync(
         if (session_state_ != SessionState::CONNECTED) {
         return false;
     }
-    std::string query(
-        impl::ClusteringKeyRangeAndIndexValue2CassSelectFromTable(cfname,
-        rkey, ck_range, where_vec, read_vec));
+    std::string query;
+    impl::CassStatementPtr statement(SelectFromTableStatement(cfname,
+        std::vector<GenDb::DbDataValueVec>(1, rkey), ck_range, read_vec,
+        where_vec, &query));
     assert(IsTableDynamic(cfname));
     size_t rk_count;
-    assert(impl::GetCassTablePartitionKeyCount(cci_, session_.get(),
-        keyspace_, cfname, &rk_count));
+    bool rk_found(impl::GetCassTablePartitionKeyCount(cci_,
+        session_.get(), keyspace_, cfname, &rk_count));
+    assert(rk_found);
     size_t ck_count;
-    assert(impl::GetCassTableClusteringKeyCount(cci_, session_.get(),
-        keyspace_, cfname, &ck_count));
+    bool ck_found(impl::GetCassTableClusteringKeyCount(cci_,
+        session_.get(), keyspace_, cfname, &ck_count));
+    assert(ck_found);
     return impl::DynamicCfGetResultAsync(cci_, session_.get(),
-        query.c_str(), consistency, cb, rk_count, ck_count, cfname.c_str(),
-        rkey);
+        query.c_str(), statement.get(), consistency, cb, rk_count, ck_count,
+        cfname.c_str(), rkey);
 }
 
 bool CqlIfImpl::SelectFromTableClusteringKeyRangeAsync(
@@ -2127,19 +3708,57 @@ bool CqlIfImpl::SelectFromTableClusteringKeyRangeAsync(
     if (session_state_ != SessionState::CONNECTED) {
         return false;
     }
-    std::string query(
-        impl::PartitionKeyAndClusteringKeyRange2CassSelectFromTable(cfname,
-        rkey, ck_range));
+    std::string query;
+    impl::CassStatementPtr statement(SelectFromTableStatement(cfname,
+        std::vector<GenDb::DbDataValueVec>(1, rkey), ck_range,
+        GenDb::FieldNamesToReadVec(), GenDb::WhereIndexInfoVec(), &query));
     assert(IsTableDynamic(cfname));
     size_t rk_count;
-    assert(impl::GetCassTablePartitionKeyCount(cci_, session_.get(),
-        keyspace_, cfname, &rk_count));
+    bool rk_found(impl::GetCassTablePartitionKeyCount(cci_,
+        session_.get(), keyspace_, cfname, &rk_count));
+    assert(rk_found);
     size_t ck_count;
-    assert(impl::GetCassTableClusteringKeyCount(cci_, session_.get(),
-        keyspace_, cfname, &ck_count));
+    bool ck_found(impl::GetCassTableClusteringKeyCount(cci_,
+        session_.get(), keyspace_, cfname, &ck_count));
+    assert(ck_found);
+    if (hedged_reads_.IsHedged(cfname)) {
+        return HedgedSelectAsync(query, statement, consistency,
+            impl::CassQueryResultContext(cfname, true, rkey, rk_count,
+                ck_count), cb);
+    }
     return impl::DynamicCfGetResultAsync(cci_, session_.get(),
-        query.c_str(), consistency, cb, rk_count, ck_count, cfname.c_str(),
-        rkey);
+        query.c_str(), statement.get(), consistency, cb, rk_count, ck_count,
+        cfname.c_str(), rkey);
+}
+
+bool CqlIfImpl::SelectFromTableClusteringKeyRangeColumnsAsync(
+    const std::string &cfname, const GenDb::DbDataValueVec &rkey,
+    const GenDb::ColumnNameRange &ck_range, CassConsistency consistency,
+    impl::CassAsyncColumnsCallback cb) {
+    if (session_state_ != SessionState::CONNECTED) {
+        return false;
+    }
+    int is_static(IsTableStatic(cfname));
+    if (is_static == -1) {
+        return false;
+    }
+    std::string query;
+    impl::CassStatementPtr statement(SelectFromTableStatement(cfname,
+        std::vector<GenDb::DbDataValueVec>(1, rkey), ck_range,
+        GenDb::FieldNamesToReadVec(), GenDb::WhereIndexInfoVec(), &query));
+    size_t rk_count;
+    bool rk_found(impl::GetCassTablePartitionKeyCount(cci_,
+        session_.get(), keyspace_, cfname, &rk_count));
+    assert(rk_found);
+    size_t ck_count(0);
+    if (!is_static) {
+        bool ck_found(impl::GetCassTableClusteringKeyCount(cci_,
+            session_.get(), keyspace_, cfname, &ck_count));
+        assert(ck_found);
+    }
+    impl::ExecuteColumnsAsync(cci_, session_.get(), query.c_str(),
+        statement.get(), consistency, cb, !is_static, rk_count, ck_count);
+    return true;
 }
 
 bool CqlIfImpl::IsTableDynamic(const std::string &table) {
@@ -2176,20 +3795,25 @@ bool CqlIfImpl::SelectFromTableSync(const std::string &cfname,
     if (session_state_ != SessionState::CONNECTED) {
         return false;
     }
-    std::string query(impl::PartitionKey2CassSelectFromTable(cfname,
-        rkey));
+    std::string query;
+    impl::CassStatementPtr statement(SelectFromTableStatement(cfname,
+        std::vector<GenDb::DbDataValueVec>(1, rkey), GenDb::ColumnNameRange(),
+        GenDb::FieldNamesToReadVec(), GenDb::WhereIndexInfoVec(), &query));
     if (IsTableStatic(cfname) == 1) {
         return impl::StaticCfGetResultSync(cci_, session_.get(),
-            query.c_str(), consistency, out);
+            query.c_str(), statement.get(), consistency, out);
     } else if (IsTableStatic(cfname) == 0){
         size_t rk_count;
-        assert(impl::GetCassTablePartitionKeyCount(cci_, session_.get(),
-            keyspace_, cfname, &rk_count));
+        bool rk_found(impl::GetCassTablePartitionKeyCount(cci_,
+            session_.get(), keyspace_, cfname, &rk_count));
+        assert(rk_found);
         size_t ck_count;
-        assert(impl::GetCassTableClusteringKeyCount(cci_, session_.get(),
-            keyspace_, cfname, &ck_count));
+        bool ck_found(impl::GetCassTableClusteringKeyCount(cci_,
+            session_.get(), keyspace_, cfname, &ck_count));
+        assert(ck_found);
         return impl::DynamicCfGetResultSync(cci_, session_.get(),
-            query.c_str(), rk_count, ck_count, consistency, out);
+            query.c_str(), statement.get(), rk_count, ck_count, consistency,
+            out);
     } else {
         return false;
     }
@@ -2200,19 +3824,25 @@ bool CqlIfImpl::SelectFromTableSync(const std::string &cfname,
     if (session_state_ != SessionState::CONNECTED) {
         return false;
     }
-    std::string query(impl::CassSelectFromTable(cfname));
+    std::string query;
+    impl::CassStatementPtr statement(SelectFromTableStatement(cfname,
+        std::vector<GenDb::DbDataValueVec>(), GenDb::ColumnNameRange(),
+        GenDb::FieldNamesToReadVec(), GenDb::WhereIndexInfoVec(), &query));
     size_t rk_count;
-    assert(impl::GetCassTablePartitionKeyCount(cci_, session_.get(),
-        keyspace_, cfname, &rk_count));
+    bool rk_found(impl::GetCassTablePartitionKeyCount(cci_,
+        session_.get(), keyspace_, cfname, &rk_count));
+    assert(rk_found);
     if (IsTableStatic(cfname) == 1) {
         return impl::StaticCfGetResultSync(cci_, session_.get(),
-            query.c_str(), rk_count, consistency, out);
+            query.c_str(), statement.get(), rk_count, consistency, out);
     } else if (IsTableStatic(cfname) == 0){
         size_t ck_count;
-        assert(impl::GetCassTableClusteringKeyCount(cci_, session_.get(),
-            keyspace_, cfname, &ck_count));
+        bool ck_found(impl::GetCassTableClusteringKeyCount(cci_,
+            session_.get(), keyspace_, cfname, &ck_count));
+        assert(ck_found);
         return impl::DynamicCfGetResultSync(cci_, session_.get(),
-            query.c_str(), rk_count, ck_count, consistency, out);
+            query.c_str(), statement.get(), rk_count, ck_count, consistency,
+            out);
     } else {
         return false;
     }
@@ -2227,12 +3857,13 @@ bool CqlIfImpl::SelectFromTableClusteringKeyRangeFieldNamesSync(const std::strin
     if (session_state_ != SessionState::CONNECTED) {
         return false;
     }
-    std::string query(
-        impl::PartitionKeyAndClusteringKeyRange2CassSelectFromTable(cfname,
-        rkey, ck_range, read_vec));
+    std::string query;
+    impl::CassStatementPtr statement(SelectFromTableStatement(cfname,
+        std::vector<GenDb::DbDataValueVec>(1, rkey), ck_range, read_vec,
+        GenDb::WhereIndexInfoVec(), &query));
     assert(IsTableDynamic(cfname));
     return impl::DynamicCfGetResultSync(cci_, session_.get(),
-        query.c_str(), read_vec, consistency, out);
+        query.c_str(), statement.get(), read_vec, consistency, out);
 }
 
 bool CqlIfImpl::SelectFromTableClusteringKeyRangeFieldNamesSync(const std::string &cfname,
@@ -2243,12 +3874,12 @@ bool CqlIfImpl::SelectFromTableClusteringKeyRangeFieldNamesSync(const std::strin
     if (session_state_ != SessionState::CONNECTED) {
         return false;
     }
-    std::string query(
-        impl::PartitionKeyAndClusteringKeyRange2CassSelectFromTable(cfname,
-        rkeys, ck_range, read_vec));
+    std::string query;
+    impl::CassStatementPtr statement(SelectFromTableStatement(cfname, rkeys,
+        ck_range, read_vec, GenDb::WhereIndexInfoVec(), &query));
     assert(IsTableDynamic(cfname));
     return impl::DynamicCfGetResultSync(cci_, session_.get(),
-        query.c_str(), read_vec, consistency, out);
+        query.c_str(), statement.get(), read_vec, consistency, out);
 }
 
 
@@ -2259,18 +3890,55 @@ bool CqlIfImpl::SelectFromTableClusteringKeyRangeSync(const std::string &cfname,
     if (session_state_ != SessionState::CONNECTED) {
         return false;
     }
-    std::string query(
-        impl::PartitionKeyAndClusteringKeyRange2CassSelectFromTable(cfname,
-        rkey, ck_range));
+    std::string query;
+    impl::CassStatementPtr statement(SelectFromTableStatement(cfname,
+        std::vector<GenDb::DbDataValueVec>(1, rkey), ck_range,
+        GenDb::FieldNamesToReadVec(), GenDb::WhereIndexInfoVec(), &query));
     assert(IsTableDynamic(cfname));
     size_t rk_count;
-    assert(impl::GetCassTablePartitionKeyCount(cci_, session_.get(),
-        keyspace_, cfname, &rk_count));
+    bool rk_found(impl::GetCassTablePartitionKeyCount(cci_,
+        session_.get(), keyspace_, cfname, &rk_count));
+    assert(rk_found);
     size_t ck_count;
-    assert(impl::GetCassTableClusteringKeyCount(cci_, session_.get(),
-        keyspace_, cfname, &ck_count));
+    bool ck_found(impl::GetCassTableClusteringKeyCount(cci_,
+        session_.get(), keyspace_, cfname, &ck_count));
+    assert(ck_found);
     return impl::DynamicCfGetResultSync(cci_, session_.get(),
-        query.c_str(), rk_count, ck_count, consistency, out);
+        query.c_str(), statement.get(), rk_count, ck_count, consistency,
+        out);
+}
+
+impl::CassStatementPtr CqlIfImpl::SelectFromTableStatement(
+    const std::string &cfname,
+    const std::vector<GenDb::DbDataValueVec> &rkeys,
+    const GenDb::ColumnNameRange &ck_range,
+    const GenDb::FieldNamesToReadVec &read_vec,
+    const GenDb::WhereIndexInfoVec &where_vec, std::string *query) {
+    // Each IN list arity is a different query, only the short lists are
+    // prepared so that the multi row reads do not fill up the cache
+    if (rkeys.size() <= kMaxPreparedSelectKeys) {
+        GenDb::DbDataValueVec values;
+        *query = impl::CassPrepareSelectFromTable(cfname, rkeys, ck_range,
+            read_vec, where_vec, &values);
+        impl::CassPreparedPtr prepared(NULL, cci_);
+        if (select_prepared_cache_.Lookup(session_.get(), *query,
+                &prepared)) {
+            impl::CassStatementPtr statement(
+                cci_->CassPreparedBind(prepared.get()), cci_);
+            if (impl::CassStatementBindValues(cci_, statement.get(),
+                    values)) {
+                return statement;
+            }
+            if (select_prepared_cache_.BindFailed(*query)) {
+                CQLIF_ERR_TRACE("Bind FAILED, executed as text: " << *query);
+            }
+        }
+    }
+    // Not prepared yet, or the values could not be bound
+    *query = impl::CassSelectFromTableInternal(cfname, rkeys, ck_range,
+        read_vec, where_vec);
+    return impl::CassStatementPtr(cci_->CassStatementNew(query->c_str(), 0),
+        cci_);
 }
 
 void CqlIfImpl::SetRequestTimeout(uint32_t timeout_ms) {
@@ -2278,6 +3946,72 @@ void CqlIfImpl::SetRequestTimeout(uint32_t timeout_ms) {
     cci_->CassClusterSetRequestTimeout(cluster_.get(), timeout_ms);
 }
 
+bool CqlIfImpl::EnableWriteCoalescing(size_t max_statements,
+    size_t max_bytes, int linger_msecs) {
+    assert(session_state_ != SessionState::CONNECTED);
+    if (evm_ == NULL) {
+        CQLIF_ERR_TRACE("Write coalescing: FAILED: No event manager");
+        return false;
+    }
+    CQLIF_INFO_TRACE("Write coalescing: max statements: " << max_statements <<
+        ", max bytes: " << max_bytes << ", linger msecs: " << linger_msecs);
+    write_coalescer_.reset(new impl::CassWriteCoalescer(cci_, max_statements,
+        max_bytes, linger_msecs));
+    if (write_coalescer_timer_ == NULL) {
+        write_coalescer_timer_ = TimerManager::CreateTimer(
+            *evm_->io_service(), "CqlIfImpl Write Coalescer Timer",
+            TaskScheduler::GetInstance()->GetTaskId(kTaskName),
+            kTaskInstance);
+    }
+    return true;
+}
+
+void CqlIfImpl::SetReadHedgePolicy(const std::string &table,
+    const impl::CassHedgedReads::Policy &policy) {
+    CQLIF_INFO_TRACE("Read hedging: " << table << ": percentile: " <<
+        policy.percentile << ", min delay msecs: " << policy.min_delay_msecs <<
+        ", max delay msecs: " << policy.max_delay_msecs <<
+        ", budget percent: " << policy.budget_percent);
+    hedged_reads_.SetPolicy(table, policy);
+    if (evm_ == NULL) {
+        return;
+    }
+    if (hedge_timer_ == NULL) {
+        hedge_timer_ = TimerManager::CreateTimer(*evm_->io_service(),
+            "CqlIfImpl Hedge Timer",
+            TaskScheduler::GetInstance()->GetTaskId(kTaskName),
+            kTaskInstance);
+    }
+    if (session_state_ == SessionState::CONNECTED) {
+        hedge_timer_->Start(kHedgeTimerMsecs,
+            boost::bind(&CqlIfImpl::HedgeTimerExpired, this));
+    }
+}
+
+void CqlIfImpl::ClearReadHedgePolicy(const std::string &table) {
+    hedged_reads_.ClearPolicy(table);
+    // Reads waiting for a cleared policy are not hedged
+    if (hedge_timer_ && hedged_reads_.policies() == 0) {
+        hedge_timer_->Cancel();
+    }
+}
+
+bool CqlIfImpl::HedgeTimerExpired() {
+    if (session_state_ == SessionState::CONNECTED) {
+        hedged_reads_.HedgeExpired(ClockMonotonicUsec());
+    }
+    // Periodic
+    return true;
+}
+
+bool CqlIfImpl::WriteCoalescerTimerExpired() {
+    if (session_state_ == SessionState::CONNECTED) {
+        write_coalescer_->FlushExpired(session_.get(), ClockMonotonicUsec());
+    }
+    // Periodic
+    return true;
+}
+
 bool CqlIfImpl::ConnectSchemaSync() {
     /* If Connect is called multiple times due to DB failure,
      * then it is better to delete previous session and use
@@ -2310,15 +4044,26 @@ bool CqlIfImpl::ConnectSync() {
      * then it is better to delete previous session and use
      * a new one to avoid gradual leak.
      */
+    // The waiting hedges refer to the previous session
+    hedged_reads_.Clear();
     session_.reset();
     impl::CassSessionPtr session(cci_->CassSessionNew(), cci_);
     session_.swap(session);
+    select_prepared_cache_.Clear();
 
     impl::CassFuturePtr future(cci_->CassSessionConnect(session_.get(),
         cluster_.get()), cci_);
     bool success(impl::SyncFutureWait(cci_, future.get()));
     if (success) {
         session_state_ = SessionState::CONNECTED;
+        if (write_coalescer_timer_) {
+            write_coalescer_timer_->Start(write_coalescer_->flush_msecs(),
+                boost::bind(&CqlIfImpl::WriteCoalescerTimerExpired, this));
+        }
+        if (hedge_timer_ && hedged_reads_.policies() != 0) {
+            hedge_timer_->Start(kHedgeTimerMsecs,
+                boost::bind(&CqlIfImpl::HedgeTimerExpired, this));
+        }
         CQLIF_INFO_TRACE("ConnectSync Done");
     } else {
         CQLIF_ERR_TRACE("ConnectSync FAILED");
@@ -2327,6 +4072,20 @@ bool CqlIfImpl::ConnectSync() {
 }
 
 bool CqlIfImpl::DisconnectSync() {
+    if (write_coalescer_timer_) {
+        write_coalescer_timer_->Cancel();
+    }
+    if (hedge_timer_) {
+        hedge_timer_->Cancel();
+    }
+    // The outstanding reads complete when the session is closed
+    hedged_reads_.Clear();
+    // Fail the inserts waiting in the queue
+    write_queue_.Clear();
+    // Execute the coalesced inserts before the session is closed
+    if (write_coalescer_) {
+        write_coalescer_->Flush(session_.get());
+    }
     // Close all session and pending queries
     impl::CassFuturePtr future(cci_->CassSessionClose(session_.get()), cci_);
     bool success(impl::SyncFutureWait(cci_, future.get()));
@@ -2353,6 +4112,23 @@ bool CqlIfImpl::DisconnectSchemaSync() {
     return success;
 }
 
+void CqlIfImpl::SetWriteQueueLimits(size_t max_in_flight,
+    size_t max_table_in_flight, size_t max_queued) {
+    CQLIF_INFO_TRACE("Write queue: max in flight: " << max_in_flight <<
+        ", max table in flight: " << max_table_in_flight <<
+        ", max queued: " << max_queued);
+    write_queue_.SetLimits(max_in_flight, max_table_in_flight, max_queued);
+}
+
+void CqlIfImpl::SetWriteQueueWaterMark(bool high, size_t count,
+    WaterMarkCallback cb) {
+    write_queue_.SetWaterMark(high, count, cb);
+}
+
+void CqlIfImpl::ResetWriteQueueWaterMarks() {
+    write_queue_.ResetWaterMarks();
+}
+
 bool CqlIfImpl::GetMetrics(Metrics *metrics) const {
     if (session_state_ != SessionState::CONNECTED) {
         return false;
@@ -2407,6 +4183,21 @@ bool CqlIfImpl::InsertIntoTableInternal(std::auto_ptr<GenDb::ColList> v_columns,
     if (session_state_ != SessionState::CONNECTED) {
         return false;
     }
+    impl::CassInsertPlanPtr plan;
+    if (GetInsertPlan(v_columns->cfname_, &plan)) {
+        impl::CassStatementPtr statement(plan->NewStatement(cci_,
+            v_columns.get()), cci_);
+        if (statement.get() != NULL) {
+            if (sync) {
+                return impl::ExecuteQueryStatementSync(cci_, session_.get(),
+                    statement.get(), consistency);
+            }
+            std::string qid("Plan: " + v_columns->cfname_);
+            InsertIntoTableStatementAsync(v_columns.get(), qid.c_str(),
+                statement, consistency, cb);
+            return true;
+        }
+    }
     std::string query;
     if (IsTableStatic(v_columns->cfname_) == 1) {
         query = impl::StaticCf2CassInsertIntoTable(v_columns.get());
@@ -2419,12 +4210,37 @@ bool CqlIfImpl::InsertIntoTableInternal(std::auto_ptr<GenDb::ColList> v_columns,
         return impl::ExecuteQuerySync(cci_, session_.get(), query.c_str(),
             consistency);
     } else {
-        impl::ExecuteQueryAsync(cci_, session_.get(), query.c_str(),
-            consistency, cb);
+        impl::CassStatementPtr statement(cci_->CassStatementNew(query.c_str(),
+            0), cci_);
+        InsertIntoTableStatementAsync(v_columns.get(), query.c_str(),
+            statement, consistency, cb);
         return true;
     }
 }
 
+void CqlIfImpl::InsertIntoTableStatementAsync(
+    const GenDb::ColList *v_columns, const char *query_id,
+    impl::CassStatementPtr statement, CassConsistency consistency,
+    impl::CassAsyncQueryCallback cb) {
+    write_queue_.Enqueue(v_columns->cfname_,
+        boost::bind(&CqlIfImpl::ExecuteInsertStatementAsync, this,
+            v_columns->cfname_, v_columns->rowkey_, std::string(query_id),
+            statement, consistency, v_columns->GetSize(), _1), cb);
+}
+
+void CqlIfImpl::ExecuteInsertStatementAsync(const std::string &table,
+    const GenDb::DbDataValueVec &rowkey, const std::string &query_id,
+    impl::CassStatementPtr statement, CassConsistency consistency,
+    size_t size, impl::CassAsyncQueryCallback cb) {
+    if (write_coalescer_) {
+        write_coalescer_->AddStatement(session_.get(), table, rowkey,
+            consistency, statement, size, cb);
+        return;
+    }
+    impl::ExecuteQueryStatementAsync(cci_, session_.get(), query_id.c_str(),
+        statement.get(), consistency, cb);
+}
+
 bool CqlIfImpl::PrepareInsertIntoTableSync(const GenDb::NewCf &cf,
     impl::CassPreparedPtr *prepared) {
     if (schema_session_state_ != SessionState::CONNECTED) {
@@ -2488,8 +4304,8 @@ bool CqlIfImpl::InsertIntoTablePrepareInternal(
             qstatement.get(), consistency);
     } else {
         std::string qid("Prepare: " + v_columns->cfname_);
-        impl::ExecuteQueryStatementAsync(cci_, session_.get(), qid.c_str(),
-            qstatement.get(), consistency, cb);
+        InsertIntoTableStatementAsync(v_columns.get(), qid.c_str(),
+            qstatement, consistency, cb);
         return true;
     }
 }
@@ -2516,7 +4332,8 @@ CqlIf::CqlIf(EventManager *evm,
         cassandra_user, cassandra_password, use_ssl,
         ca_certs_path, cci_.get())),
     use_prepared_for_insert_(true),
-    create_schema_(create_schema) {
+    create_schema_(create_schema),
+    multi_row_get_window_(kDefaultMultiRowGetWindow) {
     // Setup library logging
     cci_->CassLogSetLevel(impl::Log4Level2CassLogLevel(
         log4cplus::Logger::getRoot().getLogLevel()));
@@ -2531,7 +4348,9 @@ CqlIf::CqlIf(EventManager *evm,
     }
 }
 
-CqlIf::CqlIf() : impl_(NULL) {
+CqlIf::CqlIf() :
+    impl_(NULL),
+    multi_row_get_window_(kDefaultMultiRowGetWindow) {
 }
 
 CqlIf::~CqlIf() {
@@ -2612,13 +4431,18 @@ bool CqlIf::Db_AddColumnfamily(const GenDb::NewCf &cf,
         IncrementErrors(GenDb::IfErrors::ERR_WRITE_COLUMN_FAMILY);
         return success;
     }
+    impl_->LocateInsertPlan(cf);
     IncrementTableWriteStats(cf.cfname_);
     return success;
 }
 
 bool CqlIf::Db_UseColumnfamily(const GenDb::NewCf &cf) {
     // Check existence of table
-    return Db_UseColumnfamily(cf.cfname_);
+    bool success(Db_UseColumnfamily(cf.cfname_));
+    if (success) {
+        impl_->LocateInsertPlan(cf);
+    }
+    return success;
 }
 
 bool CqlIf::Db_UseColumnfamily(const std::string &cfname) {
@@ -2665,6 +4489,21 @@ void CqlIf::OnAsyncColumnAddCompletion(GenDb::DbOpResult::type drc,
     }
 }
 
+impl::CassAsyncQueryCallback CqlIf::TimedCallback(const std::string &cfname,
+    GenDb::DbTableLatencyStatistics::Op op, impl::CassAsyncQueryCallback cb) {
+    return boost::bind(&CqlIf::OnTimedCompletion, this, _1, _2, cfname, op,
+        ClockMonotonicUsec(), cb);
+}
+
+void CqlIf::OnTimedCompletion(GenDb::DbOpResult::type drc,
+    std::auto_ptr<GenDb::ColList> row, std::string cfname,
+    GenDb::DbTableLatencyStatistics::Op op, uint64_t start_usecs,
+    impl::CassAsyncQueryCallback cb) {
+    // The latency statistics do not need the stats lock
+    stats_.UpdateTableLatency(cfname, op, ClockMonotonicUsec() - start_usecs);
+    cb(drc, row);
+}
+
 struct AsyncRowGetCallbackContext {
     AsyncRowGetCallbackContext(GenDb::GenDbIf::DbGetRowCb cb,
         GenDb::DbOpResult::type drc, std::auto_ptr<GenDb::ColList> row) :
@@ -2699,11 +4538,8 @@ void CqlIf::OnAsyncRowGetCompletion(GenDb::DbOpResult::type drc,
         if (!cb.empty()) {
             boost::shared_ptr<AsyncRowGetCallbackContext> ctx(
                 new AsyncRowGetCallbackContext(cb, drc, row));
-            impl::WorkerTask *worker(new impl::WorkerTask(
-                boost::bind(&AsyncRowGetCompletionCallback, ctx),
-                    task_id, task_instance));
-            TaskScheduler *scheduler = TaskScheduler::GetInstance();
-            scheduler->Enqueue(worker);
+            completion_queues_.Enqueue(task_id, task_instance,
+                boost::bind(&AsyncRowGetCompletionCallback, ctx));
         }
     } else {
         if (!cb.empty()) {
@@ -2717,6 +4553,23 @@ void CqlIf::OnAsyncRowGetCompletion(GenDb::DbOpResult::type drc,
     GenDb::GenDbIf::DbGetRowCb cb) {
     OnAsyncRowGetCompletion(drc, row, cfname, cb, false, -1, -2);
 }
+void CqlIf::OnAsyncRowColumnsGetCompletion(GenDb::DbOpResult::type drc,
+    impl::CassResultColumnsPtr columns, std::string cfname,
+    DbGetRowColumnsCb cb) {
+    if (drc == GenDb::DbOpResult::OK) {
+        IncrementTableReadStats(cfname);
+    } else if (drc == GenDb::DbOpResult::BACK_PRESSURE) {
+        IncrementTableReadBackPressureFailStats(cfname);
+        IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN);
+    } else {
+        IncrementTableReadFailStats(cfname);
+        IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN);
+    }
+    if (!cb.empty()) {
+        cb(drc, columns);
+    }
+}
+
 bool CqlIf::Db_AddColumn(std::auto_ptr<GenDb::ColList> cl,
     GenDb::DbConsistency::type dconsistency,
     GenDb::GenDbIf::DbAddColumnCb cb) {
@@ -2727,16 +4580,23 @@ bool CqlIf::Db_AddColumn(std::auto_ptr<GenDb::ColList> cl,
         return false;
     }
     CassConsistency consistency(impl::Db2CassConsistency(dconsistency));
+    bool prepared(use_prepared_for_insert_ &&
+        impl_->IsInsertIntoTablePrepareSupported(cfname));
+    GenDb::DbTableLatencyStatistics::Op op(
+        GenDb::DbTableLatencyStatistics::OP_INSERT);
+    if (impl_->write_coalescer() != NULL) {
+        op = GenDb::DbTableLatencyStatistics::OP_BATCH_INSERT;
+    } else if (prepared) {
+        op = GenDb::DbTableLatencyStatistics::OP_PREPARED_INSERT;
+    }
+    impl::CassAsyncQueryCallback add_cb(TimedCallback(cfname, op,
+        boost::bind(&CqlIf::OnAsyncColumnAddCompletion, this, _1, _2, cfname,
+        cb)));
     bool success;
-    if (use_prepared_for_insert_ &&
-        impl_->IsInsertIntoTablePrepareSupported(cfname)) {
-        success = impl_->InsertIntoTablePrepareAsync(cl, consistency,
-            boost::bind(&CqlIf::OnAsyncColumnAddCompletion, this, _1, _2, cfname,
-            cb));
+    if (prepared) {
+        success = impl_->InsertIntoTablePrepareAsync(cl, consistency, add_cb);
     } else {
-        success = impl_->InsertIntoTableAsync(cl, consistency,
-            boost::bind(&CqlIf::OnAsyncColumnAddCompletion, this, _1, _2, cfname,
-            cb));
+        success = impl_->InsertIntoTableAsync(cl, consistency, add_cb);
     }
     if (!success) {
         IncrementTableWriteFailStats(cfname);
@@ -2766,8 +4626,10 @@ bool CqlIf::Db_GetRowAsync(const std::string &cfname,
     GenDb::DbConsistency::type dconsistency, GenDb::GenDbIf::DbGetRowCb cb) {
     CassConsistency consistency(impl::Db2CassConsistency(dconsistency));
     bool success(impl_->SelectFromTableClusteringKeyRangeAsync(cfname, rowkey,
-        crange, consistency, boost::bind(&CqlIf::OnAsyncRowGetCompletion, this,
-        _1, _2, cfname, cb)));
+        crange, consistency, TimedCallback(cfname,
+        GenDb::DbTableLatencyStatistics::OP_SELECT,
+        boost::bind(&CqlIf::OnAsyncRowGetCompletion, this, _1, _2, cfname,
+        cb))));
     if (!success) {
         IncrementTableReadFailStats(cfname);
         IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN_FAMILY);
@@ -2781,8 +4643,10 @@ bool CqlIf::Db_GetRowAsync(const std::string &cfname,
     GenDb::GenDbIf::DbGetRowCb cb) {
     CassConsistency consistency(impl::Db2CassConsistency(dconsistency));
     bool success(impl_->SelectFromTableClusteringKeyRangeAsync(cfname, rowkey,
-        crange, consistency, boost::bind(&CqlIf::OnAsyncRowGetCompletion, this,
-        _1, _2, cfname, cb, true, task_id, task_instance)));
+        crange, consistency, TimedCallback(cfname,
+        GenDb::DbTableLatencyStatistics::OP_SELECT,
+        boost::bind(&CqlIf::OnAsyncRowGetCompletion, this, _1, _2, cfname,
+        cb, true, task_id, task_instance))));
     if (!success) {
         IncrementTableReadFailStats(cfname);
         IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN_FAMILY);
@@ -2796,8 +4660,10 @@ bool CqlIf::Db_GetRowAsync(const std::string &cfname,
     GenDb::GenDbIf::DbGetRowCb cb) {
     CassConsistency consistency(impl::Db2CassConsistency(dconsistency));
     bool success(impl_->SelectFromTableAsync(cfname, rowkey,
-        consistency, boost::bind(&CqlIf::OnAsyncRowGetCompletion, this, _1, _2,
-        cfname, cb)));
+        consistency, TimedCallback(cfname,
+        GenDb::DbTableLatencyStatistics::OP_SELECT,
+        boost::bind(&CqlIf::OnAsyncRowGetCompletion, this, _1, _2, cfname,
+        cb))));
     if (!success) {
         IncrementTableReadFailStats(cfname);
         IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN_FAMILY);
@@ -2811,8 +4677,10 @@ bool CqlIf::Db_GetRowAsync(const std::string &cfname,
     GenDb::GenDbIf::DbGetRowCb cb) {
     CassConsistency consistency(impl::Db2CassConsistency(dconsistency));
     bool success(impl_->SelectFromTableAsync(cfname, rowkey,
-        consistency, boost::bind(&CqlIf::OnAsyncRowGetCompletion, this, _1, _2,
-        cfname, cb, true, task_id, task_instance)));
+        consistency, TimedCallback(cfname,
+        GenDb::DbTableLatencyStatistics::OP_SELECT,
+        boost::bind(&CqlIf::OnAsyncRowGetCompletion, this, _1, _2, cfname,
+        cb, true, task_id, task_instance))));
     if (!success) {
         IncrementTableReadFailStats(cfname);
         IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN_FAMILY);
@@ -2827,7 +4695,23 @@ bool CqlIf::Db_GetRowAsync(const std::string &cfname,
     CassConsistency consistency(impl::Db2CassConsistency(dconsistency));
     bool success(impl_->SelectFromTableClusteringKeyRangeAndIndexValueAsync(cfname,
         rowkey, crange, where_vec, GenDb::FieldNamesToReadVec(), consistency,
-        boost::bind(&CqlIf::OnAsyncRowGetCompletion, this, _1, _2, cfname, cb)));
+        TimedCallback(cfname, GenDb::DbTableLatencyStatistics::OP_SELECT,
+        boost::bind(&CqlIf::OnAsyncRowGetCompletion, this, _1, _2, cfname,
+        cb))));
+    if (!success) {
+        IncrementTableReadFailStats(cfname);
+        IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN_FAMILY);
+    }
+    return success;
+}
+
+bool CqlIf::Db_GetRowColumnsAsync(const std::string &cfname,
+    const GenDb::DbDataValueVec &rowkey, const GenDb::ColumnNameRange &crange,
+    GenDb::DbConsistency::type dconsistency, DbGetRowColumnsCb cb) {
+    CassConsistency consistency(impl::Db2CassConsistency(dconsistency));
+    bool success(impl_->SelectFromTableClusteringKeyRangeColumnsAsync(cfname,
+        rowkey, crange, consistency, boost::bind(
+        &CqlIf::OnAsyncRowColumnsGetCompletion, this, _1, _2, cfname, cb)));
     if (!success) {
         IncrementTableReadFailStats(cfname);
         IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN_FAMILY);
@@ -2867,50 +4751,155 @@ bool CqlIf::Db_GetRow(GenDb::ColList *out, const std::string &cfname,
     return success;
 }
 
-bool CqlIf::Db_GetMultiRow(GenDb::ColListVec *out, const std::string &cfname,
-    const std::vector<GenDb::DbDataValueVec> &v_rowkey) {
-    BOOST_FOREACH(const GenDb::DbDataValueVec &rkey, v_rowkey) {
-        std::auto_ptr<GenDb::ColList> v_columns(new GenDb::ColList);
-        // Partition Key
-        v_columns->rowkey_ = rkey;
-        bool success(impl_->SelectFromTableSync(cfname, rkey,
-            CASS_CONSISTENCY_ONE, &v_columns->columns_));
-        if (!success) {
-            CQLIF_ERR_TRACE("SELECT FROM Table: " << cfname << " Partition Key: "
-                << GenDb::DbDataValueVecToString(rkey) << " FAILED");
+struct AsyncMultiRowGetCallbackContext {
+    AsyncMultiRowGetCallbackContext(GenDb::GenDbIf::DbGetMultiRowCb cb,
+        GenDb::DbOpResult::type drc, std::auto_ptr<GenDb::ColListVec> rows) :
+        cb_(cb),
+        drc_(drc),
+        rows_(rows) {
+    }
+    GenDb::GenDbIf::DbGetMultiRowCb cb_;
+    GenDb::DbOpResult::type drc_;
+    std::auto_ptr<GenDb::ColListVec> rows_;
+};
+
+static void AsyncMultiRowGetCompletionCallback(
+    boost::shared_ptr<AsyncMultiRowGetCallbackContext> ctx) {
+    ctx->cb_(ctx->drc_, ctx->rows_);
+}
+
+void CqlIf::OnAsyncMultiRowGetCompletion(GenDb::DbOpResult::type drc,
+    std::auto_ptr<GenDb::ColListVec> rows, std::string cfname,
+    size_t num_rows, GenDb::GenDbIf::DbGetMultiRowCb cb, bool use_worker,
+    int task_id, int task_instance) {
+    if (drc == GenDb::DbOpResult::OK) {
+        IncrementTableReadStats(cfname, num_rows);
+    } else {
+        CQLIF_ERR_TRACE("SELECT FROM Table: " << cfname << " " << num_rows <<
+            " Partition Keys FAILED");
+        if (drc == GenDb::DbOpResult::BACK_PRESSURE) {
+            IncrementTableReadBackPressureFailStats(cfname);
+        } else {
             IncrementTableReadFailStats(cfname);
-            IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN);
-            return false;
         }
-        out->push_back(v_columns.release());
+        IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN);
     }
-    IncrementTableReadStats(cfname, v_rowkey.size());
+    if (cb.empty()) {
+        return;
+    }
+    if (use_worker) {
+        boost::shared_ptr<AsyncMultiRowGetCallbackContext> ctx(
+            new AsyncMultiRowGetCallbackContext(cb, drc, rows));
+        completion_queues_.Enqueue(task_id, task_instance,
+            boost::bind(&AsyncMultiRowGetCompletionCallback, ctx));
+    } else {
+        cb(drc, rows);
+    }
+}
+
+bool CqlIf::GetMultiRowAsync(const std::string &cfname,
+    const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+    const GenDb::ColumnNameRange &crange, CassConsistency consistency,
+    GenDb::GenDbIf::DbGetMultiRowCb cb, bool use_worker, int task_id,
+    int task_instance) {
+    impl::CassAsyncMultiRowSelect::SelectFn select_fn;
+    if (crange.IsEmpty()) {
+        select_fn = boost::bind(&CqlIfImpl::SelectFromTableAsync,
+            impl_.get(), cfname, _1, consistency, _2);
+    } else {
+        select_fn = boost::bind(
+            &CqlIfImpl::SelectFromTableClusteringKeyRangeAsync, impl_.get(),
+            cfname, _1, crange, consistency, _2);
+    }
+    impl::CassAsyncMultiRowSelect::SelectFn timed_select_fn(boost::bind(
+        &CqlIf::TimedSelectAsync, this, cfname, select_fn, _1, _2));
+    boost::shared_ptr<impl::CassAsyncMultiRowSelect> select(
+        new impl::CassAsyncMultiRowSelect(v_rowkey, multi_row_get_window_,
+            timed_select_fn, boost::bind(&CqlIf::OnAsyncMultiRowGetCompletion, this,
+                _1, _2, cfname, v_rowkey.size(), cb, use_worker, task_id,
+                task_instance)));
+    select->Start();
     return true;
 }
 
-bool CqlIf::Db_GetMultiRow(GenDb::ColListVec *out, const std::string &cfname,
+bool CqlIf::TimedSelectAsync(const std::string &cfname,
+    impl::CassAsyncMultiRowSelect::SelectFn select_fn,
+    const GenDb::DbDataValueVec &rowkey, impl::CassAsyncQueryCallback cb) {
+    return select_fn(rowkey, TimedCallback(cfname,
+        GenDb::DbTableLatencyStatistics::OP_SELECT, cb));
+}
+
+bool CqlIf::Db_GetMultiRowAsync(const std::string &cfname,
+    const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+    const GenDb::ColumnNameRange &crange,
+    GenDb::DbConsistency::type dconsistency,
+    GenDb::GenDbIf::DbGetMultiRowCb cb) {
+    CassConsistency consistency(impl::Db2CassConsistency(dconsistency));
+    return GetMultiRowAsync(cfname, v_rowkey, crange, consistency, cb, false,
+        -1, -2);
+}
+
+bool CqlIf::Db_GetMultiRowAsync(const std::string &cfname,
+    const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+    const GenDb::ColumnNameRange &crange,
+    GenDb::DbConsistency::type dconsistency, int task_id, int task_instance,
+    GenDb::GenDbIf::DbGetMultiRowCb cb) {
+    CassConsistency consistency(impl::Db2CassConsistency(dconsistency));
+    return GetMultiRowAsync(cfname, v_rowkey, crange, consistency, cb, true,
+        task_id, task_instance);
+}
+
+struct MultiRowGetSyncContext {
+    MultiRowGetSyncContext() :
+        done_(false),
+        drc_(GenDb::DbOpResult::ERROR) {
+    }
+    tbb::mutex mutex_;
+    tbb::interface5::condition_variable cond_var_;
+    bool done_;
+    GenDb::DbOpResult::type drc_;
+    std::auto_ptr<GenDb::ColListVec> rows_;
+};
+
+static void MultiRowGetSyncCompletion(
+    boost::shared_ptr<MultiRowGetSyncContext> ctx,
+    GenDb::DbOpResult::type drc, std::auto_ptr<GenDb::ColListVec> rows) {
+    tbb::mutex::scoped_lock lock(ctx->mutex_);
+    ctx->drc_ = drc;
+    ctx->rows_ = rows;
+    ctx->done_ = true;
+    ctx->cond_var_.notify_all();
+}
+
+bool CqlIf::GetMultiRowSync(GenDb::ColListVec *out, const std::string &cfname,
     const std::vector<GenDb::DbDataValueVec> &v_rowkey,
     const GenDb::ColumnNameRange &crange) {
-    BOOST_FOREACH(const GenDb::DbDataValueVec &rkey, v_rowkey) {
-        std::auto_ptr<GenDb::ColList> v_columns(new GenDb::ColList);
-        // Partition Key
-        v_columns->rowkey_ = rkey;
-        bool success(impl_->SelectFromTableClusteringKeyRangeSync(cfname,
-            rkey, crange, CASS_CONSISTENCY_ONE, &v_columns->columns_));
-        if (!success) {
-            CQLIF_ERR_TRACE("SELECT FROM Table: " << cfname << " Partition Key: "
-                << GenDb::DbDataValueVecToString(rkey) <<
-                " Clustering Key Range: " << crange.ToString() << " FAILED");
-            IncrementTableReadFailStats(cfname);
-            IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN);
-            return false;
-        }
-        out->push_back(v_columns.release());
+    boost::shared_ptr<MultiRowGetSyncContext> ctx(new MultiRowGetSyncContext);
+    GetMultiRowAsync(cfname, v_rowkey, crange, CASS_CONSISTENCY_ONE,
+        boost::bind(&MultiRowGetSyncCompletion, ctx, _1, _2), false, -1, -2);
+    tbb::interface5::unique_lock<tbb::mutex> lock(ctx->mutex_);
+    while (!ctx->done_) {
+        ctx->cond_var_.wait(lock);
+    }
+    if (ctx->drc_ != GenDb::DbOpResult::OK) {
+        return false;
     }
-    IncrementTableReadStats(cfname, v_rowkey.size());
+    out->transfer(out->end(), *ctx->rows_);
     return true;
 }
 
+// Selects the partitions in parallel, at most multi_row_get_window_ at a time
+bool CqlIf::Db_GetMultiRow(GenDb::ColListVec *out, const std::string &cfname,
+    const std::vector<GenDb::DbDataValueVec> &v_rowkey) {
+    return GetMultiRowSync(out, cfname, v_rowkey, GenDb::ColumnNameRange());
+}
+
+bool CqlIf::Db_GetMultiRow(GenDb::ColListVec *out, const std::string &cfname,
+    const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+    const GenDb::ColumnNameRange &crange) {
+    return GetMultiRowSync(out, cfname, v_rowkey, crange);
+}
+
 bool CqlIf::Db_GetMultiRow(GenDb::ColListVec *out, const std::string &cfname,
     const std::vector<GenDb::DbDataValueVec> &v_rowkey,
     const GenDb::ColumnNameRange &crange,
@@ -2944,17 +4933,19 @@ bool CqlIf::Db_GetAllRows(GenDb::ColListVec *out, const std::string &cfname,
 // Queue
 bool CqlIf::Db_GetQueueStats(uint64_t *queue_count,
         uint64_t *enqueues) const {
-    //return impl_->Db_GetQueueStats(queue_count, enqueues);
+    const impl::CassWriteQueue &write_queue(impl_->write_queue());
+    *queue_count = write_queue.count();
+    *enqueues = write_queue.enqueues();
     return true;
 }
 
 void CqlIf::Db_SetQueueWaterMark(bool high, size_t queue_count,
         GenDb::GenDbIf::DbQueueWaterMarkCb cb) {
-    //impl_->Db_SetQueueWaterMark(high, queue_count, cb);
+    impl_->SetWriteQueueWaterMark(high, queue_count, cb);
 }
 
 void CqlIf::Db_ResetQueueWaterMarks() {
-    //impl_->Db_ResetQueueWaterMarks();
+    impl_->ResetWriteQueueWaterMarks();
 }
 
 // Stats
@@ -2972,6 +4963,86 @@ bool CqlIf::Db_GetCumulativeStats(std::vector<GenDb::DbTableInfo> *vdbti,
     return true;
 }
 
+struct AsyncRowsPageCallbackContext {
+    AsyncRowsPageCallbackContext(GenDb::GenDbIf::DbGetRowsPageCb cb,
+        GenDb::DbOpResult::type drc, std::auto_ptr<GenDb::ColListVec> rows,
+        impl::CassPagedSelectPtr next) :
+        cb_(cb),
+        drc_(drc),
+        rows_(rows),
+        next_(next) {
+    }
+    GenDb::GenDbIf::DbGetRowsPageCb cb_;
+    GenDb::DbOpResult::type drc_;
+    std::auto_ptr<GenDb::ColListVec> rows_;
+    impl::CassPagedSelectPtr next_;
+};
+
+static void AsyncRowsPageCompletionCallback(
+    boost::shared_ptr<AsyncRowsPageCallbackContext> ctx) {
+    bool more(ctx->next_.get() != NULL);
+    if (ctx->cb_(ctx->drc_, ctx->rows_, more) && more) {
+        ctx->next_->FetchNextPage();
+    }
+}
+
+void CqlIf::OnAsyncRowsPageCompletion(GenDb::DbOpResult::type drc,
+    std::auto_ptr<GenDb::ColListVec> rows, impl::CassPagedSelectPtr next,
+    std::string cfname, GenDb::GenDbIf::DbGetRowsPageCb cb, int task_id,
+    int task_instance) {
+    if (drc == GenDb::DbOpResult::OK) {
+        IncrementTableReadStats(cfname);
+    } else if (drc == GenDb::DbOpResult::BACK_PRESSURE) {
+        IncrementTableReadBackPressureFailStats(cfname);
+        IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN);
+    } else {
+        IncrementTableReadFailStats(cfname);
+        IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN);
+    }
+    if (cb.empty()) {
+        return;
+    }
+    boost::shared_ptr<AsyncRowsPageCallbackContext> ctx(
+        new AsyncRowsPageCallbackContext(cb, drc, rows, next));
+    completion_queues_.Enqueue(task_id, task_instance,
+        boost::bind(&AsyncRowsPageCompletionCallback, ctx));
+}
+
+bool CqlIf::GetRowsPagedAsync(const std::string &cfname,
+    const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+    const GenDb::ColumnNameRange &crange, size_t page_size,
+    GenDb::DbConsistency::type dconsistency, int task_id, int task_instance,
+    GenDb::GenDbIf::DbGetRowsPageCb cb) {
+    CassConsistency consistency(impl::Db2CassConsistency(dconsistency));
+    bool success(impl_->SelectFromTablePagedAsync(cfname, v_rowkey, crange,
+        page_size, consistency, boost::bind(
+            &CqlIf::OnAsyncRowsPageCompletion, this, _1, _2, _3, cfname, cb,
+            task_id, task_instance)));
+    if (!success) {
+        IncrementTableReadFailStats(cfname);
+        IncrementErrors(GenDb::IfErrors::ERR_READ_COLUMN);
+    }
+    return success;
+}
+
+bool CqlIf::Db_GetAllRowsPagedAsync(const std::string &cfname,
+    size_t page_size, GenDb::DbConsistency::type dconsistency, int task_id,
+    int task_instance, GenDb::GenDbIf::DbGetRowsPageCb cb) {
+    return GetRowsPagedAsync(cfname, std::vector<GenDb::DbDataValueVec>(),
+        GenDb::ColumnNameRange(), page_size, dconsistency, task_id,
+        task_instance, cb);
+}
+
+bool CqlIf::Db_GetRowPagedAsync(const std::string &cfname,
+    const GenDb::DbDataValueVec &rowkey,
+    const GenDb::ColumnNameRange &crange, size_t page_size,
+    GenDb::DbConsistency::type dconsistency, int task_id, int task_instance,
+    GenDb::GenDbIf::DbGetRowsPageCb cb) {
+    return GetRowsPagedAsync(cfname,
+        std::vector<GenDb::DbDataValueVec>(1, rowkey), crange, page_size,
+        dconsistency, task_id, task_instance, cb);
+}
+
 bool CqlIf::Db_GetCqlMetrics(Metrics *metrics) const {
     return impl_->GetMetrics(metrics);
 }
@@ -2985,6 +5056,21 @@ bool CqlIf::Db_GetCqlStats(DbStats *db_stats) const {
     db_stats->requests_one_minute_rate = metrics.requests.one_minute_rate;
     db_stats->stats = metrics.stats;
     db_stats->errors = metrics.errors;
+    const impl::CassPreparedCache &cache(impl_->select_prepared_cache());
+    db_stats->prepared_selects.hits = cache.hits();
+    db_stats->prepared_selects.misses = cache.misses();
+    db_stats->prepared_selects.prepare_failures = cache.prepare_failures();
+    db_stats->prepared_selects.bind_failures = cache.bind_failures();
+    db_stats->prepared_selects.entries = cache.size();
+    db_stats->completion_queues.completions =
+        completion_queues_.completions();
+    db_stats->completion_queues.task_runs = completion_queues_.task_runs();
+    const impl::CassHedgedReads &hedged_reads(impl_->hedged_reads());
+    db_stats->hedged_reads.reads = hedged_reads.reads();
+    db_stats->hedged_reads.hedges = hedged_reads.hedges();
+    db_stats->hedged_reads.hedges_won = hedged_reads.hedges_won();
+    db_stats->hedged_reads.hedges_over_budget =
+        hedged_reads.hedges_over_budget();
     return success;
 }
 
@@ -3054,6 +5140,30 @@ std::vector<GenDb::Endpoint> CqlIf::Db_GetEndpoints() const {
     return endpoints_;
 }
 
+bool CqlIf::EnableWriteCoalescing(size_t max_statements, size_t max_bytes,
+    int linger_msecs) {
+    return impl_->EnableWriteCoalescing(max_statements, max_bytes, linger_msecs);
+}
+
+void CqlIf::SetMultiRowGetWindow(size_t window) {
+    multi_row_get_window_ = window;
+}
+
+void CqlIf::SetWriteQueueLimits(size_t max_in_flight,
+    size_t max_table_in_flight, size_t max_queued) {
+    impl_->SetWriteQueueLimits(max_in_flight, max_table_in_flight,
+        max_queued);
+}
+
+void CqlIf::SetReadHedgePolicy(const std::string &cfname,
+    const impl::CassHedgedReads::Policy &policy) {
+    impl_->SetReadHedgePolicy(cfname, policy);
+}
+
+void CqlIf::ClearReadHedgePolicy(const std::string &cfname) {
+    impl_->ClearReadHedgePolicy(cfname);
+}
+
 namespace interface {
 
 //
@@ -3181,6 +5291,11 @@ CassFuture* CassDatastaxLibrary::CassSessionPrepare(CassSession* session,
     return cass_session_prepare(session, query);
 }
 
+CassFuture* CassDatastaxLibrary::CassSessionExecuteBatch(CassSession* session,
+    const CassBatch* batch) {
+    return cass_session_execute_batch(session, batch);
+}
+
 void CassDatastaxLibrary::CassSessionGetMetrics(const CassSession* session,
     CassMetrics* output) {
     cass_session_get_metrics(session, output);
@@ -3250,6 +5365,15 @@ void CassDatastaxLibrary::CassResultFree(const CassResult* result) {
     cass_result_free(result);
 }
 
+size_t CassDatastaxLibrary::CassResultRowCount(const CassResult* result) {
+    return cass_result_row_count(result);
+}
+
+cass_bool_t CassDatastaxLibrary::CassResultHasMorePages(
+    const CassResult* result) {
+    return cass_result_has_more_pages(result);
+}
+
 size_t CassDatastaxLibrary::CassResultColumnCount(const CassResult* result) {
     return cass_result_column_count(result);
 }
@@ -3293,6 +5417,16 @@ CassError CassDatastaxLibrary::CassStatementSetConsistency(
     return cass_statement_set_consistency(statement, consistency);
 }
 
+CassError CassDatastaxLibrary::CassStatementSetPagingSize(
+    CassStatement* statement, int page_size) {
+    return cass_statement_set_paging_size(statement, page_size);
+}
+
+CassError CassDatastaxLibrary::CassStatementSetPagingState(
+    CassStatement* statement, const CassResult* result) {
+    return cass_statement_set_paging_state(statement, result);
+}
+
 CassError CassDatastaxLibrary::CassStatementBindStringN(
     CassStatement* statement,
     size_t index, const char* value, size_t value_length) {
@@ -3381,6 +5515,25 @@ CassStatement* CassDatastaxLibrary::CassPreparedBind(
     return cass_prepared_bind(prepared);
 }
 
+// CassBatch
+CassBatch* CassDatastaxLibrary::CassBatchNew(CassBatchType type) {
+    return cass_batch_new(type);
+}
+
+void CassDatastaxLibrary::CassBatchFree(CassBatch* batch) {
+    cass_batch_free(batch);
+}
+
+CassError CassDatastaxLibrary::CassBatchSetConsistency(CassBatch* batch,
+    CassConsistency consistency) {
+    return cass_batch_set_consistency(batch, consistency);
+}
+
+CassError CassDatastaxLibrary::CassBatchAddStatement(CassBatch* batch,
+    CassStatement* statement) {
+    return cass_batch_add_statement(batch, statement);
+}
+
 // CassValue
 CassValueType CassDatastaxLibrary::GetCassValueType(const CassValue* value) {
     return cass_value_type(value);
@@ -22,6 +22,8 @@ namespace cql {
 
 class CqlIf : public GenDb::GenDbIf {
  public:
+    static const size_t kDefaultMultiRowGetWindow = 64;
+
     CqlIf(EventManager *evm,
         const std::vector<std::string> &cassandra_ips,
         int cassandra_port,
@@ -100,8 +102,26 @@ class CqlIf : public GenDb::GenDbIf {
         const GenDb::DbDataValueVec &rowkey, const GenDb::ColumnNameRange &crange,
         const GenDb::WhereIndexInfoVec &where_vec,
         GenDb::DbConsistency::type dconsistency, GenDb::GenDbIf::DbGetRowCb cb);
+    virtual bool Db_GetMultiRowAsync(const std::string &cfname,
+        const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+        const GenDb::ColumnNameRange &crange,
+        GenDb::DbConsistency::type dconsistency,
+        GenDb::GenDbIf::DbGetMultiRowCb cb);
+    virtual bool Db_GetMultiRowAsync(const std::string &cfname,
+        const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+        const GenDb::ColumnNameRange &crange,
+        GenDb::DbConsistency::type dconsistency, int task_id,
+        int task_instance, GenDb::GenDbIf::DbGetMultiRowCb cb);
     virtual bool Db_GetAllRows(GenDb::ColListVec *out,
         const std::string &cfname, GenDb::DbConsistency::type dconsistency);
+    virtual bool Db_GetAllRowsPagedAsync(const std::string &cfname,
+        size_t page_size, GenDb::DbConsistency::type dconsistency,
+        int task_id, int task_instance, GenDb::GenDbIf::DbGetRowsPageCb cb);
+    virtual bool Db_GetRowPagedAsync(const std::string &cfname,
+        const GenDb::DbDataValueVec &rowkey,
+        const GenDb::ColumnNameRange &crange, size_t page_size,
+        GenDb::DbConsistency::type dconsistency, int task_id,
+        int task_instance, GenDb::GenDbIf::DbGetRowsPageCb cb);
     // Queue
     virtual bool Db_GetQueueStats(uint64_t *queue_count,
         uint64_t *enqueues) const;
@@ -118,6 +138,32 @@ class CqlIf : public GenDb::GenDbIf {
     // Connection
     virtual std::vector<GenDb::Endpoint> Db_GetEndpoints() const;
 
+    // Coalesce asynchronous inserts into the same partition into UNLOGGED
+    // batches, disabled by default, must be called before Db_Init. Fails
+    // without an event manager.
+    bool EnableWriteCoalescing(size_t max_statements, size_t max_bytes,
+        int linger_msecs);
+    // Maximum number of outstanding selects of a multi row read
+    void SetMultiRowGetWindow(size_t window);
+    // Limits of the outstanding asynchronous inserts, in total and per
+    // table, and of the inserts waiting for their turn. Not limited by
+    // default, 0 is no limit.
+    void SetWriteQueueLimits(size_t max_in_flight,
+        size_t max_table_in_flight, size_t max_queued);
+    // Hedge the asynchronous reads of a partition of the table that take
+    // longer than the hedge delay of the policy, see impl::CassHedgedReads
+    void SetReadHedgePolicy(const std::string &cfname,
+        const impl::CassHedgedReads::Policy &policy);
+    void ClearReadHedgePolicy(const std::string &cfname);
+    // Read a row without copying the values out of the driver result,
+    // the columns can be converted to a ColList if needed
+    typedef boost::function<void (GenDb::DbOpResult::type,
+        impl::CassResultColumnsPtr)> DbGetRowColumnsCb;
+    bool Db_GetRowColumnsAsync(const std::string &cfname,
+        const GenDb::DbDataValueVec &rowkey,
+        const GenDb::ColumnNameRange &crange,
+        GenDb::DbConsistency::type dconsistency, DbGetRowColumnsCb cb);
+
  private:
     void OnAsyncColumnAddCompletion(GenDb::DbOpResult::type drc,
         std::auto_ptr<GenDb::ColList> row,
@@ -129,6 +175,42 @@ class CqlIf : public GenDb::GenDbIf {
         std::auto_ptr<GenDb::ColList> row,
         std::string cfname, GenDb::GenDbIf::DbGetRowCb cb,
         bool use_worker, int task_id, int task_instance);
+    void OnAsyncRowColumnsGetCompletion(GenDb::DbOpResult::type drc,
+        impl::CassResultColumnsPtr columns, std::string cfname,
+        DbGetRowColumnsCb cb);
+    void OnAsyncMultiRowGetCompletion(GenDb::DbOpResult::type drc,
+        std::auto_ptr<GenDb::ColListVec> rows, std::string cfname,
+        size_t num_rows, GenDb::GenDbIf::DbGetMultiRowCb cb,
+        bool use_worker, int task_id, int task_instance);
+    bool GetMultiRowAsync(const std::string &cfname,
+        const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+        const GenDb::ColumnNameRange &crange, CassConsistency consistency,
+        GenDb::GenDbIf::DbGetMultiRowCb cb, bool use_worker, int task_id,
+        int task_instance);
+    // Records the latency of the operation on the table before calling cb
+    impl::CassAsyncQueryCallback TimedCallback(const std::string &cfname,
+        GenDb::DbTableLatencyStatistics::Op op,
+        impl::CassAsyncQueryCallback cb);
+    void OnTimedCompletion(GenDb::DbOpResult::type drc,
+        std::auto_ptr<GenDb::ColList> row, std::string cfname,
+        GenDb::DbTableLatencyStatistics::Op op, uint64_t start_usecs,
+        impl::CassAsyncQueryCallback cb);
+    bool TimedSelectAsync(const std::string &cfname,
+        impl::CassAsyncMultiRowSelect::SelectFn select_fn,
+        const GenDb::DbDataValueVec &rowkey,
+        impl::CassAsyncQueryCallback cb);
+    void OnAsyncRowsPageCompletion(GenDb::DbOpResult::type drc,
+        std::auto_ptr<GenDb::ColListVec> rows,
+        impl::CassPagedSelectPtr next, std::string cfname,
+        GenDb::GenDbIf::DbGetRowsPageCb cb, int task_id, int task_instance);
+    bool GetRowsPagedAsync(const std::string &cfname,
+        const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+        const GenDb::ColumnNameRange &crange, size_t page_size,
+        GenDb::DbConsistency::type dconsistency, int task_id,
+        int task_instance, GenDb::GenDbIf::DbGetRowsPageCb cb);
+    bool GetMultiRowSync(GenDb::ColListVec *out, const std::string &cfname,
+        const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+        const GenDb::ColumnNameRange &crange);
     void IncrementTableWriteStats(const std::string &table_name);
     void IncrementTableWriteStats(const std::string &table_name,
         uint64_t num_writes);
@@ -155,6 +237,9 @@ class CqlIf : public GenDb::GenDbIf {
     GenDb::GenDbIfStats stats_;
     bool use_prepared_for_insert_;
     bool create_schema_;
+    size_t multi_row_get_window_;
+    // Destroyed first, the queued completions refer to this
+    impl::CassCompletionQueues completion_queues_;
 };
 
 } // namespace cql
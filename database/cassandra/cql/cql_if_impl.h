@@ -5,15 +5,27 @@
 #ifndef DATABASE_CASSANDRA_CQL_CQL_IF_IMPL_H_
 #define DATABASE_CASSANDRA_CQL_CQL_IF_IMPL_H_
 
+#include <algorithm>
+#include <deque>
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include <tbb/atomic.h>
+#include <tbb/mutex.h>
+#include <tbb/spin_rw_mutex.h>
+#include <boost/enable_shared_from_this.hpp>
 #include <boost/unordered_map.hpp>
 
 #include <cassandra.h>
 
 #include <io/event_manager.h>
+#include <base/queue_task.h>
 #include <base/timer.h>
+#include <base/watermark.h>
 #include <database/gendb_if.h>
+#include <database/gendb_statistics.h>
 #include <database/cassandra/cql/cql_types.h>
 #include <database/cassandra/cql/cql_lib_if.h>
 
@@ -50,6 +62,17 @@ std::string PartitionKeyAndClusteringKeyRange2CassSelectFromTable(
     const std::string &table, const std::vector<GenDb::DbDataValueVec> &rkeys,
     const GenDb::ColumnNameRange &crange,
     const GenDb::FieldNamesToReadVec &read_vec = GenDb::FieldNamesToReadVec());
+// Select with bind markers in place of the values, which are appended to
+// values in bind order. Selects of the same shape have the same query.
+std::string CassPrepareSelectFromTable(const std::string &table,
+    const std::vector<GenDb::DbDataValueVec> &rkeys,
+    const GenDb::ColumnNameRange &ck_range,
+    const GenDb::FieldNamesToReadVec &read_vec,
+    const GenDb::WhereIndexInfoVec &where_vec,
+    GenDb::DbDataValueVec *values);
+// Binds the values by index, false if a value can not be bound
+bool CassStatementBindValues(interface::CassLibrary *cci,
+    CassStatement *statement, const GenDb::DbDataValueVec &values);
 
 // CQL Library Shared Pointers to handle library free calls
 template<class T>
@@ -115,6 +138,18 @@ struct Deleter<CassStatement> {
     interface::CassLibrary *cci_;
 };
 
+template<>
+struct Deleter<CassBatch> {
+    Deleter(interface::CassLibrary *cci) :
+       cci_(cci) {}
+    void operator()(CassBatch* ptr) {
+        if (ptr != NULL) {
+            cci_->CassBatchFree(ptr);
+        }
+    }
+    interface::CassLibrary *cci_;
+};
+
 template<>
 struct Deleter<const CassResult> {
     Deleter(interface::CassLibrary *cci) :
@@ -175,6 +210,7 @@ typedef CassSharedPtr<CassSsl> CassSslPtr;
 typedef CassSharedPtr<CassSession> CassSessionPtr;
 typedef CassSharedPtr<CassFuture> CassFuturePtr;
 typedef CassSharedPtr<CassStatement> CassStatementPtr;
+typedef CassSharedPtr<CassBatch> CassBatchPtr;
 typedef CassSharedPtr<const CassResult> CassResultPtr;
 typedef CassSharedPtr<CassIterator> CassIteratorPtr;
 typedef CassSharedPtr<const CassPrepared> CassPreparedPtr;
@@ -214,12 +250,571 @@ struct CassAsyncQueryContext {
     boost::scoped_ptr<CassQueryResultContext> result_ctx_;
 };
 
+//
+// Insert into a table, rendered once from the table definition. The query
+// for a set of columns is put together from the rendered column names the
+// first time the set is inserted, with bind markers for the values. The
+// values of an insert are then bound by position rather than printed into
+// the query. The values are converted to the declared column types, and
+// the TTL is only set if it is positive. Inserts that do not match the
+// table definition, with values that do not convert to the column types,
+// or that have a set of columns beyond the first kMaxQueries, get no
+// statement and are printed into the query by the caller.
+//
+class CassInsertPlan {
+ public:
+    static const size_t kMaxQueries = 64;
+
+    explicit CassInsertPlan(const GenDb::NewCf &cf);
+
+    // Statement with the values bound, or NULL
+    CassStatement *NewStatement(interface::CassLibrary *cci,
+        const GenDb::ColList *v_columns);
+    size_t queries() const;
+
+ private:
+    // Positions of the inserted columns in the table definition
+    typedef std::vector<size_t> ColumnSet;
+    typedef boost::unordered_map<std::string, size_t> ColumnIndexMap;
+    // Columns, and whether the TTL is set
+    typedef std::pair<ColumnSet, bool> QueryKey;
+    typedef boost::unordered_map<QueryKey, std::string> QueryMap;
+
+    bool GetStaticCfColumns(const GenDb::ColList *v_columns,
+        ColumnSet *columns, std::vector<const GenDb::DbDataValue *> *values,
+        int *ttl) const;
+    bool GetDynamicCfColumns(const GenDb::ColList *v_columns,
+        ColumnSet *columns, std::vector<const GenDb::DbDataValue *> *values,
+        int *ttl) const;
+    const std::string *LocateQuery(const ColumnSet &columns, bool ttl);
+
+    const bool is_static_;
+    const size_t rk_count_;
+    GenDb::DbDataTypeVec rk_types_;
+    // INSERT INTO table (key, key2, ...
+    std::string prefix_;
+    // Column names of the static table
+    ColumnIndexMap column_index_;
+    // Rendered name and type of each column, and of the value of the
+    // dynamic table
+    std::vector<std::string> names_;
+    GenDb::DbDataTypeVec types_;
+    size_t value_index_;
+    mutable tbb::mutex mutex_;
+    QueryMap queries_;
+};
+
+typedef boost::shared_ptr<CassInsertPlan> CassInsertPlanPtr;
+
+//
+// Coalesces asynchronous inserts into the same partition of a table into
+// UNLOGGED batches, so that the inserts reach the replicas of the partition
+// in one request. A batch is executed when it reaches the maximum number of
+// statements or bytes, or when it has been pending for the linger time. The
+// result of the batch is reported to the callback of each insert. The
+// owner calls FlushExpired every flush_msecs(), so that a batch lingers at
+// most a quarter more than the linger time.
+//
+class CassWriteCoalescer {
+ public:
+    CassWriteCoalescer(interface::CassLibrary *cci, size_t max_statements,
+        size_t max_bytes, int linger_msecs);
+    ~CassWriteCoalescer();
+
+    void AddStatement(CassSession *session, const std::string &table,
+        const GenDb::DbDataValueVec &partition_key,
+        CassConsistency consistency, CassStatementPtr statement,
+        size_t size, CassAsyncQueryCallback cb);
+    // Executes the batches pending for the linger time at now_usecs
+    void FlushExpired(CassSession *session, uint64_t now_usecs);
+    // Executes all pending batches
+    void Flush(CassSession *session);
+
+    int linger_msecs() const { return linger_msecs_; }
+    int flush_msecs() const {
+        return std::max(linger_msecs_ / kFlushDivisor, 1);
+    }
+    size_t pending_statements() const;
+    // Requests executed, and statements executed in these requests
+    uint64_t requests() const { return requests_; }
+    uint64_t statements() const { return statements_; }
+
+ private:
+    struct PendingBatch {
+        PendingBatch() :
+            consistency(CASS_CONSISTENCY_ONE),
+            size(0),
+            start_usecs(0) {
+        }
+        void swap(PendingBatch &other) {
+            table.swap(other.table);
+            std::swap(consistency, other.consistency);
+            statements.swap(other.statements);
+            callbacks.swap(other.callbacks);
+            std::swap(size, other.size);
+            std::swap(start_usecs, other.start_usecs);
+        }
+        std::string table;
+        CassConsistency consistency;
+        std::vector<CassStatementPtr> statements;
+        std::vector<CassAsyncQueryCallback> callbacks;
+        size_t size;
+        uint64_t start_usecs;
+    };
+    typedef boost::unordered_map<std::string, PendingBatch> PendingBatchMap;
+
+    void ExecuteBatch(CassSession *session, PendingBatch *pending);
+
+    static const int kFlushDivisor = 4;
+
+    interface::CassLibrary *cci_;
+    const size_t max_statements_;
+    const size_t max_bytes_;
+    const int linger_msecs_;
+    mutable tbb::mutex mutex_;
+    PendingBatchMap pending_batches_;
+    size_t pending_statements_;
+    tbb::atomic<uint64_t> requests_;
+    tbb::atomic<uint64_t> statements_;
+};
+
+//
+// Bounds the asynchronous writes of the session on the client. At most
+// max_in_flight writes are outstanding, and at most max_table_in_flight of
+// them are to the same table, so that a table with a high write rate can
+// not take all the outstanding writes. The other writes wait in a queue
+// per table, and the tables with waiting writes are served one write at a
+// time in turn as writes complete. A write is failed with BACK_PRESSURE if
+// max_queued writes are waiting. The water marks are on the number of
+// writes not completed, waiting or outstanding.
+//
+// A limit of 0 is no limit. By default the writes are not limited, and are
+// only counted for the water marks.
+//
+class CassWriteQueue {
+ public:
+    // Executes the write, the result is reported to the callback
+    typedef boost::function<void(CassAsyncQueryCallback)> WriteFn;
+
+    CassWriteQueue(size_t max_in_flight = 0, size_t max_table_in_flight = 0,
+        size_t max_queued = 0);
+    ~CassWriteQueue();
+
+    void SetLimits(size_t max_in_flight, size_t max_table_in_flight,
+        size_t max_queued);
+    // The write is executed now, or queued until the table is served
+    void Enqueue(const std::string &table, WriteFn write_fn,
+        CassAsyncQueryCallback cb);
+    // Fails the waiting writes
+    void Clear();
+
+    void SetWaterMark(bool high, size_t count, WaterMarkCallback cb);
+    void ResetWaterMarks();
+
+    // Writes waiting or outstanding
+    size_t count() const;
+    size_t queued() const;
+    size_t in_flight() const;
+    size_t table_in_flight(const std::string &table) const;
+    uint64_t enqueues() const { return enqueues_; }
+    uint64_t drops() const { return drops_; }
+
+ private:
+    struct Write {
+        Write(WriteFn write_fn, CassAsyncQueryCallback cb) :
+            write_fn(write_fn),
+            cb(cb) {
+        }
+        WriteFn write_fn;
+        CassAsyncQueryCallback cb;
+    };
+    struct TableQueue {
+        TableQueue() :
+            in_flight(0),
+            ready(false) {
+        }
+        std::deque<Write> writes;
+        size_t in_flight;
+        // In the ready queue
+        bool ready;
+    };
+    typedef boost::unordered_map<std::string, TableQueue> TableQueueMap;
+
+    static size_t Limit(size_t limit);
+    void MakeReady(TableQueue *tqueue);
+    bool DequeueReady();
+    void ExecuteWrites();
+    void ProcessWaterMarks(bool high);
+    void OnWriteCompletion(TableQueue *tqueue, CassAsyncQueryCallback cb,
+        GenDb::DbOpResult::type drc, std::auto_ptr<GenDb::ColList> row);
+
+    mutable tbb::mutex mutex_;
+    size_t max_in_flight_;
+    size_t max_table_in_flight_;
+    size_t max_queued_;
+    TableQueueMap tables_;
+    // Tables with waiting writes and less than max_table_in_flight
+    // outstanding, served in turn
+    std::deque<TableQueue *> ready_;
+    size_t queued_;
+    size_t in_flight_;
+    // Writes dequeued and not executed yet, executed by the thread that
+    // is executing
+    std::vector<Write> dequeued_;
+    bool executing_;
+    // Taken before mutex_
+    tbb::mutex water_mutex_;
+    WaterMarkTuple watermarks_;
+    tbb::atomic<uint64_t> enqueues_;
+    tbb::atomic<uint64_t> drops_;
+};
+
+//
+// Reads multiple partitions with an asynchronous select per partition key,
+// at most window selects outstanding at a time. The rows are reported in
+// the order of the partition keys once all selects are done. After a select
+// fails no more selects are issued, and the failure is reported once the
+// outstanding selects are done.
+//
+class CassAsyncMultiRowSelect :
+    public boost::enable_shared_from_this<CassAsyncMultiRowSelect> {
+ public:
+    typedef boost::function<bool(const GenDb::DbDataValueVec &,
+        CassAsyncQueryCallback)> SelectFn;
+    typedef boost::function<void(GenDb::DbOpResult::type,
+        std::auto_ptr<GenDb::ColListVec>)> CompletionCb;
+
+    CassAsyncMultiRowSelect(const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+        size_t window, SelectFn select_fn, CompletionCb cb);
+    ~CassAsyncMultiRowSelect();
+
+    // Must be owned by a shared pointer
+    void Start();
+
+ private:
+    void IssueSelects();
+    void OnSelectCompletion(size_t index, GenDb::DbOpResult::type drc,
+        std::auto_ptr<GenDb::ColList> row);
+
+    const std::vector<GenDb::DbDataValueVec> v_rowkey_;
+    const size_t window_;
+    SelectFn select_fn_;
+    CompletionCb cb_;
+    tbb::mutex mutex_;
+    std::vector<GenDb::ColList *> rows_;
+    size_t next_;
+    size_t outstanding_;
+    GenDb::DbOpResult::type result_;
+};
+
+//
+// Reads the result of a select one page at a time, using the paging state
+// of the driver. The next page is only requested when the reader asks for
+// it, so at most one page of rows is held at a time however large the
+// result is. A partition that spans pages is reported in a row per page.
+// The session is shared, so that it outlives a reconnect while pages are
+// still read from it.
+//
+class CassPagedSelect :
+    public boost::enable_shared_from_this<CassPagedSelect> {
+ public:
+    // Rows of a page, and the select to fetch the next page with, NULL if
+    // there are no more pages or the page failed. Dropping the select
+    // stops the read.
+    typedef boost::function<void(GenDb::DbOpResult::type,
+        std::auto_ptr<GenDb::ColListVec>,
+        boost::shared_ptr<CassPagedSelect>)> PageCb;
+
+    CassPagedSelect(interface::CassLibrary *cci, CassSessionPtr session,
+        const std::string &query, CassStatementPtr statement,
+        CassConsistency consistency, size_t page_size, bool is_dynamic_cf,
+        size_t rk_count, size_t ck_count, PageCb cb);
+
+    // Must be owned by a shared pointer, fetches the first page
+    void Start();
+    // Fetches the next page, at most once per page reported
+    void FetchNextPage();
+
+    uint64_t pages() const { return pages_; }
+    uint64_t rows() const { return rows_; }
+
+ private:
+    static void OnPageAsync(CassFuture *future, void *data);
+    void OnPage(CassFuture *future);
+
+    interface::CassLibrary *cci_;
+    CassSessionPtr session_;
+    const std::string query_;
+    CassStatementPtr statement_;
+    const bool is_dynamic_cf_;
+    const size_t rk_count_;
+    const size_t ck_count_;
+    PageCb cb_;
+    tbb::atomic<uint64_t> pages_;
+    tbb::atomic<uint64_t> rows_;
+};
+
+typedef boost::shared_ptr<CassPagedSelect> CassPagedSelectPtr;
+
+//
+// Completions of asynchronous reads that are run in the context of a task,
+// queued per (task id, task instance) instead of enqueueing a task for each
+// completion. A single runner task per queue runs the queued completions in
+// batches, in the order they were enqueued. Completions for any instance
+// are not serialized, and get a task each. The queues are looked up under
+// a reader lock, and only created under the writer lock.
+//
+class CassCompletionQueues {
+ public:
+    static const size_t kMaxCompletionsPerRun = 64;
+    typedef boost::function<void(void)> Completion;
+
+    CassCompletionQueues();
+    // Concurrency - the runner tasks must not be running
+    ~CassCompletionQueues();
+
+    void Enqueue(int task_id, int task_instance, Completion completion);
+
+    // Completions run from the queues, and runner tasks started to run them
+    uint64_t completions() const;
+    uint64_t task_runs() const;
+    size_t queue_count() const;
+
+ private:
+    typedef WorkQueue<Completion> CompletionQueue;
+    typedef std::map<std::pair<int, int>, CompletionQueue *> QueueMap;
+
+    CompletionQueue *LocateQueue(int task_id, int task_instance);
+    bool RunCompletion(Completion completion);
+
+    mutable tbb::spin_rw_mutex rw_mutex_;
+    QueueMap queues_;
+};
+
+//
+// Hedged reads of the tables with a hedging policy. A read that has not
+// completed within the hedge delay of its table is executed a second time,
+// the load balancing policy of the driver picking the coordinator, and the
+// first successful response completes the read. The hedge delay is the
+// percentile of the recent latencies of the first executions of the table,
+// within the minimum and maximum delay, or the maximum delay until latencies
+// are recorded. Each read adds budget_percent to the budget of its table, up
+// to kMaxBurst hedges, and a hedge takes 100 from it. Reads waiting for the
+// hedge delay are hedged by HedgeExpired.
+//
+class CassHedgedReads {
+ public:
+    static const int kMaxBurst = 10;
+    typedef boost::function<void(CassAsyncQueryCallback)> ReadFn;
+
+    struct Policy {
+        Policy() :
+            percentile(0.95),
+            min_delay_msecs(5),
+            max_delay_msecs(1000),
+            budget_percent(5) {
+        }
+        double percentile;
+        int min_delay_msecs;
+        int max_delay_msecs;
+        int budget_percent;
+    };
+
+    CassHedgedReads();
+    ~CassHedgedReads();
+
+    void SetPolicy(const std::string &table, const Policy &policy);
+    void ClearPolicy(const std::string &table);
+    bool IsHedged(const std::string &table) const;
+    // Tables with a policy
+    size_t policies() const;
+    uint64_t HedgeDelayUsecs(const std::string &table) const;
+
+    // Executes the read with read_fn, and again once it is hedged
+    void Read(const std::string &table, ReadFn read_fn,
+        CassAsyncQueryCallback cb);
+    // Hedges the reads waiting for the hedge delay at now_usecs
+    void HedgeExpired(uint64_t now_usecs);
+    // The outstanding reads are not hedged anymore
+    void Clear();
+
+    size_t waiting() const;
+    // Reads of the tables with a policy, hedges executed, hedges that
+    // completed the read, and hedges not executed for lack of budget
+    uint64_t reads() const { return reads_; }
+    uint64_t hedges() const { return hedges_; }
+    uint64_t hedges_won() const { return hedges_won_; }
+    uint64_t hedges_over_budget() const { return hedges_over_budget_; }
+
+ private:
+    struct HedgedRead;
+    typedef boost::shared_ptr<HedgedRead> HedgedReadPtr;
+    typedef std::multimap<uint64_t, HedgedReadPtr> HedgeMap;
+    struct TablePolicy {
+        TablePolicy() :
+            budget(0) {
+        }
+        Policy policy;
+        int budget;
+    };
+    typedef boost::unordered_map<std::string, TablePolicy> TablePolicyMap;
+
+    uint64_t HedgeDelayUsecs(const TablePolicy &tpolicy,
+        const std::string &table) const;
+    void OnReadCompletion(HedgedReadPtr read, bool hedge,
+        GenDb::DbOpResult::type drc, std::auto_ptr<GenDb::ColList> row);
+
+    mutable tbb::mutex mutex_;
+    TablePolicyMap policies_;
+    // Reads waiting for the hedge delay, by hedge time
+    HedgeMap hedges_map_;
+    GenDb::DbTableLatencyStatistics latencies_;
+    tbb::atomic<uint64_t> reads_;
+    tbb::atomic<uint64_t> hedges_;
+    tbb::atomic<uint64_t> hedges_won_;
+    tbb::atomic<uint64_t> hedges_over_budget_;
+};
+
+//
+// Prepared statements keyed by query. A query that is not in the cache is
+// prepared in the background, and executed as text until it is prepared.
+// A query that fails to prepare, or does not fit in the cache, is always
+// executed as text.
+//
+class CassPreparedCache {
+ public:
+    static const size_t kDefaultMaxSize = 1024;
+
+    CassPreparedCache(interface::CassLibrary *cci,
+        size_t max_size = kDefaultMaxSize);
+
+    // Returns true with the prepared statement if the query is prepared,
+    // else starts preparing it on the session and returns false
+    bool Lookup(CassSession *session, const std::string &query,
+        CassPreparedPtr *prepared);
+    // Prepared statements belong to the session that prepared them
+    void Clear();
+
+    size_t size() const;
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+    uint64_t prepare_failures() const { return prepare_failures_; }
+    // Records that the values could not be bound to the prepared query,
+    // which is then executed as text. Returns true the first time for the
+    // query, so that the failure is logged once.
+    bool BindFailed(const std::string &query);
+    uint64_t bind_failures() const { return bind_failures_; }
+
+ private:
+    struct PrepareContext;
+    typedef boost::unordered_map<std::string, CassPreparedPtr>
+        CassPreparedMap;
+
+    static void OnPrepareAsync(CassFuture *future, void *data);
+    void PrepareDone(CassFuture *future, const std::string &query,
+        uint64_t generation);
+
+    interface::CassLibrary *cci_;
+    const size_t max_size_;
+    mutable tbb::mutex mutex_;
+    // Queries being prepared, that failed to prepare, or that the values
+    // could not be bound to, have no prepared statement
+    CassPreparedMap prepared_map_;
+    // Incremented when the cache is cleared
+    uint64_t generation_;
+    tbb::atomic<uint64_t> hits_;
+    tbb::atomic<uint64_t> misses_;
+    tbb::atomic<uint64_t> prepare_failures_;
+    tbb::atomic<uint64_t> bind_failures_;
+};
+
+//
+// Value of a select result that is not copied out of the driver result:
+// strings and blobs point into the result, other values are stored inline.
+//
+struct CassValueView {
+    struct Bytes {
+        const char *data;
+        size_t size;
+    };
+
+    CassValueView() :
+        type(GenDb::DB_VALUE_BLANK) {
+    }
+    // Copies the value
+    GenDb::DbDataValue ToDbDataValue() const;
+
+    GenDb::DbDataValueType type;
+    union {
+        Bytes bytes;
+        uint64_t u64;
+        uint32_t u32;
+        uint16_t u16;
+        uint8_t u8;
+        double d;
+        CassUuid uuid;
+        CassInet inet;
+    };
+};
+
+//
+// Select result decoded column by column into a single array of value
+// views, so that decoding takes the same number of allocations however
+// many rows the result has. The views are valid as long as the columns,
+// which keep the driver result. The adapters copy the values into the
+// ColList representation returned by the GenDb interface.
+//
+class CassResultColumns {
+ public:
+    CassResultColumns(interface::CassLibrary *cci, CassResultPtr result,
+        bool is_dynamic_cf, size_t rk_count, size_t ck_count);
+
+    size_t row_count() const { return row_count_; }
+    size_t column_count() const { return column_count_; }
+    const CassValueView &column_name(size_t column) const {
+        return names_[column];
+    }
+    // Values of the column, one per row
+    const CassValueView *column(size_t column) const {
+        return &values_[column * row_count_];
+    }
+    const CassValueView &value(size_t row, size_t column) const {
+        return values_[column * row_count_ + row];
+    }
+
+    void GetColumns(GenDb::NewColVec *v_columns) const;
+    void GetColumns(GenDb::ColListVec *v_col_list) const;
+
+ private:
+    GenDb::NewCol *GetDynamicCfColumn(size_t row) const;
+    void GetStaticCfColumns(size_t row, GenDb::NewColVec *v_columns) const;
+
+    CassResultPtr result_;
+    const bool is_dynamic_cf_;
+    const size_t rk_count_;
+    const size_t ck_count_;
+    size_t row_count_;
+    size_t column_count_;
+    std::vector<CassValueView> names_;
+    std::vector<CassValueView> values_;
+};
+
+typedef boost::shared_ptr<const CassResultColumns> CassResultColumnsPtr;
+typedef boost::function<void (GenDb::DbOpResult::type,
+    CassResultColumnsPtr)> CassAsyncColumnsCallback;
+
 void DynamicCfGetResult(interface::CassLibrary *cci,
     CassResultPtr *result, size_t rk_count,
     size_t ck_count, GenDb::ColListVec *v_col_list);
 void StaticCfGetResult(interface::CassLibrary *cci,
     CassResultPtr *result, size_t rk_count,
     GenDb::ColListVec *v_col_list);
+// Executes the select of a partition, the bound statement is not released
+// and can be executed again
+void ExecuteSelectAsync(interface::CassLibrary *cci, CassSessionPtr session,
+    const std::string &query, CassStatementPtr statement,
+    CassConsistency consistency, const CassQueryResultContext &rctx,
+    CassAsyncQueryCallback cb);
 
 }  // namespace impl
 
@@ -252,6 +847,8 @@ class CqlIfImpl {
         CassConsistency consistency,
         const GenDb::ColIndexMode::type index_mode);
     bool LocatePrepareInsertIntoTable(const GenDb::NewCf &cf);
+    // Renders the inserts into the table, see impl::CassInsertPlan
+    void LocateInsertPlan(const GenDb::NewCf &cf);
     bool IsTablePresent(const std::string &table);
     int IsTableStatic(const std::string &table);
     bool IsTableDynamic(const std::string &table);
@@ -292,6 +889,17 @@ class CqlIfImpl {
         const GenDb::DbDataValueVec &rkey,
         const GenDb::ColumnNameRange &ck_range, CassConsistency consistency,
         cass::cql::impl::CassAsyncQueryCallback cb);
+    // Decodes the result into columns of value views, see
+    // impl::CassResultColumns
+    bool SelectFromTableClusteringKeyRangeColumnsAsync(
+        const std::string &cfname, const GenDb::DbDataValueVec &rkey,
+        const GenDb::ColumnNameRange &ck_range, CassConsistency consistency,
+        impl::CassAsyncColumnsCallback cb);
+    // All the rows of the table if v_rowkey is empty
+    bool SelectFromTablePagedAsync(const std::string &cfname,
+        const std::vector<GenDb::DbDataValueVec> &v_rowkey,
+        const GenDb::ColumnNameRange &ck_range, size_t page_size,
+        CassConsistency consistency, impl::CassPagedSelect::PageCb cb);
     bool SelectFromTableClusteringKeyRangeAndIndexValueAsync(
         const std::string &cfname, const GenDb::DbDataValueVec &rkey,
         const GenDb::ColumnNameRange &ck_range,
@@ -306,6 +914,38 @@ class CqlIfImpl {
 
     void SetRequestTimeout(uint32_t timeout_ms);
 
+    // Coalesce asynchronous inserts into batches, must be enabled before
+    // the session is connected. Fails without an event manager, which runs
+    // the timer that executes the lingering batches.
+    bool EnableWriteCoalescing(size_t max_statements, size_t max_bytes,
+        int linger_msecs);
+    const impl::CassWriteCoalescer *write_coalescer() const {
+        return write_coalescer_.get();
+    }
+
+    // Asynchronous inserts are executed through the write queue, see
+    // impl::CassWriteQueue
+    void SetWriteQueueLimits(size_t max_in_flight,
+        size_t max_table_in_flight, size_t max_queued);
+    void SetWriteQueueWaterMark(bool high, size_t count,
+        WaterMarkCallback cb);
+    void ResetWriteQueueWaterMarks();
+    const impl::CassWriteQueue &write_queue() const {
+        return write_queue_;
+    }
+
+    const impl::CassPreparedCache &select_prepared_cache() const {
+        return select_prepared_cache_;
+    }
+
+    // Hedge the asynchronous selects of a partition of the table
+    void SetReadHedgePolicy(const std::string &table,
+        const impl::CassHedgedReads::Policy &policy);
+    void ClearReadHedgePolicy(const std::string &table);
+    const impl::CassHedgedReads &hedged_reads() const {
+        return hedged_reads_;
+    }
+
     bool GetMetrics(Metrics *metrics) const;
 
  private:
@@ -315,16 +955,40 @@ class CqlIfImpl {
         impl::CassAsyncQueryCallback cb);
     bool GetPrepareInsertIntoTable(const std::string &table_name,
         impl::CassPreparedPtr *prepared) const;
+    bool GetInsertPlan(const std::string &table_name,
+        impl::CassInsertPlanPtr *plan) const;
     bool PrepareInsertIntoTableSync(const GenDb::NewCf &cf,
         impl::CassPreparedPtr *prepared);
     bool InsertIntoTablePrepareInternal(std::auto_ptr<GenDb::ColList> v_columns,
         CassConsistency consistency, bool sync,
         impl::CassAsyncQueryCallback cb);
+    void InsertIntoTableStatementAsync(const GenDb::ColList *v_columns,
+        const char *query_id, impl::CassStatementPtr statement,
+        CassConsistency consistency, impl::CassAsyncQueryCallback cb);
+    void ExecuteInsertStatementAsync(const std::string &table,
+        const GenDb::DbDataValueVec &rowkey, const std::string &query_id,
+        impl::CassStatementPtr statement, CassConsistency consistency,
+        size_t size, impl::CassAsyncQueryCallback cb);
+    bool WriteCoalescerTimerExpired();
+    bool HedgeTimerExpired();
+    bool HedgedSelectAsync(const std::string &query,
+        impl::CassStatementPtr statement, CassConsistency consistency,
+        const impl::CassQueryResultContext &rctx,
+        impl::CassAsyncQueryCallback cb);
+    impl::CassStatementPtr SelectFromTableStatement(const std::string &cfname,
+        const std::vector<GenDb::DbDataValueVec> &rkeys,
+        const GenDb::ColumnNameRange &ck_range,
+        const GenDb::FieldNamesToReadVec &read_vec,
+        const GenDb::WhereIndexInfoVec &where_vec, std::string *query);
 
     static const char * kQCreateKeyspaceIfNotExists;
     static const char * kQUseKeyspace;
     static const char * kTaskName;
     static const int kTaskInstance = -1;
+    // Resolution of the hedge delay
+    static const int kHedgeTimerMsecs = 5;
+    // Longest IN list of the prepared selects
+    static const size_t kMaxPreparedSelectKeys = 8;
 
     struct SessionState {
         enum type {
@@ -348,7 +1012,16 @@ class CqlIfImpl {
     typedef boost::unordered_map<std::string, impl::CassPreparedPtr>
         CassPreparedMapType;
     CassPreparedMapType insert_prepared_map_;
+    typedef boost::unordered_map<std::string, impl::CassInsertPlanPtr>
+        CassInsertPlanMapType;
+    CassInsertPlanMapType insert_plan_map_;
     mutable tbb::mutex map_mutex_;
+    impl::CassPreparedCache select_prepared_cache_;
+    boost::scoped_ptr<impl::CassWriteCoalescer> write_coalescer_;
+    Timer *write_coalescer_timer_;
+    impl::CassWriteQueue write_queue_;
+    impl::CassHedgedReads hedged_reads_;
+    Timer *hedge_timer_;
 };
 
 }  // namespace cql
@@ -60,6 +60,8 @@ class CassLibrary {
         const CassSession* session) = 0;
     virtual CassFuture* CassSessionPrepare(CassSession* session,
         const char* query) = 0;
+    virtual CassFuture* CassSessionExecuteBatch(CassSession* session,
+        const CassBatch* batch) = 0;
     virtual void CassSessionGetMetrics(const CassSession* session,
         CassMetrics* output) = 0;
 
@@ -87,6 +89,8 @@ class CassLibrary {
 
     // CassResult
     virtual void CassResultFree(const CassResult* result) = 0;
+    virtual size_t CassResultRowCount(const CassResult* result) = 0;
+    virtual cass_bool_t CassResultHasMorePages(const CassResult* result) = 0;
     virtual size_t CassResultColumnCount(const CassResult* result) = 0;
     virtual CassError CassResultColumnName(const CassResult *result,
         size_t index, const char** name, size_t* name_length) = 0;
@@ -105,6 +109,10 @@ class CassLibrary {
     virtual void CassStatementFree(CassStatement* statement) = 0;
     virtual CassError CassStatementSetConsistency(CassStatement* statement,
         CassConsistency consistency) = 0;
+    virtual CassError CassStatementSetPagingSize(CassStatement* statement,
+        int page_size) = 0;
+    virtual CassError CassStatementSetPagingState(CassStatement* statement,
+        const CassResult* result) = 0;
     virtual CassError CassStatementBindStringN(CassStatement* statement,
         size_t index, const char* value, size_t value_length) = 0;
     virtual CassError CassStatementBindInt32(CassStatement* statement,
@@ -140,6 +148,14 @@ class CassLibrary {
     virtual void CassPreparedFree(const CassPrepared* prepared) = 0;
     virtual CassStatement* CassPreparedBind(const CassPrepared* prepared) = 0;
 
+    // CassBatch
+    virtual CassBatch* CassBatchNew(CassBatchType type) = 0;
+    virtual void CassBatchFree(CassBatch* batch) = 0;
+    virtual CassError CassBatchSetConsistency(CassBatch* batch,
+        CassConsistency consistency) = 0;
+    virtual CassError CassBatchAddStatement(CassBatch* batch,
+        CassStatement* statement) = 0;
+
     // CassValue
     virtual CassValueType GetCassValueType(const CassValue* value) = 0;
     virtual CassError CassValueGetString(const CassValue* value,
@@ -225,6 +241,8 @@ class CassDatastaxLibrary : public CassLibrary {
         const CassSession* session);
     virtual CassFuture* CassSessionPrepare(CassSession* session,
         const char* query);
+    virtual CassFuture* CassSessionExecuteBatch(CassSession* session,
+        const CassBatch* batch);
     virtual void CassSessionGetMetrics(const CassSession* session,
         CassMetrics* output);
 
@@ -252,6 +270,8 @@ class CassDatastaxLibrary : public CassLibrary {
 
     // CassResult
     virtual void CassResultFree(const CassResult* result);
+    virtual size_t CassResultRowCount(const CassResult* result);
+    virtual cass_bool_t CassResultHasMorePages(const CassResult* result);
     virtual size_t CassResultColumnCount(const CassResult* result);
     virtual CassError CassResultColumnName(const CassResult *result,
         size_t index, const char** name, size_t* name_length);
@@ -270,6 +290,10 @@ class CassDatastaxLibrary : public CassLibrary {
     virtual void CassStatementFree(CassStatement* statement);
     virtual CassError CassStatementSetConsistency(CassStatement* statement,
         CassConsistency consistency);
+    virtual CassError CassStatementSetPagingSize(CassStatement* statement,
+        int page_size);
+    virtual CassError CassStatementSetPagingState(CassStatement* statement,
+        const CassResult* result);
     virtual CassError CassStatementBindStringN(CassStatement* statement,
         size_t index, const char* value, size_t value_length);
     virtual CassError CassStatementBindInt32(CassStatement* statement,
@@ -305,6 +329,14 @@ class CassDatastaxLibrary : public CassLibrary {
     virtual void CassPreparedFree(const CassPrepared* prepared);
     virtual CassStatement* CassPreparedBind(const CassPrepared* prepared);
 
+    // CassBatch
+    virtual CassBatch* CassBatchNew(CassBatchType type);
+    virtual void CassBatchFree(CassBatch* batch);
+    virtual CassError CassBatchSetConsistency(CassBatch* batch,
+        CassConsistency consistency);
+    virtual CassError CassBatchAddStatement(CassBatch* batch,
+        CassStatement* statement);
+
     // CassValue
     virtual CassValueType GetCassValueType(const CassValue* value);
     virtual CassError CassValueGetString(const CassValue* value,
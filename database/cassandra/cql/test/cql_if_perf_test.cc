@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2026 Juniper Networks, Inc. All rights reserved.
+//
+
+#include <testing/gunit.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include <boost/assign/list_of.hpp>
+#include <tbb/atomic.h>
+
+#include <base/logging.h>
+#include <database/gendb_if.h>
+#include <database/cassandra/cql/cql_if_impl.h>
+#include <database/cassandra/cql/test/mock_cql_lib_if.h>
+#include <database/cassandra/cql/test/fake_cql_lib_if.h>
+
+using boost::assign::list_of;
+using cass::cql::test::FakeCassResultLibrary;
+
+// The allocator is replaced in this binary only, to count the allocations
+// of the tests
+static tbb::atomic<uint64_t> allocations;
+
+void *operator new(size_t size) {
+    allocations++;
+    void *ptr(malloc(size));
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) {
+    free(ptr);
+}
+
+class CqlIfPerfTest : public ::testing::Test {
+};
+
+// Allocations per row decoding a result of 100000 rows into a ColList,
+// and into columns
+TEST_F(CqlIfPerfTest, DISABLED_ResultColumns) {
+    FakeCassResultLibrary cci(list_of("key")("column1")("column2")
+        ("column3")("value"));
+    const int rows(100000);
+    cci.AddDynamicCfRows(rows);
+    cass::cql::impl::CassResultPtr result(NULL, &cci);
+    uint64_t start(allocations);
+    {
+        GenDb::ColListVec v_col_list;
+        cass::cql::impl::DynamicCfGetResult(&cci, &result, 1, 3,
+            &v_col_list);
+    }
+    uint64_t col_list_allocations(allocations - start);
+    start = allocations;
+    {
+        cass::cql::impl::CassResultColumns columns(&cci, result, true,
+            1, 3);
+    }
+    uint64_t columns_allocations(allocations - start);
+    std::cout << "ColList: " << (double)col_list_allocations / rows <<
+        " allocations/row, Columns: " << (double)columns_allocations / rows <<
+        " allocations/row" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -4,8 +4,12 @@
 
 #include <testing/gunit.h>
 
+#include <boost/asio/deadline_timer.hpp>
+#include <boost/asio/io_service.hpp>
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 #include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/assign/list_of.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -13,10 +17,17 @@
 #include <boost/system/error_code.hpp>
 
 #include <base/logging.h>
+#include <base/string_util.h>
+#include <base/task.h>
+#include <base/time_util.h>
+#include <base/test/task_test_util.h>
+#include <io/event_manager.h>
+#include <io/test/event_manager_test.h>
 #include <database/gendb_constants.h>
 #include <database/gendb_if.h>
 #include <database/cassandra/cql/cql_if_impl.h>
 #include <database/cassandra/cql/test/mock_cql_lib_if.h>
+#include <database/cassandra/cql/test/fake_cql_lib_if.h>
 
 using namespace boost::system;
 using boost::assign::list_of;
@@ -1041,11 +1052,77 @@ TEST_F(CqlIfTest, SelectFromTableMultipleRead) {
     EXPECT_EQ(expected_qstring4, actual_qstring4);
 }
 
+TEST_F(CqlIfTest, SelectFromTablePrepare) {
+    std::string table("PrepareSelectTable");
+    GenDb::DbDataValueVec rkey(list_of(GenDb::DbDataValue(std::string("key")))
+        (GenDb::DbDataValue((uint32_t)10)));
+    GenDb::ColumnNameRange crange;
+    crange.start_ = list_of(GenDb::DbDataValue(std::string("a")))
+        (GenDb::DbDataValue((uint64_t)1));
+    crange.finish_ = list_of(GenDb::DbDataValue(std::string("z")));
+    crange.finish_op_ = GenDb::Op::LT;
+    crange.count_ = 5000;
+    GenDb::FieldNamesToReadVec fields;
+    fields.push_back(boost::make_tuple("column1", false, true, false));
+    fields.push_back(boost::make_tuple("value", false, false, true));
+    GenDb::WhereIndexInfoVec where_vec = boost::assign::tuple_list_of
+        ("column2", GenDb::Op::LIKE, GenDb::DbDataValue(std::string("Te%")))
+        ("column3", GenDb::Op::EQ, GenDb::DbDataValue((uint8_t)128));
+    GenDb::DbDataValueVec values;
+    std::string actual_qstring(
+        cass::cql::impl::CassPrepareSelectFromTable(table,
+            std::vector<GenDb::DbDataValueVec>(1, rkey), crange, fields,
+            where_vec, &values));
+    std::string expected_qstring(
+        "SELECT column1,value,WRITETIME(value) FROM PrepareSelectTable "
+        "WHERE key=? AND key2=? AND "
+        "column2 LIKE ? AND column3 = ? AND "
+        "(column1, column2) >= (?, ?) AND (column1) < (?) "
+        "LIMIT ? ALLOW FILTERING");
+    EXPECT_EQ(expected_qstring, actual_qstring);
+    GenDb::DbDataValueVec expected_values(rkey);
+    expected_values.push_back(GenDb::DbDataValue(std::string("Te%")));
+    expected_values.push_back(GenDb::DbDataValue((uint8_t)128));
+    expected_values.insert(expected_values.end(), crange.start_.begin(),
+        crange.start_.end());
+    expected_values.push_back(GenDb::DbDataValue(std::string("z")));
+    expected_values.push_back(GenDb::DbDataValue((uint32_t)5000));
+    EXPECT_EQ(expected_values, values);
+
+    // Same shape, other values
+    rkey[0] = GenDb::DbDataValue(std::string("key1"));
+    crange.count_ = 10;
+    values.clear();
+    EXPECT_EQ(expected_qstring,
+        cass::cql::impl::CassPrepareSelectFromTable(table,
+            std::vector<GenDb::DbDataValueVec>(1, rkey), crange, fields,
+            where_vec, &values));
+    EXPECT_EQ(GenDb::DbDataValue(std::string("key1")), values[0]);
+    EXPECT_EQ(GenDb::DbDataValue((uint32_t)10), values.back());
+
+    // Multiple partition keys
+    std::vector<GenDb::DbDataValueVec> keys;
+    keys.push_back(list_of(GenDb::DbDataValue(std::string("uuid1"))));
+    keys.push_back(list_of(GenDb::DbDataValue(std::string("uuid2"))));
+    values.clear();
+    EXPECT_EQ("SELECT * FROM PrepareSelectTable WHERE key IN (?,?)",
+        cass::cql::impl::CassPrepareSelectFromTable(table, keys,
+            GenDb::ColumnNameRange(), GenDb::FieldNamesToReadVec(),
+            GenDb::WhereIndexInfoVec(), &values));
+    EXPECT_EQ(2U, values.size());
+}
+
 using ::testing::_;
 using ::testing::Return;
 using ::testing::DoAll;
 using ::testing::SetArgPointee;
 using ::testing::ContainerEq;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::StrEq;
+using ::testing::Mock;
+using ::testing::AnyNumber;
+using cass::cql::test::FakeCassResultLibrary;
 
 TEST_F(CqlIfTest, DynamicCfGetResultAllRows) {
     cass::cql::test::MockCassLibrary mock_cci;
@@ -1112,8 +1189,8 @@ TEST_F(CqlIfTest, DynamicCfGetResultAllRows) {
     expected_v_col_list.push_back(col_list);
     expected_v_col_list.push_back(col_list1);
     GenDb::ColListVec actual_v_col_list;
-    cass::cql::impl::CassResultPtr result(NULL, &mock_cci);
-    cass::cql::impl::DynamicCfGetResult(&mock_cci, &result, rk_count,
+    cass::cql::impl::CassResultPtr result(NULL, &cci);
+    cass::cql::impl::DynamicCfGetResult(&cci, &result, rk_count,
         ck_count, &actual_v_col_list);
     EXPECT_THAT(actual_v_col_list, ContainerEq(expected_v_col_list));
 }
@@ -1231,12 +1308,1833 @@ TEST_F(CqlIfTest, StaticCfGetResultAllRows) {
     expected_v_col_list.push_back(col_list2);
 
     GenDb::ColListVec actual_v_col_list;
-    cass::cql::impl::CassResultPtr result(NULL, &mock_cci);
-    cass::cql::impl::StaticCfGetResult(&mock_cci, &result, rk_count,
+    cass::cql::impl::CassResultPtr result(NULL, &cci);
+    cass::cql::impl::StaticCfGetResult(&cci, &result, rk_count,
         &actual_v_col_list);
     EXPECT_THAT(actual_v_col_list, ContainerEq(expected_v_col_list));
 }
 
+// Futures of the asynchronous requests, completed by the test
+class MockCassFutures {
+ public:
+    CassError SetCallback(CassFuture *future, CassFutureCallback callback,
+        void *data) {
+        callbacks_.push_back(std::make_pair(callback, data));
+        return CASS_OK;
+    }
+    void Complete() {
+        for (size_t i = 0; i < callbacks_.size(); i++) {
+            callbacks_[i].first(NULL, callbacks_[i].second);
+        }
+        callbacks_.clear();
+    }
+ private:
+    std::vector<std::pair<CassFutureCallback, void *> > callbacks_;
+};
+
+class WriteCoalescerCallbacks {
+ public:
+    WriteCoalescerCallbacks() :
+        ok_(0),
+        back_pressure_(0),
+        error_(0) {
+    }
+    void Callback(GenDb::DbOpResult::type drc,
+        std::auto_ptr<GenDb::ColList> row) {
+        if (drc == GenDb::DbOpResult::OK) {
+            ok_++;
+        } else if (drc == GenDb::DbOpResult::BACK_PRESSURE) {
+            back_pressure_++;
+        } else {
+            error_++;
+        }
+    }
+    int ok_;
+    int back_pressure_;
+    int error_;
+};
+
+static uint8_t dummy_cass_object;
+
+static void WriteCoalescerAddStatement(
+    cass::cql::impl::CassWriteCoalescer *coalescer,
+    cass::cql::interface::CassLibrary *cci, const std::string &table,
+    const std::string &key, size_t size, WriteCoalescerCallbacks *callbacks) {
+    cass::cql::impl::CassStatementPtr statement(
+        reinterpret_cast<CassStatement *>(&dummy_cass_object), cci);
+    GenDb::DbDataValueVec partition_key(1, key);
+    coalescer->AddStatement(NULL, table, partition_key, CASS_CONSISTENCY_ONE,
+        statement, size, boost::bind(&WriteCoalescerCallbacks::Callback,
+        callbacks, _1, _2));
+}
+
+static void WriteCoalescerExpectRequests(
+    NiceMock<cass::cql::test::MockCassLibrary> *mock_cci,
+    MockCassFutures *futures) {
+    ON_CALL(*mock_cci, CassBatchNew(CASS_BATCH_TYPE_UNLOGGED))
+        .WillByDefault(Return(
+            reinterpret_cast<CassBatch *>(&dummy_cass_object)));
+    ON_CALL(*mock_cci, CassFutureSetCallback(_, _, _))
+        .WillByDefault(Invoke(futures, &MockCassFutures::SetCallback));
+}
+
+TEST_F(CqlIfTest, WriteCoalescerPartition) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    MockCassFutures futures;
+    WriteCoalescerExpectRequests(&mock_cci, &futures);
+    // 2 full batches and the flush of the 2 remaining for key1, and the
+    // flush of key2
+    EXPECT_CALL(mock_cci, CassBatchNew(CASS_BATCH_TYPE_UNLOGGED)).Times(4);
+    EXPECT_CALL(mock_cci, CassBatchAddStatement(_, _)).Times(13);
+    EXPECT_CALL(mock_cci, CassSessionExecuteBatch(_, _)).Times(4);
+    EXPECT_CALL(mock_cci, CassSessionExecute(_, _)).Times(0);
+    cass::cql::impl::CassWriteCoalescer coalescer(&mock_cci, 4, 1 << 20,
+        1000);
+    WriteCoalescerCallbacks callbacks;
+    for (int i = 0; i < 10; i++) {
+        WriteCoalescerAddStatement(&coalescer, &mock_cci, "Table1", "key1",
+            100, &callbacks);
+    }
+    for (int i = 0; i < 3; i++) {
+        WriteCoalescerAddStatement(&coalescer, &mock_cci, "Table1", "key2",
+            100, &callbacks);
+    }
+    EXPECT_EQ(2U, coalescer.requests());
+    EXPECT_EQ(8U, coalescer.statements());
+    EXPECT_EQ(5U, coalescer.pending_statements());
+    coalescer.Flush(NULL);
+    EXPECT_EQ(4U, coalescer.requests());
+    EXPECT_EQ(13U, coalescer.statements());
+    EXPECT_EQ(0U, coalescer.pending_statements());
+    // Callbacks are called on completion of the batch
+    EXPECT_EQ(0, callbacks.ok_);
+    futures.Complete();
+    EXPECT_EQ(13, callbacks.ok_);
+    EXPECT_EQ(0, callbacks.back_pressure_ + callbacks.error_);
+}
+
+TEST_F(CqlIfTest, WriteCoalescerSize) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    MockCassFutures futures;
+    WriteCoalescerExpectRequests(&mock_cci, &futures);
+    EXPECT_CALL(mock_cci, CassBatchAddStatement(_, _)).Times(4);
+    EXPECT_CALL(mock_cci, CassSessionExecuteBatch(_, _)).Times(2);
+    // The last statement is not worth a batch
+    EXPECT_CALL(mock_cci, CassSessionExecute(_, _)).Times(1);
+    cass::cql::impl::CassWriteCoalescer coalescer(&mock_cci, 100, 1000,
+        1000);
+    WriteCoalescerCallbacks callbacks;
+    for (int i = 0; i < 5; i++) {
+        WriteCoalescerAddStatement(&coalescer, &mock_cci, "Table1", "key1",
+            400, &callbacks);
+    }
+    // Batches of 800 bytes, a third statement does not fit
+    EXPECT_EQ(2U, coalescer.requests());
+    EXPECT_EQ(1U, coalescer.pending_statements());
+    coalescer.Flush(NULL);
+    EXPECT_EQ(3U, coalescer.requests());
+    EXPECT_EQ(5U, coalescer.statements());
+    futures.Complete();
+    EXPECT_EQ(5, callbacks.ok_);
+}
+
+TEST_F(CqlIfTest, WriteCoalescerLinger) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    MockCassFutures futures;
+    WriteCoalescerExpectRequests(&mock_cci, &futures);
+    cass::cql::impl::CassWriteCoalescer coalescer(&mock_cci, 100, 1 << 20,
+        1000);
+    WriteCoalescerCallbacks callbacks;
+    uint64_t start_usecs(ClockMonotonicUsec());
+    WriteCoalescerAddStatement(&coalescer, &mock_cci, "Table1", "key1", 100,
+        &callbacks);
+    WriteCoalescerAddStatement(&coalescer, &mock_cci, "Table2", "key1", 100,
+        &callbacks);
+    WriteCoalescerAddStatement(&coalescer, &mock_cci, "Table2", "key1", 100,
+        &callbacks);
+    coalescer.FlushExpired(NULL, start_usecs);
+    EXPECT_EQ(0U, coalescer.requests());
+    EXPECT_EQ(3U, coalescer.pending_statements());
+    coalescer.FlushExpired(NULL, ClockMonotonicUsec() + 1000 * 1000);
+    EXPECT_EQ(2U, coalescer.requests());
+    EXPECT_EQ(0U, coalescer.pending_statements());
+    futures.Complete();
+    EXPECT_EQ(3, callbacks.ok_);
+}
+
+TEST_F(CqlIfTest, WriteCoalescerError) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    MockCassFutures futures;
+    WriteCoalescerExpectRequests(&mock_cci, &futures);
+    EXPECT_CALL(mock_cci, CassFutureErrorCode(_))
+        .WillOnce(Return(CASS_ERROR_LIB_REQUEST_QUEUE_FULL))
+        .WillOnce(Return(CASS_ERROR_SERVER_WRITE_TIMEOUT));
+    cass::cql::impl::CassWriteCoalescer coalescer(&mock_cci, 3, 1 << 20,
+        1000);
+    WriteCoalescerCallbacks callbacks;
+    for (int i = 0; i < 6; i++) {
+        WriteCoalescerAddStatement(&coalescer, &mock_cci, "Table1", "key1",
+            100, &callbacks);
+    }
+    EXPECT_EQ(2U, coalescer.requests());
+    // The result of each batch is reported to all its statements
+    futures.Complete();
+    EXPECT_EQ(0, callbacks.ok_);
+    EXPECT_EQ(3, callbacks.back_pressure_);
+    EXPECT_EQ(3, callbacks.error_);
+}
+
+// Requests issued to the driver for inserts spread over 1000 partitions
+TEST_F(CqlIfTest, DISABLED_WriteCoalescerPerf) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    MockCassFutures futures;
+    WriteCoalescerExpectRequests(&mock_cci, &futures);
+    cass::cql::impl::CassWriteCoalescer coalescer(&mock_cci, 32, 1 << 16,
+        10);
+    WriteCoalescerCallbacks callbacks;
+    std::vector<std::string> keys;
+    for (int i = 0; i < 1000; i++) {
+        keys.push_back(integerToString(i));
+    }
+    const int kInserts(100000);
+    uint64_t start_usecs(ClockMonotonicUsec());
+    for (int i = 0; i < kInserts; i++) {
+        WriteCoalescerAddStatement(&coalescer, &mock_cci, "Table1",
+            keys[i % keys.size()], 200, &callbacks);
+        if (i % 1000 == 999) {
+            coalescer.FlushExpired(NULL, ClockMonotonicUsec());
+            futures.Complete();
+        }
+    }
+    coalescer.Flush(NULL);
+    futures.Complete();
+    uint64_t elapsed_usecs(ClockMonotonicUsec() - start_usecs);
+    EXPECT_EQ(kInserts, callbacks.ok_);
+    std::cout << kInserts << " inserts: " << coalescer.requests() <<
+        " requests, " << elapsed_usecs << " usecs" << std::endl;
+}
+
+// Asynchronous inserts into a static table through a CqlIfImpl connected
+// with the mock library, the event manager runs the write coalescer timer
+class CqlIfImplWriteCoalescerTest : public ::testing::Test {
+ protected:
+    CqlIfImplWriteCoalescerTest() :
+        thread_(&evm_) {
+    }
+
+    virtual void SetUp() {
+        ON_CALL(mock_cci_, CassSessionGetSchemaMeta(_))
+            .WillByDefault(Return(reinterpret_cast<const CassSchemaMeta *>(
+                &dummy_cass_object)));
+        ON_CALL(mock_cci_, CassSchemaMetaKeyspaceByName(_, _))
+            .WillByDefault(Return(reinterpret_cast<const CassKeyspaceMeta *>(
+                &dummy_cass_object)));
+        ON_CALL(mock_cci_, CassKeyspaceMetaTableByName(_, _))
+            .WillByDefault(Return(reinterpret_cast<const CassTableMeta *>(
+                &dummy_cass_object)));
+        ON_CALL(mock_cci_, CassTableMetaClusteringKeyCount(_))
+            .WillByDefault(Return(0));
+        ON_CALL(mock_cci_, CassStatementNew(_, _))
+            .WillByDefault(Return(reinterpret_cast<CassStatement *>(
+                &dummy_cass_object)));
+        WriteCoalescerExpectRequests(&mock_cci_, &futures_);
+        thread_.Start();
+    }
+
+    virtual void TearDown() {
+        task_util::WaitForIdle();
+        evm_.Shutdown();
+        thread_.Join();
+    }
+
+    void Insert(cass::cql::CqlIfImpl *impl, const std::string &key) {
+        std::auto_ptr<GenDb::ColList> v_columns(new GenDb::ColList);
+        v_columns->cfname_ = "Table1";
+        v_columns->rowkey_.push_back(key);
+        v_columns->columns_.push_back(new GenDb::NewCol("Column1",
+            std::string("value"), 0));
+        EXPECT_TRUE(impl->InsertIntoTableAsync(v_columns,
+            CASS_CONSISTENCY_ONE, boost::bind(
+            &WriteCoalescerCallbacks::Callback, &callbacks_, _1, _2)));
+    }
+
+    EventManager evm_;
+    ServerThread thread_;
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci_;
+    MockCassFutures futures_;
+    WriteCoalescerCallbacks callbacks_;
+};
+
+// The timer executes the batch once it has lingered
+TEST_F(CqlIfImplWriteCoalescerTest, TimerFlush) {
+    EXPECT_CALL(mock_cci_, CassSessionExecuteBatch(_, _)).Times(1);
+    EXPECT_CALL(mock_cci_, CassSessionExecute(_, _)).Times(0);
+    cass::cql::CqlIfImpl impl(&evm_, std::vector<std::string>(), 9042, "",
+        "", false, "", &mock_cci_);
+    EXPECT_TRUE(impl.EnableWriteCoalescing(100, 1 << 20, 200));
+    // The timer runs at a quarter of the linger time
+    EXPECT_EQ(50, impl.write_coalescer()->flush_msecs());
+    EXPECT_TRUE(impl.ConnectSync());
+    Insert(&impl, "key1");
+    Insert(&impl, "key1");
+    EXPECT_EQ(2U, impl.write_coalescer()->pending_statements());
+    TASK_UTIL_EXPECT_EQ(1U, impl.write_coalescer()->requests());
+    task_util::WaitForIdle();
+    EXPECT_EQ(2U, impl.write_coalescer()->statements());
+    EXPECT_EQ(0U, impl.write_coalescer()->pending_statements());
+    futures_.Complete();
+    EXPECT_EQ(2, callbacks_.ok_);
+    EXPECT_TRUE(impl.DisconnectSync());
+}
+
+// DisconnectSync executes the batches that have not lingered yet
+TEST_F(CqlIfImplWriteCoalescerTest, DisconnectFlush) {
+    EXPECT_CALL(mock_cci_, CassSessionExecuteBatch(_, _)).Times(1);
+    EXPECT_CALL(mock_cci_, CassSessionExecute(_, _)).Times(1);
+    cass::cql::CqlIfImpl impl(&evm_, std::vector<std::string>(), 9042, "",
+        "", false, "", &mock_cci_);
+    EXPECT_TRUE(impl.EnableWriteCoalescing(100, 1 << 20, 3600 * 1000));
+    EXPECT_TRUE(impl.ConnectSync());
+    Insert(&impl, "key1");
+    Insert(&impl, "key1");
+    Insert(&impl, "key2");
+    task_util::WaitForIdle();
+    EXPECT_EQ(0U, impl.write_coalescer()->requests());
+    EXPECT_EQ(3U, impl.write_coalescer()->pending_statements());
+    EXPECT_TRUE(impl.DisconnectSync());
+    EXPECT_EQ(2U, impl.write_coalescer()->requests());
+    EXPECT_EQ(0U, impl.write_coalescer()->pending_statements());
+    futures_.Complete();
+    EXPECT_EQ(3, callbacks_.ok_);
+}
+
+// Without an event manager nothing would execute the lingering batches
+TEST_F(CqlIfImplWriteCoalescerTest, NoEventManager) {
+    cass::cql::CqlIfImpl impl(NULL, std::vector<std::string>(), 9042, "",
+        "", false, "", &mock_cci_);
+    EXPECT_FALSE(impl.EnableWriteCoalescing(100, 1 << 20, 200));
+    EXPECT_TRUE(impl.write_coalescer() == NULL);
+}
+
+// Writes of the write queue, completed by the test in the order they are
+// executed
+class MockAsyncWrites {
+ public:
+    void Write(const std::string &table,
+        cass::cql::impl::CassAsyncQueryCallback cb) {
+        tables_.push_back(table);
+        callbacks_.push_back(cb);
+    }
+    void Complete(size_t count) {
+        for (size_t i = 0; i < count && !callbacks_.empty(); i++) {
+            cass::cql::impl::CassAsyncQueryCallback cb(callbacks_.front());
+            callbacks_.pop_front();
+            cb(GenDb::DbOpResult::OK, std::auto_ptr<GenDb::ColList>());
+        }
+    }
+    size_t outstanding() const { return callbacks_.size(); }
+    // Tables of the writes in the order they were executed
+    const std::vector<std::string> &tables() const { return tables_; }
+
+ private:
+    std::vector<std::string> tables_;
+    std::deque<cass::cql::impl::CassAsyncQueryCallback> callbacks_;
+};
+
+static void WriteQueueEnqueue(cass::cql::impl::CassWriteQueue *write_queue,
+    const std::string &table, MockAsyncWrites *writes,
+    WriteCoalescerCallbacks *callbacks) {
+    write_queue->Enqueue(table,
+        boost::bind(&MockAsyncWrites::Write, writes, table, _1),
+        boost::bind(&WriteCoalescerCallbacks::Callback, callbacks, _1, _2));
+}
+
+TEST_F(CqlIfTest, WriteQueueTableLimit) {
+    cass::cql::impl::CassWriteQueue write_queue(4, 2, 100);
+    MockAsyncWrites writes;
+    WriteCoalescerCallbacks callbacks;
+    for (int i = 0; i < 5; i++) {
+        WriteQueueEnqueue(&write_queue, "Table1", &writes, &callbacks);
+    }
+    EXPECT_EQ(2U, writes.outstanding());
+    EXPECT_EQ(2U, write_queue.table_in_flight("Table1"));
+    EXPECT_EQ(3U, write_queue.queued());
+    EXPECT_EQ(5U, write_queue.count());
+    // Another table gets the remaining outstanding writes
+    WriteQueueEnqueue(&write_queue, "Table2", &writes, &callbacks);
+    EXPECT_EQ(3U, writes.outstanding());
+    EXPECT_EQ(1U, write_queue.table_in_flight("Table2"));
+    // A completion lets the next write of the table go
+    writes.Complete(1);
+    EXPECT_EQ(3U, writes.outstanding());
+    EXPECT_EQ(2U, write_queue.queued());
+    EXPECT_EQ(1, callbacks.ok_);
+    while (writes.outstanding() > 0) {
+        writes.Complete(1);
+    }
+    EXPECT_EQ(6, callbacks.ok_);
+    EXPECT_EQ(0U, write_queue.count());
+    EXPECT_EQ(6U, write_queue.enqueues());
+}
+
+TEST_F(CqlIfTest, WriteQueueFairness) {
+    cass::cql::impl::CassWriteQueue write_queue(2, 2, 100);
+    MockAsyncWrites writes;
+    WriteCoalescerCallbacks callbacks;
+    // The hot table takes all outstanding writes first
+    for (int i = 0; i < 20; i++) {
+        WriteQueueEnqueue(&write_queue, "Hot", &writes, &callbacks);
+    }
+    for (int i = 0; i < 3; i++) {
+        WriteQueueEnqueue(&write_queue, "Cold", &writes, &callbacks);
+    }
+    EXPECT_EQ(0U, write_queue.table_in_flight("Cold"));
+    // Then the tables are served in turn
+    writes.Complete(6);
+    std::vector<std::string> expected_tables = list_of("Hot")("Hot")
+        ("Cold")("Hot")("Cold")("Hot")("Cold")("Hot");
+    EXPECT_THAT(writes.tables(), ContainerEq(expected_tables));
+    while (writes.outstanding() > 0) {
+        writes.Complete(1);
+    }
+    EXPECT_EQ(23, callbacks.ok_);
+}
+
+TEST_F(CqlIfTest, WriteQueueBackPressure) {
+    cass::cql::impl::CassWriteQueue write_queue(2, 1, 2);
+    MockAsyncWrites writes;
+    WriteCoalescerCallbacks callbacks;
+    for (int i = 0; i < 5; i++) {
+        WriteQueueEnqueue(&write_queue, "Table1", &writes, &callbacks);
+    }
+    // 1 outstanding, 2 waiting
+    EXPECT_EQ(2, callbacks.back_pressure_);
+    EXPECT_EQ(2U, write_queue.drops());
+    EXPECT_EQ(3U, write_queue.count());
+    // A table with outstanding writes available is not failed
+    WriteQueueEnqueue(&write_queue, "Table2", &writes, &callbacks);
+    EXPECT_EQ(2, callbacks.back_pressure_);
+    EXPECT_EQ(1U, write_queue.table_in_flight("Table2"));
+    writes.Complete(4);
+    EXPECT_EQ(4, callbacks.ok_);
+    EXPECT_EQ(0U, write_queue.count());
+}
+
+TEST_F(CqlIfTest, WriteQueueClear) {
+    cass::cql::impl::CassWriteQueue write_queue(2, 2, 100);
+    MockAsyncWrites writes;
+    WriteCoalescerCallbacks callbacks;
+    for (int i = 0; i < 5; i++) {
+        WriteQueueEnqueue(&write_queue, "Table1", &writes, &callbacks);
+    }
+    write_queue.Clear();
+    EXPECT_EQ(3, callbacks.error_);
+    EXPECT_EQ(2U, write_queue.count());
+    // The outstanding writes complete
+    writes.Complete(2);
+    EXPECT_EQ(2, callbacks.ok_);
+    EXPECT_EQ(0U, writes.outstanding());
+}
+
+class WriteQueueWaterMarks {
+ public:
+    void Callback(bool high, size_t count) {
+        counts_.push_back(std::make_pair(high, count));
+    }
+    std::vector<std::pair<bool, size_t> > counts_;
+};
+
+TEST_F(CqlIfTest, WriteQueueWaterMark) {
+    cass::cql::impl::CassWriteQueue write_queue(2, 2, 100);
+    MockAsyncWrites writes;
+    WriteCoalescerCallbacks callbacks;
+    WriteQueueWaterMarks watermarks;
+    write_queue.SetWaterMark(true, 4,
+        boost::bind(&WriteQueueWaterMarks::Callback, &watermarks, true, _1));
+    write_queue.SetWaterMark(false, 1,
+        boost::bind(&WriteQueueWaterMarks::Callback, &watermarks, false,
+            _1));
+    for (int i = 0; i < 5; i++) {
+        WriteQueueEnqueue(&write_queue, "Table1", &writes, &callbacks);
+    }
+    ASSERT_EQ(1U, watermarks.counts_.size());
+    EXPECT_EQ(std::make_pair(true, static_cast<size_t>(4)),
+        watermarks.counts_[0]);
+    writes.Complete(3);
+    EXPECT_EQ(1U, watermarks.counts_.size());
+    writes.Complete(1);
+    ASSERT_EQ(2U, watermarks.counts_.size());
+    EXPECT_EQ(std::make_pair(false, static_cast<size_t>(1)),
+        watermarks.counts_[1]);
+    write_queue.ResetWaterMarks();
+    writes.Complete(1);
+    EXPECT_EQ(2U, watermarks.counts_.size());
+}
+
+// Not limited by default, the writes are only counted for the water marks
+TEST_F(CqlIfTest, WriteQueueUnlimited) {
+    cass::cql::impl::CassWriteQueue write_queue;
+    MockAsyncWrites writes;
+    WriteCoalescerCallbacks callbacks;
+    WriteQueueWaterMarks watermarks;
+    write_queue.SetWaterMark(true, 1000,
+        boost::bind(&WriteQueueWaterMarks::Callback, &watermarks, true, _1));
+    for (int i = 0; i < 2000; i++) {
+        WriteQueueEnqueue(&write_queue, "Table1", &writes, &callbacks);
+    }
+    EXPECT_EQ(2000U, writes.outstanding());
+    EXPECT_EQ(0U, write_queue.queued());
+    EXPECT_EQ(2000U, write_queue.count());
+    EXPECT_EQ(0U, write_queue.drops());
+    EXPECT_EQ(1U, watermarks.counts_.size());
+    writes.Complete(2000);
+    EXPECT_EQ(2000, callbacks.ok_);
+    EXPECT_EQ(0U, write_queue.count());
+}
+
+// Writes completed in the context of the caller, the depth of the nested
+// writes is recorded
+class SyncWrites {
+ public:
+    SyncWrites() :
+        writes_(0),
+        depth_(0),
+        max_depth_(0) {
+    }
+    void Write(cass::cql::impl::CassAsyncQueryCallback cb) {
+        writes_++;
+        depth_++;
+        max_depth_ = std::max(max_depth_, depth_);
+        cb(GenDb::DbOpResult::OK, std::auto_ptr<GenDb::ColList>());
+        depth_--;
+    }
+    int writes_;
+    int depth_;
+    int max_depth_;
+};
+
+// The writes let go by a write completing synchronously are executed in
+// turn, not recursively
+TEST_F(CqlIfTest, WriteQueueSyncCompletion) {
+    cass::cql::impl::CassWriteQueue write_queue(1, 1, 1000);
+    MockAsyncWrites writes;
+    SyncWrites sync_writes;
+    WriteCoalescerCallbacks callbacks;
+    WriteQueueEnqueue(&write_queue, "Table1", &writes, &callbacks);
+    for (int i = 0; i < 100; i++) {
+        write_queue.Enqueue("Table1",
+            boost::bind(&SyncWrites::Write, &sync_writes, _1),
+            boost::bind(&WriteCoalescerCallbacks::Callback, &callbacks, _1,
+                _2));
+    }
+    EXPECT_EQ(100U, write_queue.queued());
+    writes.Complete(1);
+    EXPECT_EQ(100, sync_writes.writes_);
+    EXPECT_EQ(1, sync_writes.max_depth_);
+    EXPECT_EQ(101, callbacks.ok_);
+    EXPECT_EQ(0U, write_queue.count());
+}
+
+// Inserts through the write queue and the library
+TEST_F(CqlIfTest, WriteQueueExecute) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    MockCassFutures futures;
+    WriteCoalescerExpectRequests(&mock_cci, &futures);
+    cass::cql::impl::CassWriteCoalescer coalescer(&mock_cci, 1, 1 << 20,
+        1000);
+    cass::cql::impl::CassWriteQueue write_queue(2, 2, 100);
+    WriteCoalescerCallbacks callbacks;
+    EXPECT_CALL(mock_cci, CassSessionExecute(_, _)).Times(2);
+    for (int i = 0; i < 4; i++) {
+        cass::cql::impl::CassStatementPtr statement(
+            reinterpret_cast<CassStatement *>(&dummy_cass_object), &mock_cci);
+        GenDb::DbDataValueVec partition_key(1, std::string("key1"));
+        write_queue.Enqueue("Table1",
+            boost::bind(&cass::cql::impl::CassWriteCoalescer::AddStatement,
+                &coalescer, static_cast<CassSession *>(NULL),
+                std::string("Table1"), partition_key, CASS_CONSISTENCY_ONE,
+                statement, 100, _1),
+            boost::bind(&WriteCoalescerCallbacks::Callback, &callbacks, _1,
+                _2));
+    }
+    EXPECT_EQ(2U, write_queue.queued());
+    Mock::VerifyAndClearExpectations(&mock_cci);
+    // The waiting inserts are executed as the outstanding ones complete
+    EXPECT_CALL(mock_cci, CassSessionExecute(_, _)).Times(2);
+    futures.Complete();
+    EXPECT_EQ(4, callbacks.ok_);
+    EXPECT_EQ(0U, write_queue.count());
+}
+
+// Selects completed by the test
+class MockAsyncSelects {
+ public:
+    typedef std::pair<GenDb::DbDataValueVec,
+        cass::cql::impl::CassAsyncQueryCallback> Select;
+
+    MockAsyncSelects() :
+        fail_(false),
+        issued_(0),
+        max_outstanding_(0) {
+    }
+    bool AsyncSelect(const GenDb::DbDataValueVec &rkey,
+        cass::cql::impl::CassAsyncQueryCallback cb) {
+        if (fail_) {
+            return false;
+        }
+        selects_.push_back(std::make_pair(rkey, cb));
+        issued_++;
+        max_outstanding_ = std::max(max_outstanding_, selects_.size());
+        return true;
+    }
+    void Complete(size_t index, GenDb::DbOpResult::type drc) {
+        Select select(selects_[index]);
+        selects_.erase(selects_.begin() + index);
+        std::auto_ptr<GenDb::ColList> row;
+        if (drc == GenDb::DbOpResult::OK) {
+            row.reset(new GenDb::ColList);
+            row->rowkey_ = select.first;
+            row->columns_.push_back(new GenDb::NewCol("column", "value", 0));
+        }
+        select.second(drc, row);
+    }
+    size_t outstanding() const { return selects_.size(); }
+    bool fail_;
+    size_t issued_;
+    size_t max_outstanding_;
+
+ private:
+    std::vector<Select> selects_;
+};
+
+class MultiRowSelectResult {
+ public:
+    MultiRowSelectResult() :
+        done_(0),
+        drc_(GenDb::DbOpResult::OK) {
+    }
+    void Completion(GenDb::DbOpResult::type drc,
+        std::auto_ptr<GenDb::ColListVec> rows) {
+        done_++;
+        drc_ = drc;
+        rows_ = rows;
+    }
+    int done_;
+    GenDb::DbOpResult::type drc_;
+    std::auto_ptr<GenDb::ColListVec> rows_;
+};
+
+static std::vector<GenDb::DbDataValueVec> MultiRowSelectKeys(int count) {
+    std::vector<GenDb::DbDataValueVec> v_rowkey;
+    for (int i = 0; i < count; i++) {
+        v_rowkey.push_back(GenDb::DbDataValueVec(1, integerToString(i)));
+    }
+    return v_rowkey;
+}
+
+static void MultiRowSelectStart(
+    const std::vector<GenDb::DbDataValueVec> &v_rowkey, size_t window,
+    cass::cql::impl::CassAsyncMultiRowSelect::SelectFn select_fn,
+    MultiRowSelectResult *result) {
+    boost::shared_ptr<cass::cql::impl::CassAsyncMultiRowSelect> select(
+        new cass::cql::impl::CassAsyncMultiRowSelect(v_rowkey, window,
+            select_fn, boost::bind(&MultiRowSelectResult::Completion, result,
+            _1, _2)));
+    select->Start();
+}
+
+TEST_F(CqlIfTest, MultiRowSelectWindow) {
+    MockAsyncSelects selects;
+    MultiRowSelectResult result;
+    std::vector<GenDb::DbDataValueVec> v_rowkey(MultiRowSelectKeys(10));
+    MultiRowSelectStart(v_rowkey, 3, boost::bind(
+        &MockAsyncSelects::AsyncSelect, &selects, _1, _2), &result);
+    EXPECT_EQ(3U, selects.outstanding());
+    // Complete the newest select first
+    while (selects.outstanding()) {
+        EXPECT_EQ(0, result.done_);
+        selects.Complete(selects.outstanding() - 1, GenDb::DbOpResult::OK);
+    }
+    EXPECT_EQ(10U, selects.issued_);
+    EXPECT_EQ(3U, selects.max_outstanding_);
+    EXPECT_EQ(1, result.done_);
+    EXPECT_EQ(GenDb::DbOpResult::OK, result.drc_);
+    ASSERT_TRUE(result.rows_.get() != NULL);
+    ASSERT_EQ(10U, result.rows_->size());
+    // In the order of the partition keys
+    for (size_t i = 0; i < v_rowkey.size(); i++) {
+        EXPECT_EQ(v_rowkey[i], (*result.rows_)[i].rowkey_);
+        EXPECT_EQ(1U, (*result.rows_)[i].columns_.size());
+    }
+}
+
+TEST_F(CqlIfTest, MultiRowSelectError) {
+    MockAsyncSelects selects;
+    MultiRowSelectResult result;
+    MultiRowSelectStart(MultiRowSelectKeys(10), 3, boost::bind(
+        &MockAsyncSelects::AsyncSelect, &selects, _1, _2), &result);
+    selects.Complete(0, GenDb::DbOpResult::BACK_PRESSURE);
+    // No more selects, the outstanding ones are waited for
+    EXPECT_EQ(2U, selects.outstanding());
+    selects.Complete(0, GenDb::DbOpResult::OK);
+    EXPECT_EQ(0, result.done_);
+    selects.Complete(0, GenDb::DbOpResult::OK);
+    EXPECT_EQ(3U, selects.issued_);
+    EXPECT_EQ(1, result.done_);
+    EXPECT_EQ(GenDb::DbOpResult::BACK_PRESSURE, result.drc_);
+    EXPECT_TRUE(result.rows_.get() == NULL);
+
+    // Select not issued
+    MockAsyncSelects fail_selects;
+    fail_selects.fail_ = true;
+    MultiRowSelectResult fail_result;
+    MultiRowSelectStart(MultiRowSelectKeys(10), 3, boost::bind(
+        &MockAsyncSelects::AsyncSelect, &fail_selects, _1, _2), &fail_result);
+    EXPECT_EQ(1, fail_result.done_);
+    EXPECT_EQ(GenDb::DbOpResult::ERROR, fail_result.drc_);
+}
+
+TEST_F(CqlIfTest, MultiRowSelectEmpty) {
+    MockAsyncSelects selects;
+    MultiRowSelectResult result;
+    MultiRowSelectStart(MultiRowSelectKeys(0), 3, boost::bind(
+        &MockAsyncSelects::AsyncSelect, &selects, _1, _2), &result);
+    EXPECT_EQ(0U, selects.issued_);
+    EXPECT_EQ(1, result.done_);
+    EXPECT_EQ(GenDb::DbOpResult::OK, result.drc_);
+    ASSERT_TRUE(result.rows_.get() != NULL);
+    EXPECT_EQ(0U, result.rows_->size());
+}
+
+// Selects completed after a round trip delay
+class DelayedAsyncSelects {
+ public:
+    DelayedAsyncSelects(boost::asio::io_service *io_service, int delay_usecs) :
+        io_service_(io_service),
+        delay_usecs_(delay_usecs) {
+    }
+    bool AsyncSelect(const GenDb::DbDataValueVec &rkey,
+        cass::cql::impl::CassAsyncQueryCallback cb) {
+        boost::shared_ptr<boost::asio::deadline_timer> timer(
+            new boost::asio::deadline_timer(*io_service_,
+                boost::posix_time::microseconds(delay_usecs_)));
+        timer->async_wait(boost::bind(&DelayedAsyncSelects::Complete, timer,
+            rkey, cb));
+        return true;
+    }
+
+ private:
+    static void Complete(boost::shared_ptr<boost::asio::deadline_timer> timer,
+        GenDb::DbDataValueVec rkey,
+        cass::cql::impl::CassAsyncQueryCallback cb) {
+        std::auto_ptr<GenDb::ColList> row(new GenDb::ColList);
+        row->rowkey_ = rkey;
+        cb(GenDb::DbOpResult::OK, row);
+    }
+    boost::asio::io_service *io_service_;
+    int delay_usecs_;
+};
+
+// Time to read 1000 partitions with a 1 msec round trip
+TEST_F(CqlIfTest, DISABLED_MultiRowSelectPerf) {
+    size_t windows[] = { 1, 16, 64, 256 };
+    for (size_t i = 0; i < sizeof(windows) / sizeof(windows[0]); i++) {
+        boost::asio::io_service io_service;
+        DelayedAsyncSelects selects(&io_service, 1000);
+        MultiRowSelectResult result;
+        uint64_t start_usecs(ClockMonotonicUsec());
+        MultiRowSelectStart(MultiRowSelectKeys(1000), windows[i],
+            boost::bind(&DelayedAsyncSelects::AsyncSelect, &selects, _1, _2),
+            &result);
+        io_service.run();
+        EXPECT_EQ(1, result.done_);
+        std::cout << "Window " << windows[i] << ": " <<
+            ClockMonotonicUsec() - start_usecs << " usecs" << std::endl;
+    }
+}
+
+static void PreparedCacheExpectPrepare(
+    NiceMock<cass::cql::test::MockCassLibrary> *mock_cci,
+    MockCassFutures *futures) {
+    ON_CALL(*mock_cci, CassFutureGetPrepared(_))
+        .WillByDefault(Return(
+            reinterpret_cast<const CassPrepared *>(&dummy_cass_object)));
+    ON_CALL(*mock_cci, CassFutureSetCallback(_, _, _))
+        .WillByDefault(Invoke(futures, &MockCassFutures::SetCallback));
+}
+
+TEST_F(CqlIfTest, PreparedCache) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    MockCassFutures futures;
+    PreparedCacheExpectPrepare(&mock_cci, &futures);
+    cass::cql::impl::CassPreparedCache cache(&mock_cci);
+    std::string query("SELECT * FROM PreparedTable WHERE key=?");
+    EXPECT_CALL(mock_cci, CassSessionPrepare(_, StrEq(query)))
+        .Times(1);
+    cass::cql::impl::CassPreparedPtr prepared(NULL, &mock_cci);
+    // Executed as text until prepared
+    EXPECT_FALSE(cache.Lookup(NULL, query, &prepared));
+    EXPECT_FALSE(cache.Lookup(NULL, query, &prepared));
+    futures.Complete();
+    EXPECT_TRUE(cache.Lookup(NULL, query, &prepared));
+    EXPECT_TRUE(prepared.get() != NULL);
+    EXPECT_TRUE(cache.Lookup(NULL, query, &prepared));
+    EXPECT_EQ(2U, cache.hits());
+    EXPECT_EQ(2U, cache.misses());
+    EXPECT_EQ(1U, cache.size());
+}
+
+TEST_F(CqlIfTest, PreparedCacheError) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    MockCassFutures futures;
+    PreparedCacheExpectPrepare(&mock_cci, &futures);
+    ON_CALL(mock_cci, CassFutureErrorCode(_))
+        .WillByDefault(Return(CASS_ERROR_SERVER_SYNTAX_ERROR));
+    cass::cql::impl::CassPreparedCache cache(&mock_cci);
+    std::string query("SELECT * FROM PreparedTable WHERE key=?");
+    // Not prepared again
+    EXPECT_CALL(mock_cci, CassSessionPrepare(_, _))
+        .Times(1);
+    cass::cql::impl::CassPreparedPtr prepared(NULL, &mock_cci);
+    EXPECT_FALSE(cache.Lookup(NULL, query, &prepared));
+    futures.Complete();
+    EXPECT_FALSE(cache.Lookup(NULL, query, &prepared));
+    EXPECT_EQ(0U, cache.hits());
+    EXPECT_EQ(2U, cache.misses());
+    EXPECT_EQ(1U, cache.prepare_failures());
+}
+
+TEST_F(CqlIfTest, PreparedCacheClear) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    MockCassFutures futures;
+    PreparedCacheExpectPrepare(&mock_cci, &futures);
+    cass::cql::impl::CassPreparedCache cache(&mock_cci, 1);
+    std::string query("SELECT * FROM PreparedTable WHERE key=?");
+    std::string query1("SELECT * FROM PreparedTable1 WHERE key=?");
+    // Prepared again after the cache is cleared
+    EXPECT_CALL(mock_cci, CassSessionPrepare(_, StrEq(query)))
+        .Times(2);
+    // Cache full
+    EXPECT_CALL(mock_cci, CassSessionPrepare(_, StrEq(query1)))
+        .Times(0);
+    cass::cql::impl::CassPreparedPtr prepared(NULL, &mock_cci);
+    EXPECT_FALSE(cache.Lookup(NULL, query, &prepared));
+    EXPECT_FALSE(cache.Lookup(NULL, query1, &prepared));
+    // Prepared on the previous session
+    cache.Clear();
+    futures.Complete();
+    EXPECT_EQ(0U, cache.size());
+    EXPECT_FALSE(cache.Lookup(NULL, query, &prepared));
+    futures.Complete();
+    EXPECT_TRUE(cache.Lookup(NULL, query, &prepared));
+}
+
+// A query that the values could not be bound to is executed as text from
+// then on, and the failure is reported once
+TEST_F(CqlIfTest, PreparedCacheBindFailed) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    MockCassFutures futures;
+    PreparedCacheExpectPrepare(&mock_cci, &futures);
+    cass::cql::impl::CassPreparedCache cache(&mock_cci);
+    std::string query("SELECT * FROM PreparedTable WHERE key=?");
+    // Not prepared again
+    EXPECT_CALL(mock_cci, CassSessionPrepare(_, StrEq(query)))
+        .Times(1);
+    cass::cql::impl::CassPreparedPtr prepared(NULL, &mock_cci);
+    EXPECT_FALSE(cache.Lookup(NULL, query, &prepared));
+    futures.Complete();
+    EXPECT_TRUE(cache.Lookup(NULL, query, &prepared));
+    EXPECT_TRUE(cache.BindFailed(query));
+    EXPECT_FALSE(cache.BindFailed(query));
+    EXPECT_FALSE(cache.Lookup(NULL, query, &prepared));
+    EXPECT_FALSE(cache.Lookup(NULL, query, &prepared));
+    EXPECT_EQ(2U, cache.bind_failures());
+    EXPECT_EQ(1U, cache.size());
+    // Forgotten with the prepared statements of the session
+    cache.Clear();
+    EXPECT_EQ(0U, cache.size());
+}
+
+// Values that can not be bound fail the bind instead of asserting, and the
+// select is executed as text
+TEST_F(CqlIfTest, SelectBindValues) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    CassStatement *statement(
+        reinterpret_cast<CassStatement *>(&dummy_cass_object));
+    GenDb::DbDataValueVec values;
+    values.push_back(std::string("key1"));
+    values.push_back(tu64_);
+    EXPECT_CALL(mock_cci, CassStatementBindStringN(_, 0, StrEq("key1"), 4));
+    EXPECT_CALL(mock_cci, CassStatementBindInt64(_, 1, tu64_));
+    EXPECT_TRUE(cass::cql::impl::CassStatementBindValues(&mock_cci,
+        statement, values));
+    Mock::VerifyAndClearExpectations(&mock_cci);
+    // Blank
+    GenDb::DbDataValueVec blank_values(values);
+    blank_values.push_back(GenDb::DbDataValue());
+    EXPECT_FALSE(cass::cql::impl::CassStatementBindValues(&mock_cci,
+        statement, blank_values));
+    // Does not fit in the column type
+    GenDb::DbDataValueVec u64_values(1,
+        std::numeric_limits<uint64_t>::max());
+    EXPECT_FALSE(cass::cql::impl::CassStatementBindValues(&mock_cci,
+        statement, u64_values));
+    // Rejected by the driver
+    EXPECT_CALL(mock_cci, CassStatementBindInt64(_, 1, tu64_))
+        .WillOnce(Return(CASS_ERROR_LIB_INVALID_VALUE_TYPE));
+    EXPECT_FALSE(cass::cql::impl::CassStatementBindValues(&mock_cci,
+        statement, values));
+}
+
+// Client CPU per select, building the query text, or building the query
+// shape and looking up its prepared statement. Binding the values to the
+// statement is not included.
+TEST_F(CqlIfTest, DISABLED_SelectFromTablePreparePerf) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    MockCassFutures futures;
+    PreparedCacheExpectPrepare(&mock_cci, &futures);
+    cass::cql::impl::CassPreparedCache cache(&mock_cci);
+    GenDb::ColumnNameRange crange;
+    crange.start_ = all_values;
+    crange.finish_ = all_values;
+    crange.count_ = 5000;
+    const int count(100000);
+    clock_t start(clock());
+    for (int i = 0; i < count; i++) {
+        std::string query(
+            cass::cql::impl::PartitionKeyAndClusteringKeyRange2CassSelectFromTable(
+                "PerfSelectTable", all_values, crange));
+    }
+    clock_t text_clocks(clock() - start);
+    start = clock();
+    for (int i = 0; i < count; i++) {
+        GenDb::DbDataValueVec values;
+        std::string query(cass::cql::impl::CassPrepareSelectFromTable(
+            "PerfSelectTable", std::vector<GenDb::DbDataValueVec>(1,
+            all_values), crange, GenDb::FieldNamesToReadVec(),
+            GenDb::WhereIndexInfoVec(), &values));
+        cass::cql::impl::CassPreparedPtr prepared(NULL, &mock_cci);
+        cache.Lookup(NULL, query, &prepared);
+        futures.Complete();
+    }
+    clock_t prepare_clocks(clock() - start);
+    std::cout << "Text: " << text_clocks * 1000000.0 / CLOCKS_PER_SEC / count
+        << " usecs/query, Prepared: " <<
+        prepare_clocks * 1000000.0 / CLOCKS_PER_SEC / count <<
+        " usecs/query" << std::endl;
+    EXPECT_EQ(count - 1U, cache.hits());
+}
+
+TEST_F(CqlIfTest, ResultColumnsDynamicCf) {
+    FakeCassResultLibrary cci(list_of("key")("column1")("column2")
+        ("column3")("value"));
+    cci.AddDynamicCfRows(4);
+    cass::cql::impl::CassResultPtr result(NULL, &cci);
+    cass::cql::impl::CassResultColumns columns(&cci, result, true, 1, 3);
+    EXPECT_EQ(4U, columns.row_count());
+    EXPECT_EQ(5U, columns.column_count());
+    // Views into the result
+    const std::string &value(boost::get<std::string>(
+        cci.value(1, 4)));
+    const cass::cql::impl::CassValueView &value_view(columns.value(1, 4));
+    EXPECT_EQ(GenDb::DB_VALUE_STRING, value_view.type);
+    EXPECT_EQ(value.c_str(), value_view.bytes.data);
+    EXPECT_EQ(value.length(), value_view.bytes.size);
+    EXPECT_EQ(3U, columns.column(3)[3].u64);
+    EXPECT_EQ(GenDb::DbDataValue(std::string("value1")),
+        value_view.ToDbDataValue());
+    // Same rows as decoded by DynamicCfGetResult
+    GenDb::ColListVec expected_v_col_list;
+    cass::cql::impl::DynamicCfGetResult(&cci, &result, 1, 3,
+        &expected_v_col_list);
+    EXPECT_EQ(2U, expected_v_col_list.size());
+    GenDb::ColListVec actual_v_col_list;
+    columns.GetColumns(&actual_v_col_list);
+    EXPECT_THAT(actual_v_col_list, ContainerEq(expected_v_col_list));
+    GenDb::NewColVec actual_v_columns;
+    columns.GetColumns(&actual_v_columns);
+    EXPECT_EQ(4U, actual_v_columns.size());
+}
+
+TEST_F(CqlIfTest, ResultColumnsStaticCf) {
+    FakeCassResultLibrary cci(list_of("key")("Column1")("Column2"));
+    cci.AddRow(list_of(GenDb::DbDataValue(std::string("key1")))
+        (GenDb::DbDataValue((uint64_t)1))
+        (GenDb::DbDataValue(std::string("column21"))));
+    // Null values are not returned
+    cci.AddRow(list_of(GenDb::DbDataValue(std::string("key2")))
+        (GenDb::DbDataValue())
+        (GenDb::DbDataValue(std::string("column22"))));
+    cass::cql::impl::CassResultPtr result(NULL, &cci);
+    cass::cql::impl::CassResultColumns columns(&cci, result, false, 1, 0);
+    EXPECT_EQ(GenDb::DB_VALUE_BLANK, columns.value(1, 1).type);
+    GenDb::ColListVec expected_v_col_list;
+    cass::cql::impl::StaticCfGetResult(&cci, &result, 1,
+        &expected_v_col_list);
+    GenDb::ColListVec actual_v_col_list;
+    columns.GetColumns(&actual_v_col_list);
+    EXPECT_THAT(actual_v_col_list, ContainerEq(expected_v_col_list));
+    EXPECT_EQ(2U, actual_v_col_list[1].columns_.size());
+}
+
+// Dynamic table read a page at a time, the rows are made up as the page
+// is iterated, so that tables of any size can be read
+class FakeCassPagedLibrary : public FakeCassResultLibrary {
+ public:
+    FakeCassPagedLibrary(size_t rows, size_t partition_rows) :
+        FakeCassResultLibrary(list_of("key")("column1")("value")),
+        total_rows_(rows),
+        partition_rows_(partition_rows),
+        page_size_(0),
+        paging_state_(0),
+        page_start_(0),
+        page_end_(0),
+        next_row_(0),
+        executes_(0),
+        fail_execute_(0) {
+    }
+    // Fails the given execute, counted from 1
+    void set_fail_execute(size_t execute) { fail_execute_ = execute; }
+    size_t executes() const { return executes_; }
+    int page_size() const { return page_size_; }
+
+    virtual CassError CassStatementSetPagingSize(CassStatement *statement,
+        int page_size) {
+        page_size_ = page_size;
+        return CASS_OK;
+    }
+    virtual CassError CassStatementSetPagingState(CassStatement *statement,
+        const CassResult *result) {
+        paging_state_ = page_end_;
+        return CASS_OK;
+    }
+    virtual CassFuture *CassSessionExecute(CassSession *session,
+        const CassStatement *statement) {
+        executes_++;
+        page_start_ = paging_state_;
+        page_end_ = std::min(page_start_ + page_size_, total_rows_);
+        return reinterpret_cast<CassFuture *>(&dummy_cass_object);
+    }
+    // Completes the request in the context of the caller
+    virtual CassError CassFutureSetCallback(CassFuture *future,
+        CassFutureCallback callback, void *data) {
+        callback(future, data);
+        return CASS_OK;
+    }
+    virtual CassError CassFutureErrorCode(CassFuture *future) {
+        return executes_ == fail_execute_ ? CASS_ERROR_SERVER_READ_TIMEOUT :
+            CASS_OK;
+    }
+    virtual size_t CassResultRowCount(const CassResult *result) {
+        return page_end_ - page_start_;
+    }
+    virtual cass_bool_t CassResultHasMorePages(const CassResult *result) {
+        return page_end_ < total_rows_ ? cass_true : cass_false;
+    }
+    virtual CassIterator *CassIteratorFromResult(const CassResult *result) {
+        next_row_ = page_start_;
+        return reinterpret_cast<CassIterator *>(&dummy_cass_object);
+    }
+    virtual cass_bool_t CassIteratorNext(CassIterator *iterator) {
+        if (next_row_ == page_end_) {
+            return cass_false;
+        }
+        row_.clear();
+        row_.push_back(RowKey(next_row_ / partition_rows_));
+        row_.push_back((uint32_t)next_row_);
+        row_.push_back((uint64_t)next_row_);
+        next_row_++;
+        return cass_true;
+    }
+    virtual const CassRow *CassIteratorGetRow(const CassIterator *iterator) {
+        return reinterpret_cast<const CassRow *>(&row_);
+    }
+
+    static std::string RowKey(size_t partition) {
+        return "key" + integerToString(partition);
+    }
+
+ private:
+    size_t total_rows_;
+    size_t partition_rows_;
+    size_t page_size_;
+    size_t paging_state_;
+    size_t page_start_;
+    size_t page_end_;
+    size_t next_row_;
+    GenDb::DbDataValueVec row_;
+    size_t executes_;
+    size_t fail_execute_;
+};
+
+// Keeps the last page, and the select to read the next page with
+struct PagedSelectReader {
+    PagedSelectReader() :
+        drc(GenDb::DbOpResult::OK),
+        pages(0) {
+    }
+    void OnPage(GenDb::DbOpResult::type page_drc,
+        std::auto_ptr<GenDb::ColListVec> page_rows,
+        cass::cql::impl::CassPagedSelectPtr page_next) {
+        drc = page_drc;
+        rows = page_rows;
+        next = page_next;
+        pages++;
+    }
+    // Reads the next page if there is one
+    bool ReadNextPage() {
+        if (next.get() == NULL) {
+            return false;
+        }
+        cass::cql::impl::CassPagedSelectPtr select(next);
+        next.reset();
+        select->FetchNextPage();
+        return true;
+    }
+    GenDb::DbOpResult::type drc;
+    std::auto_ptr<GenDb::ColListVec> rows;
+    cass::cql::impl::CassPagedSelectPtr next;
+    size_t pages;
+};
+
+static cass::cql::impl::CassPagedSelectPtr PagedSelectStart(
+    FakeCassPagedLibrary *cci, size_t page_size, PagedSelectReader *reader) {
+    cass::cql::impl::CassStatementPtr statement(
+        reinterpret_cast<CassStatement *>(&dummy_cass_object), cci);
+    cass::cql::impl::CassPagedSelectPtr select(
+        new cass::cql::impl::CassPagedSelect(cci,
+            cass::cql::impl::CassSessionPtr(NULL, cci),
+            "SELECT * FROM PagedTable", statement, CASS_CONSISTENCY_ONE,
+            page_size, true, 1, 1, boost::bind(&PagedSelectReader::OnPage,
+                reader, _1, _2, _3)));
+    select->Start();
+    return select;
+}
+
+TEST_F(CqlIfTest, PagedSelect) {
+    // 10 partitions of 1000 rows, read 300 rows at a time
+    FakeCassPagedLibrary cci(10000, 1000);
+    PagedSelectReader reader;
+    cass::cql::impl::CassPagedSelectPtr select(PagedSelectStart(&cci, 300,
+        &reader));
+    EXPECT_EQ(300, cci.page_size());
+    size_t row(0), col_lists(0);
+    do {
+        EXPECT_EQ(GenDb::DbOpResult::OK, reader.drc);
+        ASSERT_TRUE(reader.rows.get() != NULL);
+        size_t page_rows(0);
+        BOOST_FOREACH(const GenDb::ColList &col_list, *reader.rows) {
+            EXPECT_EQ(GenDb::DbDataValueVec(1,
+                FakeCassPagedLibrary::RowKey(row / 1000)), col_list.rowkey_);
+            BOOST_FOREACH(const GenDb::NewCol &column, col_list.columns_) {
+                EXPECT_EQ(GenDb::DbDataValue((uint32_t)row),
+                    column.name->at(0));
+                EXPECT_EQ(GenDb::DbDataValue((uint64_t)row),
+                    column.value->at(0));
+                row++;
+                page_rows++;
+            }
+            col_lists++;
+        }
+        EXPECT_GE(300U, page_rows);
+    } while (reader.ReadNextPage());
+    EXPECT_EQ(10000U, row);
+    EXPECT_EQ(34U, reader.pages);
+    EXPECT_EQ(34U, select->pages());
+    EXPECT_EQ(10000U, select->rows());
+    EXPECT_EQ(34U, cci.executes());
+    // Partitions spanning pages are reported once per page
+    EXPECT_LT(10U, col_lists);
+}
+
+TEST_F(CqlIfTest, PagedSelectCancel) {
+    FakeCassPagedLibrary cci(10000, 1000);
+    PagedSelectReader reader;
+    boost::weak_ptr<cass::cql::impl::CassPagedSelect> select(
+        PagedSelectStart(&cci, 300, &reader));
+    EXPECT_TRUE(reader.ReadNextPage());
+    EXPECT_TRUE(reader.ReadNextPage());
+    EXPECT_EQ(3U, reader.pages);
+    // Dropping the select stops the read
+    ASSERT_TRUE(reader.next.get() != NULL);
+    reader.next.reset();
+    EXPECT_TRUE(select.expired());
+    EXPECT_EQ(3U, cci.executes());
+}
+
+TEST_F(CqlIfTest, PagedSelectError) {
+    FakeCassPagedLibrary cci(10000, 1000);
+    cci.set_fail_execute(2);
+    PagedSelectReader reader;
+    cass::cql::impl::CassPagedSelectPtr select(PagedSelectStart(&cci, 300,
+        &reader));
+    EXPECT_EQ(GenDb::DbOpResult::OK, reader.drc);
+    EXPECT_TRUE(reader.ReadNextPage());
+    EXPECT_EQ(GenDb::DbOpResult::ERROR, reader.drc);
+    EXPECT_TRUE(reader.rows.get() == NULL);
+    EXPECT_FALSE(reader.ReadNextPage());
+    EXPECT_EQ(1U, select->pages());
+}
+
+// The session is not freed by a reconnect while pages are read from it
+TEST_F(CqlIfTest, PagedSelectSession) {
+    FakeCassPagedLibrary cci(10000, 1000);
+    PagedSelectReader reader;
+    cass::cql::impl::CassSessionPtr session(
+        reinterpret_cast<CassSession *>(&dummy_cass_object), &cci);
+    cass::cql::impl::CassStatementPtr statement(
+        reinterpret_cast<CassStatement *>(&dummy_cass_object), &cci);
+    cass::cql::impl::CassPagedSelectPtr select(
+        new cass::cql::impl::CassPagedSelect(&cci, session,
+            "SELECT * FROM PagedTable", statement, CASS_CONSISTENCY_ONE,
+            300, true, 1, 1, boost::bind(&PagedSelectReader::OnPage,
+                &reader, _1, _2, _3)));
+    select->Start();
+    select.reset();
+    EXPECT_CALL(cci, CassSessionFree(_))
+        .Times(0);
+    session.reset();
+    EXPECT_TRUE(reader.ReadNextPage());
+    EXPECT_EQ(GenDb::DbOpResult::OK, reader.drc);
+    Mock::VerifyAndClearExpectations(&cci);
+    // Freed with the select
+    EXPECT_CALL(cci, CassSessionFree(_));
+    reader.next.reset();
+}
+
+// A table of millions of rows is read holding one page at a time
+TEST_F(CqlIfTest, PagedSelectLargeTable) {
+    const size_t rows(1000000), page_size(5000);
+    FakeCassPagedLibrary cci(rows, 100000);
+    PagedSelectReader reader;
+    cass::cql::impl::CassPagedSelectPtr select(PagedSelectStart(&cci,
+        page_size, &reader));
+    size_t read_rows(0), max_page_rows(0);
+    do {
+        ASSERT_EQ(GenDb::DbOpResult::OK, reader.drc);
+        size_t page_rows(0);
+        BOOST_FOREACH(const GenDb::ColList &col_list, *reader.rows) {
+            page_rows += col_list.columns_.size();
+        }
+        max_page_rows = std::max(max_page_rows, page_rows);
+        read_rows += page_rows;
+    } while (reader.ReadNextPage());
+    EXPECT_EQ(rows, read_rows);
+    EXPECT_EQ(page_size, max_page_rows);
+    EXPECT_EQ(rows / page_size, reader.pages);
+}
+
+static GenDb::NewCf InsertPlanStaticCf() {
+    return GenDb::NewCf("InsertPlanStaticCf",
+        boost::assign::list_of(GenDb::DbDataType::AsciiType),
+        boost::assign::map_list_of
+            ("StringColumn", GenDb::DbDataType::AsciiType)
+            ("U64Column", GenDb::DbDataType::Unsigned64Type)
+            ("UUIDColumn", GenDb::DbDataType::LexicalUUIDType));
+}
+
+static GenDb::NewCf InsertPlanDynamicCf() {
+    return GenDb::NewCf("InsertPlanDynamicCf",
+        boost::assign::list_of(GenDb::DbDataType::Unsigned32Type)
+            (GenDb::DbDataType::AsciiType),
+        boost::assign::list_of(GenDb::DbDataType::Unsigned64Type),
+        std::vector<GenDb::DbDataType::type>(7, GenDb::DbDataType::AsciiType),
+        boost::assign::list_of(GenDb::DbDataType::AsciiType));
+}
+
+static GenDb::ColList *InsertPlanStaticCfRow(const std::string &key,
+    bool u64_column) {
+    GenDb::ColList *v_columns(new GenDb::ColList);
+    v_columns->cfname_ = "InsertPlanStaticCf";
+    v_columns->rowkey_.push_back(key);
+    v_columns->columns_.push_back(new GenDb::NewCol("StringColumn",
+        tstring_, 864000));
+    if (u64_column) {
+        v_columns->columns_.push_back(new GenDb::NewCol("U64Column", tu64_,
+            864000));
+    }
+    v_columns->columns_.push_back(new GenDb::NewCol("UUIDColumn", tuuid_,
+        864000));
+    return v_columns;
+}
+
+// The blank columns are those of the set bits of the mask
+static GenDb::ColList *InsertPlanDynamicCfRow(uint32_t key,
+    unsigned int blank_columns) {
+    GenDb::ColList *v_columns(new GenDb::ColList);
+    v_columns->cfname_ = "InsertPlanDynamicCf";
+    v_columns->rowkey_ = list_of(GenDb::DbDataValue(key))
+        (GenDb::DbDataValue(std::string("key2")));
+    GenDb::DbDataValueVec *cnames(new GenDb::DbDataValueVec(1, tu64_));
+    for (int i = 0; i < 7; i++) {
+        if (blank_columns & (1 << i)) {
+            cnames->push_back(GenDb::DbDataValue());
+        } else {
+            cnames->push_back(std::string("column") + integerToString(i + 2));
+        }
+    }
+    GenDb::DbDataValueVec *cvalues(new GenDb::DbDataValueVec(1, tstring_));
+    v_columns->columns_.push_back(new GenDb::NewCol(cnames, cvalues, 3600));
+    return v_columns;
+}
+
+TEST_F(CqlIfTest, InsertPlanStaticCf) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    cass::cql::impl::CassInsertPlan plan(InsertPlanStaticCf());
+    // Values bound by position, with the TTL last
+    EXPECT_CALL(mock_cci, CassStatementNew(StrEq(
+        "INSERT INTO InsertPlanStaticCf (key, \"StringColumn\", "
+        "\"U64Column\", \"UUIDColumn\") VALUES (?, ?, ?, ?) USING TTL ?"),
+        5))
+        .Times(2)
+        .WillRepeatedly(Return(
+            reinterpret_cast<CassStatement *>(&dummy_cass_object)));
+    EXPECT_CALL(mock_cci, CassStatementBindStringN(_, 0, StrEq("key1"), 4));
+    EXPECT_CALL(mock_cci, CassStatementBindStringN(_, 0, StrEq("key2"), 4));
+    EXPECT_CALL(mock_cci, CassStatementBindStringN(_, 1, StrEq(tstring_),
+        tstring_.length())).Times(3);
+    EXPECT_CALL(mock_cci, CassStatementBindInt64(_, 2, tu64_)).Times(2);
+    EXPECT_CALL(mock_cci, CassStatementBindUuid(_, 3, _)).Times(2);
+    EXPECT_CALL(mock_cci, CassStatementBindInt32(_, 4, 864000)).Times(2);
+    boost::scoped_ptr<GenDb::ColList> v_columns1(
+        InsertPlanStaticCfRow("key1", true));
+    EXPECT_TRUE(plan.NewStatement(&mock_cci, v_columns1.get()) != NULL);
+    boost::scoped_ptr<GenDb::ColList> v_columns2(
+        InsertPlanStaticCfRow("key2", true));
+    EXPECT_TRUE(plan.NewStatement(&mock_cci, v_columns2.get()) != NULL);
+    EXPECT_EQ(1U, plan.queries());
+    // Another set of columns
+    EXPECT_CALL(mock_cci, CassStatementNew(StrEq(
+        "INSERT INTO InsertPlanStaticCf (key, \"StringColumn\", "
+        "\"UUIDColumn\") VALUES (?, ?, ?) USING TTL ?"), 4))
+        .WillOnce(Return(
+            reinterpret_cast<CassStatement *>(&dummy_cass_object)));
+    EXPECT_CALL(mock_cci, CassStatementBindStringN(_, 0, StrEq("key3"), 4));
+    EXPECT_CALL(mock_cci, CassStatementBindUuid(_, 2, _));
+    EXPECT_CALL(mock_cci, CassStatementBindInt32(_, 3, 864000));
+    boost::scoped_ptr<GenDb::ColList> v_columns3(
+        InsertPlanStaticCfRow("key3", false));
+    EXPECT_TRUE(plan.NewStatement(&mock_cci, v_columns3.get()) != NULL);
+    EXPECT_EQ(2U, plan.queries());
+    // Columns not in the table definition are printed by the caller
+    boost::scoped_ptr<GenDb::ColList> v_columns4(
+        InsertPlanStaticCfRow("key4", false));
+    v_columns4->columns_.push_back(new GenDb::NewCol("NewColumn", tu64_,
+        864000));
+    EXPECT_TRUE(plan.NewStatement(&mock_cci, v_columns4.get()) == NULL);
+    boost::scoped_ptr<GenDb::ColList> v_columns5(
+        InsertPlanStaticCfRow("key5", false));
+    v_columns5->rowkey_.push_back(std::string("key6"));
+    EXPECT_TRUE(plan.NewStatement(&mock_cci, v_columns5.get()) == NULL);
+    EXPECT_EQ(2U, plan.queries());
+}
+
+TEST_F(CqlIfTest, InsertPlanDynamicCf) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    ON_CALL(mock_cci, CassStatementNew(_, _))
+        .WillByDefault(Return(
+            reinterpret_cast<CassStatement *>(&dummy_cass_object)));
+    cass::cql::impl::CassInsertPlan plan(InsertPlanDynamicCf());
+    // Blank column names are not inserted
+    EXPECT_CALL(mock_cci, CassStatementNew(StrEq(
+        "INSERT INTO InsertPlanDynamicCf (key, key2, column1, column2, "
+        "column4, column5, column6, column7, column8, value) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?) USING TTL ?"), 11));
+    EXPECT_CALL(mock_cci, CassStatementBindInt32(_, 0, 1));
+    EXPECT_CALL(mock_cci, CassStatementBindStringN(_, 1, StrEq("key2"), 4));
+    EXPECT_CALL(mock_cci, CassStatementBindInt64(_, 2, tu64_));
+    EXPECT_CALL(mock_cci, CassStatementBindStringN(_, 3, StrEq("column2"),
+        7));
+    for (int i = 4; i <= 8; i++) {
+        std::string cname("column" + integerToString(i));
+        EXPECT_CALL(mock_cci, CassStatementBindStringN(_, i, StrEq(cname),
+            cname.length()));
+    }
+    EXPECT_CALL(mock_cci, CassStatementBindStringN(_, 9, StrEq(tstring_),
+        tstring_.length()));
+    EXPECT_CALL(mock_cci, CassStatementBindInt32(_, 10, 3600));
+    boost::scoped_ptr<GenDb::ColList> v_columns(
+        InsertPlanDynamicCfRow(1, 1 << 1));
+    EXPECT_TRUE(plan.NewStatement(&mock_cci, v_columns.get()) != NULL);
+    Mock::VerifyAndClearExpectations(&mock_cci);
+    // The number of queries is bounded
+    const size_t max_queries(cass::cql::impl::CassInsertPlan::kMaxQueries);
+    for (unsigned int i = 0; i < 128; i++) {
+        boost::scoped_ptr<GenDb::ColList> v_columns(
+            InsertPlanDynamicCfRow(i, i));
+        CassStatement *statement(plan.NewStatement(&mock_cci,
+            v_columns.get()));
+        EXPECT_EQ(i < max_queries, statement != NULL);
+    }
+    EXPECT_EQ(max_queries, plan.queries());
+}
+
+// The statement is freed if a value is rejected by the driver, and the
+// insert is executed as text
+TEST_F(CqlIfTest, InsertPlanBindError) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    ON_CALL(mock_cci, CassStatementNew(_, _))
+        .WillByDefault(Return(
+            reinterpret_cast<CassStatement *>(&dummy_cass_object)));
+    cass::cql::impl::CassInsertPlan plan(InsertPlanStaticCf());
+    EXPECT_CALL(mock_cci, CassStatementBindUuid(_, _, _))
+        .WillOnce(Return(CASS_ERROR_LIB_INVALID_VALUE_TYPE));
+    EXPECT_CALL(mock_cci, CassStatementFree(_));
+    boost::scoped_ptr<GenDb::ColList> v_columns(
+        InsertPlanStaticCfRow("key1", true));
+    EXPECT_TRUE(plan.NewStatement(&mock_cci, v_columns.get()) == NULL);
+}
+
+// Values are bound as the column types of the table definition, values
+// that do not convert are printed by the caller, and the TTL is only set
+// if it is positive
+TEST_F(CqlIfTest, InsertPlanColumnTypes) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    ON_CALL(mock_cci, CassStatementNew(_, _))
+        .WillByDefault(Return(
+            reinterpret_cast<CassStatement *>(&dummy_cass_object)));
+    cass::cql::impl::CassInsertPlan plan(InsertPlanStaticCf());
+    // Widened to the bigint of the column
+    EXPECT_CALL(mock_cci, CassStatementBindInt32(_, _, _))
+        .Times(AnyNumber());
+    EXPECT_CALL(mock_cci, CassStatementBindInt64(_, 3, tu32_));
+    EXPECT_CALL(mock_cci, CassStatementBindInt32(_, 3, _))
+        .Times(0);
+    boost::scoped_ptr<GenDb::ColList> v_columns1(
+        InsertPlanStaticCfRow("key1", false));
+    v_columns1->columns_.push_back(new GenDb::NewCol("U64Column", tu32_,
+        864000));
+    EXPECT_TRUE(plan.NewStatement(&mock_cci, v_columns1.get()) != NULL);
+    Mock::VerifyAndClearExpectations(&mock_cci);
+    // Not bound, no statement is created
+    EXPECT_CALL(mock_cci, CassStatementNew(_, _))
+        .Times(0);
+    boost::scoped_ptr<GenDb::ColList> v_columns2(
+        InsertPlanStaticCfRow("key2", false));
+    v_columns2->columns_.push_back(new GenDb::NewCol("U64Column", tstring_,
+        864000));
+    EXPECT_TRUE(plan.NewStatement(&mock_cci, v_columns2.get()) == NULL);
+    boost::scoped_ptr<GenDb::ColList> v_columns3(
+        InsertPlanStaticCfRow("key3", false));
+    v_columns3->rowkey_[0] = tu64_;
+    EXPECT_TRUE(plan.NewStatement(&mock_cci, v_columns3.get()) == NULL);
+    Mock::VerifyAndClearExpectations(&mock_cci);
+    // No TTL
+    EXPECT_CALL(mock_cci, CassStatementNew(StrEq(
+        "INSERT INTO InsertPlanStaticCf (key, \"StringColumn\", "
+        "\"UUIDColumn\") VALUES (?, ?, ?)"), 3));
+    EXPECT_CALL(mock_cci, CassStatementBindInt32(_, _, _))
+        .Times(0);
+    boost::scoped_ptr<GenDb::ColList> v_columns4(
+        InsertPlanStaticCfRow("key4", false));
+    for (size_t i = 0; i < v_columns4->columns_.size(); i++) {
+        v_columns4->columns_[i].ttl = 0;
+    }
+    EXPECT_TRUE(plan.NewStatement(&mock_cci, v_columns4.get()) != NULL);
+    Mock::VerifyAndClearExpectations(&mock_cci);
+    // The dynamic table key is an int
+    cass::cql::impl::CassInsertPlan dynamic_plan(InsertPlanDynamicCf());
+    EXPECT_CALL(mock_cci, CassStatementBindInt32(_, _, _))
+        .Times(AnyNumber());
+    EXPECT_CALL(mock_cci, CassStatementBindInt32(_, 0, 5));
+    boost::scoped_ptr<GenDb::ColList> v_columns5(
+        InsertPlanDynamicCfRow(0, 0));
+    v_columns5->rowkey_[0] = static_cast<uint64_t>(5);
+    EXPECT_TRUE(dynamic_plan.NewStatement(&mock_cci, v_columns5.get()) !=
+        NULL);
+    boost::scoped_ptr<GenDb::ColList> v_columns6(
+        InsertPlanDynamicCfRow(0, 0));
+    v_columns6->rowkey_[0] = static_cast<uint64_t>(1) << 32;
+    EXPECT_TRUE(dynamic_plan.NewStatement(&mock_cci, v_columns6.get()) ==
+        NULL);
+}
+
+// Statements built without the mock actions
+class FakeCassStatementLibrary :
+    public NiceMock<cass::cql::test::MockCassLibrary> {
+ public:
+    virtual CassStatement *CassStatementNew(const char *query,
+        size_t parameter_count) {
+        return reinterpret_cast<CassStatement *>(&dummy_cass_object);
+    }
+    virtual void CassStatementFree(CassStatement *statement) {
+    }
+    virtual CassError CassStatementBindStringN(CassStatement *statement,
+        size_t index, const char *value, size_t value_length) {
+        return CASS_OK;
+    }
+    virtual CassError CassStatementBindInt32(CassStatement *statement,
+        size_t index, cass_int32_t value) {
+        return CASS_OK;
+    }
+    virtual CassError CassStatementBindInt64(CassStatement *statement,
+        size_t index, cass_int64_t value) {
+        return CASS_OK;
+    }
+    virtual CassError CassStatementBindUuid(CassStatement *statement,
+        size_t index, CassUuid value) {
+        return CASS_OK;
+    }
+};
+
+// Inserts per second on one core, printed into the query, and bound to
+// the statement of the plan
+TEST_F(CqlIfTest, DISABLED_InsertPlanPerf) {
+    FakeCassStatementLibrary cci;
+    cass::cql::impl::CassInsertPlan static_plan(InsertPlanStaticCf());
+    cass::cql::impl::CassInsertPlan dynamic_plan(InsertPlanDynamicCf());
+    boost::scoped_ptr<GenDb::ColList> v_static_columns(
+        InsertPlanStaticCfRow("key1", true));
+    boost::scoped_ptr<GenDb::ColList> v_dynamic_columns(
+        InsertPlanDynamicCfRow(1, 1 << 1));
+    const int kInserts(100000);
+    uint64_t start_usecs(ClockMonotonicUsec());
+    for (int i = 0; i < kInserts; i++) {
+        std::string query(cass::cql::impl::StaticCf2CassInsertIntoTable(
+            v_static_columns.get()));
+        cass::cql::impl::CassStatementPtr statement(
+            cci.CassStatementNew(query.c_str(), 0), &cci);
+        query = cass::cql::impl::DynamicCf2CassInsertIntoTable(
+            v_dynamic_columns.get());
+        statement = cass::cql::impl::CassStatementPtr(
+            cci.CassStatementNew(query.c_str(), 0), &cci);
+    }
+    uint64_t query_usecs(ClockMonotonicUsec() - start_usecs);
+    start_usecs = ClockMonotonicUsec();
+    for (int i = 0; i < kInserts; i++) {
+        cass::cql::impl::CassStatementPtr statement(
+            static_plan.NewStatement(&cci, v_static_columns.get()), &cci);
+        statement = cass::cql::impl::CassStatementPtr(
+            dynamic_plan.NewStatement(&cci, v_dynamic_columns.get()), &cci);
+    }
+    uint64_t plan_usecs(ClockMonotonicUsec() - start_usecs);
+    std::cout << "Query: " << 2 * kInserts * 1000000ULL / (query_usecs + 1) <<
+        " inserts/sec, Plan: " << 2 * kInserts * 1000000ULL /
+        (plan_usecs + 1) << " inserts/sec" << std::endl;
+}
+
+static void CompletionQueuesRecord(std::vector<int> *order, int i) {
+    order->push_back(i);
+}
+
+TEST_F(CqlIfTest, CompletionQueues) {
+    TaskScheduler *scheduler(TaskScheduler::GetInstance());
+    int task_id(scheduler->GetTaskId("cass::cql::test::Completion"));
+    cass::cql::impl::CassCompletionQueues queues;
+    std::vector<int> order0, order1;
+    // Completions queued while the scheduler is stopped run in one task
+    // per instance, in order
+    task_util::TaskSchedulerStop();
+    for (int i = 0; i < 200; i++) {
+        queues.Enqueue(task_id, 0,
+            boost::bind(&CompletionQueuesRecord, &order0, i));
+        queues.Enqueue(task_id, 1,
+            boost::bind(&CompletionQueuesRecord, &order1, i));
+    }
+    EXPECT_EQ(2U, queues.queue_count());
+    task_util::TaskSchedulerStart();
+    task_util::WaitForIdle();
+    ASSERT_EQ(200U, order0.size());
+    ASSERT_EQ(200U, order1.size());
+    for (int i = 0; i < 200; i++) {
+        EXPECT_EQ(i, order0[i]);
+        EXPECT_EQ(i, order1[i]);
+    }
+    EXPECT_EQ(400U, queues.completions());
+    EXPECT_EQ(2U, queues.task_runs());
+    // The queue is reused
+    queues.Enqueue(task_id, 0, boost::bind(&CompletionQueuesRecord, &order0,
+        200));
+    task_util::WaitForIdle();
+    EXPECT_EQ(201U, order0.size());
+    EXPECT_EQ(2U, queues.queue_count());
+    EXPECT_EQ(401U, queues.completions());
+    EXPECT_EQ(3U, queues.task_runs());
+}
+
+// One task per completion, as the completions were run before
+class CompletionTask : public Task {
+ public:
+    CompletionTask(int task_id, int task_instance,
+        tbb::atomic<uint64_t> *count) :
+        Task(task_id, task_instance),
+        count_(count) {
+    }
+    bool Run() {
+        (*count_)++;
+        return true;
+    }
+    std::string Description() const {
+        return "cass::cql::test::CompletionTask";
+    }
+ private:
+    tbb::atomic<uint64_t> *count_;
+};
+
+static void CompletionQueuesCount(tbb::atomic<uint64_t> *count) {
+    (*count)++;
+}
+
+// Completions for any instance are not serialized through a queue
+TEST_F(CqlIfTest, CompletionQueuesAnyInstance) {
+    TaskScheduler *scheduler(TaskScheduler::GetInstance());
+    int task_id(scheduler->GetTaskId("cass::cql::test::Completion"));
+    cass::cql::impl::CassCompletionQueues queues;
+    tbb::atomic<uint64_t> count;
+    count = 0;
+    for (int i = 0; i < 10; i++) {
+        queues.Enqueue(task_id, Task::kTaskInstanceAny,
+            boost::bind(&CompletionQueuesCount, &count));
+    }
+    task_util::WaitForIdle();
+    EXPECT_EQ(10U, count);
+    EXPECT_EQ(0U, queues.queue_count());
+    EXPECT_EQ(0U, queues.completions());
+}
+
+// Completions per second delivered to 8 task instances from the threads
+// of the test, with a task per completion and with the completion queues
+TEST_F(CqlIfTest, DISABLED_CompletionQueuesPerf) {
+    TaskScheduler *scheduler(TaskScheduler::GetInstance());
+    int task_id(scheduler->GetTaskId("cass::cql::test::Completion"));
+    const int kCompletions(1000000);
+    const int kInstances(8);
+    tbb::atomic<uint64_t> count;
+    count = 0;
+    uint64_t start_usecs(ClockMonotonicUsec());
+    for (int i = 0; i < kCompletions; i++) {
+        scheduler->Enqueue(new CompletionTask(task_id, i % kInstances,
+            &count));
+    }
+    task_util::WaitForIdle(120);
+    uint64_t task_usecs(ClockMonotonicUsec() - start_usecs);
+    EXPECT_EQ(static_cast<uint64_t>(kCompletions), count);
+    count = 0;
+    cass::cql::impl::CassCompletionQueues queues;
+    start_usecs = ClockMonotonicUsec();
+    for (int i = 0; i < kCompletions; i++) {
+        queues.Enqueue(task_id, i % kInstances,
+            boost::bind(&CompletionQueuesCount, &count));
+    }
+    task_util::WaitForIdle(120);
+    uint64_t queue_usecs(ClockMonotonicUsec() - start_usecs);
+    EXPECT_EQ(static_cast<uint64_t>(kCompletions), count);
+    std::cout << "Task: " << kCompletions * 1000000ULL / (task_usecs + 1) <<
+        " completions/sec, Queue: " << kCompletions * 1000000ULL /
+        (queue_usecs + 1) << " completions/sec, " <<
+        queues.completions() / (queues.task_runs() + 1) <<
+        " completions/task run" << std::endl;
+}
+
+class HedgedReadResult {
+ public:
+    HedgedReadResult() :
+        done_(0),
+        drc_(GenDb::DbOpResult::OK) {
+    }
+    void Completion(GenDb::DbOpResult::type drc,
+        std::auto_ptr<GenDb::ColList> row) {
+        done_++;
+        drc_ = drc;
+    }
+    int done_;
+    GenDb::DbOpResult::type drc_;
+};
+
+static cass::cql::impl::CassHedgedReads::Policy HedgedReadsPolicy(
+    int budget_percent) {
+    cass::cql::impl::CassHedgedReads::Policy policy;
+    policy.percentile = 0.9;
+    policy.min_delay_msecs = 100;
+    policy.max_delay_msecs = 10000;
+    policy.budget_percent = budget_percent;
+    return policy;
+}
+
+static void HedgedReadsRead(cass::cql::impl::CassHedgedReads *hedged_reads,
+    MockAsyncSelects *selects, HedgedReadResult *result) {
+    hedged_reads->Read("HedgedTable", boost::bind(
+        &MockAsyncSelects::AsyncSelect, selects,
+        GenDb::DbDataValueVec(1, "key"), _1),
+        boost::bind(&HedgedReadResult::Completion, result, _1, _2));
+}
+
+// Past the maximum hedge delay
+static uint64_t HedgedReadsExpiry() {
+    return ClockMonotonicUsec() + 20 * 1000000ULL;
+}
+
+TEST_F(CqlIfTest, HedgedReadsDelay) {
+    cass::cql::impl::CassHedgedReads hedged_reads;
+    hedged_reads.SetPolicy("HedgedTable", HedgedReadsPolicy(100));
+    EXPECT_TRUE(hedged_reads.IsHedged("HedgedTable"));
+    EXPECT_FALSE(hedged_reads.IsHedged("Table"));
+    // Maximum delay until latencies are recorded
+    EXPECT_EQ(10000000U, hedged_reads.HedgeDelayUsecs("HedgedTable"));
+    MockAsyncSelects selects;
+    HedgedReadResult result;
+    for (int i = 0; i < 10; i++) {
+        HedgedReadsRead(&hedged_reads, &selects, &result);
+        selects.Complete(0, GenDb::DbOpResult::OK);
+    }
+    EXPECT_EQ(10, result.done_);
+    EXPECT_EQ(0U, hedged_reads.waiting());
+    // The latencies are below the minimum delay
+    EXPECT_EQ(100000U, hedged_reads.HedgeDelayUsecs("HedgedTable"));
+    EXPECT_EQ(1U, hedged_reads.policies());
+    hedged_reads.ClearPolicy("HedgedTable");
+    EXPECT_FALSE(hedged_reads.IsHedged("HedgedTable"));
+    EXPECT_EQ(0U, hedged_reads.policies());
+}
+
+TEST_F(CqlIfTest, HedgedReads) {
+    cass::cql::impl::CassHedgedReads hedged_reads;
+    hedged_reads.SetPolicy("HedgedTable", HedgedReadsPolicy(100));
+    MockAsyncSelects selects;
+    HedgedReadResult result;
+    HedgedReadsRead(&hedged_reads, &selects, &result);
+    EXPECT_EQ(1U, selects.outstanding());
+    EXPECT_EQ(1U, hedged_reads.waiting());
+    // Not hedged before the hedge delay
+    hedged_reads.HedgeExpired(ClockMonotonicUsec());
+    EXPECT_EQ(1U, selects.outstanding());
+    hedged_reads.HedgeExpired(HedgedReadsExpiry());
+    EXPECT_EQ(2U, selects.outstanding());
+    EXPECT_EQ(0U, hedged_reads.waiting());
+    // The hedge completes first
+    selects.Complete(1, GenDb::DbOpResult::OK);
+    EXPECT_EQ(1, result.done_);
+    EXPECT_EQ(GenDb::DbOpResult::OK, result.drc_);
+    selects.Complete(0, GenDb::DbOpResult::OK);
+    EXPECT_EQ(1, result.done_);
+    EXPECT_EQ(1U, hedged_reads.reads());
+    EXPECT_EQ(1U, hedged_reads.hedges());
+    EXPECT_EQ(1U, hedged_reads.hedges_won());
+    // Completed before the hedge delay
+    HedgedReadsRead(&hedged_reads, &selects, &result);
+    selects.Complete(0, GenDb::DbOpResult::OK);
+    EXPECT_EQ(2, result.done_);
+    EXPECT_EQ(0U, hedged_reads.waiting());
+    hedged_reads.HedgeExpired(HedgedReadsExpiry());
+    EXPECT_EQ(0U, selects.outstanding());
+    EXPECT_EQ(2U, hedged_reads.reads());
+    EXPECT_EQ(1U, hedged_reads.hedges());
+}
+
+TEST_F(CqlIfTest, HedgedReadsError) {
+    cass::cql::impl::CassHedgedReads hedged_reads;
+    hedged_reads.SetPolicy("HedgedTable", HedgedReadsPolicy(100));
+    MockAsyncSelects selects;
+    HedgedReadResult result;
+    // The first execution fails, the read completes with the hedge
+    HedgedReadsRead(&hedged_reads, &selects, &result);
+    hedged_reads.HedgeExpired(HedgedReadsExpiry());
+    ASSERT_EQ(2U, selects.outstanding());
+    selects.Complete(0, GenDb::DbOpResult::ERROR);
+    EXPECT_EQ(0, result.done_);
+    selects.Complete(0, GenDb::DbOpResult::OK);
+    EXPECT_EQ(1, result.done_);
+    EXPECT_EQ(GenDb::DbOpResult::OK, result.drc_);
+    EXPECT_EQ(1U, hedged_reads.hedges_won());
+    // Both executions fail
+    HedgedReadsRead(&hedged_reads, &selects, &result);
+    hedged_reads.HedgeExpired(HedgedReadsExpiry());
+    ASSERT_EQ(2U, selects.outstanding());
+    selects.Complete(1, GenDb::DbOpResult::ERROR);
+    EXPECT_EQ(1, result.done_);
+    selects.Complete(0, GenDb::DbOpResult::ERROR);
+    EXPECT_EQ(2, result.done_);
+    EXPECT_EQ(GenDb::DbOpResult::ERROR, result.drc_);
+    // Failed before the hedge delay, not hedged
+    HedgedReadsRead(&hedged_reads, &selects, &result);
+    selects.Complete(0, GenDb::DbOpResult::ERROR);
+    EXPECT_EQ(3, result.done_);
+    EXPECT_EQ(GenDb::DbOpResult::ERROR, result.drc_);
+    hedged_reads.HedgeExpired(HedgedReadsExpiry());
+    EXPECT_EQ(0U, selects.outstanding());
+    EXPECT_EQ(2U, hedged_reads.hedges());
+    EXPECT_EQ(1U, hedged_reads.hedges_won());
+}
+
+TEST_F(CqlIfTest, HedgedReadsBudget) {
+    cass::cql::impl::CassHedgedReads hedged_reads;
+    hedged_reads.SetPolicy("HedgedTable", HedgedReadsPolicy(10));
+    MockAsyncSelects selects;
+    HedgedReadResult result;
+    for (int i = 0; i < 20; i++) {
+        HedgedReadsRead(&hedged_reads, &selects, &result);
+    }
+    hedged_reads.HedgeExpired(HedgedReadsExpiry());
+    EXPECT_EQ(22U, selects.outstanding());
+    EXPECT_EQ(20U, hedged_reads.reads());
+    EXPECT_EQ(2U, hedged_reads.hedges());
+    EXPECT_EQ(18U, hedged_reads.hedges_over_budget());
+    while (selects.outstanding()) {
+        selects.Complete(0, GenDb::DbOpResult::OK);
+    }
+    EXPECT_EQ(20, result.done_);
+    // At most kMaxBurst hedges are saved up
+    for (int i = 0; i < 200; i++) {
+        HedgedReadsRead(&hedged_reads, &selects, &result);
+        selects.Complete(0, GenDb::DbOpResult::OK);
+    }
+    for (int i = 0; i < 20; i++) {
+        HedgedReadsRead(&hedged_reads, &selects, &result);
+    }
+    hedged_reads.HedgeExpired(HedgedReadsExpiry());
+    EXPECT_EQ(2U + cass::cql::impl::CassHedgedReads::kMaxBurst,
+        hedged_reads.hedges());
+    while (selects.outstanding()) {
+        selects.Complete(0, GenDb::DbOpResult::OK);
+    }
+    EXPECT_EQ(240, result.done_);
+}
+
+TEST_F(CqlIfTest, HedgedReadsClear) {
+    cass::cql::impl::CassHedgedReads hedged_reads;
+    hedged_reads.SetPolicy("HedgedTable", HedgedReadsPolicy(100));
+    MockAsyncSelects selects;
+    HedgedReadResult result;
+    HedgedReadsRead(&hedged_reads, &selects, &result);
+    hedged_reads.Clear();
+    EXPECT_EQ(0U, hedged_reads.waiting());
+    hedged_reads.HedgeExpired(HedgedReadsExpiry());
+    EXPECT_EQ(1U, selects.outstanding());
+    selects.Complete(0, GenDb::DbOpResult::OK);
+    EXPECT_EQ(1, result.done_);
+    EXPECT_EQ(0U, hedged_reads.hedges());
+}
+
+// The statement is executed again by the hedge, the first response
+// completes the read
+TEST_F(CqlIfTest, HedgedReadsExecute) {
+    NiceMock<cass::cql::test::MockCassLibrary> mock_cci;
+    MockCassFutures futures;
+    ON_CALL(mock_cci, CassFutureSetCallback(_, _, _))
+        .WillByDefault(Invoke(&futures, &MockCassFutures::SetCallback));
+    cass::cql::impl::CassStatementPtr statement(
+        reinterpret_cast<CassStatement *>(&dummy_cass_object), &mock_cci);
+    EXPECT_CALL(mock_cci, CassSessionExecute(_, statement.get()))
+        .Times(2);
+    cass::cql::impl::CassHedgedReads hedged_reads;
+    hedged_reads.SetPolicy("HedgedTable", HedgedReadsPolicy(100));
+    HedgedReadResult result;
+    GenDb::DbDataValueVec rkey(1, "key");
+    hedged_reads.Read("HedgedTable", boost::bind(
+        &cass::cql::impl::ExecuteSelectAsync, &mock_cci,
+        cass::cql::impl::CassSessionPtr(NULL, &mock_cci),
+        std::string("SELECT * FROM HedgedTable WHERE key='key'"), statement,
+        CASS_CONSISTENCY_ONE, cass::cql::impl::CassQueryResultContext(
+            "HedgedTable", false, rkey), _1),
+        boost::bind(&HedgedReadResult::Completion, &result, _1, _2));
+    hedged_reads.HedgeExpired(HedgedReadsExpiry());
+    futures.Complete();
+    EXPECT_EQ(1, result.done_);
+    EXPECT_EQ(GenDb::DbOpResult::OK, result.drc_);
+    EXPECT_EQ(1U, hedged_reads.hedges());
+    EXPECT_EQ(0U, hedged_reads.hedges_won());
+}
+
 int main(int argc, char **argv) {
     LoggingInit();
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2026 Juniper Networks, Inc. All rights reserved.
+//
+
+#ifndef DATABASE_CASSANDRA_CQL_TEST_FAKE_CQL_LIB_IF_H_
+#define DATABASE_CASSANDRA_CQL_TEST_FAKE_CQL_LIB_IF_H_
+
+#include <string>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+
+#include <database/gendb_if.h>
+#include <database/cassandra/cql/test/mock_cql_lib_if.h>
+
+namespace cass {
+namespace cql {
+namespace test {
+
+// Select result served by the library, the values returned by the
+// library point into the rows of the result. The library calls do not go
+// through the mock actions so that only the allocations of the decoding
+// are counted.
+class FakeCassResultLibrary : public ::testing::NiceMock<MockCassLibrary> {
+ public:
+    FakeCassResultLibrary(const std::vector<std::string> &names) :
+        names_(names),
+        row_(0) {
+    }
+    void AddRow(const GenDb::DbDataValueVec &row) {
+        assert(row.size() == names_.size());
+        rows_.push_back(row);
+    }
+    // Dynamic table with 2 partitions of the given number of rows
+    void AddDynamicCfRows(int rows) {
+        for (int i = 0; i < rows; i++) {
+            GenDb::DbDataValueVec row;
+            row.push_back(std::string(i < rows / 2 ? "key1" : "key2"));
+            row.push_back((uint32_t)i);
+            std::string blob(boost::lexical_cast<std::string>(i));
+            row.push_back(GenDb::Blob(
+                reinterpret_cast<const uint8_t *>(blob.c_str()),
+                blob.length()));
+            row.push_back((uint64_t)i);
+            row.push_back(std::string("value" + blob));
+            AddRow(row);
+        }
+    }
+    const GenDb::DbDataValue &value(size_t row, size_t column) const {
+        return rows_[row][column];
+    }
+    virtual size_t CassResultRowCount(const CassResult *result) {
+        return rows_.size();
+    }
+    virtual size_t CassResultColumnCount(const CassResult *result) {
+        return names_.size();
+    }
+    virtual CassError CassResultColumnName(const CassResult *result,
+        size_t index, const char **name, size_t *name_length) {
+        *name = names_[index].c_str();
+        *name_length = names_[index].length();
+        return CASS_OK;
+    }
+    virtual CassIterator *CassIteratorFromResult(const CassResult *result) {
+        row_ = 0;
+        return reinterpret_cast<CassIterator *>(&row_);
+    }
+    virtual cass_bool_t CassIteratorNext(CassIterator *iterator) {
+        return row_++ < rows_.size() ? cass_true : cass_false;
+    }
+    virtual const CassRow *CassIteratorGetRow(const CassIterator *iterator) {
+        return reinterpret_cast<const CassRow *>(&rows_[row_ - 1]);
+    }
+    virtual const CassValue *CassRowGetColumn(const CassRow *row,
+        size_t index) {
+        const GenDb::DbDataValueVec *values(
+            reinterpret_cast<const GenDb::DbDataValueVec *>(row));
+        return reinterpret_cast<const CassValue *>(&(*values)[index]);
+    }
+    virtual cass_bool_t CassValueIsNull(const CassValue *value) {
+        return Value(value)->which() == GenDb::DB_VALUE_BLANK ? cass_true :
+            cass_false;
+    }
+    virtual CassValueType GetCassValueType(const CassValue *value) {
+        switch (Value(value)->which()) {
+          case GenDb::DB_VALUE_STRING:
+            return CASS_VALUE_TYPE_TEXT;
+          case GenDb::DB_VALUE_UINT64:
+            return CASS_VALUE_TYPE_BIGINT;
+          case GenDb::DB_VALUE_UINT32:
+            return CASS_VALUE_TYPE_INT;
+          case GenDb::DB_VALUE_BLOB:
+            return CASS_VALUE_TYPE_BLOB;
+          default:
+            return CASS_VALUE_TYPE_UNKNOWN;
+        }
+    }
+    virtual CassError CassValueGetString(const CassValue *value,
+        const char **output, size_t *output_size) {
+        const std::string &tstring(boost::get<std::string>(*Value(value)));
+        *output = tstring.c_str();
+        *output_size = tstring.length();
+        return CASS_OK;
+    }
+    virtual CassError CassValueGetInt32(const CassValue *value,
+        cass_int32_t *output) {
+        *output = boost::get<uint32_t>(*Value(value));
+        return CASS_OK;
+    }
+    virtual CassError CassValueGetInt64(const CassValue *value,
+        cass_int64_t *output) {
+        *output = boost::get<uint64_t>(*Value(value));
+        return CASS_OK;
+    }
+    virtual CassError CassValueGetBytes(const CassValue *value,
+        const cass_byte_t **output, size_t *output_size) {
+        const GenDb::Blob &tblob(boost::get<GenDb::Blob>(*Value(value)));
+        *output = tblob.data();
+        *output_size = tblob.size();
+        return CASS_OK;
+    }
+
+ private:
+    static const GenDb::DbDataValue *Value(const CassValue *value) {
+        return reinterpret_cast<const GenDb::DbDataValue *>(value);
+    }
+    std::vector<std::string> names_;
+    std::vector<GenDb::DbDataValueVec> rows_;
+    size_t row_;
+};
+
+}  // namespace test
+}  // namespace cql
+}  // namespace cass
+
+#endif  // DATABASE_CASSANDRA_CQL_TEST_FAKE_CQL_LIB_IF_H_
@@ -61,6 +61,8 @@ class MockCassLibrary : public interface::CassLibrary {
         const CassSession* session));
     MOCK_METHOD2(CassSessionPrepare, CassFuture* (CassSession* session,
         const char* query));
+    MOCK_METHOD2(CassSessionExecuteBatch, CassFuture* (CassSession* session,
+        const CassBatch* batch));
     MOCK_METHOD2(CassSessionGetMetrics, void (const CassSession* session,
         CassMetrics* output));
 
@@ -89,6 +91,9 @@ class MockCassLibrary : public interface::CassLibrary {
 
     // CassResult
     MOCK_METHOD1(CassResultFree, void (const CassResult* result));
+    MOCK_METHOD1(CassResultRowCount, size_t (const CassResult* result));
+    MOCK_METHOD1(CassResultHasMorePages, cass_bool_t (
+        const CassResult* result));
     MOCK_METHOD1(CassResultColumnCount, size_t (const CassResult* result));
     MOCK_METHOD4(CassResultColumnName, CassError (const CassResult *result,
         size_t index, const char** name, size_t* name_length));
@@ -107,6 +112,10 @@ class MockCassLibrary : public interface::CassLibrary {
     MOCK_METHOD1(CassStatementFree, void (CassStatement* statement));
     MOCK_METHOD2(CassStatementSetConsistency, CassError (
         CassStatement* statement, CassConsistency consistency));
+    MOCK_METHOD2(CassStatementSetPagingSize, CassError (
+        CassStatement* statement, int page_size));
+    MOCK_METHOD2(CassStatementSetPagingState, CassError (
+        CassStatement* statement, const CassResult* result));
     MOCK_METHOD4(CassStatementBindStringN, CassError (CassStatement* statement,
         size_t index, const char* value, size_t value_length));
     MOCK_METHOD3(CassStatementBindInt32, CassError (CassStatement* statement,
@@ -143,6 +152,14 @@ class MockCassLibrary : public interface::CassLibrary {
     MOCK_METHOD1(CassPreparedBind, CassStatement* (
         const CassPrepared* prepared));
 
+    // CassBatch
+    MOCK_METHOD1(CassBatchNew, CassBatch* (CassBatchType type));
+    MOCK_METHOD1(CassBatchFree, void (CassBatch* batch));
+    MOCK_METHOD2(CassBatchSetConsistency, CassError (CassBatch* batch,
+        CassConsistency consistency));
+    MOCK_METHOD2(CassBatchAddStatement, CassError (CassBatch* batch,
+        CassStatement* statement));
+
     // CassValue
     MOCK_METHOD1(GetCassValueType, CassValueType (const CassValue* value));
     MOCK_METHOD3(CassValueGetString, CassError (const CassValue* value,
@@ -166,3 +166,29 @@ std::string GenDb::DbDataValueToString(const GenDb::DbDataValue &db_value) {
     DbDataValuePrinter vprinter;
     return boost::apply_visitor(vprinter, db_value);
 }
+
+bool GenDbIf::Db_GetMultiRowAsync(const std::string& cfname,
+    const std::vector<DbDataValueVec>& key, const ColumnNameRange &crange,
+    DbConsistency::type dconsistency, DbGetMultiRowCb cb) {
+    return false;
+}
+
+bool GenDbIf::Db_GetMultiRowAsync(const std::string& cfname,
+    const std::vector<DbDataValueVec>& key, const ColumnNameRange &crange,
+    DbConsistency::type dconsistency, int task_id, int task_instance,
+    DbGetMultiRowCb cb) {
+    return false;
+}
+
+bool GenDbIf::Db_GetAllRowsPagedAsync(const std::string& cfname,
+    size_t page_size, DbConsistency::type dconsistency, int task_id,
+    int task_instance, DbGetRowsPageCb cb) {
+    return false;
+}
+
+bool GenDbIf::Db_GetRowPagedAsync(const std::string& cfname,
+    const DbDataValueVec& rowkey, const ColumnNameRange &crange,
+    size_t page_size, DbConsistency::type dconsistency, int task_id,
+    int task_instance, DbGetRowsPageCb cb) {
+    return false;
+}
@@ -254,6 +254,13 @@ public:
     typedef boost::function<void(DbOpResult::type)> DbAddColumnCb;
     typedef boost::function<void(DbOpResult::type,
                                  std::auto_ptr<ColList>)> DbGetRowCb;
+    typedef boost::function<void(DbOpResult::type,
+                                 std::auto_ptr<ColListVec>)> DbGetMultiRowCb;
+    // Called with the rows of a page, and whether more pages follow,
+    // returns false to stop reading
+    typedef boost::function<bool(DbOpResult::type,
+                                 std::auto_ptr<ColListVec>,
+                                 bool)> DbGetRowsPageCb;
 
     GenDbIf() {}
     virtual ~GenDbIf() {}
@@ -315,8 +322,26 @@ public:
         const GenDb::WhereIndexInfoVec &where_vec,
         GenDb::DbConsistency::type dconsistency,
         GenDb::GenDbIf::DbGetRowCb cb) = 0;
+    // Asynchronous multi-row reads. Not supported unless overridden.
+    virtual bool Db_GetMultiRowAsync(const std::string& cfname,
+        const std::vector<DbDataValueVec>& key, const ColumnNameRange &crange,
+        DbConsistency::type dconsistency, DbGetMultiRowCb cb);
+    virtual bool Db_GetMultiRowAsync(const std::string& cfname,
+        const std::vector<DbDataValueVec>& key, const ColumnNameRange &crange,
+        DbConsistency::type dconsistency, int task_id, int task_instance,
+        DbGetMultiRowCb cb);
     virtual bool Db_GetAllRows(ColListVec *ret,
         const std::string& cfname, DbConsistency::type dconsistency) = 0;
+    // Paged reads, the rows are read page_size columns at a time and
+    // reported to the callback in the context of the task, the next page
+    // is read once the callback returns. Not supported unless overridden.
+    virtual bool Db_GetAllRowsPagedAsync(const std::string& cfname,
+        size_t page_size, DbConsistency::type dconsistency, int task_id,
+        int task_instance, DbGetRowsPageCb cb);
+    virtual bool Db_GetRowPagedAsync(const std::string& cfname,
+        const DbDataValueVec& rowkey, const ColumnNameRange &crange,
+        size_t page_size, DbConsistency::type dconsistency, int task_id,
+        int task_instance, DbGetRowsPageCb cb);
     // Queue
     virtual bool Db_GetQueueStats(uint64_t *queue_count,
         uint64_t *enqueues) const = 0;
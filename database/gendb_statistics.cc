@@ -2,6 +2,10 @@
 // Copyright (c) 2014 Juniper Networks, Inc. All rights reserved.
 //
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
 #include "gendb_statistics.h"
 
 namespace GenDb {
@@ -81,6 +85,257 @@ void DbTableStatistics::GetCumulative(std::vector<GenDb::DbTableInfo> *vdbti)
     GetInternal(vdbti, true);
 }
 
+// DbTableLatencyStatistics::Histogram
+static void UpdateMaxLatency(tbb::atomic<uint64_t> *max_usecs,
+    uint64_t usecs) {
+    uint64_t current(*max_usecs);
+    while (usecs > current) {
+        uint64_t previous(max_usecs->compare_and_swap(usecs, current));
+        if (previous == current) {
+            break;
+        }
+        current = previous;
+    }
+}
+
+DbTableLatencyStatistics::Histogram::Histogram() :
+    last_count_(0),
+    last_total_usecs_(0) {
+    for (size_t i = 0; i < kBuckets; i++) {
+        buckets_[i] = 0;
+        last_buckets_[i] = 0;
+        recent_buckets_[i] = 0;
+    }
+    recent_count_ = 0;
+    count_ = 0;
+    total_usecs_ = 0;
+    max_usecs_ = 0;
+    diff_max_usecs_ = 0;
+}
+
+void DbTableLatencyStatistics::Histogram::Update(uint64_t usecs) {
+    size_t bucket(Bucket(usecs));
+    buckets_[bucket]++;
+    recent_buckets_[bucket]++;
+    total_usecs_ += usecs;
+    UpdateMaxLatency(&max_usecs_, usecs);
+    UpdateMaxLatency(&diff_max_usecs_, usecs);
+    count_++;
+    // Only the update that reaches the limit decays
+    if (++recent_count_ == kRecentLatencies) {
+        Decay();
+    }
+}
+
+// Halves the recent buckets, latencies updated concurrently are kept
+void DbTableLatencyStatistics::Histogram::Decay() {
+    uint64_t removed(0);
+    for (size_t i = 0; i < kBuckets; i++) {
+        uint64_t count;
+        do {
+            count = recent_buckets_[i];
+        } while (recent_buckets_[i].compare_and_swap(count / 2, count) !=
+                 count);
+        removed += count - count / 2;
+    }
+    recent_count_ -= removed;
+}
+
+// DbTableLatencyStatistics
+DbTableLatencyStatistics::DbTableLatencyStatistics() {
+}
+
+DbTableLatencyStatistics::~DbTableLatencyStatistics() {
+    for (TableLatencyMap::iterator it = table_latency_map_.begin();
+         it != table_latency_map_.end(); it++) {
+        delete it->second;
+    }
+}
+
+const char *DbTableLatencyStatistics::OpName(Op op) {
+    switch (op) {
+      case OP_INSERT:
+        return "insert";
+      case OP_PREPARED_INSERT:
+        return "prepared_insert";
+      case OP_BATCH_INSERT:
+        return "batch_insert";
+      case OP_SELECT:
+        return "select";
+      default:
+        return "unknown";
+    }
+}
+
+size_t DbTableLatencyStatistics::Bucket(uint64_t usecs) {
+    size_t bucket(0);
+    while (usecs != 0 && bucket < kBuckets - 1) {
+        usecs >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+DbTableLatencyStatistics::TableLatency *DbTableLatencyStatistics::LocateTable(
+    const std::string &table_name) {
+    {
+        tbb::spin_rw_mutex::scoped_lock lock(rw_mutex_, false);
+        TableLatencyMap::const_iterator it(
+            table_latency_map_.find(table_name));
+        if (it != table_latency_map_.end()) {
+            return it->second;
+        }
+    }
+    tbb::spin_rw_mutex::scoped_lock lock(rw_mutex_, true);
+    std::pair<TableLatencyMap::iterator, bool> ret(table_latency_map_.insert(
+        std::make_pair(table_name, static_cast<TableLatency *>(NULL))));
+    if (ret.second) {
+        ret.first->second = new TableLatency;
+    }
+    return ret.first->second;
+}
+
+void DbTableLatencyStatistics::Update(const std::string &table_name, Op op,
+    uint64_t usecs) {
+    assert(op < OP_COUNT);
+    // Tables are not removed, the histograms are updated without the lock
+    LocateTable(table_name)->ops_[op].Update(usecs);
+}
+
+// Upper bound of the bucket the percentile falls in, at most the maximum
+static uint64_t LatencyPercentile(const std::vector<uint64_t> &buckets,
+    uint64_t count, uint64_t max_usecs, double percentile) {
+    uint64_t rank(static_cast<uint64_t>(std::ceil(count * percentile)));
+    uint64_t latencies(0);
+    for (size_t i = 0; i < buckets.size(); i++) {
+        latencies += buckets[i];
+        if (latencies >= rank) {
+            return std::min(static_cast<uint64_t>(1) << i, max_usecs);
+        }
+    }
+    return max_usecs;
+}
+
+static void GetOpLatency(DbTableLatencyStatistics::Op op,
+    const uint64_t *buckets, uint64_t count, uint64_t total_usecs,
+    uint64_t max_usecs, DbTableOpLatency *latency) {
+    std::vector<uint64_t> vbuckets(buckets,
+        buckets + DbTableLatencyStatistics::kBuckets);
+    // Trailing empty buckets are not reported
+    while (!vbuckets.empty() && vbuckets.back() == 0) {
+        vbuckets.pop_back();
+    }
+    latency->set_op(DbTableLatencyStatistics::OpName(op));
+    latency->set_count(count);
+    latency->set_total_usecs(total_usecs);
+    latency->set_max_usecs(max_usecs);
+    latency->set_p50_usecs(LatencyPercentile(vbuckets, count, max_usecs,
+        0.5));
+    latency->set_p99_usecs(LatencyPercentile(vbuckets, count, max_usecs,
+        0.99));
+    latency->set_p999_usecs(LatencyPercentile(vbuckets, count, max_usecs,
+        0.999));
+    latency->set_buckets(vbuckets);
+}
+
+static DbTableInfo *LocateTableInfo(std::vector<DbTableInfo> *vdbti,
+    const std::string &table_name) {
+    for (std::vector<DbTableInfo>::iterator it = vdbti->begin();
+         it != vdbti->end(); it++) {
+        if (it->get_table_name() == table_name) {
+            return &(*it);
+        }
+    }
+    DbTableInfo dbti;
+    dbti.set_table_name(table_name);
+    vdbti->push_back(dbti);
+    return &vdbti->back();
+}
+
+void DbTableLatencyStatistics::GetDiffs(std::vector<DbTableInfo> *vdbti) {
+    tbb::spin_rw_mutex::scoped_lock lock(rw_mutex_, false);
+    for (TableLatencyMap::const_iterator it = table_latency_map_.begin();
+         it != table_latency_map_.end(); it++) {
+        std::vector<DbTableOpLatency> latencies;
+        for (int op = 0; op < OP_COUNT; op++) {
+            Histogram *histogram(&it->second->ops_[op]);
+            // Latencies being updated are counted in the next diff
+            uint64_t count(histogram->count_ - histogram->last_count_);
+            histogram->last_count_ += count;
+            uint64_t total_usecs(histogram->total_usecs_ -
+                histogram->last_total_usecs_);
+            histogram->last_total_usecs_ += total_usecs;
+            uint64_t buckets[kBuckets];
+            for (size_t i = 0; i < kBuckets; i++) {
+                buckets[i] = histogram->buckets_[i] -
+                    histogram->last_buckets_[i];
+                histogram->last_buckets_[i] += buckets[i];
+            }
+            uint64_t max_usecs(histogram->diff_max_usecs_.fetch_and_store(0));
+            if (count == 0) {
+                continue;
+            }
+            DbTableOpLatency latency;
+            GetOpLatency(static_cast<Op>(op), buckets, count, total_usecs,
+                max_usecs, &latency);
+            latencies.push_back(latency);
+        }
+        if (!latencies.empty()) {
+            LocateTableInfo(vdbti, it->first)->set_op_latencies(latencies);
+        }
+    }
+}
+
+void DbTableLatencyStatistics::GetCumulative(
+    std::vector<DbTableInfo> *vdbti) const {
+    tbb::spin_rw_mutex::scoped_lock lock(rw_mutex_, false);
+    for (TableLatencyMap::const_iterator it = table_latency_map_.begin();
+         it != table_latency_map_.end(); it++) {
+        std::vector<DbTableOpLatency> latencies;
+        for (int op = 0; op < OP_COUNT; op++) {
+            const Histogram *histogram(&it->second->ops_[op]);
+            uint64_t count(histogram->count_);
+            if (count == 0) {
+                continue;
+            }
+            uint64_t buckets[kBuckets];
+            for (size_t i = 0; i < kBuckets; i++) {
+                buckets[i] = histogram->buckets_[i];
+            }
+            DbTableOpLatency latency;
+            GetOpLatency(static_cast<Op>(op), buckets, count,
+                histogram->total_usecs_, histogram->max_usecs_, &latency);
+            latencies.push_back(latency);
+        }
+        if (!latencies.empty()) {
+            LocateTableInfo(vdbti, it->first)->set_op_latencies(latencies);
+        }
+    }
+}
+
+bool DbTableLatencyStatistics::GetPercentile(const std::string &table_name,
+    Op op, double percentile, uint64_t *usecs) const {
+    assert(op < OP_COUNT);
+    tbb::spin_rw_mutex::scoped_lock lock(rw_mutex_, false);
+    TableLatencyMap::const_iterator it(table_latency_map_.find(table_name));
+    if (it == table_latency_map_.end()) {
+        return false;
+    }
+    const Histogram *histogram(&it->second->ops_[op]);
+    std::vector<uint64_t> buckets(kBuckets);
+    uint64_t count(0);
+    for (size_t i = 0; i < kBuckets; i++) {
+        buckets[i] = histogram->recent_buckets_[i];
+        count += buckets[i];
+    }
+    if (count == 0) {
+        return false;
+    }
+    *usecs = LatencyPercentile(buckets, count, histogram->max_usecs_,
+        percentile);
+    return true;
+}
+
 // IfErrors
 void IfErrors::GetInternal(DbErrors *db_errors) const {
     db_errors->set_write_tablespace_fails(write_tablespace_fails_);
@@ -217,6 +472,11 @@ void GenDbIfStats::IncrementTableReadBackPressureFail(
     IncrementTableStatsInternal(table_name, false, false, true, 1);
 }
 
+void GenDbIfStats::UpdateTableLatency(const std::string &table_name,
+    DbTableLatencyStatistics::Op op, uint64_t usecs) {
+    table_latency_stats_.Update(table_name, op, usecs);
+}
+
 void GenDbIfStats::IncrementErrors(IfErrors::Type etype) {
     errors_.Increment(etype);
     cumulative_errors_.Increment(etype);
@@ -225,6 +485,7 @@ void GenDbIfStats::IncrementErrors(IfErrors::Type etype) {
 void GenDbIfStats::GetDiffs(std::vector<DbTableInfo> *vdbti, DbErrors *dbe) {
     // Get diff cfstats
     table_stats_.GetDiffs(vdbti);
+    table_latency_stats_.GetDiffs(vdbti);
     // Get diff errors
     errors_.GetDiffs(dbe);
 }
@@ -233,6 +494,7 @@ void GenDbIfStats::GetCumulative(std::vector<DbTableInfo> *vdbti,
      DbErrors *dbe) const {
     // Get cumulative cfstats
     table_stats_.GetCumulative(vdbti);
+    table_latency_stats_.GetCumulative(vdbti);
     // Get cumulative errors
     cumulative_errors_.GetCumulative(dbe);
 }
@@ -5,7 +5,10 @@
 #ifndef GENDB_GENDB_STATISTICS_H__
 #define GENDB_GENDB_STATISTICS_H__
 
+#include <map>
 #include <boost/ptr_container/ptr_map.hpp>
+#include <tbb/atomic.h>
+#include <tbb/spin_rw_mutex.h>
 #include "gendb_types.h"
 
 namespace GenDb {
@@ -47,6 +50,71 @@ class DbTableStatistics {
         bool cumulative) const;
 };
 
+//
+// Latency histograms of the operations on each table. The histograms are
+// updated with atomic operations, only the lookup of the table takes a
+// shared lock. The diffs are the latencies since the previous GetDiffs.
+//
+class DbTableLatencyStatistics {
+ public:
+    enum Op {
+        OP_INSERT,
+        OP_PREPARED_INSERT,
+        OP_BATCH_INSERT,
+        OP_SELECT,
+        OP_COUNT,
+    };
+    // The last bucket counts the latencies of 2^24 usecs and more
+    static const size_t kBuckets = 26;
+    // The weight of the recent latencies halves every kRecentLatencies
+    static const uint64_t kRecentLatencies = 1024;
+
+    DbTableLatencyStatistics();
+    ~DbTableLatencyStatistics();
+    void Update(const std::string &table_name, Op op, uint64_t usecs);
+    // Adds the latencies to the table infos, concurrency - GetDiffs is not
+    // called concurrently with itself
+    void GetDiffs(std::vector<GenDb::DbTableInfo> *vdbti);
+    void GetCumulative(std::vector<GenDb::DbTableInfo> *vdbti) const;
+    // Latency percentile of the recent operations on the table, false if
+    // no latency was recorded
+    bool GetPercentile(const std::string &table_name, Op op,
+        double percentile, uint64_t *usecs) const;
+
+    static const char *OpName(Op op);
+    static size_t Bucket(uint64_t usecs);
+
+ private:
+    struct Histogram {
+        Histogram();
+        void Update(uint64_t usecs);
+        void Decay();
+
+        tbb::atomic<uint64_t> buckets_[kBuckets];
+        tbb::atomic<uint64_t> count_;
+        tbb::atomic<uint64_t> total_usecs_;
+        tbb::atomic<uint64_t> max_usecs_;
+        // Maximum since the previous diff
+        tbb::atomic<uint64_t> diff_max_usecs_;
+        // Values at the previous diff
+        uint64_t last_buckets_[kBuckets];
+        uint64_t last_count_;
+        uint64_t last_total_usecs_;
+        // Decayed buckets
+        tbb::atomic<uint64_t> recent_buckets_[kBuckets];
+        tbb::atomic<uint64_t> recent_count_;
+    };
+    struct TableLatency {
+        Histogram ops_[OP_COUNT];
+    };
+    typedef std::map<std::string, TableLatency *> TableLatencyMap;
+
+    TableLatency *LocateTable(const std::string &table_name);
+
+    mutable tbb::spin_rw_mutex rw_mutex_;
+    TableLatencyMap table_latency_map_;
+};
+
 class IfErrors {
  public:
     IfErrors() :
@@ -108,6 +176,10 @@ class GenDbIfStats {
     void IncrementTableReadFail(const std::string &table_name);
     void IncrementTableReadFail(const std::string &table_name, uint64_t num_reads);
     void IncrementTableReadBackPressureFail(const std::string &table_name);
+    // Concurrency - can be called without holding the lock of the other
+    // statistics
+    void UpdateTableLatency(const std::string &table_name,
+        DbTableLatencyStatistics::Op op, uint64_t usecs);
     void GetDiffs(std::vector<GenDb::DbTableInfo> *vdbti, GenDb::DbErrors *dbe);
     void GetCumulative(std::vector<GenDb::DbTableInfo> *vdbti,
         GenDb::DbErrors *dbe) const;
@@ -117,6 +189,7 @@ class GenDbIfStats {
         bool fail, bool back_pressure, uint64_t num);
 
     GenDb::DbTableStatistics table_stats_;
+    GenDb::DbTableLatencyStatistics table_latency_stats_;
     IfErrors errors_;
     IfErrors cumulative_errors_;
 };
@@ -576,6 +576,12 @@ class GenDbTest : public ::testing::Test {
         stats_.IncrementErrors(
             GenDb::IfErrors::ERR_READ_COLUMN);
     }
+    void UpdateLatency(const std::string &cfname,
+        GenDb::DbTableLatencyStatistics::Op op, uint64_t usecs, int count) {
+        for (int i = 0; i < count; i++) {
+            stats_.UpdateTableLatency(cfname, op, usecs);
+        }
+    }
 
     GenDb::GenDbIfStats stats_;
 };
@@ -741,6 +747,115 @@ TEST_F(GenDbTest, CumulativeStats) {
     EXPECT_EQ(edbti, vdbti[0]);
 }
 
+TEST_F(GenDbTest, LatencyBuckets) {
+    EXPECT_EQ(0, GenDb::DbTableLatencyStatistics::Bucket(0));
+    EXPECT_EQ(1, GenDb::DbTableLatencyStatistics::Bucket(1));
+    EXPECT_EQ(2, GenDb::DbTableLatencyStatistics::Bucket(2));
+    EXPECT_EQ(2, GenDb::DbTableLatencyStatistics::Bucket(3));
+    EXPECT_EQ(3, GenDb::DbTableLatencyStatistics::Bucket(4));
+    EXPECT_EQ(7, GenDb::DbTableLatencyStatistics::Bucket(100));
+    // Last bucket
+    EXPECT_EQ(GenDb::DbTableLatencyStatistics::kBuckets - 1,
+        GenDb::DbTableLatencyStatistics::Bucket(1ULL << 40));
+}
+
+TEST_F(GenDbTest, LatencyStats) {
+    const std::string cfname("FakeColumnFamily");
+    UpdateStatsCfWrite(cfname);
+    UpdateLatency(cfname, GenDb::DbTableLatencyStatistics::OP_SELECT, 100, 98);
+    UpdateLatency(cfname, GenDb::DbTableLatencyStatistics::OP_SELECT, 1000, 1);
+    UpdateLatency(cfname, GenDb::DbTableLatencyStatistics::OP_SELECT, 5000, 1);
+    // Latencies are added to the table info of the table
+    std::vector<GenDb::DbTableInfo> vdbti;
+    GenDb::DbErrors adbe;
+    GetStats(&vdbti, &adbe);
+    ASSERT_EQ(1, vdbti.size());
+    EXPECT_EQ(1, vdbti[0].get_writes());
+    ASSERT_EQ(1, vdbti[0].get_op_latencies().size());
+    const GenDb::DbTableOpLatency &latency(vdbti[0].get_op_latencies()[0]);
+    EXPECT_EQ("select", latency.get_op());
+    EXPECT_EQ(100, latency.get_count());
+    EXPECT_EQ(98 * 100 + 1000 + 5000, latency.get_total_usecs());
+    EXPECT_EQ(5000, latency.get_max_usecs());
+    // Upper bound of the bucket, at most the maximum
+    EXPECT_EQ(128, latency.get_p50_usecs());
+    EXPECT_EQ(1024, latency.get_p99_usecs());
+    EXPECT_EQ(5000, latency.get_p999_usecs());
+    std::vector<uint64_t> ebuckets(14);
+    ebuckets[7] = 98;
+    ebuckets[10] = 1;
+    ebuckets[13] = 1;
+    EXPECT_EQ(ebuckets, latency.get_buckets());
+    vdbti.clear();
+    // Tables without latencies do not report any
+    const std::string cfname2("FakeColumnFamily2");
+    UpdateStatsCfWrite(cfname2);
+    GetStats(&vdbti, &adbe);
+    ASSERT_EQ(1, vdbti.size());
+    EXPECT_EQ(cfname2, vdbti[0].get_table_name());
+    EXPECT_TRUE(vdbti[0].get_op_latencies().empty());
+}
+
+TEST_F(GenDbTest, LatencyPercentile) {
+    GenDb::DbTableLatencyStatistics latencies;
+    const std::string cfname("FakeColumnFamily");
+    uint64_t usecs;
+    EXPECT_FALSE(latencies.GetPercentile(cfname,
+        GenDb::DbTableLatencyStatistics::OP_SELECT, 0.9, &usecs));
+    for (int i = 0; i < 1000; i++) {
+        latencies.Update(cfname, GenDb::DbTableLatencyStatistics::OP_SELECT,
+            1000);
+    }
+    EXPECT_TRUE(latencies.GetPercentile(cfname,
+        GenDb::DbTableLatencyStatistics::OP_SELECT, 0.9, &usecs));
+    EXPECT_EQ(1000, usecs);
+    // The earlier latencies decay
+    for (uint64_t i = 0;
+         i < 4 * GenDb::DbTableLatencyStatistics::kRecentLatencies; i++) {
+        latencies.Update(cfname, GenDb::DbTableLatencyStatistics::OP_SELECT,
+            10);
+    }
+    EXPECT_TRUE(latencies.GetPercentile(cfname,
+        GenDb::DbTableLatencyStatistics::OP_SELECT, 0.9, &usecs));
+    EXPECT_EQ(16, usecs);
+}
+
+TEST_F(GenDbTest, CumulativeLatencyStats) {
+    const std::string cfname("FakeColumnFamily");
+    UpdateLatency(cfname, GenDb::DbTableLatencyStatistics::OP_SELECT, 5000, 2);
+    std::vector<GenDb::DbTableInfo> vdbti;
+    GenDb::DbErrors adbe;
+    GetStats(&vdbti, &adbe);
+    ASSERT_EQ(1, vdbti.size());
+    vdbti.clear();
+    // Diffs only have the latencies since the previous diffs
+    UpdateLatency(cfname, GenDb::DbTableLatencyStatistics::OP_BATCH_INSERT,
+        10, 1);
+    GetStats(&vdbti, &adbe);
+    ASSERT_EQ(1, vdbti.size());
+    ASSERT_EQ(1, vdbti[0].get_op_latencies().size());
+    EXPECT_EQ("batch_insert", vdbti[0].get_op_latencies()[0].get_op());
+    EXPECT_EQ(1, vdbti[0].get_op_latencies()[0].get_count());
+    EXPECT_EQ(10, vdbti[0].get_op_latencies()[0].get_max_usecs());
+    vdbti.clear();
+    UpdateLatency(cfname, GenDb::DbTableLatencyStatistics::OP_SELECT, 100, 1);
+    GetStats(&vdbti, &adbe);
+    ASSERT_EQ(1, vdbti.size());
+    ASSERT_EQ(1, vdbti[0].get_op_latencies().size());
+    EXPECT_EQ(100, vdbti[0].get_op_latencies()[0].get_max_usecs());
+    vdbti.clear();
+    // Cumulative latencies keep increasing, in the order of the ops
+    GetCumulativeStats(&vdbti, &adbe);
+    ASSERT_EQ(1, vdbti.size());
+    ASSERT_EQ(2, vdbti[0].get_op_latencies().size());
+    EXPECT_EQ("batch_insert", vdbti[0].get_op_latencies()[0].get_op());
+    const GenDb::DbTableOpLatency &select(vdbti[0].get_op_latencies()[1]);
+    EXPECT_EQ("select", select.get_op());
+    EXPECT_EQ(3, select.get_count());
+    EXPECT_EQ(2 * 5000 + 100, select.get_total_usecs());
+    EXPECT_EQ(5000, select.get_max_usecs());
+}
+
 int main(int argc, char **argv) {
     LoggingInit();
     ::testing::InitGoogleTest(&argc, argv);
@@ -221,7 +221,8 @@ private:
 
 HttpSession::HttpSession(HttpServer *server, SslSocket *socket,
     bool async_ready)
-    : SslSession(server, socket, async_ready), event_cb_(NULL) {
+    : SslSession(server, socket, async_ready), event_cb_(NULL),
+      send_blocked_(false), send_closed_(false) {
     if (req_handler_task_id_ == -1) {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         req_handler_task_id_ = scheduler->GetTaskId("http::RequestHandlerTask");
@@ -267,6 +268,7 @@ void HttpSession::OnSessionEvent(TcpSession *session,
             }
             lock.release();
             h_session->context_str_ = "";
+            h_session->RunWritableCb(true);
             HttpRequest *request = new HttpRequest();
             string nourl = "";
             request->SetUrl(&nourl);
@@ -286,6 +288,49 @@ void HttpSession::OnSessionEvent(TcpSession *session,
     }
 }
 
+bool HttpSession::SendThrottled(const uint8_t *data, size_t size,
+                                size_t *sent) {
+    // Mark blocked before sending so that a WriteReady() racing with the
+    // return of Send() is not lost
+    {
+        tbb::mutex::scoped_lock lock(send_mutex_);
+        send_blocked_ = true;
+    }
+    if (!Send(data, size, sent)) {
+        return false;
+    }
+    tbb::mutex::scoped_lock lock(send_mutex_);
+    send_blocked_ = false;
+    return true;
+}
+
+bool HttpSession::NotifyWritable(WritableCb cb) {
+    tbb::mutex::scoped_lock lock(send_mutex_);
+    if (!send_blocked_ || send_closed_) {
+        return true;
+    }
+    writable_cb_ = cb;
+    return false;
+}
+
+// The callback is run without the lock, it may send again
+void HttpSession::RunWritableCb(bool closed) {
+    WritableCb cb;
+    {
+        tbb::mutex::scoped_lock lock(send_mutex_);
+        send_blocked_ = false;
+        send_closed_ = send_closed_ || closed;
+        cb.swap(writable_cb_);
+    }
+    if (cb) {
+        cb();
+    }
+}
+
+void HttpSession::WriteReady(const boost::system::error_code &error) {
+    RunWritableCb(false);
+}
+
 void HttpSession::OnRead(Buffer buffer) {
     const u_int8_t *data = BufferData(buffer);
     size_t size = BufferSize(buffer);
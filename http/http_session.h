@@ -8,6 +8,7 @@
 #include <boost/scoped_ptr.hpp>
 #include <tbb/concurrent_queue.h>
 #include <tbb/atomic.h>
+#include <tbb/mutex.h>
 
 #include "base/util.h"
 #include "io/ssl_session.h"
@@ -19,16 +20,32 @@ class HttpSession: public SslSession {
   public:
     typedef boost::function<void(HttpSession *session,
                                  enum TcpSession::Event event)> SessionEventCb;
+    typedef boost::function<void(void)> WritableCb;
 
     HttpSession(HttpServer *server, SslSocket *sock, bool async_ready = true);
     virtual ~HttpSession();
     const std::string get_context() { return context_str_; }
 
+    // Returns false if the session is gone, or if the data was queued
+    // but the write buffer of the session is full. In the latter case the
+    // sender should wait for NotifySessionWritable() before sending more.
     static bool SendSession(std::string const& s,
             const uint8_t *data, size_t size, size_t *sent) {
         HttpSessionPtr hs = GetSession(s);
         if (!hs) return false;
-        return hs->Send(data, size, sent);
+        return hs->SendThrottled(data, size, sent);
+    }
+    // Returns true if the sender can send more right away, or if the
+    // session is gone. Otherwise returns false without blocking, and cb is
+    // called once, from the io thread, when the write buffer has drained or
+    // the session is closed.
+    static bool NotifySessionWritable(std::string const& s, WritableCb cb) {
+        HttpSessionPtr hs = GetSession(s);
+        if (!hs) return true;
+        return hs->NotifyWritable(cb);
+    }
+    static bool IsSessionOpen(std::string const& s) {
+        return GetSession(s).get() != NULL;
     }
     static std::string get_client_context(std::string const& s) {
         HttpSessionPtr hs = GetSession(s);
@@ -42,6 +59,18 @@ class HttpSession: public SslSession {
         hs->set_client_context(ctx);
         return true;
     }    
+    static std::string get_client_format(std::string const& s) {
+        HttpSessionPtr hs = GetSession(s);
+        if (!hs) return "";
+        return hs->get_client_format();
+    }
+    static bool set_client_format(std::string const& s,
+            const std::string& format) {
+        HttpSessionPtr hs = GetSession(s);
+        if (!hs) return false;
+        hs->set_client_format(format);
+        return true;
+    }
     static tbb::atomic<long> GetPendingTaskCount() {
         return task_count_;
     }
@@ -51,6 +80,7 @@ class HttpSession: public SslSession {
 
   protected:
     virtual void OnRead(Buffer buffer);
+    virtual void WriteReady(const boost::system::error_code &error);
 
   private:
     class RequestBuilder;
@@ -60,6 +90,9 @@ class HttpSession: public SslSession {
 
     void OnSessionEvent(TcpSession *session,
             enum TcpSession::Event event);
+    bool SendThrottled(const uint8_t *data, size_t size, size_t *sent);
+    bool NotifyWritable(WritableCb cb);
+    void RunWritableCb(bool closed);
 
     static map_type* GetMap() {
         if (!context_map_) {
@@ -78,12 +111,22 @@ class HttpSession: public SslSession {
     const std::string get_client_context() { return client_context_str_; }
     void set_client_context(const std::string& client_ctx)
       { client_context_str_ = client_ctx; }
+    const std::string get_client_format() { return client_format_str_; }
+    void set_client_format(const std::string& format)
+      { client_format_str_ = format; }
     boost::scoped_ptr<RequestBuilder> request_builder_;
     tbb::concurrent_queue<HttpRequest *> request_queue_;
     tbb::atomic<bool> req_queue_empty_;
     std::string context_str_;
     std::string client_context_str_;
+    std::string client_format_str_;
     SessionEventCb event_cb_;
+    // send_blocked_ is set while the write buffer is above the high water
+    // mark, writable_cb_ is the sender waiting for it to drain
+    tbb::mutex send_mutex_;
+    bool send_blocked_;
+    bool send_closed_;
+    WritableCb writable_cb_;
 
     static int req_handler_task_id_;
     static map_type* context_map_;
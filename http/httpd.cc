@@ -9,6 +9,7 @@
 #include "http/http_session.h"
 #include "io/event_manager.h"
 #include "sandesh/request_pipeline.h"
+#include "sandesh/sandesh_options.h"
 #include "http/http_message_test_types.h"
 #include "http/route_test_types.h"
 #include "config/uve/virtual_network_types.h"
@@ -16,8 +17,10 @@
 #include <boost/foreach.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/program_options.hpp>
 using namespace boost::assign;
 using namespace std;
+namespace opt = boost::program_options;
 
 class ServerInfo {
 public:
@@ -201,7 +204,34 @@ VNSwitchRouteReq::HandleRequest() const{
 
 int
 main(int argc, char *argv[]) {
-    LoggingInit();
+    SandeshConfig sandesh_config;
+    opt::options_description desc("Options");
+    desc.add_options()
+        ("help", "help message")
+        ("DEFAULT.log_file", opt::value<string>()->default_value("<stdout>"),
+         "Filename for the logs to be written to")
+        ("DEFAULT.log_file_size",
+         opt::value<long>()->default_value(10 * 1024 * 1024),
+         "Maximum size of the log file")
+        ("DEFAULT.log_files_count", opt::value<int>()->default_value(10),
+         "Maximum log file roll over index")
+        ;
+    sandesh::options::AddOptions(&desc, &sandesh_config);
+
+    opt::variables_map var_map;
+    opt::store(opt::parse_command_line(argc, argv, desc), var_map);
+    opt::notify(var_map);
+    if (var_map.count("help")) {
+        cout << desc << endl;
+        return 0;
+    }
+    sandesh::options::ProcessOptions(var_map, &sandesh_config);
+
+    LoggingInit(var_map["DEFAULT.log_file"].as<string>(),
+                var_map["DEFAULT.log_file_size"].as<long>(),
+                var_map["DEFAULT.log_files_count"].as<int>(),
+                false, "", "httpd", log4cplus::INFO_LOG_LEVEL,
+                sandesh_config.log_async_write);
 
     ServerInfo info;
     EventManager evm;
@@ -1491,6 +1491,11 @@ void t_cpp_generator::generate_sandesh_async_send_macros(ofstream &out,
     t_sandesh *tsandesh, bool generate_sandesh_object) {
     std::string sender_func_name = "Send";
     std::string logger_func_name = "Log";
+    // Systemlogs and objectlogs are dropped below the minimum level before
+    // the arguments are evaluated. The sandesh object is already created
+    // by the caller and released by Send.
+    bool level_check = !generate_sandesh_object &&
+        !((t_base_type *)tsandesh->get_type())->is_sandesh_flow();
     // Generate creator macro
     string creator_name = tsandesh->get_name() + logger_func_name;
     if (generate_sandesh_object) {
@@ -1503,9 +1508,29 @@ void t_cpp_generator::generate_sandesh_async_send_macros(ofstream &out,
         "", false, false, false, generate_sandesh_object);
     out << "\\" << endl;
     indent_up();
+    string send_args = generate_sandesh_async_creator(tsandesh, false, true,
+        false, "(_", ")", true, false, false, generate_sandesh_object);
+    if (level_check) {
+        // The level is evaluated once, for both the check and the Send
+        const string level_arg("(_level)");
+        send_args.replace(send_args.find(level_arg), level_arg.size(),
+            "_snh_level");
+        out << indent() << "do { \\" << endl;
+        indent_up();
+        out << indent() << "const SandeshLevel::type _snh_level = (_level); \\" <<
+            endl;
+        out << indent() << "if (SANDESH_LEVEL_ENABLED(_snh_level)) \\" << endl;
+        indent_up();
+    }
     out << indent() << tsandesh->get_name() << "::" << sender_func_name;
-    out << generate_sandesh_async_creator(tsandesh, false, true, false,
-        "(_", ")", true, false, false, generate_sandesh_object) << endl;
+    out << send_args;
+    if (level_check) {
+        out << "; \\" << endl;
+        indent_down();
+        indent_down();
+        out << indent() << "} while (0)";
+    }
+    out << endl;
     indent_down();
     indent(out) << endl << endl;
 
@@ -1521,9 +1546,19 @@ void t_cpp_generator::generate_sandesh_async_send_macros(ofstream &out,
         "", false, true, false, generate_sandesh_object);
     out << "\\" << endl;
     indent_up();
+    if (level_check) {
+        out << indent() <<
+            "(SANDESH_LEVEL_ENABLED(SandeshLevel::SYS_INFO) ? \\" << endl;
+        indent_up();
+    }
     out << indent() << tsandesh->get_name() << "::" << sender_func_name;
     out << generate_sandesh_async_creator(tsandesh, false, true, false,
-        "(_", ")", true, true, false, generate_sandesh_object) << endl;
+        "(_", ")", true, true, false, generate_sandesh_object);
+    if (level_check) {
+        out << " : (void)0)";
+        indent_down();
+    }
+    out << endl;
     indent_down();
     indent(out) << endl << endl;
 }
@@ -1905,7 +1940,13 @@ void t_cpp_generator::generate_sandesh_base_init(
         ofstream& out, t_sandesh* tsandesh, bool init_dval) {
     out << generate_sandesh_base_name(tsandesh, false);
 
-    if (init_dval) {
+    bool is_trace =
+        ((t_base_type *)tsandesh->get_type())->is_sandesh_trace() ||
+        ((t_base_type *)tsandesh->get_type())->is_sandesh_trace_object();
+    if (init_dval && is_trace) {
+        // Trace sandeshes do not have a static sequence number
+        out << "(\"" << tsandesh->get_name() << "\",0)";
+    } else if (init_dval) {
         out << "(\"" << tsandesh->get_name() << "\",lseqnum_++)";
     } else {
         out << "(\"" << tsandesh->get_name() << "\",seqno)";
@@ -2243,6 +2284,10 @@ void t_cpp_generator::generate_sandesh_definition(ofstream& out,
         generate_sandesh_objectlog_creators(out, tsandesh);
     } else if (is_trace) {
         // Sandesh trace
+        // Generate default constructor, used to decode binary traces
+        generate_sandesh_default_ctor(out, tsandesh, false);
+        out << indent() << "virtual SandeshTrace *CreateEmpty() const { " <<
+            "return new " << tsandesh->get_name() << "; }" << endl << endl;
         out << indent() << "virtual void SendTrace(" <<
             "const std::string& tcontext, bool more) {" << endl;
         indent_up();
@@ -2297,7 +2342,8 @@ void t_cpp_generator::generate_sandesh_definition(ofstream& out,
             " & _data, const map<string,string> & _dsconf);" << endl;
         out << indent() << "static bool UpdateUVE(" <<  dtype <<
             " & _data, " << dtype <<
-            " & tdata, uint64_t mono_usec, SandeshLevel::type Xlevel);" << endl;
+            " & tdata, uint64_t mono_usec, SandeshLevel::type Xlevel," <<
+            " bool full_sync);" << endl;
         out << indent() << "bool LoadUVE(SendType stype, uint32_t cycle);" << endl;
     }
 
@@ -3941,7 +3987,8 @@ void t_cpp_generator::generate_sandesh_updater(ofstream& out,
   indent(out) << "bool " << tsandesh->get_name() <<
     "::UpdateUVE(" <<  dtype <<
       " & _data, " << dtype <<
-      " & tdata, uint64_t mono_usec, SandeshLevel::type Xlevel) {" << endl;
+      " & tdata, uint64_t mono_usec, SandeshLevel::type Xlevel," <<
+      " bool full_sync) {" << endl;
 
   indent_up();
 
@@ -3958,8 +4005,17 @@ void t_cpp_generator::generate_sandesh_updater(ofstream& out,
         if (cat != INLINE) {
           indent(out) << "if (_data.__isset." << snm << ") { _data.__isset." <<
             snm << " = false;" << endl;
+        } else if (snm.compare("proxy") == 0) {
+          // The proxy is sent along with every update of the UVE
+          indent(out) << "if (_data.__isset." << snm << ") {" << endl;
         } else {
-          indent(out) << "if (_data.__isset." << snm << ") { send = true;" << endl;
+          // Only send inline attributes that changed since the last
+          // update, unless a full sync of this UVE is due
+          indent(out) << "if (_data.__isset." << snm << ") {" << endl;
+          indent(out) << "  if (full_sync || !tdata.__isset." << snm <<
+            " || !(tdata.get_" << snm << "() == _data.get_" << snm <<
+            "())) send = true;" << endl;
+          indent(out) << "  else _data.__isset." << snm << " = false;" << endl;
         }
       } else {
         if ((snm.compare("name") == 0) || (snm.compare("proxy") == 0)) {
@@ -4041,7 +4097,7 @@ void t_cpp_generator::generate_sandesh_updater(ofstream& out,
     }
   }
   if (!periodic_ustruct) {
-    indent(out) <<  "send = true;" << endl;
+    indent(out) <<  "if (full_sync) send = true;" << endl;
   }
   indent(out) <<  "return send;" << endl;
   indent_down();
@@ -14,6 +14,7 @@
 #define __DERIVED_STATS_H__
 
 #include <string>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/function.hpp>
@@ -121,10 +122,183 @@ void DerivedStatsMerge(const std::map<std::string, ElemT> & raw,
     }
 }
 
+// Keyed store for map-valued derived stats, kept as a vector sorted by
+// key. Merge walks a raw map and the store together, so existing keys are
+// updated in place and the vector is only rebuilt when keys are added or
+// removed.
+template <typename ValueT>
+class DSKeyedStore {
+  public:
+    typedef std::pair<std::string, ValueT> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    iterator begin() { return entries_.begin(); }
+    iterator end() { return entries_.end(); }
+    const_iterator begin() const { return entries_.begin(); }
+    const_iterator end() const { return entries_.end(); }
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    void clear() { entries_.clear(); }
+
+    // For each key of raw, calls updater.Update() on the existing value,
+    // or updater.Create() for a new key. The key is kept only if the call
+    // returns true. Keys that are not in raw are left as they are.
+    template <typename RawMapT, typename UpdaterT>
+    void Merge(const RawMapT &raw, const std::map<std::string, bool> &del,
+               UpdaterT &updater) {
+        iterator dt = entries_.begin();
+        std::map<std::string, bool>::const_iterator dlt = del.begin();
+        bool rebuild = false;
+        size_t index = 0;
+        for (typename RawMapT::const_iterator rit = raw.begin();
+                rit != raw.end(); ++rit, ++index) {
+            while (dt != entries_.end() && dt->first < rit->first) {
+                if (rebuild) Move(&*dt);
+                ++dt;
+            }
+            bool deleted = IsDeleted(del, &dlt, rit->first);
+            if (dt != entries_.end() && dt->first == rit->first) {
+                if (updater.Update(&dt->second, rit->second, index, deleted)) {
+                    if (rebuild) Move(&*dt);
+                } else if (!rebuild) {
+                    StartRebuild(dt, raw.size());
+                    rebuild = true;
+                }
+                ++dt;
+            } else {
+                ValueT value = ValueT();
+                if (updater.Create(&value, rit->second, index, deleted)) {
+                    if (!rebuild) {
+                        StartRebuild(dt, raw.size());
+                        rebuild = true;
+                    }
+                    scratch_.push_back(value_type(rit->first, value));
+                }
+            }
+        }
+        if (rebuild) {
+            for (; dt != entries_.end(); ++dt) Move(&*dt);
+            entries_.swap(scratch_);
+            scratch_.clear();
+        }
+    }
+
+  private:
+    static bool IsDeleted(const std::map<std::string, bool> &del,
+            std::map<std::string, bool>::const_iterator *dlt,
+            const std::string &key) {
+        // del normally has the same keys as raw, so it is walked along
+        while (*dlt != del.end() && (*dlt)->first < key) ++*dlt;
+        if (*dlt != del.end() && (*dlt)->first == key) return (*dlt)->second;
+        return false;
+    }
+
+    // Moves the entries before dt to scratch_, which becomes the new store
+    void StartRebuild(iterator dt, size_t raw_size) {
+        scratch_.clear();
+        scratch_.reserve(entries_.size() + raw_size);
+        for (iterator it = entries_.begin(); it != dt; ++it) Move(&*it);
+    }
+
+    void Move(value_type *entry) {
+        scratch_.push_back(value_type());
+        scratch_.back().first.swap(entry->first);
+        std::swap(scratch_.back().second, entry->second);
+    }
+
+    std::vector<value_type> entries_;
+    std::vector<value_type> scratch_;
+};
+
+// Updates the aggregate of each key of a map-valued stat, and stores the
+// difference of the raw value from the aggregate in diff, in the order of
+// the raw map. Equivalent to DerivedStatsAgg.
+template <typename ElemT>
+class DSAggUpdater {
+  public:
+    explicit DSAggUpdater(std::vector<ElemT> *diff) : diff_(diff) {}
+
+    bool Update(ElemT *agg, const ElemT &raw, size_t index, bool deleted) {
+        (*diff_)[index] = raw - *agg;
+        if (deleted) return false;
+        *agg = *agg + (*diff_)[index];
+        return true;
+    }
+
+    bool Create(ElemT *agg, const ElemT &raw, size_t index, bool deleted) {
+        (*diff_)[index] = raw;
+        if (deleted) return false;
+        *agg = raw;
+        return true;
+    }
+
+  private:
+    std::vector<ElemT> *diff_;
+};
+
+template<typename ElemT>
+void DerivedStatsAggInPlace(const std::map<std::string, ElemT> & raw,
+        DSKeyedStore<ElemT> & agg,
+        const std::map<std::string, bool> &del,
+        std::vector<ElemT> *diff) {
+    diff->resize(raw.size());
+    DSAggUpdater<ElemT> updater(diff);
+    agg.Merge(raw, del, updater);
+}
+
+// Feeds the value of each key of a map-valued stat to its DerivedStat
+// object, creating the object for new keys. The value is taken from diff
+// if given, else from the raw map.
+template<template<class,class> class DSTT, typename ElemT, typename ResultT>
+class DSObjUpdater {
+  public:
+    typedef boost::shared_ptr<DSTT<ElemT,ResultT> > DSPtr;
+
+    DSObjUpdater(const std::string &annotation,
+            const std::vector<ElemT> *diff, uint64_t mono_usec) :
+        annotation_(annotation), diff_(diff), mono_usec_(mono_usec) {}
+
+    bool Update(DSPtr *ds, const ElemT &raw, size_t index, bool deleted) {
+        if (deleted) return false;
+        (*ds)->Update(diff_ ? (*diff_)[index] : raw, mono_usec_);
+        return true;
+    }
+
+    bool Create(DSPtr *ds, const ElemT &raw, size_t index, bool deleted) {
+        if (deleted) return false;
+        *ds = boost::make_shared<DSTT<ElemT,ResultT> >(annotation_);
+        (*ds)->Update(diff_ ? (*diff_)[index] : raw, mono_usec_);
+        return true;
+    }
+
+  private:
+    const std::string &annotation_;
+    const std::vector<ElemT> *diff_;
+    uint64_t mono_usec_;
+};
+
+// Equivalent to DerivedStatsMerge, for a DSKeyedStore
+template<template<class,class> class DSTT, typename ElemT, typename ResultT>
+void DerivedStatsMergeInPlace(const std::map<std::string, ElemT> & raw,
+        const std::vector<ElemT> *diff,
+        DSKeyedStore<boost::shared_ptr<DSTT<ElemT,ResultT> > > & dsm,
+        const std::string &annotation, const std::map<std::string, bool> &del,
+        uint64_t mono_usec) {
+
+    // If the new map is empty, clear all DS objects
+    if (raw.empty()) {
+        dsm.clear();
+        return;
+    }
+    DSObjUpdater<DSTT,ElemT,ResultT> updater(annotation, diff, mono_usec);
+    dsm.Merge(raw, del, updater);
+}
+
 template <template<class,class> class DSTT, typename ElemT, typename ResultT>
 class DerivedStatsIf {
   private:
-    typedef std::map<std::string, boost::shared_ptr<DSTT<ElemT,ResultT> > > result_map;
+    typedef DSKeyedStore<boost::shared_ptr<DSTT<ElemT,ResultT> > > result_map;
 
     boost::shared_ptr<result_map> dsm_;
 
@@ -134,9 +308,9 @@ class DerivedStatsIf {
 
     bool is_agg_;
     ElemT agg_;
-    std::map<std::string, ElemT> aggm_;
+    DSKeyedStore<ElemT> aggm_;
     ElemT diff_;
-    std::map<std::string, ElemT> diffm_;
+    std::vector<ElemT> diffm_;
 
 
   public:
@@ -204,10 +378,12 @@ class DerivedStatsIf {
             dsm_ = boost::make_shared<result_map>();
         }
         if (is_agg_) {
-            diffm_ = DerivedStatsAgg<ElemT>(raw, aggm_, del);
-            DerivedStatsMerge<DSTT,ElemT,ResultT>(diffm_, *dsm_, annotation_, del, mono_usec);
+            DerivedStatsAggInPlace<ElemT>(raw, aggm_, del, &diffm_);
+            DerivedStatsMergeInPlace<DSTT,ElemT,ResultT>(
+                    raw, &diffm_, *dsm_, annotation_, del, mono_usec);
         } else {
-            DerivedStatsMerge<DSTT,ElemT,ResultT>(raw, *dsm_, annotation_, del, mono_usec);
+            DerivedStatsMergeInPlace<DSTT,ElemT,ResultT>(
+                    raw, NULL, *dsm_, annotation_, del, mono_usec);
         }
     }
 };
@@ -216,7 +392,7 @@ template <template<class,class> class DSTT, typename ElemT,
 typename SubResultT, typename ResultT>
 class DerivedStatsPeriodicIf {
   private:
-    typedef std::map<std::string, boost::shared_ptr<DSTT<ElemT,SubResultT> > > result_map;
+    typedef DSKeyedStore<boost::shared_ptr<DSTT<ElemT,SubResultT> > > result_map;
     boost::shared_ptr<result_map> dsm_;
     boost::shared_ptr< std::map<std::string,ResultT> > dsm_cache_;
 
@@ -228,9 +404,9 @@ class DerivedStatsPeriodicIf {
     bool is_agg_;
     bool init_;
     ElemT agg_;
-    std::map<std::string, ElemT> aggm_;
+    DSKeyedStore<ElemT> aggm_;
     ElemT diff_;
-    std::map<std::string, ElemT> diffm_;
+    std::vector<ElemT> diffm_;
 
   public:
     DerivedStatsPeriodicIf(std::string annotation, bool is_agg=false):
@@ -267,11 +443,11 @@ class DerivedStatsPeriodicIf {
             dsm_ = boost::make_shared<result_map>();
         }
         if (is_agg_) {
-            diffm_ = DerivedStatsAgg<ElemT>(raw, aggm_, del);
-            DerivedStatsMerge<DSTT,ElemT,SubResultT>(
-                    diffm_, *dsm_, annotation_, del, mono_usec);
-        } else DerivedStatsMerge<DSTT,ElemT,SubResultT>(
-                    raw, *dsm_, annotation_, del, mono_usec);
+            DerivedStatsAggInPlace<ElemT>(raw, aggm_, del, &diffm_);
+            DerivedStatsMergeInPlace<DSTT,ElemT,SubResultT>(
+                    raw, &diffm_, *dsm_, annotation_, del, mono_usec);
+        } else DerivedStatsMergeInPlace<DSTT,ElemT,SubResultT>(
+                    raw, NULL, *dsm_, annotation_, del, mono_usec);
         init_ = true;
     }
 
@@ -406,7 +582,7 @@ template<class,class> class PreT, typename ResultT>
 class DerivedStatsPeriodicAnomalyIf {
   private:
     DerivedStatsPeriodicIf<PreT,  ElemT,  ElemT, DSPeriodic<ElemT> > periodic_;
-    typedef std::map<std::string, boost::shared_ptr<DSTT<ElemT,ResultT> > > result_map;
+    typedef DSKeyedStore<boost::shared_ptr<DSTT<ElemT,ResultT> > > result_map;
     DerivedStatsIf<DSTT, ElemT,  ResultT> anomaly_;
     bool init_;
 
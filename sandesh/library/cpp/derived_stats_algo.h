@@ -17,8 +17,11 @@
 #include <sstream>
 #include <sandesh/derived_stats_results_types.h>
 #include <sandesh/derived_stats.h>
+#include <base/tdigest.h>
 #include <boost/assign/list_of.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
 
 using std::vector;
 using std::map;
@@ -272,7 +275,7 @@ template <typename ElemT, class SumResT>
 class DSSum {
   public:
     DSSum(const std::string &annotation): samples_(0), shifter_(0),
-            start_tbin_(0), last_tbin_(0) {
+            start_tbin_(0), last_tbin_(0), history_head_(0) {
 
         if (annotation.empty()) {
             range_usecs_ = 0;
@@ -284,13 +287,25 @@ class DSSum {
             while ((uint64_t)(1 << (shifter_ + 8)) < range_usecs_) shifter_++;
         }
     }
+
+    // Aggregate of the samples seen in one time bucket
+    struct HistoryBucket {
+        HistoryBucket() : samples(0), value() {}
+        uint64_t samples;
+        ElemT value;
+    };
+
     uint64_t samples_;
     SumResT value_;
-    map<uint64_t, pair<uint64_t,ElemT> > history_buf_;
+    // Circular buffer of the time buckets within the range, allocated on
+    // the first Update. The bucket at history_head_ is for last_tbin_, and
+    // the one n positions before it is for last_tbin_ - (n << shifter_)
+    vector<HistoryBucket> history_buf_;
     uint64_t range_usecs_;
     uint8_t shifter_;
     uint64_t start_tbin_;
     uint64_t last_tbin_;
+    size_t history_head_;
 
     virtual DSReturnType FillResult(SumResT &res) const {
         static SumResT empty_val;
@@ -313,46 +328,69 @@ class DSSum {
         return DSR_OK;
     }
 
-    virtual void Purge(uint64_t mono_usec) {
+    // Number of time buckets whose range has not ended yet
+    size_t HistorySize() const {
+        size_t size = range_usecs_ >> shifter_;
+        return size ? size : 1;
+    }
 
-        for (typename map<uint64_t, pair<uint64_t,ElemT> >::iterator it =
-                history_buf_.begin(); it!= history_buf_.end(); ) {
-            uint64_t end_range = ((it->first + range_usecs_) >> shifter_) << shifter_;
-            if (end_range <= mono_usec) {
-                value_ = value_ - it->second.second;
-                samples_ = samples_ - it->second.first;
-                history_buf_.erase(it++);
-            } else {
-                ++it;
+    // Moves the window forward to mono_usec, subtracting the buckets
+    // whose range has ended
+    virtual void Purge(uint64_t mono_usec) {
+        uint64_t tbin = (mono_usec >> shifter_) << shifter_;
+        if (history_buf_.empty() || tbin <= last_tbin_) {
+            return;
+        }
+        size_t size = history_buf_.size();
+        uint64_t steps = (tbin - last_tbin_) >> shifter_;
+        if (steps > size) steps = size;
+        for (uint64_t i = 0; i < steps; i++) {
+            history_head_ = (history_head_ + 1) % size;
+            HistoryBucket &bucket = history_buf_[history_head_];
+            if (bucket.samples) {
+                value_ = value_ - bucket.value;
+                samples_ = samples_ - bucket.samples;
+                bucket = HistoryBucket();
             }
         }
+        last_tbin_ = tbin;
     }
 
     virtual void Update(const ElemT& raw, uint64_t mono_usec) {
-        if (!samples_) {
-            value_ = raw;
-        } else {
-            value_ = value_ + raw;
-        }
         if (range_usecs_) {
             // if 'range_usecs_' is non-0, we need to aggregate only
             // the last 'range_usecs_' worth of elements
             uint64_t tbin = (mono_usec >> shifter_) << shifter_;
             if (!start_tbin_) start_tbin_ = tbin;
-            last_tbin_ = tbin;
+            if (history_buf_.empty()) {
+                history_buf_.resize(HistorySize());
+                last_tbin_ = tbin;
+            }
 
             // Subtract old entries, if there are any
             Purge(tbin);
 
-            // Record the new update, so we can subtract when needed
-            typename map<uint64_t, pair<uint64_t,ElemT> >::iterator ut =
-                    history_buf_.find(tbin);
-            if (ut == history_buf_.end()) {
-                history_buf_[tbin] = make_pair(1,raw);
+            // Record the new update, so we can subtract when needed.
+            // A sample older than the range is not counted at all
+            uint64_t age = 0;
+            if (tbin < last_tbin_) {
+                age = (last_tbin_ - tbin) >> shifter_;
+                if (age >= history_buf_.size()) return;
+            }
+            size_t size = history_buf_.size();
+            HistoryBucket &bucket =
+                    history_buf_[(history_head_ + size - age) % size];
+            if (!bucket.samples) {
+                bucket.value = raw;
             } else {
-                ut->second.second = ut->second.second + raw;
-                ut->second.first++;
+                bucket.value = bucket.value + raw;
             }
+            bucket.samples++;
+        }
+        if (!samples_) {
+            value_ = raw;
+        } else {
+            value_ = value_ + raw;
         }
         samples_++;
     }
@@ -374,6 +412,208 @@ class DSAvg : public DSSum<ElemT,AvgResT> {
     }
 };
 
+// t-digest summary of a stream of samples, see base/tdigest.h
+class DSDigest {
+  public:
+    // A compression of 0.05 keeps a digest of a million samples to about
+    // 300 centroids, with the 99th percentile within 0.1%
+    static double Delta() { return 0.05; }
+
+    DSDigest() : digest_(TDigest_create(Delta(), DEFAULT_K)) {}
+    ~DSDigest() { TDigest_destroy(digest_); }
+
+    void Add(double x) {
+        Replace(TDigest_add(digest_, x, 1));
+    }
+    void Merge(const DSDigest &other) {
+        Replace(TDigest_merge(digest_, other.digest_));
+    }
+    void Clear() {
+        Replace(TDigest_create(Delta(), DEFAULT_K));
+    }
+    uint64_t Count() const {
+        return TDigest_get_count(digest_);
+    }
+    // q is between 0 and 1
+    double Percentile(double q) const {
+        return TDigest_percentile(digest_, q);
+    }
+    // Estimated number of samples less than or equal to x
+    uint64_t CountUpTo(double x) const {
+        return (uint64_t)(TDigest_cdf(digest_, x) * Count() + 0.5);
+    }
+
+  private:
+    void Replace(TDigest *digest) {
+        if (digest) {
+            TDigest_destroy(digest_);
+            digest_ = digest;
+        }
+    }
+
+    TDigest *digest_;
+
+    DSDigest(const DSDigest &);
+    DSDigest &operator=(const DSDigest &);
+};
+
+// Keeps the samples of the last window as two digests of half a window
+// each, so that a result covers between half a window and a window worth
+// of samples. Without a window, all the samples are kept.
+class DSDigestWindow {
+  public:
+    DSDigestWindow(uint64_t window_usecs) : half_usecs_(window_usecs / 2),
+            cur_bin_(0), cur_(new DSDigest), prev_(new DSDigest) {}
+
+    void Update(double x, uint64_t mono_usec) {
+        if (half_usecs_) {
+            uint64_t bin = mono_usec / half_usecs_;
+            if (bin > cur_bin_) {
+                if (bin == cur_bin_ + 1) {
+                    prev_.swap(cur_);
+                } else {
+                    prev_->Clear();
+                }
+                cur_->Clear();
+                cur_bin_ = bin;
+            }
+        }
+        cur_->Add(x);
+    }
+
+    // Returns the digest of the window, merged into scratch if needed
+    const DSDigest &Digest(DSDigest *scratch) const {
+        if (!prev_->Count()) return *cur_;
+        scratch->Merge(*prev_);
+        scratch->Merge(*cur_);
+        return *scratch;
+    }
+
+  private:
+    uint64_t half_usecs_;
+    uint64_t cur_bin_;
+    boost::scoped_ptr<DSDigest> cur_;
+    boost::scoped_ptr<DSDigest> prev_;
+};
+
+// Parses a "<value>,<value>...[:<window in seconds>]" annotation
+inline void DSDigestAnnotation(const std::string &annotation,
+        const std::string &default_values,
+        vector<pair<string, double> > *values, uint64_t *window_usecs,
+        std::string *errstr) {
+    size_t rpos = annotation.find(':');
+    std::string vstr = annotation.substr(0, rpos);
+    *window_usecs = 0;
+    if (rpos != string::npos) {
+        *window_usecs = ((uint64_t) strtoul(
+            annotation.c_str() + rpos + 1, NULL, 10)) * 1000000;
+    }
+    if (vstr.empty()) vstr = default_values;
+    if (vstr.empty()) {
+        *errstr = std::string("No values");
+        return;
+    }
+    vector<string> tokens;
+    boost::algorithm::split(tokens, vstr, boost::is_any_of(","));
+    for (vector<string>::const_iterator it = tokens.begin();
+            it != tokens.end(); ++it) {
+        char *end;
+        double value = strtod(it->c_str(), &end);
+        if (it->empty() || *end != '\0') {
+            *errstr = std::string("Invalid value ") + *it;
+            return;
+        }
+        values->push_back(make_pair(*it, value));
+    }
+}
+
+// Reports the configured percentiles of the samples, e.g. "50,99:60"
+// for the median and 99th percentile of the last minute
+template <typename ElemT, class PercentileResT>
+class DSPercentile {
+  public:
+    DSPercentile(const std::string &annotation) : window_(0) {
+        uint64_t window_usecs;
+        DSDigestAnnotation(annotation, "50,95,99", &percentiles_,
+                           &window_usecs, &error_);
+        for (vector<pair<string, double> >::const_iterator it =
+                percentiles_.begin(); it != percentiles_.end(); ++it) {
+            if ((it->second < 0) || (it->second > 100)) {
+                error_ = std::string("Invalid percentile ") + it->first;
+            }
+        }
+        window_.reset(new DSDigestWindow(window_usecs));
+    }
+
+    DSReturnType FillResult(PercentileResT &res) const {
+        DSDigest scratch;
+        const DSDigest &digest = window_->Digest(&scratch);
+        res.set_samples(digest.Count());
+        if (!error_.empty()) {
+            res.set_error(error_);
+            return DSR_OK;
+        }
+        if (!digest.Count()) return DSR_INVALID;
+        map<string, double> percentiles;
+        for (vector<pair<string, double> >::const_iterator it =
+                percentiles_.begin(); it != percentiles_.end(); ++it) {
+            percentiles.insert(make_pair(it->first,
+                digest.Percentile(it->second / 100)));
+        }
+        res.set_percentiles(percentiles);
+        return DSR_OK;
+    }
+
+    void Update(const ElemT& raw, uint64_t mono_usec) {
+        window_->Update((double) raw, mono_usec);
+    }
+
+  private:
+    vector<pair<string, double> > percentiles_;
+    std::string error_;
+    boost::scoped_ptr<DSDigestWindow> window_;
+};
+
+// Reports the number of samples less than or equal to each of the
+// configured bucket bounds, e.g. "10,100,1000:60"
+template <typename ElemT, class HistogramResT>
+class DSHistogram {
+  public:
+    DSHistogram(const std::string &annotation) : window_(0) {
+        uint64_t window_usecs;
+        DSDigestAnnotation(annotation, "", &bounds_, &window_usecs, &error_);
+        window_.reset(new DSDigestWindow(window_usecs));
+    }
+
+    DSReturnType FillResult(HistogramResT &res) const {
+        DSDigest scratch;
+        const DSDigest &digest = window_->Digest(&scratch);
+        res.set_samples(digest.Count());
+        if (!error_.empty()) {
+            res.set_error(error_);
+            return DSR_OK;
+        }
+        if (!digest.Count()) return DSR_INVALID;
+        map<string, uint64_t> buckets;
+        for (vector<pair<string, double> >::const_iterator it =
+                bounds_.begin(); it != bounds_.end(); ++it) {
+            buckets.insert(make_pair(it->first,
+                digest.CountUpTo(it->second)));
+        }
+        res.set_buckets(buckets);
+        return DSR_OK;
+    }
+
+    void Update(const ElemT& raw, uint64_t mono_usec) {
+        window_->Update((double) raw, mono_usec);
+    }
+
+  private:
+    vector<pair<string, double> > bounds_;
+    std::string error_;
+    boost::scoped_ptr<DSDigestWindow> window_;
+};
+
 } // namespace sandesh
 } // namespace contrail
 
@@ -828,6 +828,9 @@ int32_t TJSONProtocol::writeString(const string& str) {
   int32_t size = 0, ret;
   string json;
   json.reserve(512);
+  if (json_string_escape_) {
+    return writePlain(escapeJSONString(str));
+  }
   json += str;
   // Escape JSON control characters in the string before writing
   return writePlain(escapeJSONControlChars(json));
@@ -5,6 +5,7 @@
 #ifndef _SANDESH_PROTOCOL_TJSONPROTOCOL_H_
 #define _SANDESH_PROTOCOL_TJSONPROTOCOL_H_ 1
 
+#include <stdio.h>
 #include <string.h>
 #include "TVirtualProtocol.h"
 
@@ -37,6 +38,9 @@ class TJSONProtocol : public TVirtualProtocol<TJSONProtocol> {
     , trans_(trans.get())
     , string_limit_(DEFAULT_STRING_LIMIT)
     , string_prefix_size_(DEFAULT_STRING_PREFIX_SIZE)
+    , is_string_begin_(false)
+    , is_list_elem_string_(false)
+    , json_string_escape_(false)
     , reader_(*trans)
   {
     TType ttypes_arr[] = { T_STRUCT, T_MAP, T_SET, T_LIST, T_SANDESH };
@@ -82,6 +86,31 @@ class TJSONProtocol : public TVirtualProtocol<TJSONProtocol> {
     }
   }
 
+  // Escapes the string for use as a JSON string value
+  static std::string escapeJSONString(const std::string& str) {
+    std::string json;
+    json.reserve(str.length());
+    for (std::string::const_iterator it = str.begin();
+         it != str.end(); ++it) {
+      switch(*it) {
+       case '"':  json += "\\\"";  break;
+       case '\\': json += "\\\\"; break;
+       case '\n': json += "\\n";   break;
+       case '\r': json += "\\r";   break;
+       case '\t': json += "\\t";   break;
+       default:
+        if (static_cast<unsigned char>(*it) < 0x20) {
+          char ustr[8];
+          snprintf(ustr, sizeof(ustr), "\\u%04x", *it);
+          json += ustr;
+        } else {
+          json += *it;
+        }
+      }
+    }
+    return json;
+  }
+
   static void unescapeJSONControlChars(std::string& str) {
       boost::algorithm::replace_all(str, "&amp;", "&");
       boost::algorithm::replace_all(str, "&apos;", "\'");
@@ -173,6 +202,13 @@ class TJSONProtocol : public TVirtualProtocol<TJSONProtocol> {
       sandesh_end_ = val;
   }
 
+  // Write strings escaped as JSON string values, instead of with the XML
+  // control characters escaped. Output is then not readable by this
+  // protocol, but by any JSON parser.
+  void setJSONStringEscape(bool val) {
+      json_string_escape_ = val;
+  }
+
   class LookaheadReader {
 
    public:
@@ -294,6 +330,8 @@ class TJSONProtocol : public TVirtualProtocol<TJSONProtocol> {
 
   bool is_list_elem_string_;
 
+  bool json_string_escape_;
+
   std::vector<std::string> current_sandesh_context_;
 
   std::vector<bool> is_first_element_context_;
@@ -81,6 +81,7 @@ SandeshLevel::type Sandesh::logging_level_ = SandeshLevel::INVALID;
 SandeshLevel::type Sandesh::logging_ut_level_ =
     getenv("SANDSH_UT_DEBUG") ? SandeshLevel::SYS_DEBUG : SandeshLevel::UT_DEBUG;
 std::string Sandesh::logging_category_;
+SandeshLevel::type Sandesh::min_level_ = SandeshLevel::INVALID;
 EventManager* Sandesh::event_manager_ = NULL;
 SandeshMessageStatistics Sandesh::msg_stats_;
 tbb::mutex Sandesh::stats_mutex_;
@@ -93,6 +94,7 @@ log4cplus::Logger Sandesh::sampled_logger_ =
 
 Sandesh::ModuleContextMap Sandesh::module_context_;
 tbb::atomic<uint32_t> Sandesh::sandesh_send_ratelimit_;
+tbb::atomic<uint32_t> Sandesh::sandesh_send_flush_deadline_usec_;
 
 const char *loggingPattern = "%D{%Y-%m-%d %a %H:%M:%S:%Q %Z} "
                              " %h [Thread %t, Pid %i]: %m%n";
@@ -175,6 +177,7 @@ bool Sandesh::Initialize(SandeshRole::type role,
     event_manager_  = evm;
 
     set_send_rate_limit(config.system_logs_rate_limit);
+    set_send_flush_deadline(config.send_flush_deadline_usec);
     DisableSendingObjectLogs(config.disable_object_logs);
     InitReceive(Task::kTaskInstanceAny);
     bool success(SandeshHttp::Init(evm, module, http_port,
@@ -444,6 +447,15 @@ void Sandesh::SetLoggingCategory(std::string category) {
     }
 }
 
+void Sandesh::SetMinLevel(SandeshLevel::type level) {
+    if (min_level_ != level) {
+        SANDESH_LOG(INFO, "SANDESH: MIN LEVEL: " << "[ " <<
+                LevelToString(min_level_) << " ] -> [ " <<
+                LevelToString(level) << " ]");
+        min_level_ = level;
+    }
+}
+
 void Sandesh::SetLocalLogging(bool enable_local_log) {
     if (enable_local_log_ != enable_local_log) {
         SANDESH_LOG(INFO, "SANDESH: Logging: " <<
@@ -541,6 +553,19 @@ uint32_t Sandesh::get_send_rate_limit() {
     return sandesh_send_ratelimit_;
 }
 
+void Sandesh::set_send_flush_deadline(uint32_t deadline_usec) {
+    if (sandesh_send_flush_deadline_usec_ != deadline_usec) {
+        SANDESH_LOG(INFO, "SANDESH: Send Flush Deadline: " <<
+            sandesh_send_flush_deadline_usec_ << " -> " << deadline_usec <<
+            " usec");
+        sandesh_send_flush_deadline_usec_ = deadline_usec;
+    }
+}
+
+uint32_t Sandesh::get_send_flush_deadline() {
+    return sandesh_send_flush_deadline_usec_;
+}
+
 bool Sandesh::Enqueue(SandeshQueue *queue) {
     if (!queue) {
         if (IsLoggingDroppedAllowed(type())) {
@@ -915,7 +940,7 @@ void Sandesh::SetSendQueue(bool enable) {
         send_queue_enabled_ = enable;
         if (enable) {
             if (client_ && client_->IsSession()) {
-                client_->session()->send_queue()->MayBeStartRunner();
+                client_->session()->MayBeStartSendQueueRunner();
             }
         }
     }
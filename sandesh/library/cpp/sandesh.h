@@ -97,6 +97,18 @@
 #include <sandesh/sandesh_trace.h>
 #include <sandesh/sandesh_options.h>
 
+// Systemlogs and objectlogs less severe than SANDESH_MIN_LOG_LEVEL are
+// compiled out of the generated *_LOG and *_SEND macros, e.g. build with
+// -DSANDESH_MIN_LOG_LEVEL=SandeshLevel::SYS_INFO to remove the debug logs.
+#ifndef SANDESH_MIN_LOG_LEVEL
+#define SANDESH_MIN_LOG_LEVEL SandeshLevel::INVALID
+#endif
+
+// Checked by the generated macros before the arguments are evaluated.
+// The level is evaluated once.
+#define SANDESH_LEVEL_ENABLED(_level)                                     \
+    Sandesh::IsLevelEnabled(_level)
+
 // Forward declaration
 class EventManager;
 class SandeshClient;
@@ -208,6 +220,11 @@ public:
     static bool IsSendingFlowsDisabled();
     static void set_send_rate_limit(int rate_limit);
     static uint32_t get_send_rate_limit();
+    // Time, in microseconds, for which messages are held back to be sent
+    // along with the following ones. 0 sends them as soon as the send
+    // queue is empty.
+    static void set_send_flush_deadline(uint32_t deadline_usec);
+    static uint32_t get_send_flush_deadline();
 
     // Logging and category APIs
     static void SetLoggingParams(bool enable_local_log, std::string category,
@@ -230,6 +247,16 @@ public:
     static void SetTracePrint(bool enable);
     static void SetLoggingCategory(std::string category);
     static std::string LoggingCategory() { return logging_category_; }
+    // Systemlogs and objectlogs less severe than the minimum level are
+    // neither sent nor logged by the generated macros, without evaluating
+    // their arguments. Defaults to INVALID, everything is enabled, and the
+    // messages dropped for the sending level are still counted and logged
+    // as queue drops. Eliding them is opt-in.
+    static void SetMinLevel(SandeshLevel::type level);
+    static SandeshLevel::type MinLevel() { return min_level_; }
+    static inline bool IsLevelEnabled(SandeshLevel::type level) {
+        return level <= SANDESH_MIN_LOG_LEVEL && level <= min_level_;
+    }
 
     //GetSize method to report the size
     virtual size_t GetSize() const = 0;
@@ -286,13 +313,13 @@ public:
 
     // Accessors
     static void set_source(std::string &source) { source_ = source; }
-    static std::string source() { return source_; }
+    static const std::string &source() { return source_; }
     static void set_module(std::string &module) { module_ = module; }
-    static std::string module() { return module_; }
+    static const std::string &module() { return module_; }
     static void set_instance_id(std::string &instance_id) { instance_id_ = instance_id; }
-    static std::string instance_id() { return instance_id_; }
+    static const std::string &instance_id() { return instance_id_; }
     static void set_node_type(std::string &node_type) { node_type_ = node_type; }
-    static std::string node_type() { return node_type_; }
+    static const std::string &node_type() { return node_type_; }
     static SandeshRole::type role() { return role_; }
     static int http_port() { return http_port_; }
     static SandeshRxQueue* recv_queue() { return recv_queue_.get(); }
@@ -419,6 +446,7 @@ private:
     static SandeshLevel::type logging_level_; // current logging level
     static SandeshLevel::type logging_ut_level_; // ut_debug logging level
     static std::string logging_category_; // current logging category
+    static SandeshLevel::type min_level_; // level checked by the macros
     static bool enable_trace_print_; // whether to print traces locally
     static bool connect_to_collector_; // whether to connect to collector
     static EventManager *event_manager_;
@@ -444,6 +472,7 @@ private:
     std::string category_;
     std::string name_;
     static tbb::atomic<uint32_t> sandesh_send_ratelimit_;
+    static tbb::atomic<uint32_t> sandesh_send_flush_deadline_usec_;
     static bool slo_to_collector_;
     static bool sampled_to_collector_;
     static bool slo_to_logger_;
@@ -453,14 +482,19 @@ private:
 struct SandeshElement {
     Sandesh *snh_;
     //Explicit constructor creating only if Sandesh is passed as arg
-    explicit SandeshElement(Sandesh *snh):snh_(snh),size_(snh->GetSize()) {
+    explicit SandeshElement(Sandesh *snh):snh_(snh),size_(snh->GetSize()),
+        enqueue_time_(ClockMonotonicUsec()) {
     }
-    SandeshElement():size_(0) { }
+    SandeshElement():size_(0),enqueue_time_(0) { }
     size_t GetSize() const {
         return size_;
     }
+    uint64_t GetEnqueueTime() const {
+        return enqueue_time_;
+    }
     private:
         size_t size_;
+        uint64_t enqueue_time_;
 };
 
 template<>
@@ -529,9 +563,13 @@ class SandeshTrace : public Sandesh {
 public:
     const uint32_t seqnum() { return xseqnum_; }
     virtual void SendTrace(const std::string& context, bool more) = 0;
+    // Returns a default constructed trace of the same type, used to decode
+    // traces stored in binary trace buffers
+    virtual SandeshTrace *CreateEmpty() const { return NULL; }
     const bool get_more() const { return more_; }
     virtual ~SandeshTrace() {}
 protected:
+    friend class SandeshTraceCodec;
     SandeshTrace(const std::string& name, uint32_t seqno) :
         Sandesh(SandeshType::TRACE, name, 0), xseqnum_(0), more_(true) {}
     bool Dispatch(SandeshConnection * sconn = NULL);
@@ -359,7 +359,7 @@ struct Connect : public sc::state<Connect, SandeshClientSMImpl> {
             std::string(), ConnectionStatus::INIT, session->remote_endpoint(),
             state_machine->StateName() + " : " + event.Name());       
         // Start the send queue runner XXX move this to Established or later
-        session->send_queue()->MayBeStartRunner();
+        session->MayBeStartSendQueueRunner();
         return transit<ClientInit>();
     }
 
@@ -103,7 +103,8 @@ protected:
     }
 
     bool send_session(Sandesh *snh) {
-        return snh->Enqueue(session_->send_queue());
+        session_->EnqueueSandesh(snh);
+        return true;
     }
 
     void set_server(TcpServer::Endpoint e) {
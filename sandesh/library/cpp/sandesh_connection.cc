@@ -84,8 +84,7 @@ bool SandeshConnection::SendSandesh(Sandesh *snh) {
         return false;
     }
     // XXX No bounded work queue
-    SandeshElement element(snh);
-    session_->send_queue()->Enqueue(element);
+    session_->EnqueueSandesh(snh);
     return true;
 }
 
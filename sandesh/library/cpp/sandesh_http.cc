@@ -18,12 +18,14 @@
 #include <cstdlib>
 #include <boost/bind.hpp>
 #include <boost/tokenizer.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 
 #include <sandesh/sandesh_types.h>
 #include <sandesh/sandesh.h>
 #include <sandesh/sandesh_http.h>
 #include <sandesh/transport/TBufferTransports.h>
 #include <sandesh/protocol/TXMLProtocol.h>
+#include <sandesh/protocol/TJSONProtocol.h>
 #include "sandesh_client.h"
 #include <sandesh/sandesh_trace.h>
 #include <sandesh/sandesh_trace_types.h>
@@ -31,6 +33,7 @@
 #include "http/http_request.h"
 #include "http/http_server.h"
 #include "http/http_session.h"
+#include "base/task.h"
 
 #include "css_bootstrap_min_css.cpp"
 #include "css_DT_bootstrap_css.cpp"
@@ -61,9 +64,6 @@ string SandeshHttp::index_str_;
 SandeshHttp::HtmlInfo *SandeshHttp::index_hti_ = NULL;
 
 
-#define SESSION_SEND(buf) \
-    HttpSession::SendSession(context,reinterpret_cast<const u_int8_t *>(buf), strlen(buf), NULL)
-
 enum HttpXMLState {
     HXMLInvalid,
     HXMLNew,
@@ -71,8 +71,32 @@ enum HttpXMLState {
     HXMLMax
 };
 
+// Serializes the responses sent on all sessions
+static tbb::mutex hmutex;
+
+// Returns the state of the response being sent on the session, recording
+// name as the response in progress if it is a new one. Returns HXMLInvalid
+// if the session is gone.
+// Must be called with hmutex held.
+//
+static HttpXMLState
+HttpResponseState(const std::string& context, const std::string& name,
+                  std::string *client_ctx) {
+    *client_ctx = HttpSession::get_client_context(context);
+    if (!client_ctx->empty()) {
+        return HXMLIncomplete;
+    }
+    *client_ctx = name;
+    if (!HttpSession::set_client_context(context, *client_ctx)) {
+        return HXMLInvalid;
+    }
+    return HXMLNew;
+}
+
 // Helper function for forming HTTP headers and sending a bytestream
-// for XML
+// for XML. A response with more content coming is sent using chunked
+// transfer-encoding, each page being written to the session as one chunk
+// as soon as it is produced.
 //
 // Arguments:
 //   context : handle to Session on which to send bytestream
@@ -85,7 +109,6 @@ static void
 HttpSendXML(const std::string& context, const u_int8_t * buf, uint32_t len,
             const char * name, bool more) {
 
-    char buffer_str[100];
     char length_str[80];
     static const char xsl_response[] =
 "HTTP/1.1 200 OK\r\n"
@@ -95,122 +118,148 @@ HttpSendXML(const std::string& context, const u_int8_t * buf, uint32_t len,
 "HTTP/1.1 200 OK\r\n"
 "Content-Type: text/xml\r\n"
 "Transfer-Encoding: chunked\r\n\r\n"
+;
+    static const char xsl_stylesheet[] =
+"<?xml-stylesheet type=\"text/xsl\" href=\"/universal_parse.xsl\"?>"
 ;
     char resp_name[40];
     int loc = strcspn(reinterpret_cast<const char *>(buf)," ");
     strncpy(resp_name, reinterpret_cast<const char *>(buf + 1), loc - 1);
     resp_name[loc - 1] = 0;
 
-    static tbb::mutex hmutex;
-    static int seq = 0;
     tbb::mutex::scoped_lock lock(hmutex);
     std::string client_ctx;
-    seq++;
-
-    client_ctx = HttpSession::get_client_context(context);
-    HttpXMLState state;
+    HttpXMLState state = HttpResponseState(context, resp_name, &client_ctx);
 
-    // Calculate current state;
-    if (!client_ctx.empty()) {
-        state = HXMLIncomplete;
-    } else {
-        state = HXMLNew;
-        client_ctx = resp_name;
+    // If the session is gone, we can stop processing.
+    if (HXMLInvalid == state)
+        return;
 
-        // If the session is gone, we can stop processing.
-        if (!HttpSession::set_client_context(context, client_ctx))
-            return;
-    }
+    // Headers, page and trailer are sent in a single write
+    std::string out;
+    out.reserve(len + sizeof(chunk_response) + sizeof(xsl_stylesheet) +
+                2 * client_ctx.size() + 64);
 
     if ((HXMLNew == state) && (!more)) {
         // This is the first and last chunk of this response
-
-        SESSION_SEND(xsl_response);
-
-        size_t total_len = len;
-        sprintf(buffer_str,
-            "<?xml-stylesheet type=\"text/xsl\" href=\"/universal_parse.xsl\"?>"
-            );
-        sprintf(length_str,
-                "Content-Length: %zu\r\n\r\n", total_len + strlen(buffer_str));
-        SESSION_SEND(length_str);
-        SESSION_SEND(buffer_str);
-
-        HttpSession::SendSession(context, buf, len, NULL);
-
-    } else if ((HXMLNew == state) && more) {
-        // This is the first chunk of this response
-        SESSION_SEND(chunk_response);
-
-        // Calculation for Header
-        sprintf(buffer_str,
-            "<?xml-stylesheet type=\"text/xsl\" href=\"/universal_parse.xsl\"?>"
-            );
-        int hdr_len = strlen(buffer_str);
-        sprintf(buffer_str,
-            "<__%s_list type=\"slist\">\r\n", client_ctx.c_str());
-        hdr_len += (strlen(buffer_str) - 2);
-
-        sprintf(length_str, "%x\r\n", hdr_len);
-        SESSION_SEND(length_str);
-
-        sprintf(buffer_str,
-            "<?xml-stylesheet type=\"text/xsl\" href=\"/universal_parse.xsl\"?>"
-            );
-        SESSION_SEND(buffer_str);
-
-        sprintf(buffer_str,
-            "<__%s_list type=\"slist\">\r\n", client_ctx.c_str());
-        SESSION_SEND(buffer_str);
-
+        out.append(xsl_response);
+        snprintf(length_str, sizeof(length_str), "Content-Length: %zu\r\n\r\n",
+                 len + strlen(xsl_stylesheet));
+        out.append(length_str);
+        out.append(xsl_stylesheet);
+        out.append(reinterpret_cast<const char *>(buf), len);
+    } else {
+        if (HXMLNew == state) {
+            // This is the first chunk of this response. The CRLF ending
+            // the list element also ends the header chunk.
+            std::string list_hdr("<__" + client_ctx +
+                                 "_list type=\"slist\">\r\n");
+            out.append(chunk_response);
+            snprintf(length_str, sizeof(length_str), "%zx\r\n",
+                     strlen(xsl_stylesheet) + list_hdr.size() - 2);
+            out.append(length_str);
+            out.append(xsl_stylesheet);
+            out.append(list_hdr);
+        }
 
         // Calculation for Data
-        sprintf(length_str, "%x\r\n", len);
-        SESSION_SEND(length_str);
-
-        HttpSession::SendSession(context, buf, len, NULL);
+        snprintf(length_str, sizeof(length_str), "%x\r\n", len);
+        out.append(length_str);
+        out.append(reinterpret_cast<const char *>(buf), len);
+        out.append("\r\n");
+
+        if (!more) {
+            // This is the last chunk of this response
+            std::string list_ftr("</__" + client_ctx + "_list>\r\n");
+            snprintf(length_str, sizeof(length_str), "%zx\r\n",
+                     list_ftr.size() - 2);
+            out.append(length_str);
+            out.append(list_ftr);
+            out.append("0\r\n\r\n");
+        }
+    }
 
-        sprintf(buffer_str,"\r\n");
-        SESSION_SEND(buffer_str);
+    HttpSession::SendSession(context,
+        reinterpret_cast<const u_int8_t *>(out.data()), out.size(), NULL);
 
-    } else if ((HXMLIncomplete == state) && !more) {
-        // This is the last chunk of this response
+    // Update context for other users
+    if (!more) {
+        HttpSession::set_client_context(context,"");
+    }
+}
 
-        // Calculation for Data
-        sprintf(length_str, "%x\r\n", len);
-        SESSION_SEND(length_str);
+// Helper function for forming HTTP headers and sending a bytestream
+// for JSON. The pages of a multi-page response are sent as the elements
+// of a JSON array, each one as a chunk of the chunked transfer-encoding.
+//
+// Arguments:
+//   context : handle to Session on which to send bytestream
+//   buf : Buffer that contains JSON payload
+//   len : length of buffer
+//   name : Name of the Sandesh
+//   more : This is true if there is more content coming for this response
+//
+static void
+HttpSendJSON(const std::string& context, const u_int8_t * buf, uint32_t len,
+             const std::string& name, bool more) {
 
-        HttpSession::SendSession(context, buf, len, NULL);
+    char length_str[80];
+    static const char json_response[] =
+"HTTP/1.1 200 OK\r\n"
+"Content-Type: application/json\r\n"
+;
+    static const char chunk_response[] =
+"HTTP/1.1 200 OK\r\n"
+"Content-Type: application/json\r\n"
+"Transfer-Encoding: chunked\r\n\r\n"
+;
+    static const char chunk_footer[] =
+"1\r\n]\r\n"
+"0\r\n\r\n"
+;
 
-        sprintf(buffer_str,"\r\n");
-        SESSION_SEND(buffer_str);
+    tbb::mutex::scoped_lock lock(hmutex);
+    std::string client_ctx;
+    HttpXMLState state = HttpResponseState(context, name, &client_ctx);
 
-        //Calculation for Footer
-        sprintf(buffer_str,"</__%s_list>\r\n", client_ctx.c_str());
-        sprintf(length_str, "%zx\r\n", strlen(buffer_str) - 2);
-        SESSION_SEND(length_str);
-        SESSION_SEND(buffer_str);
+    // If the session is gone, we can stop processing.
+    if (HXMLInvalid == state)
+        return;
 
-        sprintf(length_str, "0\r\n\r\n");
-        SESSION_SEND(length_str);
-    } else if ((HXMLIncomplete == state) && more) {
-        // This is a middle chunk of the response
+    // Headers, page and trailer are sent in a single write
+    std::string out;
+    out.reserve(len + sizeof(chunk_response) + sizeof(chunk_footer) + 32);
 
-        // Calculation for Data
-        sprintf(length_str, "%x\r\n", len);
-        SESSION_SEND(length_str);
+    if ((HXMLNew == state) && (!more)) {
+        // This is the first and last chunk of this response
+        out.append(json_response);
+        snprintf(length_str, sizeof(length_str), "Content-Length: %u\r\n\r\n",
+                 len);
+        out.append(length_str);
+        out.append(reinterpret_cast<const char *>(buf), len);
+    } else {
+        if (HXMLNew == state) {
+            out.append(chunk_response);
+        }
+        // Page, preceded by the opening bracket or the separator
+        snprintf(length_str, sizeof(length_str), "%x\r\n", len + 1);
+        out.append(length_str);
+        out.append(1, (HXMLNew == state) ? '[' : ',');
+        out.append(reinterpret_cast<const char *>(buf), len);
+        out.append("\r\n");
+        if (!more) {
+            // This is the last chunk of this response
+            out.append(chunk_footer);
+        }
+    }
 
-        HttpSession::SendSession(context, buf, len, NULL);
+    HttpSession::SendSession(context,
+        reinterpret_cast<const u_int8_t *>(out.data()), out.size(), NULL);
 
-        sprintf(buffer_str,"\r\n");
-        SESSION_SEND(buffer_str);
-    }
     // Update context for other users
     if (!more) {
-        client_ctx = resp_name;
         HttpSession::set_client_context(context,"");
     }
-
 }
 
 // Function for HTTP Server to call when HTTP Client Requests a .sandesh module
@@ -265,6 +314,44 @@ HttpSandeshFileCallback(SandeshHttp::HtmlInfo *hti,
 
 SandeshHttp::RequestCallbackFn httpreqcb;
 
+// Returns the format in which the client wants the response, "json" if
+// requested with a format=json query parameter or an Accept header, empty
+// for the default XML. The format parameter, which is not a field of the
+// Sandesh Request, is removed from the query.
+//
+static string
+HttpRequestFormat(const HttpRequest *request, string *query) {
+    static const string kFormatParam("format=");
+    string format;
+    string snh_query;
+    boost::char_separator<char> sep("&");
+    boost::tokenizer<boost::char_separator<char> > tokens(*query, sep);
+    for (boost::tokenizer<boost::char_separator<char> >::iterator it =
+         tokens.begin(); it != tokens.end(); ++it) {
+        if (it->compare(0, kFormatParam.size(), kFormatParam) == 0) {
+            format = it->substr(kFormatParam.size());
+            continue;
+        }
+        if (!snh_query.empty()) {
+            snh_query += '&';
+        }
+        snh_query += *it;
+    }
+    *query = snh_query;
+    if (format.empty()) {
+        const HttpRequest::HeaderMap &headers = request->Headers();
+        for (HttpRequest::HeaderMap::const_iterator it = headers.begin();
+             it != headers.end(); ++it) {
+            if (boost::iequals(it->first, "Accept") &&
+                it->second.find("application/json") != string::npos) {
+                format = "json";
+                break;
+            }
+        }
+    }
+    return (format == "json") ? format : string();
+}
+
 // Function for HTTP Server to call when HTTP Client sends a Sandesh Request
 //
 // Arguments:
@@ -279,6 +366,7 @@ HttpSandeshRequestCallback(HttpServer *hs,
         const HttpRequest *request) {
 
     string snh_name = request->UrlPath().substr(5);
+    string snh_query = request->UrlQuery();
     Sandesh *sandesh = SandeshBaseFactory::CreateInstance(snh_name);
     if (sandesh == NULL) {
         SANDESH_LOG(DEBUG, __func__ << " Unknown sandesh:" <<
@@ -287,7 +375,9 @@ HttpSandeshRequestCallback(HttpServer *hs,
     }
     SandeshRequest *rsnh = dynamic_cast<SandeshRequest *>(sandesh);
     assert(rsnh);
-    rsnh->RequestFromHttp(session->get_context(), request->UrlQuery());
+    HttpSession::set_client_format(session->get_context(),
+        HttpRequestFormat(request, &snh_query));
+    rsnh->RequestFromHttp(session->get_context(), snh_query);
     httpreqcb(rsnh);
     delete request;
 }
@@ -327,18 +417,106 @@ SandeshHttp::Response(Sandesh *snh, std::string context) {
     boost::shared_ptr<TMemoryBuffer> btrans =
             boost::shared_ptr<TMemoryBuffer>(
                     new TMemoryBuffer(kEncodeBufferSize));
-    boost::shared_ptr<TXMLProtocol> prot =
-            boost::shared_ptr<TXMLProtocol>(
-                    new TXMLProtocol(btrans));
+    bool json = (HttpSession::get_client_format(context) == "json");
+    boost::shared_ptr<TProtocol> prot;
+    if (json) {
+        TJSONProtocol *jprot = new TJSONProtocol(btrans);
+        jprot->setJSONStringEscape(true);
+        prot.reset(jprot);
+    } else {
+        prot.reset(new TXMLProtocol(btrans));
+    }
     // Write the sandesh
     xfer += snh->Write(prot);
     // Get the buffer
     btrans->getBuffer(&buffer, &offset);
-    HttpSendXML(context, buffer, offset, snh->ModuleName().c_str(), more);
+    if (json) {
+        HttpSendJSON(context, buffer, offset, snh->Name(), more);
+    } else {
+        HttpSendXML(context, buffer, offset, snh->ModuleName().c_str(), more);
+    }
     buffer[offset] = 0;
     snh->Release();
 }
 
+// Runs the producer of a multi-page response, one page per task. After a
+// page, the next one is queued right away if the session can take more,
+// otherwise the session queues it from its write ready callback, so that
+// a slow client neither holds a task nor gets pages piled up in memory.
+class SandeshHttpStreamer {
+public:
+    typedef boost::shared_ptr<SandeshHttpStreamer> Ptr;
+
+    SandeshHttpStreamer(const std::string &context,
+                        SandeshHttp::PageProducerFn producer,
+                        int task_id, int task_instance) :
+        context_(context), producer_(producer),
+        task_id_(task_id), task_instance_(task_instance) {
+    }
+
+    static void Schedule(Ptr streamer) {
+        TaskScheduler::GetInstance()->Enqueue(new PageTask(streamer));
+    }
+
+private:
+    class PageTask : public Task {
+    public:
+        explicit PageTask(Ptr streamer) :
+            Task(streamer->task_id_, streamer->task_instance_),
+            streamer_(streamer) {
+        }
+        virtual bool Run() {
+            streamer_->ProducePage(streamer_);
+            return true;
+        }
+        std::string Description() const {
+            return "SandeshHttpStreamer::PageTask";
+        }
+    private:
+        Ptr streamer_;
+    };
+
+    void ProducePage(Ptr self) {
+        // Nobody to send the remaining pages to
+        if (!HttpSession::IsSessionOpen(context_)) {
+            return;
+        }
+        if (!producer_()) {
+            return;
+        }
+        if (HttpSession::NotifySessionWritable(context_,
+                boost::bind(&SandeshHttpStreamer::Schedule, self))) {
+            Schedule(self);
+        }
+    }
+
+    std::string context_;
+    SandeshHttp::PageProducerFn producer_;
+    int task_id_;
+    int task_instance_;
+
+    DISALLOW_COPY_AND_ASSIGN(SandeshHttpStreamer);
+};
+
+void
+SandeshHttp::StreamResponse(const std::string &context,
+                            PageProducerFn producer) {
+    int task_id;
+    int task_instance;
+    Task *task = Task::Running();
+    if (task) {
+        task_id = task->GetTaskId();
+        task_instance = task->GetTaskInstance();
+    } else {
+        task_id = TaskScheduler::GetInstance()->GetTaskId(
+            "http::RequestHandlerTask");
+        task_instance = -1;
+    }
+    SandeshHttpStreamer::Ptr streamer(new SandeshHttpStreamer(context,
+        producer, task_id, task_instance));
+    SandeshHttpStreamer::Schedule(streamer);
+}
+
 // This function should be called during Sandesh Generator Initialization
 // It initializes the HTTP Server and Registers callbacks for sandesh modules
 // and sandesh requests.
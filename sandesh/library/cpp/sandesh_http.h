@@ -25,8 +25,17 @@ class Sandesh;
 class SandeshHttp {
 public:
     typedef boost::function<int32_t(SandeshRequest *)> RequestCallbackFn;
+    // Sends the next page of a response with Response() and returns true
+    // if there are more pages to produce
+    typedef boost::function<bool(void)> PageProducerFn;
 
     static void Response(Sandesh *snh, std::string context);
+    // Produces a multi-page response one page per task, in the task id and
+    // instance of the caller. When the client does not keep up, the producer
+    // is parked and re-queued once the session has drained, instead of
+    // holding a task.
+    static void StreamResponse(const std::string &context,
+                               PageProducerFn producer);
     static bool Init(EventManager *evm, const std::string module,
         short port, RequestCallbackFn reqcb, int *hport,
         const SandeshConfig &config = SandeshConfig());
@@ -50,6 +50,14 @@ void AddOptions(opt::options_description *sandesh_options,
          opt::value<uint32_t>()->default_value(
          g_sandesh_constants.DEFAULT_SANDESH_SEND_RATELIMIT),
          "System logs send rate limit in messages per second per message type")
+        ("SANDESH.sandesh_send_flush_deadline",
+         opt::value<uint32_t>()->default_value(0),
+         "Time in microseconds for which sandesh messages are held back "
+         "to be sent along with the following ones")
+        ("DEFAULT.log_async_write",
+         opt::value<bool>()->default_value(false),
+         "Write the log file from a background thread, dropping log "
+         "records rather than blocking if the disk stalls")
         ("DEFAULT.http_server_ip",
          opt::value<std::string>()->default_value(
          "0.0.0.0"),
@@ -93,6 +101,10 @@ void ProcessOptions(const opt::variables_map &var_map,
                         "STATS.stats_collector");
     GetOptValue<uint32_t>(var_map, sandesh_config->system_logs_rate_limit,
                           "DEFAULT.sandesh_send_rate_limit");
+    GetOptValue<uint32_t>(var_map, sandesh_config->send_flush_deadline_usec,
+                          "SANDESH.sandesh_send_flush_deadline");
+    GetOptValue<bool>(var_map, sandesh_config->log_async_write,
+                      "DEFAULT.log_async_write");
     GetOptValue<std::string>(var_map, sandesh_config->http_server_ip,
                         "DEFAULT.http_server_ip");
     GetOptValue<bool>(var_map, sandesh_config->tcp_keepalive_enable,
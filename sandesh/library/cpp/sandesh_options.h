@@ -27,7 +27,9 @@ struct SandeshConfig {
         tcp_keepalive_probes(9),
         tcp_keepalive_interval(75),
         system_logs_rate_limit(
-            g_sandesh_constants.DEFAULT_SANDESH_SEND_RATELIMIT) {
+            g_sandesh_constants.DEFAULT_SANDESH_SEND_RATELIMIT),
+        send_flush_deadline_usec(0),
+        log_async_write(false) {
     }
     ~SandeshConfig() {
     }
@@ -48,6 +50,10 @@ struct SandeshConfig {
     int tcp_keepalive_probes;
     int tcp_keepalive_interval;
     uint32_t system_logs_rate_limit;
+    uint32_t send_flush_deadline_usec;
+    // Passed to LoggingInit() to write the log file from a background
+    // thread
+    bool log_async_write;
 };
 
 namespace sandesh {
@@ -20,6 +20,29 @@ using boost::asio::ip::address;
 
 int PullSandeshGenStatsReq = 0;
 
+static void GetSendLaneStats(SandeshSession *ssession,
+    std::vector<SandeshSendLaneStats> *lane_stats) {
+    for (int i = 0; i < SandeshSession::SendLane::MAX; i++) {
+        SandeshSession::SendLane::type lane(
+            static_cast<SandeshSession::SendLane::type>(i));
+        Sandesh::SandeshQueue *queue(ssession->send_queue(lane));
+        SandeshQueueStats qstats;
+        qstats.set_enqueues(queue->NumEnqueues());
+        qstats.set_count(queue->Length());
+        qstats.set_max_count(queue->max_queue_len());
+        const SandeshSession::SendLaneStats &sstats(
+            ssession->GetSendLaneStats(lane));
+        SandeshSendLaneStats lstats;
+        lstats.set_lane(SandeshSession::SendLaneName(lane));
+        lstats.set_queue_stats(qstats);
+        lstats.set_messages_sent(sstats.num_send_msg);
+        lstats.set_latency_avg_usec(sstats.num_send_msg ?
+            sstats.latency_usec_total / sstats.num_send_msg : 0);
+        lstats.set_latency_max_usec(sstats.latency_usec_max);
+        lane_stats->push_back(lstats);
+    }
+}
+
 void SandeshMessageStatsReq::HandleRequest() const {
     SandeshMessageStatsResp *resp(new SandeshMessageStatsResp);
     std::vector<SandeshMessageTypeStats> mtype_stats;
@@ -36,11 +59,14 @@ void SandeshMessageStatsReq::HandleRequest() const {
         SandeshSession *ssession(client->session());
         if (ssession) {
             SandeshQueueStats qstats;
-            qstats.set_enqueues(ssession->send_queue()->NumEnqueues());
-            qstats.set_count(ssession->send_queue()->Length());
-            qstats.set_max_count(ssession->send_queue()->max_queue_len());
+            qstats.set_enqueues(ssession->SendQueueNumEnqueues());
+            qstats.set_count(ssession->SendQueueLength());
+            qstats.set_max_count(ssession->SendQueueMaxLength());
             resp->set_send_queue_stats(qstats);
             resp->set_sending_level(LevelToString(ssession->SendingLevel()));
+            std::vector<SandeshSendLaneStats> lane_stats;
+            GetSendLaneStats(ssession, &lane_stats);
+            resp->set_send_lane_stats(lane_stats);
         }
     }
     resp->set_stats(sandesh_stats);
@@ -13,6 +13,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include <base/parse_object.h>
+#include <base/timer.h>
 
 #include <sandesh/common/vns_types.h>
 #include <sandesh/common/vns_constants.h>
@@ -38,18 +39,197 @@ const std::string SandeshWriter::sandesh_open_attr_length_ =
         sXML_SANDESH_OPEN_ATTR_LENGTH;
 const std::string SandeshWriter::sandesh_close_ = sXML_SANDESH_CLOSE;
 
+//
+// SandeshHeaderEncoder
+//
+static int32_t WriteHeaderStringField(TXMLProtocol *prot, const char *name,
+        int16_t id, const std::string &value) {
+    int32_t xfer = 0, ret;
+    if ((ret = prot->writeFieldBegin(name, T_STRING, id)) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = prot->writeString(value)) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = prot->writeFieldEnd()) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    return xfer;
+}
+
+static int32_t WriteHeaderI32Field(TXMLProtocol *prot, const char *name,
+        int16_t id, int32_t value) {
+    int32_t xfer = 0, ret;
+    if ((ret = prot->writeFieldBegin(name, T_I32, id)) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = prot->writeI32(value)) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = prot->writeFieldEnd()) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    return xfer;
+}
+
+static int32_t WriteHeaderI64Field(TXMLProtocol *prot, const char *name,
+        int16_t id, int64_t value) {
+    int32_t xfer = 0, ret;
+    if ((ret = prot->writeFieldBegin(name, T_I64, id)) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = prot->writeI64(value)) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = prot->writeFieldEnd()) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    return xfer;
+}
+
+static int32_t WriteHeaderCachedFields(TMemoryBuffer *btrans,
+        const std::string &xml) {
+    uint8_t *buffer = btrans->getWritePtr(xml.length());
+    memcpy(buffer, xml.c_str(), xml.length());
+    btrans->wroteBytes(xml.length());
+    return xml.length();
+}
+
+SandeshHeaderEncoder::SandeshHeaderEncoder()
+    : cache_valid_(false),
+      cache_update_count_(0) {
+}
+
+bool SandeshHeaderEncoder::IsCacheValid() const {
+    return cache_valid_ &&
+        module_ == Sandesh::module() &&
+        source_ == Sandesh::source() &&
+        node_type_ == Sandesh::node_type() &&
+        instance_id_ == Sandesh::instance_id();
+}
+
+bool SandeshHeaderEncoder::UpdateCache() {
+    cache_valid_ = false;
+    module_ = Sandesh::module();
+    source_ = Sandesh::source();
+    node_type_ = Sandesh::node_type();
+    instance_id_ = Sandesh::instance_id();
+    boost::shared_ptr<TMemoryBuffer> btrans(new TMemoryBuffer(512));
+    boost::shared_ptr<TXMLProtocol> prot(new TXMLProtocol(btrans));
+    if (WriteHeaderStringField(prot.get(), "Module", 3, module_) < 0 ||
+        WriteHeaderStringField(prot.get(), "Source", 4, source_) < 0) {
+        return false;
+    }
+    module_source_xml_.clear();
+    btrans->appendBufferToString(module_source_xml_);
+    btrans->resetBuffer();
+    if (WriteHeaderStringField(prot.get(), "NodeType", 12, node_type_) < 0 ||
+        WriteHeaderStringField(prot.get(), "InstanceId", 13,
+            instance_id_) < 0) {
+        return false;
+    }
+    node_type_instance_id_xml_.clear();
+    btrans->appendBufferToString(node_type_instance_id_xml_);
+    cache_valid_ = true;
+    cache_update_count_++;
+    return true;
+}
+
+// Produces the same encoding as SandeshHeader::write() for the header
+// populated from the sandesh, and returns the number of bytes written
+// on success, -1 otherwise
+int32_t SandeshHeaderEncoder::Write(Sandesh *sandesh, TXMLProtocol *prot,
+        TMemoryBuffer *btrans) {
+    int32_t xfer = 0, ret;
+    if (!IsCacheValid() && !UpdateCache()) {
+        return -1;
+    }
+    if ((ret = prot->writeStructBegin("SandeshHeader")) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = WriteHeaderStringField(prot, "Namespace", 1,
+            sandesh->scope())) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = WriteHeaderI64Field(prot, "Timestamp", 2,
+            sandesh->timestamp())) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    xfer += WriteHeaderCachedFields(btrans, module_source_xml_);
+    if ((ret = WriteHeaderStringField(prot, "Context", 5,
+            sandesh->context())) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = WriteHeaderI32Field(prot, "SequenceNum", 6,
+            sandesh->seqnum())) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = WriteHeaderI32Field(prot, "VersionSig", 7,
+            sandesh->versionsig())) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = WriteHeaderI32Field(prot, "Type", 8,
+            (int32_t)sandesh->type())) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = WriteHeaderI32Field(prot, "Hints", 9,
+            sandesh->hints())) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = WriteHeaderI32Field(prot, "Level", 10,
+            (int32_t)sandesh->level())) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = WriteHeaderStringField(prot, "Category", 11,
+            sandesh->category())) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    xfer += WriteHeaderCachedFields(btrans, node_type_instance_id_xml_);
+    if ((ret = prot->writeFieldStop()) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    if ((ret = prot->writeStructEnd()) < 0) {
+        return ret;
+    }
+    xfer += ret;
+    return xfer;
+}
+
 //
 // SandeshWriter
 //
-SandeshWriter::SandeshWriter(SandeshSession *session)
+SandeshWriter::SandeshWriter(SandeshSession *session, int task_id,
+        int task_instance)
     : session_(session),
     ready_to_send_(true),
-    send_buf_(new uint8_t[kDefaultSendSize]),
-    send_buf_offset_(0) {
+    batch_start_usec_(0),
+    flush_timer_(TimerManager::CreateTimer(
+        *session->server()->event_manager()->io_service(),
+        "SandeshWriter flush timer", task_id, task_instance)) {
 }
 
 SandeshWriter::~SandeshWriter() {
-    delete [] send_buf_;
+    TimerManager::DeleteTimer(flush_timer_);
 }
 
 void SandeshWriter::WriteReady(const boost::system::error_code &ec) {
@@ -67,40 +247,60 @@ void SandeshWriter::WriteReady(const boost::system::error_code &ec) {
     }
 
     // We may want to start the Runner for the send_queue
-    session_->send_queue()->MayBeStartRunner();
+    session_->MayBeStartSendQueueRunner();
+}
+
+void SandeshWriter::AllocBatch() {
+    batch_.btrans.reset(new TMemoryBuffer(kEncodeBufferSize));
+    batch_.prot.reset(new TXMLProtocol(batch_.btrans));
+    session_->increment_send_encode_buffer_alloc();
+}
+
+// The batch has been handed over to the session, so the buffer can be
+// reused unless a large message has grown it beyond kMaxBatchBufferSize.
+void SandeshWriter::ResetBatch() {
+    batch_.btrans->resetBuffer();
+    if (batch_.btrans->available_write() > kMaxBatchBufferSize) {
+        batch_.btrans.reset();
+        batch_.prot.reset();
+    }
 }
 
+// Write the message length, zero padded, into the sandesh open envelope
+static void WriteSandeshOpenLength(uint8_t *buffer, uint32_t length) {
+    // Adjust for '">'
+    size_t width = SandeshWriter::sandesh_open_.length() -
+        SandeshWriter::sandesh_open_attr_length_.length() - 2;
+    uint8_t *cp = buffer + SandeshWriter::sandesh_open_attr_length_.length() +
+        width;
+    for (size_t i = 0; i < width; i++) {
+        *--cp = '0' + (length % 10);
+        length /= 10;
+    }
+}
+
+// Encode the message at the end of the batch, right after the messages
+// that have not been sent yet.
 void SandeshWriter::SendMsg(Sandesh *sandesh, bool more) {
-    SandeshHeader header;
-    std::stringstream ss;
     uint8_t *buffer;
     int32_t xfer = 0, ret;
-    uint32_t offset;
-    boost::shared_ptr<TMemoryBuffer> btrans(
-                    new TMemoryBuffer(kEncodeBufferSize));
-    boost::shared_ptr<TXMLProtocol> prot(
-                    new TXMLProtocol(btrans));
-    // Populate the header
-    header.set_Namespace(sandesh->scope());
-    header.set_Timestamp(sandesh->timestamp());
-    header.set_Module(sandesh->module());
-    header.set_Source(sandesh->source());
-    header.set_Context(sandesh->context());
-    header.set_SequenceNum(sandesh->seqnum());
-    header.set_VersionSig(sandesh->versionsig());
-    header.set_Type(sandesh->type());
-    header.set_Hints(sandesh->hints());
-    header.set_Level(sandesh->level());
-    header.set_Category(sandesh->category());
-    header.set_NodeType(sandesh->node_type());
-    header.set_InstanceId(sandesh->instance_id());
+    uint32_t start, offset;
+    if (!batch_.btrans) {
+        AllocBatch();
+    }
+    TMemoryBuffer *btrans = batch_.btrans.get();
+    start = btrans->available_read();
+    if (start == 0) {
+        batch_start_usec_ = ClockMonotonicUsec();
+    }
 
     // Write the sandesh open envelope.
     buffer = btrans->getWritePtr(sandesh_open_.length());
     memcpy(buffer, sandesh_open_.c_str(), sandesh_open_.length());
     btrans->wroteBytes(sandesh_open_.length());
     // Write the sandesh header
-    if ((ret = header.write(prot)) < 0) {
+    if ((ret = header_encoder_.Write(sandesh, batch_.prot.get(),
+                                     btrans)) < 0) {
         SANDESH_LOG(ERROR, __func__ << ": Sandesh header write FAILED: " <<
             sandesh->Name() << " : " << sandesh->source() << ":" <<
             sandesh->module() << ":" << sandesh->instance_id() <<
@@ -108,12 +308,15 @@ void SandeshWriter::SendMsg(Sandesh *sandesh, bool more) {
         session_->increment_send_msg_fail();
         Sandesh::UpdateTxMsgFailStats(sandesh->Name(), 0,
             SandeshTxDropReason::HeaderWriteFailed);
+        // Drop the partially encoded message
+        btrans->truncate(start);
+        batch_.prot.reset(new TXMLProtocol(batch_.btrans));
         sandesh->Release();
         return;
     }
     xfer += ret;
     // Write the sandesh
-    if ((ret = sandesh->Write(prot)) < 0) {
+    if ((ret = sandesh->Write(batch_.prot)) < 0) {
         SANDESH_LOG(ERROR, __func__ << ": Sandesh write FAILED: "<<
             sandesh->Name() << " : " << sandesh->source() << ":" <<
             sandesh->module() << ":" << sandesh->instance_id() <<
@@ -121,6 +324,9 @@ void SandeshWriter::SendMsg(Sandesh *sandesh, bool more) {
         session_->increment_send_msg_fail();
         Sandesh::UpdateTxMsgFailStats(sandesh->Name(), 0,
             SandeshTxDropReason::WriteFailed);
+        // Drop the partially encoded message
+        btrans->truncate(start);
+        batch_.prot.reset(new TXMLProtocol(batch_.btrans));
         sandesh->Release();
         return;
     }
@@ -131,163 +337,179 @@ void SandeshWriter::SendMsg(Sandesh *sandesh, bool more) {
     btrans->wroteBytes(sandesh_close_.length());
     // Get the buffer
     btrans->getBuffer(&buffer, &offset);
+    offset -= start;
     // Sanity
     assert(sandesh_open_.length() + xfer + sandesh_close_.length() ==
             offset);
     // Update the sandesh open envelope length;
-    char prev = ss.fill('0');
-    // Adjust for '">'
-    ss.width(sandesh_open_.length() - sandesh_open_attr_length_.length() - 2);
-    ss << offset;
-    ss.fill(prev);
-    memcpy(buffer + sandesh_open_attr_length_.length(), ss.str().c_str(),
-            ss.str().length());
+    WriteSandeshOpenLength(buffer + start, offset);
 
     // Update sandesh stats
     Sandesh::UpdateTxMsgStats(sandesh->Name(), offset);
     session_->increment_send_msg();
-
-    if (send_buf()) {
-        if (more) {
-            // There are more messages in the send_queue_.
-            // Try to package as many sandesh messages as possible
-            // (== kEncodeBufferSize) before transporting to the
-            // receiver.
-            SendMsgMore(btrans);
-        } else {
-            // send_queue_ is empty. Flush sandesh->send_buf_ and this message.
-            SendMsgAll(btrans);
-        }
-    } else {
-        // Send the message
-        SendInternal(btrans);
-    }
     sandesh->Release();
+
+    ProcessBatch(start, more);
 }
 
-// Package as many sandesh messages as possible [not more than
-// kEncodeBufferSize] before transporting it to the receiver.
-//
-// send_buf_ => unsent data (partial/complete message).
-// buf => new message
-// buf_len => buf's len
+// There are more messages in the send_queue_.
+// Add this message to the batch of unsent messages.
 void SandeshWriter::SendMsgMore(boost::shared_ptr<TMemoryBuffer>
                                             send_buffer) {
+    AppendToBatch(send_buffer, true);
+}
+
+// sandesh->send_queue_ is empty.
+// Flush unsent messages (if any) and this message.
+void SandeshWriter::SendMsgAll(boost::shared_ptr<TMemoryBuffer> send_buffer) {
+    AppendToBatch(send_buffer, false);
+}
+
+void SandeshWriter::AppendToBatch(boost::shared_ptr<TMemoryBuffer>
+                                  send_buffer, bool more) {
     uint8_t *buf;
     uint32_t buf_len;
 
     send_buffer->getBuffer(&buf, &buf_len);
 
-    if (send_buf_offset()) {
-        // We have some unsent data.
-        size_t bulk_msg_len = send_buf_offset() + buf_len;
-        if (bulk_msg_len < kDefaultSendSize) {
-            // We still have space for more data. Don't send the message yet.
-            // Add the message to the existing data.
-            append_send_buf(buf, buf_len);
-        } else {
-            uint8_t *buffer;
-            // (send_buf_offset() + buf_len) >= kDefaultSendSize
-            boost::shared_ptr<TMemoryBuffer> bulk_msg(
-                    new TMemoryBuffer(send_buf_offset()));
-            buffer = bulk_msg->getWritePtr(send_buf_offset());
-            // Copy unsent data
-            memcpy(buffer, send_buf(), send_buf_offset());
-            bulk_msg->wroteBytes(send_buf_offset());
-            // Send it
-            SendInternal(bulk_msg);
-            // Cleanup send_buf
-            reset_send_buf();
-            // Next send the new message
+    uint32_t start = send_buf_offset();
+    if (start == 0) {
+        // We don't have any unsent data. Send the message now, without
+        // copying it, if it would be flushed right away.
+        if (buf_len >= kDefaultSendSize) {
             SendInternal(send_buffer);
+            session_->increment_send_flush(FlushReason::BATCH_FULL);
+            return;
         }
-    } else {
-        // We don't have any unsent data.
-        if (buf_len >= kDefaultSendSize) {
-            // We don't have room to accommodate anything more.
-            // Send the message now.
+        if (!more && Sandesh::get_send_flush_deadline() == 0) {
             SendInternal(send_buffer);
-        } else {
-            // We have room to accommodate more data.
-            // Save this message.
-            // Note: The memcpy here can be avoided by passing send_buf_
-            // to TMemoryBuffer so that the message is encoded in
-            // send_buf_ itself.
-            set_send_buf(buf, buf_len);
+            session_->increment_send_flush(FlushReason::QUEUE_EMPTY);
+            return;
         }
+        batch_start_usec_ = ClockMonotonicUsec();
+    }
+    if (!batch_.btrans) {
+        AllocBatch();
     }
+    batch_.btrans->write(buf, buf_len);
+    ProcessBatch(start, more);
 }
 
-// sandesh->send_queue_ is empty.
-// Flush unsent data (if any) and this message.
-void SandeshWriter::SendMsgAll(boost::shared_ptr<TMemoryBuffer> send_buffer) {
+// The message at [start, end) of the batch has just been added.
+//
+// The batch is sent once it reaches kDefaultSendSize. Otherwise, when
+// there are no more messages to send, it is sent right away, or when the
+// flush deadline of its first message expires if one is configured.
+// A message that takes the batch beyond kDefaultSendSize is sent on its
+// own, right after the messages before it.
+void SandeshWriter::ProcessBatch(uint32_t start, bool more) {
+    uint32_t end = send_buf_offset();
+    uint32_t deadline = Sandesh::get_send_flush_deadline();
+
+    if (more) {
+        if (end >= kDefaultSendSize) {
+            FlushBatch(start, FlushReason::BATCH_FULL);
+            return;
+        }
+    } else {
+        if (start && end > kDefaultSendSize) {
+            FlushBatch(start, FlushReason::BATCH_FULL);
+            return;
+        }
+        if (end >= kDefaultSendSize) {
+            FlushBatch(0, FlushReason::BATCH_FULL);
+            return;
+        }
+        if (deadline == 0) {
+            FlushBatch(0, FlushReason::QUEUE_EMPTY);
+            return;
+        }
+    }
+    if (deadline == 0) {
+        return;
+    }
+    uint64_t deadline_usec = batch_start_usec_ + deadline;
+    if (ClockMonotonicUsec() >= deadline_usec) {
+        FlushBatch(0, FlushReason::DEADLINE);
+        return;
+    }
+    if (!more) {
+        StartFlushTimer(deadline_usec);
+    }
+}
+
+// Hand the batch over to the session. If split is not 0, the message
+// starting at split is sent separately after the ones before it.
+void SandeshWriter::FlushBatch(uint32_t split, FlushReason::type reason) {
     uint8_t *buf;
-    uint32_t buf_len;
+    uint32_t len;
+    batch_.btrans->getBuffer(&buf, &len);
+    if (split) {
+        SendInternal(buf, split);
+        SendInternal(buf + split, len - split);
+    } else {
+        SendInternal(buf, len);
+    }
+    session_->increment_send_flush(reason);
+    ResetBatch();
+}
 
-    send_buffer->getBuffer(&buf, &buf_len);
+// The timer is left alone if it is already running or has fired, and
+// FlushTimerExpired() then takes care of the current batch.
+void SandeshWriter::StartFlushTimer(uint64_t deadline_usec) {
+    uint64_t now(ClockMonotonicUsec());
+    int timeout_ms = deadline_usec > now ?
+        (deadline_usec - now + 999) / 1000 : 0;
+    flush_timer_->Start(timeout_ms,
+        boost::bind(&SandeshWriter::FlushTimerExpired, this));
+}
 
-    if (send_buf_offset()) {
-        // We have some unsent data.
-        size_t bulk_msg_len = send_buf_offset() + buf_len;
-        if (bulk_msg_len <= kDefaultSendSize) {
-            uint8_t *buffer;
-            // We have enough room to send all the pending data in one message.
-            boost::shared_ptr<TMemoryBuffer> bulk_msg(new
-                    TMemoryBuffer(bulk_msg_len));
-            buffer = bulk_msg->getWritePtr(bulk_msg_len);
-            memcpy(buffer, send_buf(), send_buf_offset());
-            memcpy(buffer + send_buf_offset(), buf, buf_len);
-            bulk_msg->wroteBytes(bulk_msg_len);
-            // send the message
-            SendInternal(bulk_msg);
-            // reset send_buf_
-            reset_send_buf();
-        } else {
-            uint8_t *buffer;
-            // We don't have enough space to accommodate all the
-            // pending data in one message.
-            boost::shared_ptr<TMemoryBuffer> old_buf(new
-                    TMemoryBuffer(send_buf_offset()));
-            buffer = old_buf->getWritePtr(send_buf_offset());
-            memcpy(buffer, send_buf(),
-                   send_buf_offset());
-            old_buf->wroteBytes(send_buf_offset());
-            // Take care of the unsent data in send_buf_ first.
-            // Note that we could have accomodated part of buf [last message]
-            // here. But, not doing so to avoid additional memcpy() :)
-            SendInternal(old_buf);
-            // Cleanup send_buf_
-            reset_send_buf();
-            // Well, send the last message now.
-            SendInternal(send_buffer);
-        }
-    } else {
-        // No unsent data. Send the message now.
-        SendInternal(send_buffer);
+// Runs in the writer task, so it does not race with SendMsg()
+bool SandeshWriter::FlushTimerExpired() {
+    if (send_buf_offset() == 0) {
+        return false;
+    }
+    uint64_t deadline_usec = batch_start_usec_ +
+        Sandesh::get_send_flush_deadline();
+    uint64_t now(ClockMonotonicUsec());
+    if (now < deadline_usec) {
+        // The batch was flushed and refilled since the timer was started
+        flush_timer_->Reschedule((deadline_usec - now + 999) / 1000);
+        return true;
     }
+    FlushBatch(0, FlushReason::DEADLINE);
+    return false;
 }
 
 void SandeshWriter::SendInternal(boost::shared_ptr<TMemoryBuffer> buf) {
     uint8_t  *buffer;
     uint32_t len;
     buf->getBuffer(&buffer, &len);
+    SendInternal(buffer, len);
+}
+
+void SandeshWriter::SendInternal(const uint8_t *buf, size_t len) {
     tbb::mutex::scoped_lock lock(send_mutex_);
-    ready_to_send_ = session_->Send((const uint8_t *)buffer, len, NULL);
+    ready_to_send_ = session_->Send(buf, len, NULL);
 }
 
 //
 // SandeshSession
 //
+const size_t SandeshSession::kSendLaneWeight[SandeshSession::SendLane::MAX] = {
+    32, // CTRL
+    32, // UVE
+    16, // SYSTEM
+    8,  // OBJECT
+    4,  // FLOW
+};
+
 SandeshSession::SandeshSession(SslServer *client, SslSocket *socket,
         int task_instance, int writer_task_id, int reader_task_id) :
     SslSession(client, socket),
     instance_(task_instance),
-    writer_(new SandeshWriter(this)),
+    writer_(new SandeshWriter(this, writer_task_id, task_instance)),
     reader_(new SandeshReader(this)),
-    send_queue_(new Sandesh::SandeshQueue(writer_task_id,
-            task_instance,
-            boost::bind(&SandeshSession::SendMsg, this, _1),
-            kQueueSize)),
     stats_client_(NULL),
     connection_(NULL),
     keepalive_idle_time_(kSessionKeepaliveIdleTime),
@@ -295,39 +517,149 @@ SandeshSession::SandeshSession(SslServer *client, SslSocket *socket,
     keepalive_probes_(kSessionKeepaliveProbes),
     tcp_user_timeout_(kSessionTcpUserTimeout),
     reader_task_id_(reader_task_id),
-    sending_level_(SandeshLevel::INVALID) {
+    sending_level_(SandeshLevel::INVALID),
+    send_queue_max_len_(0) {
     if (Sandesh::role() == Sandesh::SandeshRole::Collector) {
         send_buffer_queue_.reset(new Sandesh::SandeshBufferQueue(writer_task_id,
                 task_instance,
                 boost::bind(&SandeshSession::SendBuffer, this, _1)));
         send_buffer_queue_->SetStartRunnerFunc(boost::bind(&SandeshSession::SessionSendReady, this));
     }
-    send_queue_->SetStartRunnerFunc(boost::bind(&SandeshSession::SessionSendReady, this));
+    // The lanes split the send queue size, the session enforces the
+    // total in EnqueueSandesh
+    for (int i = 0; i < SendLane::MAX; i++) {
+        SendLane::type lane(static_cast<SendLane::type>(i));
+        send_queue_[i].reset(new Sandesh::SandeshQueue(writer_task_id,
+                task_instance,
+                boost::bind(&SandeshSession::SendMsg, this, lane, _1),
+                kQueueSize / SendLane::MAX, kSendLaneWeight[i]));
+        send_queue_[i]->SetStartRunnerFunc(boost::bind(&SandeshSession::SessionSendReady, this));
+        send_queue_[i]->set_name(std::string("SandeshSession ") +
+            SendLaneName(lane));
+    }
 }
 
 SandeshSession::~SandeshSession() {
 }
 
+SandeshSession::SendLane::type SandeshSession::GetSendLane(
+    SandeshType::type type) {
+    switch (type) {
+    case SandeshType::UVE:
+    case SandeshType::ALARM:
+        return SendLane::UVE;
+    case SandeshType::OBJECT:
+    case SandeshType::TRACE_OBJECT:
+        return SendLane::OBJECT;
+    case SandeshType::FLOW:
+    case SandeshType::SESSION:
+        return SendLane::FLOW;
+    case SandeshType::REQUEST:
+    case SandeshType::RESPONSE:
+        return SendLane::CTRL;
+    default:
+        return SendLane::SYSTEM;
+    }
+}
+
+SandeshSession::SendLane::type SandeshSession::GetSendLane(
+    const Sandesh *sandesh) {
+    if (sandesh->hints() & g_sandesh_constants.SANDESH_CONTROL_HINT) {
+        return SendLane::CTRL;
+    }
+    return GetSendLane(sandesh->type());
+}
+
+const char *SandeshSession::SendLaneName(SendLane::type lane) {
+    switch (lane) {
+    case SendLane::CTRL:
+        return "ctrl";
+    case SendLane::UVE:
+        return "uve";
+    case SendLane::SYSTEM:
+        return "system";
+    case SendLane::OBJECT:
+        return "object";
+    case SendLane::FLOW:
+        return "flow";
+    default:
+        return "invalid";
+    }
+}
+
 bool SandeshSession::SessionSendReady() {
     return (IsEstablished() && writer_->SendReady() &&
             Sandesh::IsSendQueueEnabled());
 }
 
+void SandeshSession::MayBeStartSendQueueRunner() {
+    for (int i = 0; i < SendLane::MAX; i++) {
+        send_queue_[i]->MayBeStartRunner();
+    }
+}
+
+bool SandeshSession::IsSendQueueEmpty() const {
+    for (int i = 0; i < SendLane::MAX; i++) {
+        if (!send_queue_[i]->IsQueueEmpty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t SandeshSession::SendQueueLength() const {
+    size_t length = 0;
+    for (int i = 0; i < SendLane::MAX; i++) {
+        length += send_queue_[i]->Length();
+    }
+    return length;
+}
+
+size_t SandeshSession::SendQueueNumEnqueues() const {
+    size_t enqueues = 0;
+    for (int i = 0; i < SendLane::MAX; i++) {
+        enqueues += send_queue_[i]->NumEnqueues();
+    }
+    return enqueues;
+}
+
+size_t SandeshSession::SendQueueMaxLength() const {
+    tbb::mutex::scoped_lock lock(send_queue_water_mutex_);
+    return send_queue_max_len_;
+}
+
+// Enqueue the sandesh on its lane and process the watermarks on the total
+// length of the lanes, so that the session watermarks bound the memory of
+// the send queue as a whole. The sandesh is always enqueued, the watermarks
+// raise the sending level as the queue grows.
+void SandeshSession::EnqueueSandesh(Sandesh *sandesh) {
+    SandeshElement element(sandesh);
+    tbb::mutex::scoped_lock lock(send_queue_water_mutex_);
+    send_queue_[GetSendLane(sandesh)]->Enqueue(element);
+    size_t length(SendQueueLength());
+    if (length > send_queue_max_len_) {
+        send_queue_max_len_ = length;
+    }
+    send_queue_watermarks_.ProcessHighWaterMarks(length);
+}
+
 void SandeshSession::SetSendQueueWaterMark(
     Sandesh::QueueWaterMarkInfo &swmi) {
     WaterMarkInfo wm(boost::get<0>(swmi),
         boost::bind(&SandeshSession::SetSendingLevel, this, _1,
             boost::get<1>(swmi)));
+    tbb::mutex::scoped_lock lock(send_queue_water_mutex_);
     if (boost::get<2>(swmi)) {
-        send_queue_->SetHighWaterMark(wm);
+        send_queue_watermarks_.SetHighWaterMark(wm);
     } else {
-        send_queue_->SetLowWaterMark(wm);
+        send_queue_watermarks_.SetLowWaterMark(wm);
     }
 }
 
 void SandeshSession::ResetSendQueueWaterMark() {
-    send_queue_->ResetHighWaterMark();
-    send_queue_->ResetLowWaterMark();
+    tbb::mutex::scoped_lock lock(send_queue_water_mutex_);
+    send_queue_watermarks_.ResetHighWaterMark();
+    send_queue_watermarks_.ResetLowWaterMark();
 }
 
 void SandeshSession::SetSendingLevel(size_t count, SandeshLevel::type level) {
@@ -344,7 +676,9 @@ void SandeshSession::Shutdown() {
     if (Sandesh::role() == Sandesh::SandeshRole::Collector) {
         send_buffer_queue_->Shutdown();
     }
-    send_queue_->Shutdown();
+    for (int i = 0; i < SendLane::MAX; i++) {
+        send_queue_[i]->Shutdown();
+    }
 }
 
 std::string SandeshSession::ToString() const {
@@ -366,9 +700,21 @@ void SandeshSession::OnRead(Buffer buffer) {
     reader_->OnRead(buffer);
 }
 
-bool SandeshSession::SendMsg(SandeshElement element) {
+bool SandeshSession::SendMsg(SendLane::type lane, SandeshElement element) {
     Sandesh *sandesh = element.snh_;
+    {
+        tbb::mutex::scoped_lock lock(send_queue_water_mutex_);
+        send_queue_watermarks_.ProcessLowWaterMarks(SendQueueLength());
+    }
     tbb::mutex::scoped_lock lock(send_mutex_);
+    // Time spent by the message in the lane
+    SendLaneStats &lstats(send_lane_stats_[lane]);
+    uint64_t latency(ClockMonotonicUsec() - element.GetEnqueueTime());
+    lstats.num_send_msg++;
+    lstats.latency_usec_total += latency;
+    if (latency > lstats.latency_usec_max) {
+        lstats.latency_usec_max = latency;
+    }
     if (!IsEstablished()) {
         if (Sandesh::IsLoggingDroppedAllowed(sandesh->type())) {
             SANDESH_LOG(ERROR, __func__ << " Not Connected : Dropping Message: " <<
@@ -383,7 +729,7 @@ bool SandeshSession::SendMsg(SandeshElement element) {
     if (sandesh->IsLoggingAllowed()) {
         sandesh->Log();
     }
-    bool more = !send_queue_->IsQueueEmpty();
+    bool more = !IsSendQueueEmpty();
     if (stats_client_ && sandesh->type() == SandeshType::UVE) {
         stats_client_->SendMsg(sandesh);
     }
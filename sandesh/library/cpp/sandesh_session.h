@@ -18,25 +18,69 @@
 #include <boost/tuple/tuple.hpp>
 
 #include <base/util.h>
+#include <base/watermark.h>
 #include <io/ssl_session.h>
 #include <io/udp_server.h>
 
 #include <sandesh/transport/TBufferTransports.h>
+#include <sandesh/protocol/TXMLProtocol.h>
 #include <sandesh/sandesh.h>
 #include <sandesh/sandesh_util.h>
 #include <sandesh/sandesh_uve_types.h>
 #include <sandesh/stats_client.h>
 
 using contrail::sandesh::transport::TMemoryBuffer;
+using contrail::sandesh::protocol::TXMLProtocol;
 class SandeshSession;
 class Sandesh;
+class Timer;
+
+// Encodes the SandeshHeader of outgoing messages. The module, source,
+// node type and instance id do not change once the generator is
+// initialized, so their encoding is cached and copied into the transport
+// while only the per message fields are encoded on every send.
+class SandeshHeaderEncoder {
+public:
+    SandeshHeaderEncoder();
+    int32_t Write(Sandesh *sandesh, TXMLProtocol *prot, TMemoryBuffer *btrans);
+    uint64_t cache_update_count() const { return cache_update_count_; }
+
+private:
+    bool IsCacheValid() const;
+    bool UpdateCache();
+
+    std::string module_;
+    std::string source_;
+    std::string node_type_;
+    std::string instance_id_;
+    // Encoded Module and Source [fields 3, 4]
+    std::string module_source_xml_;
+    // Encoded NodeType and InstanceId [fields 12, 13]
+    std::string node_type_instance_id_xml_;
+    bool cache_valid_;
+    uint64_t cache_update_count_;
+
+    DISALLOW_COPY_AND_ASSIGN(SandeshHeaderEncoder);
+};
 
 class SandeshWriter {
 public:
     static const uint32_t kEncodeBufferSize = 2048;
     static const unsigned int kDefaultSendSize = 16384;
-
-    SandeshWriter(SandeshSession *session);
+    // The batch buffer is not reused once a large message has grown it
+    // beyond this size
+    static const uint32_t kMaxBatchBufferSize = 4 * kDefaultSendSize;
+
+    // Reason for handing the batched messages over to the session
+    struct FlushReason {
+        enum type {
+            BATCH_FULL,   // The batch reached kDefaultSendSize
+            QUEUE_EMPTY,  // There are no more messages to send
+            DEADLINE,     // The oldest message waited for the flush deadline
+        };
+    };
+
+    SandeshWriter(SandeshSession *session, int task_id, int task_instance);
     ~SandeshWriter();
     void SendMsg(Sandesh *sandesh, bool more);
     void SendBuffer(boost::shared_ptr<TMemoryBuffer> sbuffer,
@@ -48,6 +92,9 @@ public:
         tbb::mutex::scoped_lock lock(send_mutex_);
         return ready_to_send_;
     }
+    const SandeshHeaderEncoder &header_encoder() const {
+        return header_encoder_;
+    }
 
     static const std::string sandesh_open_;
     static const std::string sandesh_open_attr_length_;
@@ -56,38 +103,47 @@ public:
 protected:
     friend class SandeshSessionTest;
 
-    // Inline routines invoked by SendMsg()
+    // Inline routines to batch already encoded messages
     void SendMsgMore(boost::shared_ptr<TMemoryBuffer>);
     void SendMsgAll(boost::shared_ptr<TMemoryBuffer>);
 
 private:
     friend class SandeshSendMsgUnitTest;
 
+    // Transport and protocol used to encode messages
+    struct EncodeContext {
+        boost::shared_ptr<TMemoryBuffer> btrans;
+        boost::shared_ptr<TXMLProtocol> prot;
+    };
+
     SandeshSession *session_;
 
+    void AllocBatch();
+    void ResetBatch();
+    void AppendToBatch(boost::shared_ptr<TMemoryBuffer> send_buffer,
+        bool more);
+    void ProcessBatch(uint32_t start, bool more);
+    void FlushBatch(uint32_t split, FlushReason::type reason);
+    bool FlushTimerExpired();
+    void StartFlushTimer(uint64_t deadline_usec);
     void SendInternal(boost::shared_ptr<TMemoryBuffer>);
+    void SendInternal(const uint8_t *buf, size_t len);
     void ConnectTimerExpired(const boost::system::error_code &error);
-    size_t send_buf_offset() { return send_buf_offset_; }
-    uint8_t* send_buf() const { return send_buf_; }
-    void set_send_buf(uint8_t *buf, size_t len) {
-        assert(len && (len < kDefaultSendSize));
-        memcpy(send_buf(), buf, len);
-        send_buf_offset_ = len;
-    }
-    void append_send_buf(uint8_t *buf, size_t len) {
-        assert(len && ((len + send_buf_offset_) < kDefaultSendSize));
-        memcpy(send_buf() + send_buf_offset_, buf, len);
-        send_buf_offset_ += len;
-    }
-    void reset_send_buf() {
-        send_buf_offset_ = 0;
+    size_t send_buf_offset() const {
+        return batch_.btrans ? batch_.btrans->available_read() : 0;
     }
 
     tbb::mutex send_mutex_;
     bool ready_to_send_;
-    // send_buf_ is used to store unsent data
-    uint8_t *send_buf_;
-    size_t send_buf_offset_;
+    // Messages are encoded back to back into the batch buffer, which is
+    // handed over to the session in one write. Accessed only from the
+    // writer task.
+    EncodeContext batch_;
+    // Time at which the first message in the batch was added
+    uint64_t batch_start_usec_;
+    // Flushes the batch when the flush deadline expires
+    Timer *flush_timer_;
+    SandeshHeaderEncoder header_encoder_;
 
 #define sXML_SANDESH_OPEN_ATTR_LENGTH  "<sandesh length=\""
 #define sXML_SANDESH_OPEN              "<sandesh length=\"0000000000\">"
@@ -142,6 +198,34 @@ class SandeshConnection;
 
 class SandeshSession : public SslSession {
 public:
+    // The send queue is split into lanes so that a flood of messages of
+    // one kind does not delay the others. All lanes are drained by the
+    // writer task of the session and each lane runner yields after its
+    // weight worth of messages, which results in weighted round robin
+    // draining across the lanes. The lanes share the byte budget and the
+    // watermarks of the session, which are evaluated on the total length
+    // of the lanes.
+    struct SendLane {
+        enum type {
+            CTRL,
+            UVE,
+            SYSTEM,
+            OBJECT,
+            FLOW,
+            MAX,
+        };
+    };
+    struct SendLaneStats {
+        SendLaneStats() :
+            num_send_msg(0),
+            latency_usec_total(0),
+            latency_usec_max(0) {
+        }
+        uint64_t num_send_msg;
+        uint64_t latency_usec_total;
+        uint64_t latency_usec_max;
+    };
+
     SandeshSession(SslServer *client, SslSocket *socket, int task_instance,
         int writer_task_id, int reader_task_id);
     virtual ~SandeshSession();
@@ -151,9 +235,21 @@ public:
         writer_->WriteReady(ec);
     }
     virtual bool EnqueueBuffer(u_int8_t *buf, u_int32_t buf_len);
-    Sandesh::SandeshQueue *send_queue() {
-        return send_queue_.get();
+    void EnqueueSandesh(Sandesh *sandesh);
+    Sandesh::SandeshQueue *send_queue(SendLane::type lane) {
+        return send_queue_[lane].get();
+    }
+    Sandesh::SandeshQueue *send_queue(const Sandesh *sandesh) {
+        return send_queue_[GetSendLane(sandesh)].get();
     }
+    static SendLane::type GetSendLane(const Sandesh *sandesh);
+    static SendLane::type GetSendLane(SandeshType::type type);
+    static const char *SendLaneName(SendLane::type lane);
+    void MayBeStartSendQueueRunner();
+    bool IsSendQueueEmpty() const;
+    size_t SendQueueLength() const;
+    size_t SendQueueNumEnqueues() const;
+    size_t SendQueueMaxLength() const;
     Sandesh::SandeshBufferQueue *send_buffer_queue() {
         return send_buffer_queue_.get();
     }
@@ -208,9 +304,28 @@ public:
     inline void increment_write_ready_cb_error() {
         sstats_.num_write_ready_cb_error++;
     }
+    inline void increment_send_encode_buffer_alloc() {
+        sstats_.num_send_encode_buffer_alloc++;
+    }
+    inline void increment_send_flush(SandeshWriter::FlushReason::type reason) {
+        switch (reason) {
+        case SandeshWriter::FlushReason::BATCH_FULL:
+            sstats_.num_send_flush_batch_full++;
+            break;
+        case SandeshWriter::FlushReason::QUEUE_EMPTY:
+            sstats_.num_send_flush_queue_empty++;
+            break;
+        case SandeshWriter::FlushReason::DEADLINE:
+            sstats_.num_send_flush_deadline++;
+            break;
+        }
+    }
     const SandeshSessionStats& GetStats() const {
         return sstats_;
     }
+    const SendLaneStats& GetSendLaneStats(SendLane::type lane) const {
+        return send_lane_stats_[lane];
+    }
     void SetSendQueueWaterMark(Sandesh::QueueWaterMarkInfo &wm_info);
     void ResetSendQueueWaterMark();
     SandeshLevel::type SendingLevel() const;
@@ -229,8 +344,10 @@ private:
     static const int kSessionKeepaliveProbes = 5; // count
     static const int kSessionTcpUserTimeout = 30000; // ms
     static const int kQueueSize = 200 * 1024 * 1024; // 200 MB
+    // Number of messages sent from a lane before yielding to other lanes
+    static const size_t kSendLaneWeight[SendLane::MAX];
 
-    bool SendMsg(SandeshElement element);
+    bool SendMsg(SendLane::type lane, SandeshElement element);
     bool SendBuffer(boost::shared_ptr<TMemoryBuffer> sbuffer);
     bool SessionSendReady();
     void SetSendingLevel(size_t count, SandeshLevel::type level);
@@ -238,7 +355,7 @@ private:
     int instance_;
     boost::scoped_ptr<SandeshWriter> writer_;
     boost::scoped_ptr<SandeshReader> reader_;
-    boost::scoped_ptr<Sandesh::SandeshQueue> send_queue_;
+    boost::scoped_ptr<Sandesh::SandeshQueue> send_queue_[SendLane::MAX];
     boost::scoped_ptr<Sandesh::SandeshBufferQueue> send_buffer_queue_;
     StatsClient *stats_client_;
     SandeshConnection *connection_;
@@ -250,9 +367,13 @@ private:
     int tcp_user_timeout_;
     int reader_task_id_;
     SandeshLevel::type sending_level_;
+    WaterMarkTuple send_queue_watermarks_;
+    mutable tbb::mutex send_queue_water_mutex_;
+    size_t send_queue_max_len_;
 
     // Session statistics
     SandeshSessionStats sstats_;
+    SendLaneStats send_lane_stats_[SendLane::MAX];
 
     DISALLOW_COPY_AND_ASSIGN(SandeshSession);
 };
@@ -9,20 +9,148 @@
 //
 
 #include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+#include <cstring>
 #include <ctime>
+#include <memory>
 #include <base/trace.h>
+#include <sandesh/transport/TBufferTransports.h>
+#include <sandesh/protocol/TBinaryProtocol.h>
 #include <sandesh/sandesh_types.h>
 #include <sandesh/sandesh.h>
 #include <sandesh/sandesh_trace_types.h>
+#include "sandesh_http.h"
 #include "sandesh_trace.h"
 
 using std::string;
 using std::vector;
+using contrail::sandesh::protocol::TBinaryProtocol;
+using contrail::sandesh::transport::TMemoryBuffer;
 
 int PullSandeshTraceReq = 0;
 
 template<> TraceSandeshType *TraceSandeshType::trace_ = NULL;
 
+size_t TraceEntryMemory(const SandeshTrace *entry) {
+    return sizeof(SandeshTrace) + entry->GetSize();
+}
+
+SandeshTraceCodec::SandeshTraceCodec(const std::string &category) :
+    category_(category),
+    wtrans_(new TMemoryBuffer(kSandeshTraceSlotSize)),
+    wprot_(new TBinaryProtocol(wtrans_)),
+    rtrans_(new TMemoryBuffer(NULL, 0)),
+    rprot_(new TBinaryProtocol(rtrans_)),
+    arena_(NULL) {
+}
+
+SandeshTraceCodec::~SandeshTraceCodec() {
+}
+
+size_t SandeshTraceCodec::Encode(SandeshTrace *entry, uint8_t *buf,
+                                 size_t buf_len) {
+    uint16_t type_index;
+    TypeIndexMap::const_iterator it = type_index_map_.find(entry->Name());
+    if (it != type_index_map_.end()) {
+        type_index = it->second;
+    } else {
+        if (prototypes_.size() >= kMaxTypes) {
+            return 0;
+        }
+        SandeshTrace *prototype = entry->CreateEmpty();
+        if (prototype == NULL) {
+            return 0;
+        }
+        type_index = prototypes_.size();
+        prototypes_.push_back(prototype);
+        type_index_map_.insert(std::make_pair(entry->Name(), type_index));
+        if (arena_) {
+            arena_->SetTypeName(type_index, entry->Name());
+        }
+    }
+
+    wtrans_->resetBuffer();
+    if (wprot_->writeI16(type_index) < 0 ||
+        wprot_->writeI64(entry->timestamp()) < 0 ||
+        wprot_->writeI32(entry->seqnum()) < 0 ||
+        entry->Write(wprot_) < 0) {
+        return 0;
+    }
+    uint8_t *data;
+    uint32_t len;
+    wtrans_->getBuffer(&data, &len);
+    if (len > buf_len) {
+        return 0;
+    }
+    memcpy(buf, data, len);
+    return len;
+}
+
+SandeshTrace *SandeshTraceCodec::Decode(const uint8_t *buf, size_t buf_len) {
+    rtrans_->resetBuffer(const_cast<uint8_t *>(buf), buf_len);
+    int16_t type_index;
+    int64_t timestamp;
+    int32_t seqnum;
+    if (rprot_->readI16(type_index) < 0 ||
+        rprot_->readI64(timestamp) < 0 ||
+        rprot_->readI32(seqnum) < 0) {
+        return NULL;
+    }
+    if (static_cast<uint16_t>(type_index) >= prototypes_.size()) {
+        return NULL;
+    }
+    std::auto_ptr<SandeshTrace> entry(
+        prototypes_[static_cast<uint16_t>(type_index)].CreateEmpty());
+    if (entry->Read(rprot_) < 0) {
+        return NULL;
+    }
+    entry->set_timestamp(timestamp);
+    entry->set_seqnum(seqnum);
+    entry->set_category(category_);
+    return entry.release();
+}
+
+void SandeshTraceCodec::SetArena(TraceArena *arena) {
+    arena_ = arena;
+    for (TypeIndexMap::const_iterator it = type_index_map_.begin();
+         it != type_index_map_.end(); ++it) {
+        arena_->SetTypeName(it->second, it->first);
+    }
+}
+
+// Sends the traces read for an introspect request a page at a time, so
+// that a large trace buffer is encoded and written out as the client drains
+// the session instead of in one response
+class SandeshTracePageProducer {
+public:
+    static const size_t kTracesPerPage = 1000;
+
+    SandeshTracePageProducer(const std::string& req_context,
+            vector<string> *traces) :
+        req_context_(req_context),
+        next_(0) {
+        traces_.swap(*traces);
+    }
+
+    bool NextPage() {
+        size_t end = std::min(next_ + kTracesPerPage, traces_.size());
+        SandeshTraceTextResponse *sttr = new SandeshTraceTextResponse;
+        sttr->set_traces(vector<string>(traces_.begin() + next_,
+                traces_.begin() + end));
+        next_ = end;
+        sttr->set_context(req_context_);
+        sttr->set_more(next_ < traces_.size());
+        sttr->Response();
+        return next_ < traces_.size();
+    }
+
+private:
+    std::string req_context_;
+    vector<string> traces_;
+    size_t next_;
+};
+
 class SandeshTraceRequestRunner {
 public:
     SandeshTraceRequestRunner(SandeshTraceBufferPtr trace_buf,
@@ -32,7 +160,6 @@ public:
         req_buf_(trace_buf),
         req_context_(req_context),
         read_context_(read_context),
-        sttr_(new SandeshTraceTextResponse),
         req_count_(count),
         read_count_(0) {
         if (!req_count_) {
@@ -48,9 +175,11 @@ public:
                 boost::bind(&SandeshTraceRequestRunner::SandeshTraceRead,
                     this, _1, _2));
         if ("Collector" != read_context_) {
-            sttr_->set_context(req_context_);
-            sttr_->Response();
             SandeshTraceBufferReadDone(req_buf_, read_context_);
+            boost::shared_ptr<SandeshTracePageProducer> producer(
+                new SandeshTracePageProducer(req_context_, &traces_));
+            SandeshHttp::StreamResponse(req_context_,
+                boost::bind(&SandeshTracePageProducer::NextPage, producer));
         }
     }
 
@@ -58,10 +187,9 @@ private:
     void SandeshTraceRead(SandeshTrace *tsnh, bool more) {
         read_count_++;
         assert(tsnh);
-        vector<string>& tracebuf = const_cast<vector<string>&>(sttr_->get_traces());
 
         if ("Collector" != read_context_) {
-            tracebuf.push_back(tsnh->ToString());
+            traces_.push_back(tsnh->ToString());
             return;
         }
 
@@ -75,7 +203,7 @@ private:
     SandeshTraceBufferPtr req_buf_;
     std::string req_context_;
     std::string read_context_;
-    SandeshTraceTextResponse *sttr_;
+    vector<string> traces_;
     uint32_t req_count_;
     uint32_t read_count_;
 };
@@ -179,6 +307,7 @@ void SandeshTraceBufStatusReq::HandleRequest() const {
         trace_buf_status.set_trace_buf_name(*it);
         SandeshTraceBufferPtr tbp = SandeshTraceBufferGet(*it);
         assert(tbp);
+        trace_buf_status.set_memory(SandeshTraceBufferMemoryGet(tbp));
         if (IsSandeshTraceBufferEnabled(tbp)) {
             trace_buf_status.set_enable_disable("Enabled");
         } else {
@@ -11,15 +11,62 @@
 #ifndef __SANDESH_TRACE_H__
 #define __SANDESH_TRACE_H__
 
+#include <boost/ptr_container/ptr_vector.hpp>
 #include <base/trace.h>
 #include <sandesh/sandesh_types.h>
 #include <sandesh/sandesh.h>
 
 class SandeshTrace;
+namespace contrail {
+namespace sandesh {
+namespace transport {
+class TMemoryBuffer;
+}  // namespace transport
+namespace protocol {
+class TProtocol;
+}  // namespace protocol
+}  // namespace sandesh
+}  // namespace contrail
 
 typedef boost::shared_ptr<TraceBuffer<SandeshTrace> > SandeshTraceBufferPtr;
 typedef Trace<SandeshTrace> TraceSandeshType;
 
+size_t TraceEntryMemory(const SandeshTrace *entry);
+
+//
+// Encodes traces for binary trace buffers using TBinaryProtocol. Each
+// record is the index of the trace type, the timestamp and the sequence
+// number, followed by the generated Write() encoding of the trace. A
+// default constructed instance of every trace type seen is kept to create
+// the traces when decoding.
+//
+class SandeshTraceCodec : public TraceEntryCodec<SandeshTrace> {
+public:
+    explicit SandeshTraceCodec(const std::string &category);
+    virtual ~SandeshTraceCodec();
+
+    virtual size_t Encode(SandeshTrace *entry, uint8_t *buf, size_t buf_len);
+    virtual SandeshTrace *Decode(const uint8_t *buf, size_t buf_len);
+    // Records the names of the known types in the arena, and of the types
+    // added later, so that the trace file can be decoded offline
+    virtual void SetArena(TraceArena *arena);
+
+private:
+    typedef std::map<std::string, uint16_t> TypeIndexMap;
+    static const size_t kMaxTypes = 0xffff;
+
+    std::string category_;
+    boost::shared_ptr<contrail::sandesh::transport::TMemoryBuffer> wtrans_;
+    boost::shared_ptr<contrail::sandesh::protocol::TProtocol> wprot_;
+    boost::shared_ptr<contrail::sandesh::transport::TMemoryBuffer> rtrans_;
+    boost::shared_ptr<contrail::sandesh::protocol::TProtocol> rprot_;
+    TypeIndexMap type_index_map_;
+    boost::ptr_vector<SandeshTrace> prototypes_;
+    TraceArena *arena_;
+
+    DISALLOW_COPY_AND_ASSIGN(SandeshTraceCodec);
+};
+
 inline void SandeshTraceEnable() {
     TraceSandeshType::GetInstance()->TraceOn();
 }
@@ -43,12 +90,47 @@ inline SandeshTraceBufferPtr SandeshTraceBufferResetSize(
              buf_name, buf_size);
 }
 
+// per_thread selects lock-free per writer thread rings, merged by sequence
+// number on read, for buffers written at high rates from many tasks.
 inline SandeshTraceBufferPtr SandeshTraceBufferCreate(
         const std::string& buf_name,
         size_t buf_size,
-        bool trace_enable = true) {
+        bool trace_enable = true,
+        bool per_thread = false) {
     return TraceSandeshType::GetInstance()->TraceBufAdd(
-            buf_name, buf_size, trace_enable);
+            buf_name, buf_size, trace_enable, per_thread);
+}
+
+// Binary trace buffers keep each trace serialized in a fixed slot of
+// slot_size bytes instead of as a heap object, and decode traces only when
+// the buffer is read. Traces larger than a slot are kept as objects.
+static const size_t kSandeshTraceSlotSize = 256;
+
+inline SandeshTraceBufferPtr SandeshTraceBufferCreateBinary(
+        const std::string& buf_name,
+        size_t buf_size,
+        size_t slot_size = kSandeshTraceSlotSize,
+        bool trace_enable = true) {
+    boost::shared_ptr<TraceEntryCodec<SandeshTrace> > codec(
+        new SandeshTraceCodec(buf_name));
+    return TraceSandeshType::GetInstance()->TraceBufAddBinary(
+            buf_name, buf_size, trace_enable, codec, slot_size);
+}
+
+// Persistent trace buffers are binary trace buffers whose slots are a
+// shared mapping of file_path, so the traces survive the death of the
+// process and can be read with sandesh_trace_file_dump.py. An existing
+// file is renamed to <file_path>.prev.
+inline SandeshTraceBufferPtr SandeshTraceBufferCreatePersistent(
+        const std::string& buf_name,
+        size_t buf_size,
+        const std::string& file_path,
+        size_t slot_size = kSandeshTraceSlotSize,
+        bool trace_enable = true) {
+    boost::shared_ptr<TraceEntryCodec<SandeshTrace> > codec(
+        new SandeshTraceCodec(buf_name));
+    return TraceSandeshType::GetInstance()->TraceBufAddBinary(
+            buf_name, buf_size, trace_enable, codec, slot_size, file_path);
 }
 
 inline SandeshTraceBufferPtr SandeshTraceBufferGet(const std::string& buf_name) {
@@ -71,6 +153,10 @@ inline size_t SandeshTraceBufferSizeGet(SandeshTraceBufferPtr trace_buf) {
     return trace_buf->TraceBufSizeGet();
 }
 
+inline size_t SandeshTraceBufferMemoryGet(SandeshTraceBufferPtr trace_buf) {
+    return trace_buf->TraceBufMemoryGet();
+}
+
 inline void SandeshTraceBufferRead(SandeshTraceBufferPtr trace_buf,
         const std::string& read_context, const int count,
         boost::function<void (SandeshTrace *, bool)> cb) {
@@ -8,6 +8,8 @@
 // file to handle requests for Sending Sandesh UVEs
 //
 
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
 #include "sandesh_uve.h"
 #include "../common/sandesh_uve_types.h"
 #include "sandesh_session.h"
@@ -133,12 +135,61 @@ SandeshUVEDSConfReq::HandleRequest() const {
     sur->Response();
 }
 
+// Sends the cached UVEs of a type for an introspect request a page of UVEs
+// at a time, followed by the SandeshUVECacheResp with the count
+class SandeshUVECachePageProducer {
+public:
+    static const size_t kUVEsPerPage = 100;
+
+    SandeshUVECachePageProducer(const SandeshUVETypeMaps::uve_global_elem &um,
+            const std::string &context) :
+        um_(um),
+        context_(context),
+        next_(0),
+        returned_(0) {
+        um_.second->GetUVENames(&names_);
+    }
+
+    bool NextPage() {
+        size_t end = std::min(next_ + kUVEsPerPage, names_.size());
+        for (; next_ < end; next_++) {
+            if (um_.second->SendUVE("", names_[next_], context_)) returned_++;
+        }
+        if (next_ < names_.size()) return true;
+
+        SandeshUVECacheResp *sur = new SandeshUVECacheResp();
+        sur->set_returned(returned_);
+        sur->set_period(um_.first);
+        sur->set_context(context_);
+        sur->Response();
+        return false;
+    }
+
+private:
+    SandeshUVETypeMaps::uve_global_elem um_;
+    std::string context_;
+    std::vector<std::string> names_;
+    size_t next_;
+    uint32_t returned_;
+};
+
 void
 SandeshUVECacheReq::HandleRequest() const {
     uint32_t returned = 0;
 
     const SandeshUVETypeMaps::uve_global_elem um = SandeshUVETypeMaps::TypeMap(get_tname());
 
+    // Introspect requests for the whole cache are streamed, so that a large
+    // cache is written out as the client drains the session
+    if (um.second && !__isset.key &&
+        ((0 == context().find("http%")) || (0 == context().find("https%")))) {
+        boost::shared_ptr<SandeshUVECachePageProducer> producer(
+            new SandeshUVECachePageProducer(um, context()));
+        SandeshHttp::StreamResponse(context(),
+            boost::bind(&SandeshUVECachePageProducer::NextPage, producer));
+        return;
+    }
+
     if (um.second) {
         if (__isset.key) {
             returned = um.second->SendUVE("", get_key(), context());
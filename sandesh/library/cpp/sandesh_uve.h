@@ -12,14 +12,15 @@
 #ifndef __SANDESH_UVE_H__
 #define __SANDESH_UVE_H__
 
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <boost/ptr_container/ptr_map.hpp>
 #include <boost/assign/ptr_map_inserter.hpp>
 #include <sandesh/sandesh_types.h>
 #include <sandesh/sandesh.h>
+#include <boost/shared_ptr.hpp>
 #include <tbb/mutex.h>
-#include <tbb/concurrent_hash_map.h>
 #include <boost/functional/hash.hpp>
 
 class SandeshUVEPerTypeMap;
@@ -58,6 +59,9 @@ public:
     static uve_global_map::const_iterator Begin() { return GetMap()->begin(); }
     static uve_global_map::const_iterator End() { return GetMap()->end(); }
     static const int kProxyPartitions = 30;
+    // Cached UVEs normally send only the attributes that changed;
+    // all attributes are resent at least this often
+    static const uint64_t kFullSyncIntervalUsec = 300 * 1000 * 1000ULL;
 private:
     static uve_global_map *map_;
 
@@ -82,6 +86,7 @@ public:
             const std::map<std::string,std::string> & dsconf) = 0;
     virtual bool SendUVE(const std::string& table, const std::string& name,
             const std::string& ctx) const = 0;
+    virtual void GetUVENames(std::vector<std::string> *names) const = 0;
     virtual std::map<std::string, std::string> GetDSConf(void) const = 0;
     virtual int GetTimeout(void) const = 0;
     virtual uint32_t ClearUVEs(const std::string& proxy, int partition) = 0;
@@ -109,86 +114,90 @@ template<typename T, typename U, int P, int TM>
 class SandeshUVEPerTypeMapImpl {
 public:
 
-    struct HashCompare {
-        static size_t hash( const std::string& key )
-            { return boost::hash_value(key); }
-        static bool   equal( const std::string& key1, const std::string& key2 )
-            { return ( key1 == key2 ); }
-    };
-
     struct UVEMapEntry {
         UVEMapEntry(const std::string &table, uint32_t seqnum,
-                    SandeshLevel::type level):
-                data(table), seqno(seqnum), level(level) {
+                    SandeshLevel::type level, uint64_t mono_usec):
+                data(table), seqno(seqnum), level(level),
+                full_sync_usec(mono_usec) {
         }
         U data;
         uint32_t seqno;
         SandeshLevel::type level;
+        // Time at which all attributes of this UVE were last sent
+        uint64_t full_sync_usec;
     };
 
     // The key is the table name
     typedef boost::ptr_map<std::string, UVEMapEntry> uve_table_map;
 
     // The key is the UVE-Key
-    typedef tbb::concurrent_hash_map<std::string, uve_table_map, HashCompare > uve_cmap;
+    typedef boost::ptr_map<std::string, uve_table_map> uve_shard_map;
+
+    // The cache is partitioned by the hash of the UVE-Key, and each
+    // shard has its own lock. Updates only contend with other updates
+    // of the same shard, and iterators lock one shard at a time.
+    struct UVEShard {
+        tbb::mutex mutex;
+        uve_shard_map map;
+    };
+    static const size_t kNumShards = 16;
+
+    // DerivedStats configuration. It is replaced as a whole whenever
+    // it changes, so that readers can use a snapshot without locking
+    typedef std::map<std::string, std::string> ds_conf_map;
+    typedef boost::shared_ptr<const ds_conf_map> ds_conf_ptr;
 
     SandeshUVEPerTypeMapImpl() :
-            dsconf_(T::_DSConf()) {}
+            dsconf_(new ds_conf_map(T::_DSConf())) {}
 
     // This function is called whenever a SandeshUVE is sent from
     // the generator to the collector.
-    // It updates the cache.
+    // It updates the cache, and clears the attributes of the given
+    // UVE that have not changed, so that only the delta is sent.
+    // A new UVE, or one that has not been sent in full for
+    // kFullSyncIntervalUsec, is sent with all its attributes.
     bool UpdateUVE(U& data, uint32_t seqnum, uint64_t mono_usec,
                    SandeshLevel::type level) {
         bool send = false;
-        tbb::mutex::scoped_lock lock;
         const std::string &table = data.table_;
         assert(!table.empty());
         const std::string &s = data.get_name();
         if (!mono_usec) mono_usec = ClockMonotonicUsec();
 
-        // pickup DS Config
-        lock.acquire(uve_mutex_);
-        std::map<string,string> dsconf = dsconf_;
-
-        // If we are going to erase, we need a global lock
-        // to coordinate with iterators
-        // To prevent deadlock, we always acquire global lock
-        // before accessor
-        if (!data.get_deleted()) {
-            lock.release();
+        UVEShard &shard = GetShard(s);
+        tbb::mutex::scoped_lock lock(shard.mutex);
+        typename uve_shard_map::iterator git = shard.map.find(s);
+        if (git == shard.map.end()) {
+            std::string key(s);
+            git = shard.map.insert(key, new uve_table_map).first;
         }
-        typename uve_cmap::accessor a;
 
-        // Ensure that the entry exists, and we have an accessor to it
-        while (true) {
-            if (cmap_.find(a, s)) break;
-            else {
-                if (cmap_.insert(a, s)) break;
-            }
-        }
-
-        typename uve_table_map::iterator imapentry = a->second.find(table);
-        if (imapentry == a->second.end()) {
+        typename uve_table_map::iterator imapentry = git->second->find(table);
+        if (imapentry == git->second->end()) {
             std::auto_ptr<UVEMapEntry> ume(new
-                    UVEMapEntry(data.table_, seqnum, level));
-            T::_InitDerivedStats(ume->data, dsconf);
-            send = T::UpdateUVE(data, ume->data, mono_usec, level);
-            imapentry = a->second.insert(table, ume).first;
+                    UVEMapEntry(data.table_, seqnum, level, mono_usec));
+            // pickup DS Config
+            ds_conf_ptr dsconf = GetDSConfSnapshot();
+            T::_InitDerivedStats(ume->data, *dsconf);
+            send = T::UpdateUVE(data, ume->data, mono_usec, level, true);
+            imapentry = git->second->insert(table, ume).first;
         } else {
             if (TM != 0) {
                 // If we get an update , mark this UVE so that it is not
                 // deleted during the next round of periodic processing
                 imapentry->second->data.set_deleted(false);
             }
-            send = T::UpdateUVE(data, imapentry->second->data, mono_usec,
-                                level);
-            imapentry->second->seqno = seqnum;
+            UVEMapEntry *entry = imapentry->second;
+            bool full_sync = mono_usec >= entry->full_sync_usec +
+                SandeshUVETypeMaps::kFullSyncIntervalUsec;
+            send = T::UpdateUVE(data, entry->data, mono_usec, level,
+                                full_sync);
+            if (full_sync) entry->full_sync_usec = mono_usec;
+            entry->seqno = seqnum;
         }
         if (data.get_deleted()) {
-            a->second.erase(imapentry);
-            if (a->second.empty()) cmap_.erase(a);
-            lock.release();
+            git->second->erase(imapentry);
+            if (git->second->empty()) shard.map.erase(git);
         }
 
         return send;
@@ -197,50 +206,47 @@ public:
     // Clear all UVEs in this cache
     // This is used ONLY with proxy groups
     uint32_t ClearUVEs(void) {
-
-        // Global lock is needed for iterator
-        tbb::mutex::scoped_lock lock(uve_mutex_);
         uint32_t count = 0;
-        (const_cast<SandeshUVEPerTypeMapImpl<T,U,P,TM> *>(this))->cmap_.rehash();
-        typename uve_cmap::iterator git = cmap_.begin();
-        while (git != cmap_.end()) {
-            typename uve_cmap::accessor a;
-            if (!cmap_.find(a, git->first)) continue;
-            typename uve_table_map::iterator uit = a->second.begin();
-            while (uit != a->second.end()) {
-                SANDESH_LOG(INFO, __func__ << " Clearing " << uit->first <<
-                    " val " << uit->second->data.log() << " proxy " <<
-                    SandeshStructProxyTrait<U>::get(uit->second->data) <<
-                    " seq " << uit->second->seqno);
-                uit->second->data.set_deleted(true);
-                T::Send(uit->second->data, uit->second->level,
-                        SandeshUVE::ST_SYNC, uit->second->seqno, 0, "");
-                count++;
-                ++uit;
+        for (size_t idx = 0; idx < kNumShards; idx++) {
+            UVEShard &shard = shards_[idx];
+            tbb::mutex::scoped_lock lock(shard.mutex);
+            for (typename uve_shard_map::iterator git = shard.map.begin();
+                    git != shard.map.end(); ++git) {
+                for (typename uve_table_map::iterator uit = git->second->begin();
+                        uit != git->second->end(); ++uit) {
+                    SANDESH_LOG(INFO, __func__ << " Clearing " << uit->first <<
+                        " val " << uit->second->data.log() << " proxy " <<
+                        SandeshStructProxyTrait<U>::get(uit->second->data) <<
+                        " seq " << uit->second->seqno);
+                    uit->second->data.set_deleted(true);
+                    T::Send(uit->second->data, uit->second->level,
+                            SandeshUVE::ST_SYNC, uit->second->seqno, 0, "");
+                    count++;
+                }
             }
-            ++git;
+            shard.map.clear();
         }
-        cmap_.clear();
         return count;
     }
 
     bool InitDerivedStats(const std::map<std::string,std::string> & dsconf) {
 
-        // Global lock is needed for iterator
-        tbb::mutex::scoped_lock lock(uve_mutex_);
+        // Serialize configuration changes
+        tbb::mutex::scoped_lock lock(dsconf_mutex_);
 
         // Copy the existing configuration
         // We will be replacing elements in it.
-        std::map<std::string,std::string> dsnew = dsconf_;
+        boost::shared_ptr<ds_conf_map> dsnew(
+            new ds_conf_map(*GetDSConfSnapshot()));
 
         bool failure = false;
         for (map<std::string,std::string>::const_iterator n_iter = dsconf.begin();
                 n_iter != dsconf.end(); n_iter++) {
-            if (dsnew.find(n_iter->first) != dsnew.end()) {
+            if (dsnew->find(n_iter->first) != dsnew->end()) {
                 SANDESH_LOG(INFO, __func__ << " Overide DSConf for " <<
-                    n_iter->first << " , " << dsnew[n_iter->first] <<
+                    n_iter->first << " , " << (*dsnew)[n_iter->first] <<
                     " with " << n_iter->second);
-                dsnew[n_iter->first] = n_iter->second;
+                (*dsnew)[n_iter->first] = n_iter->second;
             } else {
                 SANDESH_LOG(INFO, __func__ << " Cannot find DSConf for " <<
                     n_iter->first << " , " << n_iter->second);
@@ -250,19 +256,21 @@ public:
 
         if (failure) return false;
 
-        // Copy the new conf into the old one if there we no errors
-        dsconf_ = dsnew;
-
-        (const_cast<SandeshUVEPerTypeMapImpl<T,U,P,TM> *>(this))->cmap_.rehash();
-        for (typename uve_cmap::iterator git = cmap_.begin();
-                git != cmap_.end(); git++) {
-            typename uve_cmap::accessor a;
-            if (!cmap_.find(a, git->first)) continue;
-            for (typename uve_table_map::iterator uit = a->second.begin();
-                    uit != a->second.end(); uit++) {
-                SANDESH_LOG(INFO, __func__ << " Reset Derived Stats for " <<
-                    git->first);
-                T::_InitDerivedStats(uit->second->data, dsconf_);
+        // Publish the new conf if there we no errors
+        ds_conf_ptr dsconf_new(dsnew);
+        boost::atomic_store(&dsconf_, dsconf_new);
+
+        for (size_t idx = 0; idx < kNumShards; idx++) {
+            UVEShard &shard = shards_[idx];
+            tbb::mutex::scoped_lock slock(shard.mutex);
+            for (typename uve_shard_map::iterator git = shard.map.begin();
+                    git != shard.map.end(); git++) {
+                for (typename uve_table_map::iterator uit = git->second->begin();
+                        uit != git->second->end(); uit++) {
+                    SANDESH_LOG(INFO, __func__ << " Reset Derived Stats for " <<
+                        git->first);
+                    T::_InitDerivedStats(uit->second->data, *dsconf_new);
+                }
             }
         }
         return true;
@@ -272,18 +280,73 @@ public:
             SandeshUVE::SendType st,
             uint32_t seqno, uint32_t cycle,
             const std::string &ctx) {
-        // Global lock is needed for iterator
-        tbb::mutex::scoped_lock lock(uve_mutex_);
         uint32_t count = 0;
-        (const_cast<SandeshUVEPerTypeMapImpl<T,U,P,TM> *>(this))->cmap_.rehash();
-        typename uve_cmap::iterator git = cmap_.begin();
-        while (git != cmap_.end()) {
-            typename uve_cmap::accessor a;
-            if (!cmap_.find(a, git->first)) continue;
-            typename uve_table_map::iterator uit = a->second.begin();
-            while (uit != a->second.end()) {
-                typename uve_table_map::iterator dit = a->second.end();
-                if (!table.empty() && uit->first != table) continue;
+        for (size_t idx = 0; idx < kNumShards; idx++) {
+            count += SyncShard(shards_[idx], table, st, seqno, cycle, ctx);
+        }
+        return count;
+    }
+
+    bool SendUVE(const std::string& table, const std::string& name,
+                 const std::string& ctx) const {
+        bool sent = false;
+        UVEShard &shard = GetShard(name);
+        tbb::mutex::scoped_lock lock(shard.mutex);
+        typename uve_shard_map::const_iterator git = shard.map.find(name);
+        if (git != shard.map.end()) {
+            for (typename uve_table_map::const_iterator uve_entry = git->second->begin();
+                    uve_entry != git->second->end(); uve_entry++) {
+                if (!table.empty() && uve_entry->first != table) continue;
+                sent = true;
+                T::Send(uve_entry->second->data, uve_entry->second->level,
+                    (ctx.empty() ? SandeshUVE::ST_INTROSPECT : SandeshUVE::ST_SYNC),
+                    uve_entry->second->seqno, 0, ctx);
+            }
+        }
+        return sent;
+    }
+
+    // Appends the keys of all the cached UVEs, one shard at a time
+    void GetUVENames(std::vector<std::string> *names) const {
+        for (size_t idx = 0; idx < kNumShards; idx++) {
+            UVEShard &shard = shards_[idx];
+            tbb::mutex::scoped_lock slock(shard.mutex);
+            for (typename uve_shard_map::const_iterator git = shard.map.begin();
+                    git != shard.map.end(); git++) {
+                names->push_back(git->first);
+            }
+        }
+    }
+
+    std::map<std::string, std::string> GetDSConf(void) const {
+        return *GetDSConfSnapshot();
+    }
+
+private:
+
+    UVEShard &GetShard(const std::string &key) const {
+        return shards_[boost::hash_value(key) % kNumShards];
+    }
+
+    ds_conf_ptr GetDSConfSnapshot(void) const {
+        return boost::atomic_load(&dsconf_);
+    }
+
+    uint32_t SyncShard(UVEShard &shard, const std::string &table,
+            SandeshUVE::SendType st,
+            uint32_t seqno, uint32_t cycle,
+            const std::string &ctx) {
+        tbb::mutex::scoped_lock lock(shard.mutex);
+        uint32_t count = 0;
+        typename uve_shard_map::iterator git = shard.map.begin();
+        while (git != shard.map.end()) {
+            typename uve_table_map::iterator uit = git->second->begin();
+            while (uit != git->second->end()) {
+                typename uve_table_map::iterator dit = git->second->end();
+                if (!table.empty() && uit->first != table) {
+                    ++uit;
+                    continue;
+                }
                 if ((seqno < uit->second->seqno) || (seqno == 0)) {
                     if (ctx.empty()) {
                         SANDESH_LOG(INFO, __func__ << " Syncing " << uit->first <<
@@ -310,40 +373,20 @@ public:
                     count++;
                 }
                 ++uit;
-                if (dit != a->second.end()) a->second.erase(dit);
+                if (dit != git->second->end()) git->second->erase(dit);
             }
-            ++git;
-            if (a->second.empty()) cmap_.erase(a);
-        }
-        return count;
-    }
-
-    bool SendUVE(const std::string& table, const std::string& name,
-                 const std::string& ctx) const {
-        bool sent = false;
-        typename uve_cmap::const_accessor a;
-        if (cmap_.find(a, name)) {
-            for (typename uve_table_map::const_iterator uve_entry = a->second.begin();
-                    uve_entry != a->second.end(); uve_entry++) {
-                if (!table.empty() && uve_entry->first != table) continue;
-                sent = true;
-                T::Send(uve_entry->second->data, uve_entry->second->level,
-                    (ctx.empty() ? SandeshUVE::ST_INTROSPECT : SandeshUVE::ST_SYNC),
-                    uve_entry->second->seqno, 0, ctx);
+            if (git->second->empty()) {
+                shard.map.erase(git++);
+            } else {
+                ++git;
             }
         }
-        return sent;
-    }
-
-    std::map<std::string, std::string> GetDSConf(void) const {
-        return dsconf_;
+        return count;
     }
 
-private:
-
-    uve_cmap cmap_;
-    std::map<std::string, std::string> dsconf_;
-    mutable tbb::mutex uve_mutex_;
+    mutable UVEShard shards_[kNumShards];
+    ds_conf_ptr dsconf_;
+    tbb::mutex dsconf_mutex_;
 };
 
 #define SANDESH_UVE_DEF(x,y,z,w) \
@@ -437,11 +480,18 @@ public:
     }
 
     // Sync UVEs for both the native UVE Map and the proxy groups
+    // Only UVEs updated after the given seqno (the last one
+    // acknowledged by the collector) are sent; all are sent if it is 0
     uint32_t SyncUVE(const std::string &table,
             SandeshUVE::SendType st,
             uint32_t seqno, uint32_t cycle,
             const std::string &ctx) {
         uint32_t count=0;
+        // Nothing has been sent since the collector's seqno, so avoid
+        // walking the caches
+        if (seqno != 0 && seqno >= TypeSeq()) {
+            return count;
+        }
         std::vector<uve_emap *> nev = GetNMaps();
         for (size_t idx=0; idx<nev.size(); idx++) {
             count += nev[idx]->SyncUVE(table, st, seqno, cycle,ctx);
@@ -485,6 +535,25 @@ public:
         return sent;
     }
 
+    // Get the keys of the UVEs in the native UVE map and the proxy groups
+    void GetUVENames(std::vector<std::string> *names) const {
+        std::vector<uve_emap *> nev =
+            const_cast<SandeshUVEPerTypeMapGroup<T,U,P,TM> * >(this)->GetNMaps();
+        for (size_t idx=0; idx<nev.size(); idx++) {
+            nev[idx]->GetUVENames(names);
+        }
+
+        std::vector<uve_pmap *> pv =
+                const_cast<SandeshUVEPerTypeMapGroup<T,U,P,TM> * >(this)->GetGMaps();
+        for (size_t jdx=0; jdx<pv.size(); jdx++) {
+            for (size_t idx=0; idx<SandeshUVETypeMaps::kProxyPartitions; idx++) {
+                pv[jdx]->at(idx).GetUVENames(names);
+            }
+        }
+        std::sort(names->begin(), names->end());
+        names->erase(std::unique(names->begin(), names->end()), names->end());
+    }
+
     std::map<std::string, std::string> GetDSConf(void) const {
         return nativep_->GetDSConf();
     }
@@ -757,8 +757,9 @@ protected:
 "<nullm_zc type=\"map\" identifier=\"12\" mstats=\"z.count:DSNull:\"><map key=\"string\" value=\"struct\" size=\"1\"><element>idx1</element><NullResult><samples type=\"u64\" identifier=\"3\">2</samples><value type=\"i32\" identifier=\"5\">56</value></NullResult></map></nullm_zc>");
                 EXPECT_STREQ(mm["null_fz"].c_str(),
 "");
+                // fz has not changed since case 1
                 EXPECT_STREQ(mm["fz"].c_str(),
-"<fz type=\"struct\" identifier=\"5\"><TestAggStruct><count type=\"i32\" identifier=\"1\">20</count></TestAggStruct></fz>");
+"");
                 EXPECT_STREQ(mm["null_gz"].c_str(),
 "");
                 EXPECT_STREQ(mm["gz"].c_str(),
@@ -1322,6 +1323,182 @@ TEST_F(SandeshUVEAlarmTest, UVEAlarm) {
     TASK_UTIL_EXPECT_TRUE(msg_num_ == 33);
 }
 
+class SandeshUVECacheTest : public ::testing::Test {
+protected:
+    typedef std::map<std::string, std::string> AttrMap;
+
+    virtual void SetUp() {
+        evm_.reset(new EventManager());
+        server_ = new SandeshServerTest(evm_.get(),
+            boost::bind(&SandeshUVECacheTest::ReceiveSandeshMsg, this, _1, _2));
+        thread_.reset(new ServerThread(evm_.get()));
+        server_->Initialize(0);
+        thread_->Start();
+        int port = server_->GetPort();
+        ASSERT_LT(0, port);
+        Sandesh::InitGenerator("SandeshUVECacheTest-Client", "localhost",
+                               "Test", "0", evm_.get(), 0, NULL);
+        Sandesh::ConnectToCollector("127.0.0.1", port);
+        TASK_UTIL_EXPECT_TRUE(Sandesh::client()->state() ==
+                              SandeshClientSM::ESTABLISHED);
+    }
+
+    virtual void TearDown() {
+        task_util::WaitForIdle();
+        Sandesh::Uninit();
+        task_util::WaitForIdle();
+        TASK_UTIL_EXPECT_FALSE(server_->HasSessions());
+        task_util::WaitForIdle();
+        server_->Shutdown();
+        task_util::WaitForIdle();
+        TcpServerManager::DeleteServer(server_);
+        task_util::WaitForIdle();
+        evm_->Shutdown();
+        if (thread_.get() != NULL) {
+            thread_->Join();
+        }
+        task_util::WaitForIdle();
+    }
+
+    bool ReceiveSandeshMsg(SandeshSession* session,
+                           const SandeshMessage* msg) {
+        // Ignore UVEs sent by the sandesh library
+        if (msg->GetMessageType() != "SandeshUVEDeltaTest") {
+            return true;
+        }
+        const SandeshXMLMessage *xmsg =
+            dynamic_cast<const SandeshXMLMessage *>(msg);
+        EXPECT_TRUE(xmsg != NULL);
+        pugi::xml_node dnode = xmsg->GetMessageNode().first_child();
+        EXPECT_STREQ(dnode.name(), "data");
+        dnode = dnode.first_child();
+        AttrMap mm;
+        for (pugi::xml_node node = dnode.first_child(); node;
+                node = node.next_sibling()) {
+            mm.insert(std::make_pair(node.name(), node.child_value()));
+        }
+        // The UVE cache outlives the test, so ignore the UVEs of the
+        // other tests that are resent on a resync
+        if (mm["name"] != name_) {
+            return true;
+        }
+        tbb::mutex::scoped_lock lock(mutex_);
+        msgs_.push_back(mm);
+        return true;
+    }
+
+    size_t MessageCount() {
+        tbb::mutex::scoped_lock lock(mutex_);
+        return msgs_.size();
+    }
+
+    AttrMap Message(size_t idx) {
+        tbb::mutex::scoped_lock lock(mutex_);
+        return msgs_[idx];
+    }
+
+    SandeshUVEDeltaData UVEData(int32_t x, const std::string &s) const {
+        SandeshUVEDeltaData data;
+        data.set_name(name_);
+        data.set_x(x);
+        data.set_s(s);
+        return data;
+    }
+
+    std::string name_;
+    tbb::mutex mutex_;
+    std::vector<AttrMap> msgs_;
+    std::auto_ptr<ServerThread> thread_;
+    std::auto_ptr<EventManager> evm_;
+    SandeshServerTest *server_;
+};
+
+TEST_F(SandeshUVECacheTest, ChangedAttributes) {
+    name_ = "uve_changedattributes";
+    uint64_t mono_usec(ClockMonotonicUsec());
+    // A new UVE is sent with all its attributes
+    SandeshUVEDeltaTest::Send(UVEData(1, "s1"), SandeshLevel::SYS_NOTICE, "",
+                              mono_usec);
+    TASK_UTIL_EXPECT_EQ(1U, MessageCount());
+    AttrMap mm(Message(0));
+    EXPECT_EQ(name_, mm["name"]);
+    EXPECT_EQ("1", mm["x"]);
+    EXPECT_EQ("s1", mm["s"]);
+
+    // Only the attribute that changed is sent
+    SandeshUVEDeltaTest::Send(UVEData(2, "s1"), SandeshLevel::SYS_NOTICE, "",
+                              mono_usec + 1);
+    TASK_UTIL_EXPECT_EQ(2U, MessageCount());
+    mm = Message(1);
+    EXPECT_EQ(name_, mm["name"]);
+    EXPECT_EQ("2", mm["x"]);
+    EXPECT_TRUE(mm.find("s") == mm.end());
+
+    // Nothing is sent if no attribute changed
+    SandeshUVEDeltaTest::Send(UVEData(2, "s1"), SandeshLevel::SYS_NOTICE, "",
+                              mono_usec + 2);
+    task_util::WaitForIdle();
+    EXPECT_EQ(2U, MessageCount());
+}
+
+TEST_F(SandeshUVECacheTest, FullSyncInterval) {
+    name_ = "uve_fullsyncinterval";
+    uint64_t mono_usec(ClockMonotonicUsec());
+    SandeshUVEDeltaTest::Send(UVEData(3, "s3"), SandeshLevel::SYS_NOTICE, "",
+                              mono_usec);
+    TASK_UTIL_EXPECT_EQ(1U, MessageCount());
+    SandeshUVEDeltaTest::Send(UVEData(3, "s3"), SandeshLevel::SYS_NOTICE, "",
+        mono_usec + SandeshUVETypeMaps::kFullSyncIntervalUsec - 1);
+    task_util::WaitForIdle();
+    EXPECT_EQ(1U, MessageCount());
+
+    // All the attributes are sent once the full sync interval elapses,
+    // even if none of them changed
+    SandeshUVEDeltaTest::Send(UVEData(3, "s3"), SandeshLevel::SYS_NOTICE, "",
+        mono_usec + SandeshUVETypeMaps::kFullSyncIntervalUsec);
+    TASK_UTIL_EXPECT_EQ(2U, MessageCount());
+    AttrMap mm(Message(1));
+    EXPECT_EQ("3", mm["x"]);
+    EXPECT_EQ("s3", mm["s"]);
+
+    // The next full sync is due an interval after the last one
+    SandeshUVEDeltaTest::Send(UVEData(4, "s3"), SandeshLevel::SYS_NOTICE, "",
+        mono_usec + SandeshUVETypeMaps::kFullSyncIntervalUsec + 1);
+    TASK_UTIL_EXPECT_EQ(3U, MessageCount());
+    mm = Message(2);
+    EXPECT_EQ("4", mm["x"]);
+    EXPECT_TRUE(mm.find("s") == mm.end());
+}
+
+TEST_F(SandeshUVECacheTest, Resync) {
+    name_ = "uve_resync";
+    uint64_t mono_usec(ClockMonotonicUsec());
+    SandeshUVEDeltaTest::Send(UVEData(5, "s5"), SandeshLevel::SYS_NOTICE, "",
+                              mono_usec);
+    SandeshUVEDeltaTest::Send(UVEData(6, "s5"), SandeshLevel::SYS_NOTICE, "",
+                              mono_usec + 1);
+    TASK_UTIL_EXPECT_EQ(2U, MessageCount());
+    AttrMap mm(Message(1));
+    EXPECT_TRUE(mm.find("s") == mm.end());
+
+    // The collector has acknowledged the last update, nothing to resync
+    std::map<std::string, uint32_t> seqno_map;
+    seqno_map.insert(std::make_pair("SandeshUVEDeltaTest",
+                                    SandeshUVEDeltaTest::lseqnum()));
+    SandeshUVETypeMaps::SyncAllMaps(seqno_map);
+    task_util::WaitForIdle();
+    EXPECT_EQ(2U, MessageCount());
+
+    // After a reconnect without a seqno the full UVE is resent from the
+    // cache, including the attributes suppressed in the last update
+    SandeshUVETypeMaps::SyncAllMaps(std::map<std::string, uint32_t>());
+    TASK_UTIL_EXPECT_EQ(3U, MessageCount());
+    mm = Message(2);
+    EXPECT_EQ(name_, mm["name"]);
+    EXPECT_EQ("6", mm["x"]);
+    EXPECT_EQ("s5", mm["s"]);
+}
+
 class SandeshBaseFactoryTest : public ::testing::Test {
 protected:
     SandeshBaseFactoryTest() {
@@ -27,9 +27,16 @@
 #include <sandesh/sandesh_types.h>
 #include <sandesh/sandesh_constants.h>
 #include <sandesh/sandesh.h>
+#include <sandesh/sandesh_session.h>
+#include <sandesh/derived_stats_algo.h>
+#include <sandesh/protocol/TXMLProtocol.h>
+#include <sandesh/transport/TBufferTransports.h>
 
 #include "sandesh_perf_test_types.h"
 
+using namespace contrail::sandesh::protocol;
+using namespace contrail::sandesh::transport;
+
 using contrail::regex;
 using contrail::regex_replace;
 
@@ -170,6 +177,87 @@ TEST_F(SandeshPerfTestEnqueue, DISABLED_PStructPoolEnqueue) {
     pstructpool_queue_->Shutdown();   
 }
 
+// Compare SandeshHeader::write() against SandeshHeaderEncoder::Write()
+// which reuses the encoding of the static header fields
+class SandeshPerfTestHeaderEncode : public ::testing::Test {
+protected:
+    SandeshPerfTestHeaderEncode() :
+        btrans_(new TMemoryBuffer(SandeshWriter::kEncodeBufferSize)),
+        prot_(new TXMLProtocol(btrans_)) {
+    }
+
+    virtual void SetUp() {
+        std::string module("PerfTest&Module"), source("perf-test-source");
+        std::string node_type("Test"), instance_id("0");
+        Sandesh::set_module(module);
+        Sandesh::set_source(source);
+        Sandesh::set_node_type(node_type);
+        Sandesh::set_instance_id(instance_id);
+        sandesh_ = new PerfTestSandesh();
+        sandesh_->set_context("perf<test>context");
+        sandesh_->set_category("perf'test");
+    }
+
+    virtual void TearDown() {
+        sandesh_->Release();
+    }
+
+    std::string HeaderWrite() {
+        SandeshHeader header;
+        header.set_Namespace(sandesh_->scope());
+        header.set_Timestamp(sandesh_->timestamp());
+        header.set_Module(sandesh_->module());
+        header.set_Source(sandesh_->source());
+        header.set_Context(sandesh_->context());
+        header.set_SequenceNum(sandesh_->seqnum());
+        header.set_VersionSig(sandesh_->versionsig());
+        header.set_Type(sandesh_->type());
+        header.set_Hints(sandesh_->hints());
+        header.set_Level(sandesh_->level());
+        header.set_Category(sandesh_->category());
+        header.set_NodeType(sandesh_->node_type());
+        header.set_InstanceId(sandesh_->instance_id());
+        btrans_->resetBuffer();
+        EXPECT_LT(0, header.write(prot_));
+        return btrans_->getBufferAsString();
+    }
+
+    std::string EncoderWrite() {
+        btrans_->resetBuffer();
+        EXPECT_LT(0, encoder_.Write(sandesh_, prot_.get(), btrans_.get()));
+        return btrans_->getBufferAsString();
+    }
+
+    boost::shared_ptr<TMemoryBuffer> btrans_;
+    boost::shared_ptr<TXMLProtocol> prot_;
+    SandeshHeaderEncoder encoder_;
+    PerfTestSandesh *sandesh_;
+};
+
+TEST_F(SandeshPerfTestHeaderEncode, Basic) {
+    EXPECT_EQ(HeaderWrite(), EncoderWrite());
+    EXPECT_EQ(1U, encoder_.cache_update_count());
+    EXPECT_EQ(HeaderWrite(), EncoderWrite());
+    EXPECT_EQ(1U, encoder_.cache_update_count());
+    // Change in the static fields must be picked up
+    std::string instance_id("1");
+    Sandesh::set_instance_id(instance_id);
+    EXPECT_EQ(HeaderWrite(), EncoderWrite());
+    EXPECT_EQ(2U, encoder_.cache_update_count());
+}
+
+TEST_F(SandeshPerfTestHeaderEncode, DISABLED_HeaderWrite) {
+    for (int i = 0; i < 1000000; i++) {
+        HeaderWrite();
+    }
+}
+
+TEST_F(SandeshPerfTestHeaderEncode, DISABLED_EncoderWrite) {
+    for (int i = 0; i < 1000000; i++) {
+        EncoderWrite();
+    }
+}
+
 static const char* expression = "(<)|(>)|(&)|(')";
 static const char* format = "(?1&lt;)(?2&gt;)(?3&amp;)(?4&apos;)";
 
@@ -395,6 +483,393 @@ TEST_F(SandeshPerfTestString, DISABLED_PerfTestSplitIter) {
     }
 }
 
+// Windowed DSSum/DSAvg updates, compared with the std::map based history
+// the circular bucket history replaced
+class SandeshPerfTestDerivedStats : public ::testing::Test {
+protected:
+    typedef contrail::sandesh::DSSum<uint64_t, uint64_t> SumStat;
+    typedef contrail::sandesh::DSAvg<uint64_t, double> AvgStat;
+
+    // Reference implementation of the windowed sum
+    class MapSumStat {
+    public:
+        explicit MapSumStat(uint64_t range_secs) : samples_(0), value_(0),
+            range_usecs_(range_secs * 1000000), shifter_(0) {
+            while ((uint64_t)(1 << (shifter_ + 8)) < range_usecs_) shifter_++;
+        }
+        void Update(uint64_t raw, uint64_t mono_usec) {
+            uint64_t tbin = (mono_usec >> shifter_) << shifter_;
+            for (std::map<uint64_t, std::pair<uint64_t, uint64_t> >::iterator
+                    it = history_buf_.begin(); it != history_buf_.end(); ) {
+                uint64_t end_range =
+                    ((it->first + range_usecs_) >> shifter_) << shifter_;
+                if (end_range <= tbin) {
+                    value_ -= it->second.second;
+                    samples_ -= it->second.first;
+                    history_buf_.erase(it++);
+                } else {
+                    ++it;
+                }
+            }
+            std::pair<uint64_t, uint64_t> &bucket = history_buf_[tbin];
+            bucket.first++;
+            bucket.second += raw;
+            value_ += raw;
+            samples_++;
+        }
+        uint64_t samples_;
+        uint64_t value_;
+    private:
+        std::map<uint64_t, std::pair<uint64_t, uint64_t> > history_buf_;
+        uint64_t range_usecs_;
+        uint8_t shifter_;
+    };
+
+    static const int kUpdates = 1000000;
+    static const uint64_t kStartUsec = 1000000000;
+};
+
+TEST_F(SandeshPerfTestDerivedStats, Basic) {
+    SumStat sum("60");
+    AvgStat avg("60");
+    MapSumStat ref(60);
+    uint64_t mono_usec = kStartUsec;
+    srand(1);
+    for (int i = 0; i < 20000; i++) {
+        // Mostly small steps, with an occasional gap longer than the range
+        mono_usec += (i % 5000 == 4999) ? 120000000 : rand() % 100000;
+        uint64_t raw = rand() % 1000;
+        sum.Update(raw, mono_usec);
+        avg.Update(raw, mono_usec);
+        ref.Update(raw, mono_usec);
+        ASSERT_EQ(ref.samples_, sum.samples_);
+        ASSERT_EQ(ref.value_, sum.value_);
+        ASSERT_LE(sum.history_buf_.size(), 256U);
+    }
+    uint64_t sum_res;
+    EXPECT_EQ(contrail::sandesh::DSR_OK, sum.FillResult(sum_res));
+    EXPECT_EQ(ref.value_, sum_res);
+    double avg_res;
+    EXPECT_EQ(contrail::sandesh::DSR_OK, avg.FillResult(avg_res));
+    EXPECT_DOUBLE_EQ((double)ref.value_ / ref.samples_, avg_res);
+
+    // Everything expires after a range without updates
+    sum.Purge(mono_usec + 61000000);
+    EXPECT_EQ(0U, sum.samples_);
+}
+
+TEST_F(SandeshPerfTestDerivedStats, Percentile) {
+    contrail::sandesh::DSPercentile<uint64_t, PercentileResult> pct("50,99");
+    PercentileResult res;
+    EXPECT_EQ(contrail::sandesh::DSR_INVALID, pct.FillResult(res));
+    for (int i = 1; i <= 10000; i++) {
+        pct.Update(i, kStartUsec + i);
+    }
+    EXPECT_EQ(contrail::sandesh::DSR_OK, pct.FillResult(res));
+    EXPECT_EQ(10000U, res.get_samples());
+    ASSERT_EQ(2U, res.get_percentiles().size());
+    EXPECT_NEAR(5000, res.get_percentiles().find("50")->second, 100);
+    EXPECT_NEAR(9900, res.get_percentiles().find("99")->second, 20);
+
+    contrail::sandesh::DSPercentile<uint64_t, PercentileResult> bad("50,x");
+    bad.Update(1, kStartUsec);
+    EXPECT_EQ(contrail::sandesh::DSR_OK, bad.FillResult(res));
+    EXPECT_EQ("Invalid value x", res.get_error());
+}
+
+TEST_F(SandeshPerfTestDerivedStats, PercentileWindow) {
+    // Samples older than the window are dropped
+    contrail::sandesh::DSPercentile<uint64_t, PercentileResult> pct("50:10");
+    for (int i = 0; i < 1000; i++) {
+        pct.Update(1000000, kStartUsec + i * 1000);
+    }
+    for (int i = 0; i < 1000; i++) {
+        pct.Update(i, kStartUsec + 20000000 + i * 1000);
+    }
+    PercentileResult res;
+    EXPECT_EQ(contrail::sandesh::DSR_OK, pct.FillResult(res));
+    EXPECT_EQ(1000U, res.get_samples());
+    EXPECT_NEAR(500, res.get_percentiles().find("50")->second, 20);
+}
+
+TEST_F(SandeshPerfTestDerivedStats, Histogram) {
+    contrail::sandesh::DSHistogram<uint64_t, HistogramResult> hist(
+        "100,1000,100000");
+    for (int i = 0; i < 10000; i++) {
+        hist.Update(i, kStartUsec);
+    }
+    HistogramResult res;
+    EXPECT_EQ(contrail::sandesh::DSR_OK, hist.FillResult(res));
+    EXPECT_EQ(10000U, res.get_samples());
+    const std::map<std::string, uint64_t> &buckets = res.get_buckets();
+    ASSERT_EQ(3U, buckets.size());
+    EXPECT_NEAR(100, buckets.find("100")->second, 10);
+    EXPECT_NEAR(1000, buckets.find("1000")->second, 50);
+    EXPECT_EQ(10000U, buckets.find("100000")->second);
+
+    contrail::sandesh::DSHistogram<uint64_t, HistogramResult> none("");
+    none.Update(1, kStartUsec);
+    EXPECT_EQ(contrail::sandesh::DSR_OK, none.FillResult(res));
+    EXPECT_EQ("No values", res.get_error());
+}
+
+TEST_F(SandeshPerfTestDerivedStats, PercentilePeriodic) {
+    contrail::sandesh::DerivedStatsPeriodicIf<contrail::sandesh::DSPercentile,
+        uint64_t, PercentileResult, PercentileResult_P_> periodic("50");
+    for (int i = 0; i < 100; i++) {
+        periodic.Update(i, kStartUsec);
+    }
+    PercentileResult_P_ res;
+    bool isset;
+    periodic.FillResult(res, isset);
+    EXPECT_TRUE(isset);
+    EXPECT_TRUE(res.__isset.staging);
+    EXPECT_FALSE(res.__isset.value);
+
+    // Each period reports only its own samples
+    EXPECT_TRUE(periodic.Flush(res));
+    periodic.Update(1000, kStartUsec);
+    PercentileResult_P_ next;
+    periodic.FillResult(next, isset);
+    EXPECT_TRUE(next.__isset.value);
+    EXPECT_EQ(100U, next.get_value().get_samples());
+    EXPECT_TRUE(next.__isset.staging);
+    EXPECT_EQ(1U, next.get_staging().get_samples());
+    EXPECT_EQ(1000, next.get_staging().get_percentiles().find("50")->second);
+}
+
+TEST_F(SandeshPerfTestDerivedStats, DISABLED_DSPercentileUpdate) {
+    contrail::sandesh::DSPercentile<uint64_t, PercentileResult> pct("50,99");
+    for (int i = 0; i < kUpdates; i++) {
+        pct.Update(rand() % 100000, kStartUsec + i * 10000ULL);
+    }
+    PercentileResult res;
+    pct.FillResult(res);
+}
+
+// Map-valued derived stats, compared with the std::map based
+// DerivedStatsAgg and DerivedStatsMerge
+class SandeshPerfTestDerivedStatsMap : public ::testing::Test {
+protected:
+    typedef contrail::sandesh::DSSum<uint64_t, uint64_t> SumStat;
+    typedef std::map<std::string, uint64_t> RawMap;
+    typedef std::map<std::string, bool> DelMap;
+    typedef std::map<std::string, boost::shared_ptr<SumStat> > SumStatMap;
+
+    static const int kKeys = 10000;
+
+    static void BuildRaw(int keys, RawMap *raw, DelMap *del) {
+        for (int i = 0; i < keys; i++) {
+            std::ostringstream key;
+            key << "default-domain:project:vn-" << i;
+            raw->insert(std::make_pair(key.str(), (uint64_t)i));
+            del->insert(std::make_pair(key.str(), false));
+        }
+    }
+
+    static void StepRaw(RawMap *raw) {
+        for (RawMap::iterator it = raw->begin(); it != raw->end(); ++it) {
+            it->second += 10;
+        }
+    }
+
+    static void ReferenceUpdate(bool is_agg, const RawMap &raw,
+            const DelMap &del, RawMap *agg, SumStatMap *dsm) {
+        if (is_agg) {
+            RawMap diff(contrail::sandesh::DerivedStatsAgg<uint64_t>(
+                raw, *agg, del));
+            contrail::sandesh::DerivedStatsMerge<contrail::sandesh::DSSum,
+                uint64_t, uint64_t>(diff, *dsm, "", del, 0);
+        } else {
+            contrail::sandesh::DerivedStatsMerge<contrail::sandesh::DSSum,
+                uint64_t, uint64_t>(raw, *dsm, "", del, 0);
+        }
+    }
+
+    static RawMap ReferenceResult(const SumStatMap &dsm) {
+        RawMap result;
+        for (SumStatMap::const_iterator it = dsm.begin(); it != dsm.end();
+             ++it) {
+            uint64_t res;
+            if (it->second->FillResult(res) == contrail::sandesh::DSR_OK) {
+                result.insert(std::make_pair(it->first, res));
+            }
+        }
+        return result;
+    }
+
+    void CompareUpdates(bool is_agg) {
+        contrail::sandesh::DerivedStatsIf<contrail::sandesh::DSSum,
+            uint64_t, uint64_t> ds("", is_agg);
+        RawMap agg;
+        SumStatMap dsm;
+        srand(1);
+        for (int step = 0; step < 200; step++) {
+            RawMap raw;
+            DelMap del;
+            // Random subsets of keys, some of them deleted, and
+            // occasionally an empty map
+            if (step % 50 != 49) {
+                for (int i = 0; i < 20; i++) {
+                    if (rand() % 2) continue;
+                    std::ostringstream key;
+                    key << "key-" << i;
+                    raw.insert(std::make_pair(key.str(),
+                        (uint64_t)(step * 100 + rand() % 100)));
+                    del.insert(std::make_pair(key.str(), rand() % 5 == 0));
+                }
+            }
+            ds.Update(raw, del, 0);
+            ReferenceUpdate(is_agg, raw, del, &agg, &dsm);
+            RawMap result;
+            bool isset;
+            ds.FillResult(result, isset);
+            ASSERT_EQ(ReferenceResult(dsm), result) << "step " << step;
+        }
+    }
+};
+
+TEST_F(SandeshPerfTestDerivedStatsMap, Basic) {
+    CompareUpdates(false);
+}
+
+TEST_F(SandeshPerfTestDerivedStatsMap, Agg) {
+    CompareUpdates(true);
+}
+
+TEST_F(SandeshPerfTestDerivedStatsMap, DISABLED_KeyedStoreUpdate) {
+    contrail::sandesh::DerivedStatsIf<contrail::sandesh::DSSum,
+        uint64_t, uint64_t> ds("", true);
+    RawMap raw;
+    DelMap del;
+    BuildRaw(kKeys, &raw, &del);
+    for (int step = 0; step < 100; step++) {
+        StepRaw(&raw);
+        ds.Update(raw, del, 0);
+    }
+}
+
+TEST_F(SandeshPerfTestDerivedStatsMap, DISABLED_MapUpdate) {
+    RawMap agg;
+    SumStatMap dsm;
+    RawMap raw;
+    DelMap del;
+    BuildRaw(kKeys, &raw, &del);
+    for (int step = 0; step < 100; step++) {
+        StepRaw(&raw);
+        ReferenceUpdate(true, raw, del, &agg, &dsm);
+    }
+}
+
+TEST_F(SandeshPerfTestDerivedStats, DISABLED_DSSumUpdate) {
+    SumStat sum("3600");
+    for (int i = 0; i < kUpdates; i++) {
+        sum.Update(i, kStartUsec + i * 10000ULL);
+    }
+}
+
+TEST_F(SandeshPerfTestDerivedStats, DISABLED_DSSumMapUpdate) {
+    MapSumStat sum(3600);
+    for (int i = 0; i < kUpdates; i++) {
+        sum.Update(i, kStartUsec + i * 10000ULL);
+    }
+}
+
+TEST_F(SandeshPerfTestDerivedStats, DISABLED_DSAvgUpdate) {
+    AvgStat avg("3600");
+    double res;
+    for (int i = 0; i < kUpdates; i++) {
+        avg.Update(i, kStartUsec + i * 10000ULL);
+        avg.FillResult(res);
+    }
+}
+
+// Debug systemlogs in a tight loop, dropped by the level check in the
+// generated macro before the arguments are evaluated, compared with the
+// ones dropped by the logging level after
+class SandeshPerfTestLogLevel : public ::testing::Test {
+protected:
+    static const int kLogs = 10000000;
+
+    virtual void SetUp() {
+        logging_level_ = Sandesh::LoggingLevel();
+        Sandesh::SetLoggingLevel(SandeshLevel::SYS_INFO);
+        evaluated_ = 0;
+    }
+
+    virtual void TearDown() {
+        Sandesh::SetMinLevel(SandeshLevel::INVALID);
+        Sandesh::SetLoggingLevel(logging_level_);
+    }
+
+    std::string Name(int i) {
+        evaluated_++;
+        return "perf-test-" + integerToString(i);
+    }
+
+    SandeshLevel::type logging_level_;
+    int evaluated_;
+};
+
+// Eliding is opt-in, the logging level does not change the minimum level
+TEST_F(SandeshPerfTestLogLevel, DefaultMinLevel) {
+    EXPECT_EQ(SandeshLevel::INVALID, Sandesh::MinLevel());
+    Sandesh::SetLoggingLevel(SandeshLevel::SYS_ERR);
+    EXPECT_EQ(SandeshLevel::INVALID, Sandesh::MinLevel());
+    EXPECT_TRUE(Sandesh::IsLevelEnabled(SandeshLevel::SYS_DEBUG));
+    EXPECT_TRUE(Sandesh::IsLevelEnabled(SandeshLevel::UT_DEBUG));
+}
+
+// The level is evaluated once by the generated macro
+TEST_F(SandeshPerfTestLogLevel, LevelEvaluatedOnce) {
+    int levels = 0;
+    Sandesh::SetMinLevel(SandeshLevel::SYS_INFO);
+    PERF_TEST_DEBUG_LOG("PerfTest",
+        (levels++, SandeshLevel::SYS_DEBUG), Name(1), 1);
+    EXPECT_EQ(1, levels);
+    EXPECT_EQ(0, evaluated_);
+    PERF_TEST_DEBUG_LOG("PerfTest",
+        (levels++, SandeshLevel::SYS_INFO), Name(2), 2);
+    EXPECT_EQ(2, levels);
+    EXPECT_EQ(1, evaluated_);
+}
+
+TEST_F(SandeshPerfTestLogLevel, Basic) {
+    EXPECT_TRUE(Sandesh::IsLevelEnabled(SandeshLevel::SYS_DEBUG));
+    PERF_TEST_DEBUG_LOG("PerfTest", SandeshLevel::SYS_DEBUG, Name(1), 1);
+    EXPECT_EQ(1, evaluated_);
+
+    Sandesh::SetMinLevel(SandeshLevel::SYS_INFO);
+    EXPECT_FALSE(Sandesh::IsLevelEnabled(SandeshLevel::SYS_DEBUG));
+    EXPECT_TRUE(Sandesh::IsLevelEnabled(SandeshLevel::SYS_INFO));
+    PERF_TEST_DEBUG_LOG("PerfTest", SandeshLevel::SYS_DEBUG, Name(2), 2);
+    EXPECT_EQ(1, evaluated_);
+    PERF_TEST_DEBUG_LOG("PerfTest", SandeshLevel::SYS_INFO, Name(3), 3);
+    EXPECT_EQ(2, evaluated_);
+
+    // The legacy macro sends at SYS_INFO
+    PERF_TEST_DEBUG_SEND(Name(4), 4);
+    EXPECT_EQ(3, evaluated_);
+    Sandesh::SetMinLevel(SandeshLevel::SYS_WARN);
+    PERF_TEST_DEBUG_SEND(Name(5), 5);
+    EXPECT_EQ(3, evaluated_);
+}
+
+TEST_F(SandeshPerfTestLogLevel, DISABLED_MinLevelDebugLog) {
+    Sandesh::SetMinLevel(SandeshLevel::SYS_INFO);
+    for (int i = 0; i < kLogs; i++) {
+        PERF_TEST_DEBUG_LOG("PerfTest", SandeshLevel::SYS_DEBUG, Name(i), i);
+    }
+    EXPECT_EQ(0, evaluated_);
+}
+
+TEST_F(SandeshPerfTestLogLevel, DISABLED_LoggingLevelDebugLog) {
+    for (int i = 0; i < kLogs; i++) {
+        PERF_TEST_DEBUG_LOG("PerfTest", SandeshLevel::SYS_DEBUG, Name(i), i);
+    }
+    EXPECT_EQ(kLogs, evaluated_);
+}
+
 int main(int argc, char **argv) {
     LoggingInit();
     ::testing::InitGoogleTest(&argc, argv);
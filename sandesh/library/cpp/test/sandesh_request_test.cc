@@ -412,11 +412,10 @@ TEST_F(SandeshRequestTest, MessageStats) {
     SandeshClient *client = Sandesh::client();
     ASSERT_TRUE(client != NULL);
     ASSERT_TRUE(client->session() != NULL);
-    ASSERT_TRUE(client->session()->send_queue() != NULL);
     SandeshQueueStats qstats;
-    qstats.set_enqueues(client->session()->send_queue()->NumEnqueues());
-    qstats.set_count(client->session()->send_queue()->Length());
-    qstats.set_max_count(client->session()->send_queue()->max_queue_len());
+    qstats.set_enqueues(client->session()->SendQueueNumEnqueues());
+    qstats.set_count(client->session()->SendQueueLength());
+    qstats.set_max_count(client->session()->SendQueueMaxLength());
     // Send request
     SandeshMessageStatsReq *req(new SandeshMessageStatsReq);
     Sandesh::set_response_callback(boost::bind(ValidateMessageStatsResponse,
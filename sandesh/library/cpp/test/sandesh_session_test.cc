@@ -21,6 +21,7 @@
 #include <sandesh/sandesh.h>
 #include <sandesh/sandesh_server.h>
 #include <sandesh/sandesh_session.h>
+#include <sandesh/sandesh_trace_types.h>
 
 using namespace std;
 
@@ -557,6 +558,139 @@ TEST_F(SandeshSendMsgUnitTest, AsyncSend) {
     }
 }
 
+TEST_F(SandeshSendMsgUnitTest, FlushDeadline) {
+    uint32_t max_size = SandeshWriter::kDefaultSendSize;
+    SendMsgInfo msg_info[] = { {max_size/4},
+                               {max_size/4},
+                               {max_size/2},
+                               {max_size/4}
+    };
+
+    for (size_t i = 0; i < ARRAYLEN(msg_info); i++) {
+        msg_info[i].buf = new uint8_t[msg_info[i].msg_size];
+        CreateFakeMessage(msg_info[i].buf, msg_info[i].msg_size);
+    }
+
+    send_action = SEND;
+    // Hold back the messages even though the send queue is empty
+    Sandesh::set_send_flush_deadline(60 * 1000 * 1000);
+    session_->SendMessage(msg_info[0].buf, msg_info[0].msg_size, false);
+    EXPECT_EQ(0, session_->send_count());
+    EXPECT_EQ(max_size/4, send_buf_offset());
+    session_->SendMessage(msg_info[1].buf, msg_info[1].msg_size, false);
+    EXPECT_EQ(0, session_->send_count());
+    EXPECT_EQ(max_size/2, send_buf_offset());
+    // The batch is sent once it is full
+    session_->SendMessage(msg_info[2].buf, msg_info[2].msg_size, false);
+    EXPECT_EQ(1, session_->send_count());
+    EXPECT_EQ(0, send_buf_offset());
+    EXPECT_EQ(1U, session_->GetStats().get_num_send_flush_batch_full());
+
+    // Without a deadline, the message is sent as soon as the queue is empty
+    Sandesh::set_send_flush_deadline(0);
+    session_->SendMessage(msg_info[3].buf, msg_info[3].msg_size, false);
+    EXPECT_EQ(2, session_->send_count());
+    EXPECT_EQ(0, send_buf_offset());
+    EXPECT_EQ(1U, session_->GetStats().get_num_send_flush_queue_empty());
+    EXPECT_EQ(0U, session_->GetStats().get_num_send_flush_deadline());
+
+    uint8_t *send_buf = NULL;
+    size_t buf_len;
+    session_->send_buf(0, &send_buf, &buf_len);
+    EXPECT_EQ(max_size, buf_len);
+    EXPECT_EQ(0, memcmp(msg_info[0].buf, send_buf, max_size/4));
+    EXPECT_EQ(0, memcmp(msg_info[1].buf, send_buf + max_size/4, max_size/4));
+    EXPECT_EQ(0, memcmp(msg_info[2].buf, send_buf + max_size/2, max_size/2));
+    session_->send_buf(1, &send_buf, &buf_len);
+    EXPECT_EQ(max_size/4, buf_len);
+    EXPECT_EQ(0, memcmp(msg_info[3].buf, send_buf, buf_len));
+    for (size_t i = 0; i < ARRAYLEN(msg_info); i++) {
+        delete [] msg_info[i].buf;
+    }
+}
+
+static bool SendCountIs(SandeshSessionTest *session, int count) {
+    return session->send_count() == count;
+}
+
+TEST_F(SandeshSendMsgUnitTest, FlushTimer) {
+    uint32_t msg_size = SandeshWriter::kDefaultSendSize/4;
+    uint8_t *msg = new uint8_t[msg_size];
+    CreateFakeMessage(msg, msg_size);
+
+    send_action = SEND;
+    // The batch is not full and the queue is empty, so only the flush
+    // timer can send it
+    uint32_t deadline_usec = 50 * 1000;
+    Sandesh::set_send_flush_deadline(deadline_usec);
+    uint64_t start_usec = ClockMonotonicUsec();
+    session_->SendMessage(msg, msg_size, false);
+    EXPECT_EQ(0, session_->send_count());
+    EXPECT_EQ(msg_size, send_buf_offset());
+    task_util::WaitForCondition(&evm_,
+        boost::bind(&SendCountIs, session_, 1), 5);
+    EXPECT_EQ(1, session_->send_count());
+    EXPECT_LE(start_usec + deadline_usec, ClockMonotonicUsec());
+    EXPECT_EQ(0, send_buf_offset());
+    EXPECT_EQ(1U, session_->GetStats().get_num_send_flush_deadline());
+    EXPECT_EQ(0U, session_->GetStats().get_num_send_flush_batch_full());
+    EXPECT_EQ(0U, session_->GetStats().get_num_send_flush_queue_empty());
+
+    uint8_t *send_buf = NULL;
+    size_t buf_len;
+    session_->send_buf(0, &send_buf, &buf_len);
+    EXPECT_EQ(msg_size, buf_len);
+    EXPECT_EQ(0, memcmp(msg, send_buf, buf_len));
+    Sandesh::set_send_flush_deadline(0);
+    delete [] msg;
+}
+
+TEST_F(SandeshSendMsgUnitTest, SendLane) {
+    EXPECT_EQ(SandeshSession::SendLane::UVE,
+        SandeshSession::GetSendLane(SandeshType::UVE));
+    EXPECT_EQ(SandeshSession::SendLane::UVE,
+        SandeshSession::GetSendLane(SandeshType::ALARM));
+    EXPECT_EQ(SandeshSession::SendLane::CTRL,
+        SandeshSession::GetSendLane(SandeshType::RESPONSE));
+    EXPECT_EQ(SandeshSession::SendLane::SYSTEM,
+        SandeshSession::GetSendLane(SandeshType::SYSTEM));
+    EXPECT_EQ(SandeshSession::SendLane::OBJECT,
+        SandeshSession::GetSendLane(SandeshType::OBJECT));
+    EXPECT_EQ(SandeshSession::SendLane::FLOW,
+        SandeshSession::GetSendLane(SandeshType::FLOW));
+    EXPECT_EQ(SandeshSession::SendLane::FLOW,
+        SandeshSession::GetSendLane(SandeshType::SESSION));
+    for (int i = 0; i < SandeshSession::SendLane::MAX; i++) {
+        SandeshSession::SendLane::type lane(
+            static_cast<SandeshSession::SendLane::type>(i));
+        EXPECT_TRUE(session_->send_queue(lane) != NULL);
+    }
+    EXPECT_EQ(SandeshLevel::INVALID, session_->SendingLevel());
+    EXPECT_TRUE(session_->IsSendQueueEmpty());
+    EXPECT_EQ(0U, session_->SendQueueLength());
+}
+
+TEST_F(SandeshSendMsgUnitTest, SendLaneWaterMark) {
+    // The session is not established, so the lanes are not drained
+    Sandesh *ctrl_snh(new SandeshMessageStatsResp);
+    Sandesh *system_snh(new SandeshTraceText);
+    size_t ctrl_size(ctrl_snh->GetSize());
+    size_t system_size(system_snh->GetSize());
+    ASSERT_NE(SandeshSession::GetSendLane(ctrl_snh),
+        SandeshSession::GetSendLane(system_snh));
+    // The high watermark is crossed only by the total of the lanes
+    Sandesh::QueueWaterMarkInfo hwm(ctrl_size + system_size,
+        SandeshLevel::SYS_ERR, true, false);
+    session_->SetSendQueueWaterMark(hwm);
+    session_->EnqueueSandesh(ctrl_snh);
+    EXPECT_EQ(SandeshLevel::INVALID, session_->SendingLevel());
+    session_->EnqueueSandesh(system_snh);
+    EXPECT_EQ(SandeshLevel::SYS_ERR, session_->SendingLevel());
+    EXPECT_EQ(ctrl_size + system_size, session_->SendQueueLength());
+    EXPECT_EQ(ctrl_size + system_size, session_->SendQueueMaxLength());
+    session_->ResetSendQueueWaterMark();
+}
+
 int main(int argc, char **argv) {
     LoggingInit();
     ::testing::InitGoogleTest(&argc, argv);
@@ -46,6 +46,11 @@ public:
         trace_list_.push_back(magicNo);
     }
 
+    void TraceCategory(SandeshTrace *sandesh) {
+        category_list_.push_back(sandesh->category());
+        TraceRead(sandesh);
+    }
+
 protected:
     virtual void SetUp() {
     }
@@ -54,6 +59,7 @@ protected:
     }
 
     std::vector<int> trace_list_; 
+    std::vector<std::string> category_list_;
     EventManager evm_;
 };
 
@@ -397,6 +403,71 @@ TEST_F(SandeshTraceTest, test1) {
     SandeshTraceDisable();
 }
 
+TEST_F(SandeshTraceTest, BinaryBuffer) {
+    SandeshTraceEnable();
+    SandeshTraceBufferPtr trace_buf(
+        SandeshTraceBufferCreateBinary("binary_buf", 3, 64));
+    EXPECT_TRUE(trace_buf->IsBinary());
+    SANDESH_TRACE_TEST1_TRACE(trace_buf, 1, 1);
+    SANDESH_TRACE_TEST2_TRACE(trace_buf, 2, 2);
+    SandeshTraceBufferRead(trace_buf, "context1", 0,
+            boost::bind(&SandeshTraceTest::TraceRead, this, _1));
+    {
+        EXPECT_EQ(2, trace_list_.size());
+        int expected[] = {1, 2};
+        std::vector<int>::iterator it = trace_list_.begin();
+        for (size_t i = 0; i < trace_list_.size(); i++, it++) {
+            EXPECT_EQ(expected[i], *it);
+        }
+    }
+
+    // Wrap the buffer, the read context continues after the last read
+    trace_list_.clear();
+    SANDESH_TRACE_TEST3_TRACE(trace_buf, 3, 3);
+    SANDESH_TRACE_TEST1_TRACE(trace_buf, 4, 1);
+    SandeshTraceBufferRead(trace_buf, "context1", 0,
+            boost::bind(&SandeshTraceTest::TraceRead, this, _1));
+    {
+        EXPECT_EQ(2, trace_list_.size());
+        int expected[] = {3, 4};
+        std::vector<int>::iterator it = trace_list_.begin();
+        for (size_t i = 0; i < trace_list_.size(); i++, it++) {
+            EXPECT_EQ(expected[i], *it);
+        }
+    }
+    trace_list_.clear();
+    SandeshTraceBufferRead(trace_buf, "context1", 0,
+            boost::bind(&SandeshTraceTest::TraceRead, this, _1));
+    EXPECT_EQ(0, trace_list_.size());
+    SandeshTraceBufferReadDone(trace_buf, "context1");
+
+    // Decoded traces carry the buffer name as category
+    SandeshTraceBufferRead(trace_buf, "context2", 0,
+            boost::bind(&SandeshTraceTest::TraceCategory, this, _1));
+    ASSERT_EQ(3, category_list_.size());
+    for (size_t i = 0; i < category_list_.size(); i++) {
+        EXPECT_EQ("binary_buf", category_list_[i]);
+    }
+    trace_list_.clear();
+    SandeshTraceBufferReadDone(trace_buf, "context2");
+
+    // Memory report for binary versus object storage
+    SandeshTraceBufferPtr binary_mem_buf(
+        SandeshTraceBufferCreateBinary("binary_mem_buf", 1000, 64));
+    SandeshTraceBufferPtr obj_mem_buf(
+        SandeshTraceBufferCreate("obj_mem_buf", 1000));
+    for (int i = 0; i < 1000; i++) {
+        SANDESH_TRACE_TEST1_TRACE(binary_mem_buf, i, 1);
+        SANDESH_TRACE_TEST1_TRACE(obj_mem_buf, i, 1);
+    }
+    size_t binary_memory = SandeshTraceBufferMemoryGet(binary_mem_buf);
+    size_t obj_memory = SandeshTraceBufferMemoryGet(obj_mem_buf);
+    LOG(DEBUG, "1000 entries memory: object " << obj_memory <<
+        " binary " << binary_memory);
+    EXPECT_LT(binary_memory, obj_memory);
+    SandeshTraceDisable();
+}
+
 class SandeshTracePerfTest : public ::testing::Test {
 protected:
     virtual void SetUp() {
@@ -427,6 +427,12 @@ class TMemoryBuffer : public TVirtualTransport<TMemoryBuffer, TBufferBase> {
   // that had been provided by getWritePtr().
   void wroteBytes(uint32_t len);
 
+  // Discards the data written after the first 'len' readable bytes
+  void truncate(uint32_t len) {
+    assert(len <= available_read());
+    wBase_ = rBase_ + len;
+  }
+
   /*
    * TVirtualTransport provides a default implementation of readAll().
    * We want to use the TBufferBase version instead.
@@ -0,0 +1,195 @@
+from __future__ import print_function
+#
+#  Copyright (c) 2026 Juniper Networks. All rights reserved.
+#
+#  sandesh_trace_file_dump.py
+#
+#  Dumps a persistent sandesh trace buffer file, created with
+#  SandeshTraceBufferCreatePersistent(), without the daemon running.
+#
+#  usage: sandesh_trace_file_dump.py <trace file> [<trace file> ...]
+
+import datetime
+import socket
+import struct
+import sys
+import uuid
+
+_FILE_MAGIC = b'CTRACE01'
+_FILE_VERSION = 2
+# TraceFileHeader and TraceSlotHeader in base/trace_arena.h, host byte order
+_FILE_HEADER = struct.Struct('=8sIIII64sIIII')
+_SLOT_HEADER = struct.Struct('=QII')
+
+# Thrift types, see protocol/TProtocol.h
+T_STOP = 0
+T_BOOL = 2
+T_BYTE = 3
+T_DOUBLE = 4
+T_I16 = 6
+T_I32 = 8
+T_U64 = 9
+T_I64 = 10
+T_STRING = 11
+T_STRUCT = 12
+T_MAP = 13
+T_SET = 14
+T_LIST = 15
+T_U16 = 19
+T_U32 = 20
+T_XML = 21
+T_IPV4 = 22
+T_UUID = 23
+T_IPADDR = 24
+
+_FIXED_TYPES = {
+    T_BOOL: '>?',
+    T_BYTE: '>b',
+    T_DOUBLE: '>d',
+    T_I16: '>h',
+    T_I32: '>i',
+    T_U64: '>Q',
+    T_I64: '>q',
+    T_U16: '>H',
+    T_U32: '>I',
+}
+
+def _UTCTimestampUsecToString(utc_usec):
+    return datetime.datetime.fromtimestamp(utc_usec/1000000.0).strftime('%Y-%m-%d %H:%M:%S.%f')
+#end _UTCTimestampUsecToString
+
+class _BinaryReader(object):
+    """Decodes TBinaryProtocol encoded data without the sandesh schema."""
+
+    def __init__(self, data):
+        self._data = data
+        self._offset = 0
+
+    def unpack(self, fmt):
+        value = struct.unpack_from(fmt, self._data, self._offset)[0]
+        self._offset += struct.calcsize(fmt)
+        return value
+
+    def read(self, size):
+        if self._offset + size > len(self._data):
+            raise ValueError('truncated entry')
+        value = self._data[self._offset:self._offset + size]
+        self._offset += size
+        return value
+
+    def read_string(self):
+        value = self.read(self.unpack('>i'))
+        return value.decode('utf-8', 'replace')
+
+    def read_value(self, ttype):
+        if ttype in _FIXED_TYPES:
+            return str(self.unpack(_FIXED_TYPES[ttype]))
+        if ttype in (T_STRING, T_XML):
+            return '"' + self.read_string() + '"'
+        if ttype == T_IPV4:
+            return socket.inet_ntoa(self.read(4))
+        if ttype == T_IPADDR:
+            if self.unpack('>B') == socket.AF_INET:
+                return socket.inet_ntop(socket.AF_INET, self.read(4))
+            return socket.inet_ntop(socket.AF_INET6, self.read(16))
+        if ttype == T_UUID:
+            return str(uuid.UUID(bytes=bytes(self.read(16))))
+        if ttype == T_STRUCT:
+            return '{ ' + self.read_fields() + '}'
+        if ttype in (T_LIST, T_SET):
+            etype = self.unpack('>b')
+            size = self.unpack('>i')
+            return '[ ' + ''.join(self.read_value(etype) + '; '
+                                  for _ in range(size)) + ']'
+        if ttype == T_MAP:
+            ktype = self.unpack('>b')
+            vtype = self.unpack('>b')
+            size = self.unpack('>i')
+            s = '{ '
+            for _ in range(size):
+                s += self.read_value(ktype) + ': '
+                s += self.read_value(vtype) + '; '
+            return s + '}'
+        raise ValueError('unknown type %d' % (ttype))
+
+    def read_fields(self):
+        s = ''
+        while True:
+            ttype = self.unpack('>b')
+            if ttype == T_STOP:
+                return s
+            fid = self.unpack('>h')
+            s += '%d = %s ' % (fid, self.read_value(ttype))
+#end class _BinaryReader
+
+def _read_type_names(data, offset, count, size):
+    """Returns the entry type names recorded by SandeshTraceCodec."""
+    names = []
+    for i in range(count):
+        name = data[offset + i * size:offset + (i + 1) * size]
+        names.append(name.split(b'\0', 1)[0].decode('utf-8', 'replace'))
+    return names
+#end _read_type_names
+
+def _decode_trace(data, type_names):
+    # SandeshTraceCodec: type index, timestamp and seqnum followed by
+    # the sandesh as written by Sandesh::Write()
+    reader = _BinaryReader(data)
+    type_index = reader.unpack('>H')
+    timestamp = reader.unpack('>q')
+    seqnum = reader.unpack('>i')
+    name = reader.read_string()
+    # The type table is authoritative, the sandesh name is only used for
+    # the types that did not fit in the table
+    if type_index < len(type_names) and type_names[type_index]:
+        name = type_names[type_index]
+    return '%s %d %s: %s' % (_UTCTimestampUsecToString(timestamp), seqnum,
+                             name, reader.read_fields())
+#end _decode_trace
+
+def print_trace_file(path):
+    """Dumps the content of the specified trace buffer file, oldest first."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if len(data) < _FILE_HEADER.size:
+        print('%s: not a trace buffer file' % (path))
+        return
+    magic, version, header_size, slot_size, slot_count, name, \
+        type_table_offset, type_count, type_name_size, _ = \
+        _FILE_HEADER.unpack_from(data)
+    if magic != _FILE_MAGIC or version != _FILE_VERSION:
+        print('%s: not a trace buffer file' % (path))
+        return
+    if type_table_offset + type_count * type_name_size > header_size:
+        print('%s: corrupt type table' % (path))
+        return
+    print('Trace buffer: ' + name.split(b'\0', 1)[0].decode('utf-8'))
+    type_names = _read_type_names(data, type_table_offset, type_count,
+                                  type_name_size)
+    slots = []
+    for i in range(slot_count):
+        offset = header_size + i * slot_size
+        if offset + slot_size > len(data):
+            break
+        seqno, length, _ = _SLOT_HEADER.unpack_from(data, offset)
+        # Never written
+        if seqno == 0:
+            continue
+        slots.append((seqno, offset + _SLOT_HEADER.size, length))
+    for seqno, offset, length in sorted(slots):
+        # Being written at the time of the crash, or too large for a slot
+        if length == 0 or length > slot_size - _SLOT_HEADER.size:
+            print('<entry not stored>')
+            continue
+        try:
+            print(_decode_trace(data[offset:offset + length], type_names))
+        except (ValueError, struct.error) as e:
+            print('<entry not decoded: %s>' % (e))
+#end print_trace_file
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print('usage: %s <trace file> [<trace file> ...]' % (sys.argv[0]))
+        sys.exit(1)
+    for trace_file in sys.argv[1:]:
+        print_trace_file(trace_file)